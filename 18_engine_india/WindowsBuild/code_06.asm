@@ -0,0 +1,26 @@
+; Interpreted code storing into translated code (see emulator_aot.cpp).
+; patch is only reached through JMP ($10), so the translator never sees
+; it; it points the branch at back at set99 the second time round,
+; while the block translated for loop still has the old branch.
+* = $0340
+        lda #<patch
+        sta $10
+        lda #>patch
+        sta $11
+        lda #$11
+        sta $20
+        ldx #0
+        jmp loop            ; so loop is a translated block
+loop:   lda #1
+back:   bne over            ; taken both times
+set99:  lda #$99
+        sta $20
+        rts
+over:   cpx #1
+        beq done
+        inx
+        jmp ($10)
+done:   rts
+patch:  lda #set99-back-2
+        sta back+1
+        jmp loop
@@ -0,0 +1,271 @@
+//345678901234567890123456789012345678901234567890123456789012345678901234567890
+//       1         2         3         4         5         6         7         8
+// Filename: ../emulator_6502.cpp
+// Last Modified: Tue Oct 20, 2026  06:40AM
+//
+// The 6502 instruction set, one row per opcode byte: mnemonic, addressing
+// mode, length, base cycle count, and whether indexing across a page (or a
+// taken branch) costs an extra cycle. The CPU, the assembler and the
+// disassembler build their tables from this, so an opcode only ever has to
+// be described once.
+
+#include "emulator_6502.h"
+
+const Opcode_Info OPCODES[256] = {
+    { "BRK", MODE_IMPLIED,          1, 7, 0 },  // 0x00
+    { "ORA", MODE_INDEXED_INDIRECT, 2, 6, 0 },  // 0x01
+    { "???", MODE_NONE,             1, 2, 0 },  // 0x02
+    { "???", MODE_NONE,             1, 2, 0 },  // 0x03
+    { "???", MODE_NONE,             1, 2, 0 },  // 0x04
+    { "ORA", MODE_ZERO_PAGE,        2, 3, 0 },  // 0x05
+    { "ASL", MODE_ZERO_PAGE,        2, 5, 0 },  // 0x06
+    { "???", MODE_NONE,             1, 2, 0 },  // 0x07
+    { "PHP", MODE_IMPLIED,          1, 3, 0 },  // 0x08
+    { "ORA", MODE_IMMEDIATE,        2, 2, 0 },  // 0x09
+    { "ASL", MODE_ACCUMULATOR,      1, 2, 0 },  // 0x0A
+    { "???", MODE_NONE,             1, 2, 0 },  // 0x0B
+    { "???", MODE_NONE,             1, 2, 0 },  // 0x0C
+    { "ORA", MODE_ABSOLUTE,         3, 4, 0 },  // 0x0D
+    { "ASL", MODE_ABSOLUTE,         3, 6, 0 },  // 0x0E
+    { "???", MODE_NONE,             1, 2, 0 },  // 0x0F
+    { "BPL", MODE_RELATIVE,         2, 2, 1 },  // 0x10
+    { "ORA", MODE_INDIRECT_INDEXED, 2, 5, 1 },  // 0x11
+    { "???", MODE_NONE,             1, 2, 0 },  // 0x12
+    { "???", MODE_NONE,             1, 2, 0 },  // 0x13
+    { "???", MODE_NONE,             1, 2, 0 },  // 0x14
+    { "ORA", MODE_ZERO_PAGE_X,      2, 4, 0 },  // 0x15
+    { "ASL", MODE_ZERO_PAGE_X,      2, 6, 0 },  // 0x16
+    { "???", MODE_NONE,             1, 2, 0 },  // 0x17
+    { "CLC", MODE_IMPLIED,          1, 2, 0 },  // 0x18
+    { "ORA", MODE_ABSOLUTE_Y,       3, 4, 1 },  // 0x19
+    { "???", MODE_NONE,             1, 2, 0 },  // 0x1A
+    { "???", MODE_NONE,             1, 2, 0 },  // 0x1B
+    { "???", MODE_NONE,             1, 2, 0 },  // 0x1C
+    { "ORA", MODE_ABSOLUTE_X,       3, 4, 1 },  // 0x1D
+    { "ASL", MODE_ABSOLUTE_X,       3, 7, 0 },  // 0x1E
+    { "???", MODE_NONE,             1, 2, 0 },  // 0x1F
+    { "JSR", MODE_ABSOLUTE,         3, 6, 0 },  // 0x20
+    { "AND", MODE_INDEXED_INDIRECT, 2, 6, 0 },  // 0x21
+    { "???", MODE_NONE,             1, 2, 0 },  // 0x22
+    { "???", MODE_NONE,             1, 2, 0 },  // 0x23
+    { "BIT", MODE_ZERO_PAGE,        2, 3, 0 },  // 0x24
+    { "AND", MODE_ZERO_PAGE,        2, 3, 0 },  // 0x25
+    { "ROL", MODE_ZERO_PAGE,        2, 5, 0 },  // 0x26
+    { "???", MODE_NONE,             1, 2, 0 },  // 0x27
+    { "PLP", MODE_IMPLIED,          1, 4, 0 },  // 0x28
+    { "AND", MODE_IMMEDIATE,        2, 2, 0 },  // 0x29
+    { "ROL", MODE_ACCUMULATOR,      1, 2, 0 },  // 0x2A
+    { "???", MODE_NONE,             1, 2, 0 },  // 0x2B
+    { "BIT", MODE_ABSOLUTE,         3, 4, 0 },  // 0x2C
+    { "AND", MODE_ABSOLUTE,         3, 4, 0 },  // 0x2D
+    { "ROL", MODE_ABSOLUTE,         3, 6, 0 },  // 0x2E
+    { "???", MODE_NONE,             1, 2, 0 },  // 0x2F
+    { "BMI", MODE_RELATIVE,         2, 2, 1 },  // 0x30
+    { "AND", MODE_INDIRECT_INDEXED, 2, 5, 1 },  // 0x31
+    { "???", MODE_NONE,             1, 2, 0 },  // 0x32
+    { "???", MODE_NONE,             1, 2, 0 },  // 0x33
+    { "???", MODE_NONE,             1, 2, 0 },  // 0x34
+    { "AND", MODE_ZERO_PAGE_X,      2, 4, 0 },  // 0x35
+    { "ROL", MODE_ZERO_PAGE_X,      2, 6, 0 },  // 0x36
+    { "???", MODE_NONE,             1, 2, 0 },  // 0x37
+    { "SEC", MODE_IMPLIED,          1, 2, 0 },  // 0x38
+    { "AND", MODE_ABSOLUTE_Y,       3, 4, 1 },  // 0x39
+    { "???", MODE_NONE,             1, 2, 0 },  // 0x3A
+    { "???", MODE_NONE,             1, 2, 0 },  // 0x3B
+    { "???", MODE_NONE,             1, 2, 0 },  // 0x3C
+    { "AND", MODE_ABSOLUTE_X,       3, 4, 1 },  // 0x3D
+    { "ROL", MODE_ABSOLUTE_X,       3, 7, 0 },  // 0x3E
+    { "???", MODE_NONE,             1, 2, 0 },  // 0x3F
+    { "RTI", MODE_IMPLIED,          1, 6, 0 },  // 0x40
+    { "EOR", MODE_INDEXED_INDIRECT, 2, 6, 0 },  // 0x41
+    { "???", MODE_NONE,             1, 2, 0 },  // 0x42
+    { "???", MODE_NONE,             1, 2, 0 },  // 0x43
+    { "???", MODE_NONE,             1, 2, 0 },  // 0x44
+    { "EOR", MODE_ZERO_PAGE,        2, 3, 0 },  // 0x45
+    { "LSR", MODE_ZERO_PAGE,        2, 5, 0 },  // 0x46
+    { "???", MODE_NONE,             1, 2, 0 },  // 0x47
+    { "PHA", MODE_IMPLIED,          1, 3, 0 },  // 0x48
+    { "EOR", MODE_IMMEDIATE,        2, 2, 0 },  // 0x49
+    { "LSR", MODE_ACCUMULATOR,      1, 2, 0 },  // 0x4A
+    { "???", MODE_NONE,             1, 2, 0 },  // 0x4B
+    { "JMP", MODE_ABSOLUTE,         3, 3, 0 },  // 0x4C
+    { "EOR", MODE_ABSOLUTE,         3, 4, 0 },  // 0x4D
+    { "LSR", MODE_ABSOLUTE,         3, 6, 0 },  // 0x4E
+    { "???", MODE_NONE,             1, 2, 0 },  // 0x4F
+    { "BVC", MODE_RELATIVE,         2, 2, 1 },  // 0x50
+    { "EOR", MODE_INDIRECT_INDEXED, 2, 5, 1 },  // 0x51
+    { "???", MODE_NONE,             1, 2, 0 },  // 0x52
+    { "???", MODE_NONE,             1, 2, 0 },  // 0x53
+    { "???", MODE_NONE,             1, 2, 0 },  // 0x54
+    { "EOR", MODE_ZERO_PAGE_X,      2, 4, 0 },  // 0x55
+    { "LSR", MODE_ZERO_PAGE_X,      2, 6, 0 },  // 0x56
+    { "???", MODE_NONE,             1, 2, 0 },  // 0x57
+    { "CLI", MODE_IMPLIED,          1, 2, 0 },  // 0x58
+    { "EOR", MODE_ABSOLUTE_Y,       3, 4, 1 },  // 0x59
+    { "???", MODE_NONE,             1, 2, 0 },  // 0x5A
+    { "???", MODE_NONE,             1, 2, 0 },  // 0x5B
+    { "???", MODE_NONE,             1, 2, 0 },  // 0x5C
+    { "EOR", MODE_ABSOLUTE_X,       3, 4, 1 },  // 0x5D
+    { "LSR", MODE_ABSOLUTE_X,       3, 7, 0 },  // 0x5E
+    { "???", MODE_NONE,             1, 2, 0 },  // 0x5F
+    { "RTS", MODE_IMPLIED,          1, 6, 0 },  // 0x60
+    { "ADC", MODE_INDEXED_INDIRECT, 2, 6, 0 },  // 0x61
+    { "???", MODE_NONE,             1, 2, 0 },  // 0x62
+    { "???", MODE_NONE,             1, 2, 0 },  // 0x63
+    { "???", MODE_NONE,             1, 2, 0 },  // 0x64
+    { "ADC", MODE_ZERO_PAGE,        2, 3, 0 },  // 0x65
+    { "ROR", MODE_ZERO_PAGE,        2, 5, 0 },  // 0x66
+    { "???", MODE_NONE,             1, 2, 0 },  // 0x67
+    { "PLA", MODE_IMPLIED,          1, 4, 0 },  // 0x68
+    { "ADC", MODE_IMMEDIATE,        2, 2, 0 },  // 0x69
+    { "ROR", MODE_ACCUMULATOR,      1, 2, 0 },  // 0x6A
+    { "???", MODE_NONE,             1, 2, 0 },  // 0x6B
+    { "JMP", MODE_INDIRECT,         3, 5, 0 },  // 0x6C
+    { "ADC", MODE_ABSOLUTE,         3, 4, 0 },  // 0x6D
+    { "ROR", MODE_ABSOLUTE,         3, 6, 0 },  // 0x6E
+    { "???", MODE_NONE,             1, 2, 0 },  // 0x6F
+    { "BVS", MODE_RELATIVE,         2, 2, 1 },  // 0x70
+    { "ADC", MODE_INDIRECT_INDEXED, 2, 5, 1 },  // 0x71
+    { "???", MODE_NONE,             1, 2, 0 },  // 0x72
+    { "???", MODE_NONE,             1, 2, 0 },  // 0x73
+    { "???", MODE_NONE,             1, 2, 0 },  // 0x74
+    { "ADC", MODE_ZERO_PAGE_X,      2, 4, 0 },  // 0x75
+    { "ROR", MODE_ZERO_PAGE_X,      2, 6, 0 },  // 0x76
+    { "???", MODE_NONE,             1, 2, 0 },  // 0x77
+    { "SEI", MODE_IMPLIED,          1, 2, 0 },  // 0x78
+    { "ADC", MODE_ABSOLUTE_Y,       3, 4, 1 },  // 0x79
+    { "???", MODE_NONE,             1, 2, 0 },  // 0x7A
+    { "???", MODE_NONE,             1, 2, 0 },  // 0x7B
+    { "???", MODE_NONE,             1, 2, 0 },  // 0x7C
+    { "ADC", MODE_ABSOLUTE_X,       3, 4, 1 },  // 0x7D
+    { "ROR", MODE_ABSOLUTE_X,       3, 7, 0 },  // 0x7E
+    { "???", MODE_NONE,             1, 2, 0 },  // 0x7F
+    { "???", MODE_NONE,             1, 2, 0 },  // 0x80
+    { "STA", MODE_INDEXED_INDIRECT, 2, 6, 0 },  // 0x81
+    { "???", MODE_NONE,             1, 2, 0 },  // 0x82
+    { "???", MODE_NONE,             1, 2, 0 },  // 0x83
+    { "STY", MODE_ZERO_PAGE,        2, 3, 0 },  // 0x84
+    { "STA", MODE_ZERO_PAGE,        2, 3, 0 },  // 0x85
+    { "STX", MODE_ZERO_PAGE,        2, 3, 0 },  // 0x86
+    { "???", MODE_NONE,             1, 2, 0 },  // 0x87
+    { "DEY", MODE_IMPLIED,          1, 2, 0 },  // 0x88
+    { "???", MODE_NONE,             1, 2, 0 },  // 0x89
+    { "TXA", MODE_IMPLIED,          1, 2, 0 },  // 0x8A
+    { "???", MODE_NONE,             1, 2, 0 },  // 0x8B
+    { "STY", MODE_ABSOLUTE,         3, 4, 0 },  // 0x8C
+    { "STA", MODE_ABSOLUTE,         3, 4, 0 },  // 0x8D
+    { "STX", MODE_ABSOLUTE,         3, 4, 0 },  // 0x8E
+    { "???", MODE_NONE,             1, 2, 0 },  // 0x8F
+    { "BCC", MODE_RELATIVE,         2, 2, 1 },  // 0x90
+    { "STA", MODE_INDIRECT_INDEXED, 2, 6, 0 },  // 0x91
+    { "???", MODE_NONE,             1, 2, 0 },  // 0x92
+    { "???", MODE_NONE,             1, 2, 0 },  // 0x93
+    { "STY", MODE_ZERO_PAGE_X,      2, 4, 0 },  // 0x94
+    { "STA", MODE_ZERO_PAGE_X,      2, 4, 0 },  // 0x95
+    { "STX", MODE_ZERO_PAGE_Y,      2, 4, 0 },  // 0x96
+    { "???", MODE_NONE,             1, 2, 0 },  // 0x97
+    { "TYA", MODE_IMPLIED,          1, 2, 0 },  // 0x98
+    { "STA", MODE_ABSOLUTE_Y,       3, 5, 0 },  // 0x99
+    { "TXS", MODE_IMPLIED,          1, 2, 0 },  // 0x9A
+    { "???", MODE_NONE,             1, 2, 0 },  // 0x9B
+    { "???", MODE_NONE,             1, 2, 0 },  // 0x9C
+    { "STA", MODE_ABSOLUTE_X,       3, 5, 0 },  // 0x9D
+    { "???", MODE_NONE,             1, 2, 0 },  // 0x9E
+    { "???", MODE_NONE,             1, 2, 0 },  // 0x9F
+    { "LDY", MODE_IMMEDIATE,        2, 2, 0 },  // 0xA0
+    { "LDA", MODE_INDEXED_INDIRECT, 2, 6, 0 },  // 0xA1
+    { "LDX", MODE_IMMEDIATE,        2, 2, 0 },  // 0xA2
+    { "???", MODE_NONE,             1, 2, 0 },  // 0xA3
+    { "LDY", MODE_ZERO_PAGE,        2, 3, 0 },  // 0xA4
+    { "LDA", MODE_ZERO_PAGE,        2, 3, 0 },  // 0xA5
+    { "LDX", MODE_ZERO_PAGE,        2, 3, 0 },  // 0xA6
+    { "???", MODE_NONE,             1, 2, 0 },  // 0xA7
+    { "TAY", MODE_IMPLIED,          1, 2, 0 },  // 0xA8
+    { "LDA", MODE_IMMEDIATE,        2, 2, 0 },  // 0xA9
+    { "TAX", MODE_IMPLIED,          1, 2, 0 },  // 0xAA
+    { "???", MODE_NONE,             1, 2, 0 },  // 0xAB
+    { "LDY", MODE_ABSOLUTE,         3, 4, 0 },  // 0xAC
+    { "LDA", MODE_ABSOLUTE,         3, 4, 0 },  // 0xAD
+    { "LDX", MODE_ABSOLUTE,         3, 4, 0 },  // 0xAE
+    { "???", MODE_NONE,             1, 2, 0 },  // 0xAF
+    { "BCS", MODE_RELATIVE,         2, 2, 1 },  // 0xB0
+    { "LDA", MODE_INDIRECT_INDEXED, 2, 5, 1 },  // 0xB1
+    { "???", MODE_NONE,             1, 2, 0 },  // 0xB2
+    { "???", MODE_NONE,             1, 2, 0 },  // 0xB3
+    { "LDY", MODE_ZERO_PAGE_X,      2, 4, 0 },  // 0xB4
+    { "LDA", MODE_ZERO_PAGE_X,      2, 4, 0 },  // 0xB5
+    { "LDX", MODE_ZERO_PAGE_Y,      2, 4, 0 },  // 0xB6
+    { "???", MODE_NONE,             1, 2, 0 },  // 0xB7
+    { "CLV", MODE_IMPLIED,          1, 2, 0 },  // 0xB8
+    { "LDA", MODE_ABSOLUTE_Y,       3, 4, 1 },  // 0xB9
+    { "TSX", MODE_IMPLIED,          1, 2, 0 },  // 0xBA
+    { "???", MODE_NONE,             1, 2, 0 },  // 0xBB
+    { "LDY", MODE_ABSOLUTE_X,       3, 4, 1 },  // 0xBC
+    { "LDA", MODE_ABSOLUTE_X,       3, 4, 1 },  // 0xBD
+    { "LDX", MODE_ABSOLUTE_Y,       3, 4, 1 },  // 0xBE
+    { "???", MODE_NONE,             1, 2, 0 },  // 0xBF
+    { "CPY", MODE_IMMEDIATE,        2, 2, 0 },  // 0xC0
+    { "CMP", MODE_INDEXED_INDIRECT, 2, 6, 0 },  // 0xC1
+    { "???", MODE_NONE,             1, 2, 0 },  // 0xC2
+    { "???", MODE_NONE,             1, 2, 0 },  // 0xC3
+    { "CPY", MODE_ZERO_PAGE,        2, 3, 0 },  // 0xC4
+    { "CMP", MODE_ZERO_PAGE,        2, 3, 0 },  // 0xC5
+    { "DEC", MODE_ZERO_PAGE,        2, 5, 0 },  // 0xC6
+    { "???", MODE_NONE,             1, 2, 0 },  // 0xC7
+    { "INY", MODE_IMPLIED,          1, 2, 0 },  // 0xC8
+    { "CMP", MODE_IMMEDIATE,        2, 2, 0 },  // 0xC9
+    { "DEX", MODE_IMPLIED,          1, 2, 0 },  // 0xCA
+    { "???", MODE_NONE,             1, 2, 0 },  // 0xCB
+    { "CPY", MODE_ABSOLUTE,         3, 4, 0 },  // 0xCC
+    { "CMP", MODE_ABSOLUTE,         3, 4, 0 },  // 0xCD
+    { "DEC", MODE_ABSOLUTE,         3, 6, 0 },  // 0xCE
+    { "???", MODE_NONE,             1, 2, 0 },  // 0xCF
+    { "BNE", MODE_RELATIVE,         2, 2, 1 },  // 0xD0
+    { "CMP", MODE_INDIRECT_INDEXED, 2, 5, 1 },  // 0xD1
+    { "???", MODE_NONE,             1, 2, 0 },  // 0xD2
+    { "???", MODE_NONE,             1, 2, 0 },  // 0xD3
+    { "???", MODE_NONE,             1, 2, 0 },  // 0xD4
+    { "CMP", MODE_ZERO_PAGE_X,      2, 4, 0 },  // 0xD5
+    { "DEC", MODE_ZERO_PAGE_X,      2, 6, 0 },  // 0xD6
+    { "???", MODE_NONE,             1, 2, 0 },  // 0xD7
+    { "CLD", MODE_IMPLIED,          1, 2, 0 },  // 0xD8
+    { "CMP", MODE_ABSOLUTE_Y,       3, 4, 1 },  // 0xD9
+    { "???", MODE_NONE,             1, 2, 0 },  // 0xDA
+    { "???", MODE_NONE,             1, 2, 0 },  // 0xDB
+    { "???", MODE_NONE,             1, 2, 0 },  // 0xDC
+    { "CMP", MODE_ABSOLUTE_X,       3, 4, 1 },  // 0xDD
+    { "DEC", MODE_ABSOLUTE_X,       3, 7, 0 },  // 0xDE
+    { "???", MODE_NONE,             1, 2, 0 },  // 0xDF
+    { "CPX", MODE_IMMEDIATE,        2, 2, 0 },  // 0xE0
+    { "SBC", MODE_INDEXED_INDIRECT, 2, 6, 0 },  // 0xE1
+    { "???", MODE_NONE,             1, 2, 0 },  // 0xE2
+    { "???", MODE_NONE,             1, 2, 0 },  // 0xE3
+    { "CPX", MODE_ZERO_PAGE,        2, 3, 0 },  // 0xE4
+    { "SBC", MODE_ZERO_PAGE,        2, 3, 0 },  // 0xE5
+    { "INC", MODE_ZERO_PAGE,        2, 5, 0 },  // 0xE6
+    { "???", MODE_NONE,             1, 2, 0 },  // 0xE7
+    { "INX", MODE_IMPLIED,          1, 2, 0 },  // 0xE8
+    { "SBC", MODE_IMMEDIATE,        2, 2, 0 },  // 0xE9
+    { "NOP", MODE_IMPLIED,          1, 2, 0 },  // 0xEA
+    { "???", MODE_NONE,             1, 2, 0 },  // 0xEB
+    { "CPX", MODE_ABSOLUTE,         3, 4, 0 },  // 0xEC
+    { "SBC", MODE_ABSOLUTE,         3, 4, 0 },  // 0xED
+    { "INC", MODE_ABSOLUTE,         3, 6, 0 },  // 0xEE
+    { "???", MODE_NONE,             1, 2, 0 },  // 0xEF
+    { "BEQ", MODE_RELATIVE,         2, 2, 1 },  // 0xF0
+    { "SBC", MODE_INDIRECT_INDEXED, 2, 5, 1 },  // 0xF1
+    { "???", MODE_NONE,             1, 2, 0 },  // 0xF2
+    { "???", MODE_NONE,             1, 2, 0 },  // 0xF3
+    { "???", MODE_NONE,             1, 2, 0 },  // 0xF4
+    { "SBC", MODE_ZERO_PAGE_X,      2, 4, 0 },  // 0xF5
+    { "INC", MODE_ZERO_PAGE_X,      2, 6, 0 },  // 0xF6
+    { "???", MODE_NONE,             1, 2, 0 },  // 0xF7
+    { "SED", MODE_IMPLIED,          1, 2, 0 },  // 0xF8
+    { "SBC", MODE_ABSOLUTE_Y,       3, 4, 1 },  // 0xF9
+    { "???", MODE_NONE,             1, 2, 0 },  // 0xFA
+    { "???", MODE_NONE,             1, 2, 0 },  // 0xFB
+    { "???", MODE_NONE,             1, 2, 0 },  // 0xFC
+    { "SBC", MODE_ABSOLUTE_X,       3, 4, 1 },  // 0xFD
+    { "INC", MODE_ABSOLUTE_X,       3, 7, 0 },  // 0xFE
+    { "???", MODE_NONE,             1, 2, 0 },  // 0xFF
+};
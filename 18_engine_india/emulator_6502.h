@@ -0,0 +1,339 @@
+#ifndef EMULATOR_6502
+#define EMULATOR_6502
+
+#include <stddef.h>  // for size_t
+
+// 6502 emulator shared declarations (see emulator_6502.cpp for the opcode
+// table, emulator_cpu.cpp for the CPU and emulator_assembler.cpp for the
+// assembler).
+
+// addressing modes
+enum ADDRESS_MODES {
+    MODE_NONE = 0,            // not an official opcode
+    MODE_IMPLIED,             // CLC
+    MODE_ACCUMULATOR,         // ASL A
+    MODE_IMMEDIATE,           // LDA #$10
+    MODE_ZERO_PAGE,           // LDA $10
+    MODE_ZERO_PAGE_X,         // LDA $10,X
+    MODE_ZERO_PAGE_Y,         // LDX $10,Y
+    MODE_ABSOLUTE,            // LDA $1234
+    MODE_ABSOLUTE_X,          // LDA $1234,X
+    MODE_ABSOLUTE_Y,          // LDA $1234,Y
+    MODE_INDIRECT,            // JMP ($1234)
+    MODE_INDEXED_INDIRECT,    // LDA ($10,X)
+    MODE_INDIRECT_INDEXED,    // LDA ($10),Y
+    MODE_RELATIVE,            // BNE label
+    NUM_ADDRESS_MODES
+};
+
+// registers
+typedef struct {
+    unsigned char   a;
+    unsigned char   x;
+    unsigned char   y;
+    unsigned short pc; //Program Counter;
+    unsigned char   s; //Stack Pointer
+    unsigned char   p; //Processor Status Register: N V - B D I Z C
+} CPU;
+
+// bits of p
+const unsigned char FLAG_C = 0x01;
+const unsigned char FLAG_Z = 0x02;
+const unsigned char FLAG_I = 0x04;
+const unsigned char FLAG_D = 0x08;
+const unsigned char FLAG_B = 0x10;
+const unsigned char FLAG_U = 0x20;   // always 1 when pushed
+const unsigned char FLAG_V = 0x40;
+const unsigned char FLAG_N = 0x80;
+
+// one entry per opcode byte, unofficial opcodes are "???" / MODE_NONE
+struct Opcode_Info {
+    const char*   mnemonic;
+    unsigned char mode;           // ADDRESS_MODES
+    unsigned char length;         // bytes, including the opcode
+    unsigned char cycles;         // base cycle count
+    unsigned char page_penalty;   // +1 cycle if an index crosses a page
+};
+extern const Opcode_Info OPCODES[256];
+
+// CPU core (emulator_cpu.cpp). Every address has a decoded op, filled in
+// the first time the CPU runs it and thrown away (a 256-byte page at a
+// time) when a store lands on code.
+struct Machine;
+struct Decoded_Op;
+typedef void (*Op_Handler)(Machine* v, const Decoded_Op* d);
+
+struct Decoded_Op {
+    Op_Handler     execute;       // NULL until decoded
+    unsigned short operand;       // immediate value, address, zero page
+                                  // pointer or branch target
+    unsigned char  opcode;
+    unsigned char  length;
+    unsigned char  cycles;
+    unsigned char  page_penalty;
+};
+
+struct Decode_Cache {
+    Decoded_Op    ops[65536];
+    unsigned char code_page[256]; // page has decoded ops that stores must
+                                  // invalidate
+};
+
+struct Block_Cache;
+
+// Memory bus. Each 256-byte page reads and writes either straight through
+// a pointer or through a device's handlers: a page with read == NULL calls
+// io_read, one with write == NULL calls io_write, or ignores the store if
+// there's no io_write either (ROM). Without a bus the CPU uses m[] alone.
+typedef unsigned char (*Io_Read)(void* device, unsigned short address);
+typedef void (*Io_Write)(void* device, unsigned short address,
+        unsigned char value);
+
+struct Bus_Page {
+    unsigned char* read;          // this page's 256 bytes, or NULL
+    unsigned char* write;
+    Io_Read        io_read;
+    Io_Write       io_write;
+    void*          device;
+};
+
+struct Memory_Bus {
+    Bus_Page pages[256];
+};
+
+// Profile of the code a machine runs (see emulator_profile.cpp). Cycles
+// include page crossing and branch penalties; reads and writes are the
+// data accesses instructions make, not opcode or operand fetches.
+struct Profile {
+    unsigned long long executions[65536];   // by the address of the opcode
+    unsigned long long cycles[65536];
+    unsigned long long opcodes[256];
+    unsigned int       reads[65536];
+    unsigned int       writes[65536];
+};
+
+// Debugger state (see emulator_debugger.cpp). A run stops before an
+// instruction at a breakpoint, or just after one that reads or writes a
+// watched address, and says why in stop_reason.
+const int TRACE_LENGTH = 64;              // power of 2
+
+const unsigned char WATCH_READ = 1;
+const unsigned char WATCH_WRITE = 2;
+
+enum STOP_REASONS {
+    STOP_NONE = 0,                // ran to the end or to max_cycles
+    STOP_BREAKPOINT,
+    STOP_WATCH_READ,
+    STOP_WATCH_WRITE
+};
+
+struct Trace_Entry {
+    CPU                cpu;       // before the instruction ran
+    unsigned char      opcode;
+    unsigned short     operand;   // as decoded (branches: the target)
+    unsigned long long cycles;
+};
+
+struct Debugger {
+    unsigned char      breakpoints[8192];     // bit per address
+    unsigned char      watch_reads[8192];
+    unsigned char      watch_writes[8192];
+    unsigned char      watch_pages[256];      // WATCH_READ/WATCH_WRITE if
+                                              // anything on the page is
+    bool               tracing;
+    Trace_Entry        trace[TRACE_LENGTH];   // ring, oldest overwritten
+    unsigned int       trace_count;           // ever recorded
+    int                stop_reason;
+    unsigned short     stop_address;          // breakpoint or watched address
+    unsigned char      stop_value;            // the byte read or written
+    int                ignore_breakpoint;     // address continued from, or -1
+    bool               resume;                // last run stopped part way
+};
+
+struct Machine {
+    CPU                cpu;
+    unsigned char*     m;         // 64KB
+    Memory_Bus*        bus;       // NULL for m[] alone
+    Profile*           profile;   // NULL when not profiling
+    Debugger*          debugger;  // NULL when not debugging
+    Decode_Cache*      cache;
+    Block_Cache*       blocks;    // NULL until run_6502_blocks() is used
+    unsigned long long cycles;
+    unsigned long long instructions;
+    unsigned char      stack_base;  // RTS with s here ends the run
+    bool               halted;
+};
+
+bool initialize_machine(Machine* v, unsigned char* m);
+void free_machine(Machine* v);
+unsigned long run_6502(Machine* v, unsigned long long max_cycles);
+unsigned char read_byte(Machine* v, unsigned short address);
+void write_byte(Machine* v, unsigned short address, unsigned char value);
+void invalidate_code_page(Machine* v, int page);
+void invalidate_decode_cache(Machine* v);  // after changing m[] directly
+
+// bus setup. Pages are mapped in runs starting at first_page; memory for
+// RAM and ROM is pages * 256 bytes. A bus starts as all RAM over m.
+// Remapping a bus the CPU has run code from needs invalidate_decode_cache().
+void initialize_bus(Memory_Bus* bus, unsigned char* m);
+void map_ram(Memory_Bus* bus, int first_page, int pages,
+        unsigned char* memory);
+void map_rom(Memory_Bus* bus, int first_page, int pages,
+        unsigned char* memory);
+void map_io(Memory_Bus* bus, int first_page, int pages, Io_Read io_read,
+        Io_Write io_write, void* device);
+void attach_bus(Machine* v, Memory_Bus* bus);    // NULL for m[] alone
+void map_pages(Memory_Bus* bus, int first_page, int pages,
+        unsigned char* read, unsigned char* write, Io_Read io_read,
+        Io_Write io_write, void* device);
+
+// profiling. While a profile is attached the CPU runs a counting copy of
+// every handler (the normal ones don't change), and run_6502_blocks() and
+// run_6502_aot() fall back to run_6502(). print_profile() lists the top
+// hot addresses, blocks, opcodes and data addresses, with a memory map.
+void attach_profile(Machine* v, Profile* profile);  // NULL to stop
+void print_profile(Machine* v, int top);
+
+// debugging. Like a profile, an attached debugger runs its own copy of the
+// handlers and the other run modes fall back to run_6502(). After a run
+// stops part way (a breakpoint, watchpoint or max_cycles), the next
+// run_6502() carries on from there: it doesn't count the stack from the
+// new position or stop again at the same breakpoint. run_6502(v, 1) steps
+// one instruction. Set resume to false to start a program over.
+void initialize_debugger(Debugger* g);
+void attach_debugger(Machine* v, Debugger* g);    // NULL to stop
+void set_breakpoint(Debugger* g, unsigned short address, bool on);
+void watch_memory(Debugger* g, unsigned short first, unsigned short last,
+        unsigned char kinds);                     // 0 to stop watching
+const Trace_Entry* trace_entry(const Debugger* g, int back);  // 0: newest
+void disassemble_trace_entry(const Trace_Entry* t, char* text, size_t size);
+void print_trace(Debugger* g, int count);
+void describe_stop(const Debugger* g, char* text, size_t size);
+
+// monitor view of a machine on the engine's textgrid: registers, why it
+// stopped, the trace, code from pc and memory around it
+// (emulator_monitor.cpp, only built with the engine)
+struct Symbol_Table;
+void draw_monitor(Machine* v, const Symbol_Table* symbols);  // can be NULL
+
+// snapshots (emulator_snapshot.cpp). A machine's memory can be kept as
+// 256 copy-on-write pages shared with any number of snapshots: taking a
+// snapshot copies no memory, restoring one is a swap of page pointers.
+// Snapshots can be restored into any Cow_Memory, not just the one they
+// were taken from.
+struct Cow_Page;
+
+struct Cow_Memory {
+    Memory_Bus   bus;
+    Machine*     v;
+    Cow_Page*    pages[256];
+    unsigned int dirty[8];        // bit per page written since the last
+                                  // snapshot or restore
+};
+
+struct Snapshot {
+    CPU                cpu;
+    unsigned long long cycles;
+    unsigned long long instructions;
+    Cow_Page*          pages[256];
+};
+
+// v must already be initialized; its memory starts as a copy of image (or
+// zeros) and v->m is no longer used
+bool initialize_cow_memory(Cow_Memory* cow, Machine* v,
+        const unsigned char* image);
+void free_cow_memory(Cow_Memory* cow);
+void take_snapshot(Cow_Memory* cow, Snapshot* s);
+void restore_snapshot(Cow_Memory* cow, const Snapshot* s);
+void free_snapshot(Snapshot* s);
+
+// used by the core and the block translator: the handlers for v's bus,
+// with flags or without (NULL where there's no such version)
+const Op_Handler* op_handlers(Machine* v, bool flags);
+const Decoded_Op* decode_at(Machine* v, unsigned short pc);
+void step_6502(Machine* v);
+
+// block translator (emulator_dynarec.cpp). Same results as run_6502(),
+// but straight-line runs of code are translated into blocks that run
+// without going back through the decode cache; flags nothing reads are
+// never computed. max_cycles is checked between blocks.
+unsigned long run_6502_blocks(Machine* v, unsigned long long max_cycles);
+void invalidate_blocks(Machine* v, int page);
+void reset_blocks(Machine* v);     // after invalidate_decode_cache(), for
+                                   // a different program
+void free_blocks(Machine* v);
+
+// what each opcode does with flags, control flow and memory, as used by
+// the block translator and tools/aot_translator.cpp
+extern unsigned char flags_written[256];
+extern unsigned char flags_read[256];
+extern bool          ends_block[256];
+extern bool          writes_memory[256];
+void build_block_tables(void);
+
+// assembler. Source is standard 6502 syntax (labels, expressions, .org,
+// .byte, .word, every addressing mode) plus the original format: a first
+// line holding only the load address, LDAIM/LDXIM/LDYIM for immediate
+// mode, and END.
+struct Asm_Result {
+    unsigned short start;         // first .org (where the program loads)
+    unsigned short end;           // one past the highest byte written
+    int            bytes;         // bytes written
+    int            lines;
+    int            errors;        // each one printed with its line number
+};
+bool assemble_source(const char* source, size_t length, unsigned char* m,
+        Asm_Result* result, Symbol_Table* symbols);     // symbols can be NULL
+bool assemble_file(const char* filename, unsigned char* m, Asm_Result* result,
+        Symbol_Table* symbols);
+
+// labels and constants kept from an assembly, for the disassembler. at[]
+// picks the name shown for an address: labels before constants, then the
+// first one defined. Names longer than MAX_SYMBOL_NAME are cut short.
+const int MAX_TABLE_SYMBOLS = 4096;
+const int MAX_SYMBOL_NAME = 31;
+struct Symbol_Table {
+    int            count;
+    unsigned short value[MAX_TABLE_SYMBOLS];
+    char           name[MAX_TABLE_SYMBOLS][MAX_SYMBOL_NAME + 1];
+    unsigned short at[65536];     // 1 + symbol named at an address, 0 if none
+};
+void clear_symbols(Symbol_Table* t);
+bool add_symbol(Symbol_Table* t, const char* name, int length, int value);
+const char* symbol_at(const Symbol_Table* t, unsigned short address);
+
+// disassembler (emulator_disassembler.cpp), driven by OPCODES[] like the
+// CPU and the assembler. Lines stream out of any address range into the
+// caller's Disasm_Line, so nothing is allocated or copied per line. With a
+// Symbol_Table, operand addresses that have a name show it and each line
+// carries the label for its own address.
+const int DISASM_TEXT_SIZE = 48;          // fits the longest name
+struct Disasm_Line {
+    unsigned short address;
+    unsigned char  length;
+    unsigned char  bytes[3];
+    const char*    label;                  // name at address, or NULL
+    char           text[DISASM_TEXT_SIZE]; // "LDA table,X"
+};
+struct Disassembler {
+    const unsigned char* m;                // NULL: read through v's bus
+    Machine*             v;
+    unsigned int         address;          // next line
+    unsigned int         end;              // one past the range, <= 65536
+    const Symbol_Table*  symbols;          // can be NULL
+};
+void start_disassembly(Disassembler* d, const unsigned char* m,
+        unsigned short first, unsigned int end, const Symbol_Table* symbols);
+void start_machine_disassembly(Disassembler* d, Machine* v,
+        unsigned short first, unsigned int end, const Symbol_Table* symbols);
+bool next_instruction(Disassembler* d, Disasm_Line* line);   // false at end
+int  disassemble_lines(Disassembler* d, Disasm_Line* lines, int count);
+int  format_instruction(const unsigned char* bytes, unsigned short address,
+        const Symbol_Table* symbols, char* text);  // DISASM_TEXT_SIZE bytes
+
+// one instruction as text ("LDA $1234,X"; branches show their target),
+// from its opcode and the two bytes after it. Returns the length.
+int disassemble_instruction(const unsigned char* bytes, unsigned short address,
+        char* text, size_t size);
+
+#endif
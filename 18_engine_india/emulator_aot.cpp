@@ -0,0 +1,113 @@
+//345678901234567890123456789012345678901234567890123456789012345678901234567890
+//       1         2         3         4         5         6         7         8
+// Filename: ../emulator_aot.cpp
+// Last Modified: Tue Oct 20, 2026  10:40AM
+//
+// Runs 6502 programs translated ahead of time by tools/aot_translator.cpp.
+//
+// A translated program is a list of C++ functions, one per basic block,
+// keyed by address. run_6502_aot() first checks that the bytes in memory
+// are the bytes that were translated (the same program is loaded at the
+// same address). Then, at each address, it calls the block translated for
+// it, or has the interpreter run one instruction if there isn't one, which
+// covers code reached through JMP (indirect) and code the program writes
+// for itself. If the program stores over its own translated code, the
+// block returns AOT_CODE_CHANGED and the rest of the run is interpreted.
+//
+// Interpreted instructions can store over translated code too. The pages
+// the translated code is on are marked as code pages in the decode cache,
+// so a store onto one clears the page's flag (see emulator_cpu.cpp); when
+// one has been cleared the translated bytes are checked again, and if they
+// changed the rest of the run is interpreted just the same.
+//
+// Build: run the translator on the .asm file, add the .cpp it writes to
+// OBJS, and declare "extern Aot_Program AOT_<name>;" where it's run.
+
+#include "emulator_aot.h"
+#include <stdlib.h>
+
+bool aot_code_matches(Machine* v, const Aot_Program* program) {
+
+    for(unsigned int a = program->code_low; a < program->code_high; a++) {
+        unsigned int offset = a - program->code_low;
+        if((program->code_map[offset >> 3] & (1 << (offset & 7))) &&
+                v->m[a] != program->code[offset])
+            return false;
+    }
+    return true;
+}
+
+// Marks the translated code's pages as code, false if a store has
+// cleared one since they were last marked
+bool mark_aot_pages(Machine* v, int first_page, int last_page) {
+
+    bool marked = true;
+    for(int page = first_page; page <= last_page; page++) {
+        if(v->cache->code_page[page] == 0)
+            marked = false;
+        v->cache->code_page[page] = 1;
+    }
+    return marked;
+}
+
+unsigned long run_6502_aot(Machine* v, Aot_Program* program,
+        unsigned long long max_cycles) {
+
+    //Machines on different threads can run the same program: each builds
+    //the table if there isn't one yet, and the first to publish its table
+    //wins (GCC builtins, as the Makefile builds with g++)
+    Aot_Block_Fn* lookup = __atomic_load_n(&program->lookup, __ATOMIC_ACQUIRE);
+    if(lookup == NULL) {
+        Aot_Block_Fn* table =
+            (Aot_Block_Fn*)calloc(65536, sizeof(Aot_Block_Fn));
+        if(table == NULL)
+            return run_6502(v, max_cycles);
+        for(int i = 0; i < program->num_blocks; i++)
+            table[program->blocks[i].address] = program->blocks[i].run;
+
+        if(__sync_bool_compare_and_swap(&program->lookup, NULL, table)) {
+            lookup = table;
+        } else {
+            free(table);
+            lookup = __atomic_load_n(&program->lookup, __ATOMIC_ACQUIRE);
+        }
+    }
+
+    //Translated code reads and writes m[] directly and has no hooks
+    if(v->bus != NULL || v->profile != NULL || v->debugger != NULL ||
+            aot_code_matches(v, program) == false)
+        return run_6502(v, max_cycles);
+
+    CPU* c = &v->cpu;
+    unsigned long long limit = v->cycles + max_cycles;
+    unsigned long long instructions = v->instructions;
+    int first_page = program->code_low >> 8;
+    int last_page = (program->code_high - 1) >> 8;
+
+    v->halted = false;
+    v->stack_base = c->s;
+    mark_aot_pages(v, first_page, last_page);
+
+    while(v->halted == false && v->cycles < limit) {
+
+        Aot_Block_Fn run = lookup[c->pc];
+        bool changed;
+        if(run == NULL) {
+            //A store onto a translated page (or data sharing one) clears
+            //its mark; only then are the bytes worth comparing
+            step_6502(v);
+            changed = mark_aot_pages(v, first_page, last_page) == false &&
+                aot_code_matches(v, program) == false;
+        } else {
+            changed = (run(v) == AOT_CODE_CHANGED);
+        }
+
+        if(changed) {
+            //Translated code no longer matches, interpret the rest
+            while(v->halted == false && v->cycles < limit)
+                step_6502(v);
+        }
+    }
+
+    return (unsigned long)(v->instructions - instructions);
+}
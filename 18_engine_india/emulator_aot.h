@@ -0,0 +1,136 @@
+#ifndef EMULATOR_AOT
+#define EMULATOR_AOT
+
+#include "emulator_6502.h"
+
+// Runtime for 6502 programs translated ahead of time into C++ by
+// tools/aot_translator.cpp (see emulator_aot.cpp). Generated files include
+// this header and nothing else.
+
+// what a translated block returns
+const int AOT_CONTINUE = 0;
+const int AOT_CODE_CHANGED = 1;     // stored into translated code, pc is
+                                    // just past the store
+
+typedef int (*Aot_Block_Fn)(Machine* v);
+
+struct Aot_Block {
+    unsigned short address;
+    Aot_Block_Fn   run;
+};
+
+struct Aot_Program {
+    const char*          name;
+    unsigned short       start;          // where the program was loaded
+    const Aot_Block*     blocks;         // sorted by address
+    int                  num_blocks;
+    unsigned short       code_low;       // translated bytes lie in
+    unsigned int         code_high;      // [code_low, code_high)
+    const unsigned char* code_map;       // bit per address in that range
+    const unsigned char* code;           // the bytes that were translated
+    Aot_Block_Fn*        lookup;         // 64K, built on first run (by
+                                         // any thread)
+};
+
+// Runs like run_6502(), using the translated blocks for as long as the
+// program's code in memory is the code that was translated, and the
+// interpreter for anything else (indirect jump targets that weren't found,
+// code built at run time, or everything after the program changes itself).
+unsigned long run_6502_aot(Machine* v, Aot_Program* program,
+        unsigned long long max_cycles);
+
+// helpers for generated code, flags work as in emulator_cpu.cpp
+
+inline unsigned char aot_nz(unsigned char p, unsigned char value) {
+    return (p & ~(FLAG_N | FLAG_Z)) | (value & FLAG_N) | (value ? 0 : FLAG_Z);
+}
+
+inline unsigned char aot_compare(unsigned char p, unsigned char reg,
+        unsigned char value) {
+    p = aot_nz(p, (unsigned char)(reg - value));
+    return (reg >= value) ? (p | FLAG_C) : (p & ~FLAG_C);
+}
+
+inline unsigned char aot_bit(unsigned char p, unsigned char a,
+        unsigned char value) {
+    return (p & ~(FLAG_N | FLAG_V | FLAG_Z)) | (value & (FLAG_N | FLAG_V)) |
+        ((a & value) ? 0 : FLAG_Z);
+}
+
+inline void aot_adc(unsigned char& a, unsigned char& p, unsigned char value) {
+
+    unsigned int carry = p & FLAG_C;
+    unsigned int sum = a + value + carry;
+    p = (~(a ^ value) & (a ^ sum) & 0x80) ? (p | FLAG_V) : (p & ~FLAG_V);
+
+    if(p & FLAG_D) {
+        unsigned int low = (a & 0x0F) + (value & 0x0F) + carry;
+        unsigned int high = (a & 0xF0) + (value & 0xF0);
+        if(low > 0x09)
+            low += 0x06;
+        if(low > 0x0F)
+            high += 0x10;
+        if(high > 0x90)
+            high += 0x60;
+        sum = (high & 0x1F0) | (low & 0x0F);
+    }
+
+    p = (sum > 0xFF) ? (p | FLAG_C) : (p & ~FLAG_C);
+    a = (unsigned char)sum;
+    p = aot_nz(p, a);
+}
+
+inline void aot_sbc(unsigned char& a, unsigned char& p, unsigned char value) {
+
+    unsigned int borrow = (p & FLAG_C) ? 0 : 1;
+    unsigned int difference = a - value - borrow;
+    p = ((a ^ value) & (a ^ difference) & 0x80) ? (p | FLAG_V) : (p & ~FLAG_V);
+    p = (difference < 0x100) ? (p | FLAG_C) : (p & ~FLAG_C);
+
+    if(p & FLAG_D) {
+        int low = (a & 0x0F) - (value & 0x0F) - (int)borrow;
+        int high = (a >> 4) - (value >> 4);
+        if(low < 0) {
+            low += 10;
+            high--;
+        }
+        if(high < 0)
+            high += 10;
+        difference = (high << 4) | (low & 0x0F);
+    }
+
+    a = (unsigned char)difference;
+    p = aot_nz(p, a);
+}
+
+inline unsigned char aot_shift(unsigned char& p, unsigned char value,
+        char kind) {
+
+    //kind: 'A'SL, 'L'SR, 'O' (ROL), 'R' (ROR); constant in generated code
+    unsigned char carry_in = p & FLAG_C;
+    unsigned char carry_out;
+    switch(kind) {
+        case 'A': carry_out = value >> 7; value <<= 1; break;
+        case 'L': carry_out = value & 1;  value >>= 1; break;
+        case 'O': carry_out = value >> 7; value = (value << 1) | carry_in; break;
+        default:  carry_out = value & 1;
+                  value = (value >> 1) | (carry_in << 7); break;
+    }
+    p = carry_out ? (p | FLAG_C) : (p & ~FLAG_C);
+    p = aot_nz(p, value);
+    return value;
+}
+
+// a store that isn't known to miss translated code: the interpreter's
+// decode cache is kept right, and the caller leaves the block if the
+// program just changed its own translated code
+inline bool aot_store(Machine* v, const Aot_Program* program,
+        unsigned short address, unsigned char value) {
+
+    write_byte(v, address, value);
+    unsigned int offset = (unsigned int)address - program->code_low;
+    return address >= program->code_low && address < program->code_high &&
+        (program->code_map[offset >> 3] & (1 << (offset & 7)));
+}
+
+#endif
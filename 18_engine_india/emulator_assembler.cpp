@@ -0,0 +1,908 @@
+//345678901234567890123456789012345678901234567890123456789012345678901234567890
+//       1         2         3         4         5         6         7         8
+// Filename: ../emulator_assembler.cpp
+// Last Modified: Tue Oct 20, 2026  10:10AM
+//
+// 6502 assembler.
+//
+// Source is read once, line by line, straight out of the buffer (no
+// copying, no strtok). Each line can have a label ("loop:", or just "loop"
+// in column 0 or in front of an instruction), an instruction or directive,
+// and a comment after ';'. CR, LF and CRLF line endings all work.
+//
+// Mnemonics are looked up without any string compares: the three letters
+// make a number from 0 to 26*26*26-1 that indexes a table built once from
+// OPCODES[], which gives a row of opcodes, one per addressing mode.
+// LDAIM/LDXIM/LDYIM (any mnemonic followed by "IM") are the original
+// format's immediate mode, and END stops assembly.
+//
+// Operands are expressions: decimal, $hex, %binary, 'c' characters,
+// labels, * (the current address), + - * / % & | ^ << >>, unary - ~,
+// < (low byte), > (high byte) and parentheses. The addressing mode comes
+// from the operand's shape: #imm, A, addr, addr,X, addr,Y, (addr),
+// (zp,X), (zp),Y. A plain address that's already known and under 256
+// uses zero page when the instruction has it, unless it's written with
+// an a: in front (LDA a:$10), as the disassembler does, which keeps the
+// absolute form.
+//
+// Labels that haven't been seen yet can't be evaluated when the line is
+// assembled, so the instruction is written with a placeholder (always the
+// absolute form) and a fixup is recorded. Once the whole file has been
+// read, the second pass evaluates every fixup's expression again with all
+// labels known and patches the bytes in.
+//
+// Directives: .org addr (or * = addr), .byte list, .word list, and
+// name = value (or name .equ value) for constants. A first line holding
+// nothing but a number is taken as .org, as in the original format.
+//
+// Errors are printed with their line number and assembly carries on, so
+// one run reports every mistake.
+//
+// Given a Symbol_Table, the labels and constants are copied into it at the
+// end (the names here point into the source, which the caller frees), for
+// the disassembler to show them.
+
+#include "emulator_6502.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+
+const int MAX_SYMBOLS = 8192;
+const int SYMBOL_SLOTS = 16384;            // power of 2, at most half full
+const int MAX_FIXUPS = 16384;
+const int MAX_PRINTED_ERRORS = 50;
+const int MNEMONIC_KEYS = 26 * 26 * 26;
+
+enum FIXUP_KINDS {
+    FIXUP_BYTE = 0,
+    FIXUP_WORD,
+    FIXUP_RELATIVE
+};
+
+struct Asm_Symbol {
+    const char* name;                      // points into the source
+    int         length;                    // 0 = empty slot
+    int         value;
+    int         order;                     // defined nth
+    bool        label;                     // false for a constant
+};
+
+struct Asm_Fixup {
+    unsigned short address;                // where the value goes
+    unsigned short pc;                     // value of * for the expression
+    unsigned char  kind;                   // FIXUP_KINDS
+    int            line;
+    const char*    expr;                   // points into the source
+    const char*    expr_end;
+};
+
+struct Asm_State {
+    unsigned char* m;
+    unsigned int   pc;
+    bool           org_seen;
+    int            line;
+    Asm_Result*    result;
+    Asm_Symbol     symbols[SYMBOL_SLOTS];
+    int            num_symbols;
+    Asm_Fixup      fixups[MAX_FIXUPS];
+    int            num_fixups;
+    const char*    expr_error;             // set by the expression parser
+};
+
+// Built once from OPCODES[]
+short mnemonic_index[MNEMONIC_KEYS];       // key -> row, -1 if none
+short opcode_for[64][NUM_ADDRESS_MODES];   // row, mode -> opcode, -1 if none
+bool  assembler_tables_ready = false;
+
+void build_assembler_tables(void);
+int  mnemonic_key(const char* s);
+int  find_mnemonic(const char* s, int length, bool* immediate_alias);
+void assemble_line(Asm_State* a, const char* s, const char* end,
+        bool column_0);
+void assemble_instruction(Asm_State* a, int row, bool immediate_alias,
+        const char* s, const char* end);
+void assemble_directive(Asm_State* a, const char* name, int length,
+        const char* s, const char* end);
+void resolve_fixups(Asm_State* a);
+void asm_error(Asm_State* a, int line, const char* format, ...);
+void asm_emit(Asm_State* a, int byte);
+void asm_emit_value(Asm_State* a, int kind, int value, bool known,
+        const char* expr, const char* expr_end, unsigned short pc);
+bool define_symbol(Asm_State* a, const char* name, int length, int value,
+        bool label);
+void export_symbols(Asm_State* a, Symbol_Table* t);
+Asm_Symbol* find_symbol(Asm_State* a, const char* name, int length);
+int  evaluate(Asm_State* a, const char* s, const char* end, bool* known);
+int  parse_binary(Asm_State* a, const char** p, const char* end, int level,
+        bool* known);
+int  parse_unary(Asm_State* a, const char** p, const char* end, bool* known);
+
+// Character helpers
+bool is_space(char c) { return c == ' ' || c == '\t'; }
+bool is_ident_start(char c) {
+    return (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') || c == '_' ||
+        c == '.' || c == '@';
+}
+bool is_ident(char c) {
+    return is_ident_start(c) || (c >= '0' && c <= '9');
+}
+char to_upper(char c) { return (c >= 'a' && c <= 'z') ? c - 32 : c; }
+const char* skip_spaces(const char* p, const char* end) {
+    while(p < end && is_space(*p))
+        p++;
+    return p;
+}
+const char* trim_end(const char* s, const char* end) {
+    while(end > s && is_space(end[-1]))
+        end--;
+    return end;
+}
+// Past a "string" or 'c' constant, so a ; or , in one isn't taken for a
+// comment or a separator. Only the quote that opened a string closes it.
+const char* skip_literal(const char* p, const char* end) {
+    char quote = *p;
+    if(quote == '\'' && end - p >= 3 && p[2] == '\'')
+        return p + 3;
+    p++;
+    while(p < end && *p != quote)
+        p++;
+    return (p < end) ? p + 1 : end;
+}
+
+bool assemble_file(const char* filename, unsigned char* m, Asm_Result* result,
+        Symbol_Table* symbols) {
+
+    FILE* f = fopen(filename, "rb");
+    if(f == NULL) {
+        printf(" ASM ERROR: unable to open %s\n", filename);
+        memset(result, 0, sizeof(Asm_Result));
+        result->errors = 1;
+        return false;
+    }
+
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+
+    char* source = (char*)malloc(size > 0 ? size : 1);
+    size_t got = fread(source, 1, size, f);
+    fclose(f);
+
+    bool ok = assemble_source(source, got, m, result, symbols);
+    free(source);
+    return ok;
+}
+
+bool assemble_source(const char* source, size_t length, unsigned char* m,
+        Asm_Result* result, Symbol_Table* symbols) {
+
+    if(assembler_tables_ready == false)
+        build_assembler_tables();
+
+    Asm_State* a = (Asm_State*)calloc(1, sizeof(Asm_State));
+    memset(result, 0, sizeof(Asm_Result));
+    if(a == NULL) {
+        printf(" ASM ERROR: out of memory\n");
+        result->errors = 1;
+        return false;
+    }
+    a->m = m;
+    a->result = result;
+
+    //Pass one: every line, in order
+    const char* p = source;
+    const char* end = source + length;
+    bool first_line = true;
+    while(p < end) {
+
+        const char* line_end = p;
+        while(line_end < end && *line_end != '\n' && *line_end != '\r')
+            line_end++;
+        a->line++;
+
+        //Comment
+        const char* code_end = p;
+        while(code_end < line_end && *code_end != ';') {
+            if(*code_end == '"' || *code_end == '\'')
+                code_end = skip_literal(code_end, line_end);
+            else
+                code_end++;
+        }
+        const char* s = skip_spaces(p, code_end);
+        code_end = trim_end(s, code_end);
+
+        if(s < code_end) {
+
+            //Original format: the first line is just the load address
+            const char* d = s;
+            while(d < code_end && *d >= '0' && *d <= '9')
+                d++;
+            if(first_line && d == code_end) {
+                a->pc = atoi(s);
+                a->org_seen = true;
+                result->start = (unsigned short)a->pc;
+            } else if(code_end - s == 3 && to_upper(s[0]) == 'E' &&
+                    to_upper(s[1]) == 'N' && to_upper(s[2]) == 'D') {
+                break;
+            } else {
+                assemble_line(a, s, code_end, s == p);
+            }
+            first_line = false;
+        }
+
+        //Next line (CRLF counts once)
+        p = line_end;
+        if(p < end && *p == '\r')
+            p++;
+        if(p < end && *p == '\n')
+            p++;
+    }
+    result->lines = a->line;
+
+    //Pass two: everything that referred to a label defined further down
+    resolve_fixups(a);
+
+    if(result->errors > MAX_PRINTED_ERRORS) {
+        printf(" ASM: %d more errors not shown\n",
+                result->errors - MAX_PRINTED_ERRORS);
+    }
+
+    if(symbols != NULL)
+        export_symbols(a, symbols);
+
+    bool ok = (result->errors == 0);
+    free(a);
+    return ok;
+}
+
+void build_assembler_tables(void) {
+
+    memset(mnemonic_index, 0xFF, sizeof(mnemonic_index));
+    memset(opcode_for, 0xFF, sizeof(opcode_for));
+
+    int rows = 0;
+    for(int op = 0; op < 256; op++) {
+        if(OPCODES[op].mode == MODE_NONE)
+            continue;
+        int key = mnemonic_key(OPCODES[op].mnemonic);
+        if(mnemonic_index[key] < 0)
+            mnemonic_index[key] = rows++;
+        opcode_for[mnemonic_index[key]][OPCODES[op].mode] = op;
+    }
+
+    assembler_tables_ready = true;
+}
+
+int mnemonic_key(const char* s) {
+
+    int key = 0;
+    for(int i = 0; i < 3; i++) {
+        char c = to_upper(s[i]);
+        if(c < 'A' || c > 'Z')
+            return -1;
+        key = key * 26 + (c - 'A');
+    }
+    return key;
+}
+
+int find_mnemonic(const char* s, int length, bool* immediate_alias) {
+
+    *immediate_alias = false;
+    if(length == 5 && to_upper(s[3]) == 'I' && to_upper(s[4]) == 'M')
+        *immediate_alias = true;
+    else if(length != 3)
+        return -1;
+
+    int key = mnemonic_key(s);
+    return (key < 0) ? -1 : mnemonic_index[key];
+}
+
+void assemble_line(Asm_State* a, const char* s, const char* end,
+        bool column_0) {
+
+    //"* = addr" sets the address, like .org
+    if(*s == '*') {
+        const char* q = skip_spaces(s + 1, end);
+        if(q < end && *q == '=') {
+            assemble_directive(a, ".org", 4, q + 1, end);
+            return;
+        }
+    }
+
+    if(is_ident_start(*s) == false) {
+        asm_error(a, a->line, "expected a label or instruction");
+        return;
+    }
+
+    const char* word = s;
+    while(s < end && is_ident(*s))
+        s++;
+    int length = (int)(s - word);
+    s = skip_spaces(s, end);
+
+    bool immediate_alias;
+    int row = (*word == '.') ? -1 : find_mnemonic(word, length, &immediate_alias);
+
+    //Label (or constant) in front of whatever follows
+    if(row < 0 && *word != '.') {
+
+        bool colon = (s < end && *s == ':');
+        if(colon)
+            s = skip_spaces(s + 1, end);
+
+        if(s < end && *s == '=') {
+            assemble_directive(a, word, length, s + 1, end);   // constant
+            return;
+        }
+        if(end - s >= 4 && strncmp(s, ".equ", 4) == 0 && !is_ident(s[4])) {
+            assemble_directive(a, word, length, s + 4, end);
+            return;
+        }
+
+        //Without a colon it's only a label in column 0 or in front of an
+        //instruction; an indented RTSS on its own is a typo
+        if(s == end) {
+            if(colon || column_0)
+                define_symbol(a, word, length, a->pc, true);
+            else
+                asm_error(a, a->line, "unknown instruction '%.*s'", length, word);
+            return;
+        }
+
+        const char* label = word;
+        int label_length = length;
+        word = s;
+        while(s < end && is_ident(*s))
+            s++;
+        length = (int)(s - word);
+        s = skip_spaces(s, end);
+        row = (*word == '.') ? -1 : find_mnemonic(word, length, &immediate_alias);
+
+        //FOO 1 is an unknown FOO, not a label FOO and an unknown 1
+        if(colon == false && row < 0 && *word != '.') {
+            asm_error(a, a->line, "unknown instruction '%.*s'", label_length,
+                label);
+            return;
+        }
+        define_symbol(a, label, label_length, a->pc, true);
+        if(length == 0) {
+            asm_error(a, a->line, "unknown instruction '%.*s'",
+                (int)(end - word), word);
+            return;
+        }
+    }
+
+    if(*word == '.') {
+        assemble_directive(a, word, length, s, end);
+    } else if(row >= 0) {
+        assemble_instruction(a, row, immediate_alias, s, end);
+    } else {
+        asm_error(a, a->line, "unknown instruction '%.*s'", length, word);
+    }
+}
+
+void assemble_instruction(Asm_State* a, int row, bool immediate_alias,
+        const char* s, const char* end) {
+
+    const short* ops = opcode_for[row];
+    unsigned short pc = (unsigned short)a->pc;   // * in the operand
+    int mode = MODE_NONE;
+    bool force_absolute = false;
+    const char* expr = s;
+    const char* expr_end = end;
+
+    //Work out the addressing mode from the operand's shape
+    if(immediate_alias) {
+        mode = MODE_IMMEDIATE;
+    } else if(s == end) {
+        mode = (ops[MODE_IMPLIED] >= 0) ? MODE_IMPLIED : MODE_ACCUMULATOR;
+    } else if(end - s == 1 && to_upper(*s) == 'A' && ops[MODE_ACCUMULATOR] >= 0) {
+        mode = MODE_ACCUMULATOR;
+    } else if(*s == '#') {
+        mode = MODE_IMMEDIATE;
+        expr = s + 1;
+    } else {
+
+        if(end - s > 2 && to_upper(s[0]) == 'A' && s[1] == ':') {
+            force_absolute = true;
+            s = skip_spaces(s + 2, end);
+            expr = s;
+        }
+
+        //Trailing ,X or ,Y
+        int index = 0;
+        const char* e = end;
+        if(e - s >= 2 && (to_upper(e[-1]) == 'X' || to_upper(e[-1]) == 'Y')) {
+            const char* comma = trim_end(s, e - 1);
+            if(comma > s && comma[-1] == ',') {
+                index = to_upper(e[-1]);
+                e = trim_end(s, comma - 1);
+            }
+        }
+
+        if(*s == '(' && index == 0 && e[-1] == ')' &&
+                ops[MODE_INDEXED_INDIRECT] >= 0) {
+            //(zp,X): the ,X is inside the parentheses
+            const char* inner = trim_end(s, e - 1);
+            if(inner - s >= 2 && to_upper(inner[-1]) == 'X') {
+                const char* comma = trim_end(s, inner - 1);
+                if(comma > s && comma[-1] == ',') {
+                    mode = MODE_INDEXED_INDIRECT;
+                    expr = s + 1;
+                    expr_end = comma - 1;
+                }
+            }
+        }
+        if(mode == MODE_NONE && *s == '(' && e[-1] == ')' && index != 'X' &&
+                (ops[MODE_INDIRECT] >= 0 || ops[MODE_INDIRECT_INDEXED] >= 0)) {
+            //(addr) or (zp),Y
+            mode = (index == 'Y') ? MODE_INDIRECT_INDEXED : MODE_INDIRECT;
+            expr = s + 1;
+            expr_end = e - 1;
+        }
+
+        if(mode == MODE_NONE) {
+            expr_end = e;
+            if(index == 'X')
+                mode = MODE_ABSOLUTE_X;
+            else if(index == 'Y')
+                mode = MODE_ABSOLUTE_Y;
+            else if(ops[MODE_RELATIVE] >= 0)
+                mode = MODE_RELATIVE;
+            else
+                mode = MODE_ABSOLUTE;
+        }
+    }
+
+    bool known = true;
+    int value = 0;
+    if(mode != MODE_IMPLIED && mode != MODE_ACCUMULATOR)
+        value = evaluate(a, expr, expr_end, &known);
+    if(a->expr_error != NULL) {
+        asm_error(a, a->line, "%s", a->expr_error);
+        return;
+    }
+
+    //Use zero page if the address is known to fit, or if there's no
+    //absolute form to fall back on (STX zp,Y and STY zp,X)
+    bool small = known && value >= 0 && value < 256 && force_absolute == false;
+    if(mode == MODE_ABSOLUTE && ops[MODE_ZERO_PAGE] >= 0 &&
+            (small || ops[MODE_ABSOLUTE] < 0))
+        mode = MODE_ZERO_PAGE;
+    if(mode == MODE_ABSOLUTE_X && ops[MODE_ZERO_PAGE_X] >= 0 &&
+            (small || ops[MODE_ABSOLUTE_X] < 0))
+        mode = MODE_ZERO_PAGE_X;
+    if(mode == MODE_ABSOLUTE_Y && ops[MODE_ZERO_PAGE_Y] >= 0 &&
+            (small || ops[MODE_ABSOLUTE_Y] < 0))
+        mode = MODE_ZERO_PAGE_Y;
+
+    if(ops[mode] < 0) {
+        asm_error(a, a->line, "addressing mode not available for this instruction");
+        return;
+    }
+
+    asm_emit(a, ops[mode]);
+    switch(OPCODES[ops[mode]].length) {
+        case 2:
+            asm_emit_value(a, (mode == MODE_RELATIVE) ? FIXUP_RELATIVE : FIXUP_BYTE,
+                    value, known, expr, expr_end, pc);
+            break;
+        case 3:
+            asm_emit_value(a, FIXUP_WORD, value, known, expr, expr_end, pc);
+            break;
+    }
+}
+
+void assemble_directive(Asm_State* a, const char* name, int length,
+        const char* s, const char* end) {
+
+    s = skip_spaces(s, end);
+    bool known = true;
+
+    if(*name != '.') {
+        //name = value
+        int value = evaluate(a, s, end, &known);
+        if(a->expr_error != NULL)
+            asm_error(a, a->line, "%s", a->expr_error);
+        else if(known == false)
+            asm_error(a, a->line, "constant must only use labels defined above it");
+        else
+            define_symbol(a, name, length, value, false);
+        return;
+    }
+
+    if(length == 4 && strncmp(name, ".org", 4) == 0) {
+        int value = evaluate(a, s, end, &known);
+        if(a->expr_error != NULL || known == false || value < 0 || value > 0xFFFF) {
+            asm_error(a, a->line, ".org needs an address known at this point");
+            return;
+        }
+        a->pc = value;
+        if(a->org_seen == false)
+            a->result->start = (unsigned short)value;
+        a->org_seen = true;
+        return;
+    }
+
+    bool is_byte = (length == 5 && strncmp(name, ".byte", 5) == 0);
+    bool is_word = (length == 5 && strncmp(name, ".word", 5) == 0);
+    if(is_byte == false && is_word == false) {
+        asm_error(a, a->line, "unknown directive '%.*s'", length, name);
+        return;
+    }
+
+    //Comma separated list; .byte also takes "strings"
+    while(s < end) {
+
+        const char* item = s;
+        while(s < end && *s != ',') {
+            if(*s == '"' || *s == '\'')
+                s = skip_literal(s, end);
+            else
+                s++;
+        }
+        const char* item_end = trim_end(item, s);
+
+        if(is_byte && *item == '"' && item_end - item >= 2 && item_end[-1] == '"') {
+            for(const char* c = item + 1; c < item_end - 1; c++)
+                asm_emit(a, (unsigned char)*c);
+        } else {
+            unsigned short pc = (unsigned short)a->pc;
+            int value = evaluate(a, item, item_end, &known);
+            if(a->expr_error != NULL) {
+                asm_error(a, a->line, "%s", a->expr_error);
+                return;
+            }
+            asm_emit_value(a, is_byte ? FIXUP_BYTE : FIXUP_WORD, value, known,
+                    item, item_end, pc);
+        }
+
+        if(s < end)
+            s = skip_spaces(s + 1, end);   // past the comma
+    }
+}
+
+void asm_emit(Asm_State* a, int byte) {
+
+    if(a->pc > 0xFFFF) {
+        if(a->pc == 0x10000)
+            asm_error(a, a->line, "program runs past the end of memory");
+        a->pc++;
+        return;
+    }
+
+    a->m[a->pc++] = (unsigned char)byte;
+    a->result->bytes++;
+    if(a->pc > a->result->end)
+        a->result->end = (unsigned short)((a->pc > 0xFFFF) ? 0xFFFF : a->pc);
+}
+
+void asm_emit_value(Asm_State* a, int kind, int value, bool known,
+        const char* expr, const char* expr_end, unsigned short pc) {
+
+    unsigned int address = a->pc;
+
+    if(known == false) {
+        //Placeholder now, real value in pass two
+        if(a->num_fixups == MAX_FIXUPS) {
+            asm_error(a, a->line, "too many forward references");
+        } else {
+            Asm_Fixup* f = &a->fixups[a->num_fixups++];
+            f->address = (unsigned short)address;
+            f->pc = pc;
+            f->kind = kind;
+            f->line = a->line;
+            f->expr = expr;
+            f->expr_end = expr_end;
+        }
+        value = 0;
+        if(kind == FIXUP_RELATIVE)
+            value = address + 1;       // offset of 0
+    }
+
+    if(kind == FIXUP_RELATIVE) {
+        int offset = value - (int)(address + 1);
+        if(known && (offset < -128 || offset > 127))
+            asm_error(a, a->line, "branch out of range (%d bytes)", offset);
+        asm_emit(a, offset & 0xFF);
+    } else if(kind == FIXUP_BYTE) {
+        if(known && (value < -128 || value > 255))
+            asm_error(a, a->line, "value %d doesn't fit in a byte", value);
+        asm_emit(a, value & 0xFF);
+    } else {
+        asm_emit(a, value & 0xFF);
+        asm_emit(a, (value >> 8) & 0xFF);
+    }
+}
+
+void resolve_fixups(Asm_State* a) {
+
+    for(int i = 0; i < a->num_fixups; i++) {
+
+        Asm_Fixup* f = &a->fixups[i];
+        bool known = true;
+        unsigned int saved_pc = a->pc;
+        a->pc = f->pc;
+        int value = evaluate(a, f->expr, f->expr_end, &known);
+        a->pc = saved_pc;
+
+        if(a->expr_error != NULL || known == false) {
+            asm_error(a, f->line, "undefined label in '%.*s'",
+                    (int)(f->expr_end - f->expr), f->expr);
+            continue;
+        }
+
+        unsigned char* m = a->m;
+        if(f->kind == FIXUP_RELATIVE) {
+            int offset = value - (int)(f->address + 1);
+            if(offset < -128 || offset > 127)
+                asm_error(a, f->line, "branch out of range (%d bytes)", offset);
+            m[f->address] = offset & 0xFF;
+        } else if(f->kind == FIXUP_BYTE) {
+            if(value < -128 || value > 255)
+                asm_error(a, f->line, "value %d doesn't fit in a byte", value);
+            m[f->address] = value & 0xFF;
+        } else {
+            m[f->address] = value & 0xFF;
+            m[(unsigned short)(f->address + 1)] = (value >> 8) & 0xFF;
+        }
+    }
+}
+
+void asm_error(Asm_State* a, int line, const char* format, ...) {
+
+    a->result->errors++;
+    a->expr_error = NULL;
+    if(a->result->errors > MAX_PRINTED_ERRORS)
+        return;
+
+    char message[256];
+    va_list args;
+    va_start(args, format);
+    vsnprintf(message, sizeof(message), format, args);
+    va_end(args);
+    printf(" ASM ERROR (line %d): %s\n", line, message);
+}
+
+// SYMBOLS ////////////////////////////////////////////////////////////////////
+
+unsigned int hash_name(const char* name, int length) {
+
+    //FNV-1a
+    unsigned int h = 2166136261u;
+    for(int i = 0; i < length; i++) {
+        h ^= (unsigned char)name[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+Asm_Symbol* find_symbol(Asm_State* a, const char* name, int length) {
+
+    unsigned int i = hash_name(name, length) & (SYMBOL_SLOTS - 1);
+    while(a->symbols[i].length != 0) {
+        if(a->symbols[i].length == length &&
+                memcmp(a->symbols[i].name, name, length) == 0)
+            return &a->symbols[i];
+        i = (i + 1) & (SYMBOL_SLOTS - 1);
+    }
+    return NULL;
+}
+
+bool define_symbol(Asm_State* a, const char* name, int length, int value,
+        bool label) {
+
+    if(find_symbol(a, name, length) != NULL) {
+        asm_error(a, a->line, "'%.*s' is already defined", length, name);
+        return false;
+    }
+    if(a->num_symbols == MAX_SYMBOLS) {
+        asm_error(a, a->line, "too many labels");
+        return false;
+    }
+
+    unsigned int i = hash_name(name, length) & (SYMBOL_SLOTS - 1);
+    while(a->symbols[i].length != 0)
+        i = (i + 1) & (SYMBOL_SLOTS - 1);
+    a->symbols[i].name = name;
+    a->symbols[i].length = length;
+    a->symbols[i].value = value;
+    a->symbols[i].order = a->num_symbols++;
+    a->symbols[i].label = label;
+    return true;
+}
+
+void export_symbols(Asm_State* a, Symbol_Table* t) {
+
+    //Back into the order they were defined, out of the hash table
+    Asm_Symbol* defined[MAX_SYMBOLS];
+    for(int i = 0; i < SYMBOL_SLOTS; i++) {
+        if(a->symbols[i].length != 0)
+            defined[a->symbols[i].order] = &a->symbols[i];
+    }
+
+    //Labels first, so they're the names shown for their addresses
+    clear_symbols(t);
+    for(int pass = 0; pass < 2; pass++) {
+        for(int i = 0; i < a->num_symbols; i++) {
+            Asm_Symbol* symbol = defined[i];
+            if(symbol->label == (pass == 0) &&
+                    add_symbol(t, symbol->name, symbol->length,
+                        symbol->value) == false)
+                return;            // the table's full: keep the ones in it
+        }
+    }
+}
+
+// EXPRESSIONS ////////////////////////////////////////////////////////////////
+
+int evaluate(Asm_State* a, const char* s, const char* end, bool* known) {
+
+    //known comes back false if a label isn't defined (yet)
+    *known = true;
+    a->expr_error = NULL;
+    if(skip_spaces(s, end) == end) {
+        a->expr_error = "missing operand";
+        return 0;
+    }
+
+    const char* p = s;
+    int value = parse_binary(a, &p, end, 0, known);
+    p = skip_spaces(p, end);
+    if(a->expr_error == NULL && p != end)
+        a->expr_error = "unexpected characters in expression";
+    return value;
+}
+
+int parse_binary(Asm_State* a, const char** p, const char* end, int level,
+        bool* known) {
+
+    //Lowest precedence first: | ^ & (<< >>) (+ -) (* / %)
+    if(level == 6)
+        return parse_unary(a, p, end, known);
+
+    int left = parse_binary(a, p, end, level + 1, known);
+    while(a->expr_error == NULL) {
+
+        const char* q = skip_spaces(*p, end);
+        if(q == end)
+            break;
+
+        int op = 0;
+        int op_length = 1;
+        switch(level) {
+            case 0: if(*q == '|') op = '|'; break;
+            case 1: if(*q == '^') op = '^'; break;
+            case 2: if(*q == '&') op = '&'; break;
+            case 3:
+                if(end - q >= 2 && q[0] == '<' && q[1] == '<') op = 'l';
+                if(end - q >= 2 && q[0] == '>' && q[1] == '>') op = 'r';
+                op_length = 2;
+                break;
+            case 4: if(*q == '+' || *q == '-') op = *q; break;
+            case 5: if(*q == '*' || *q == '/' || *q == '%') op = *q; break;
+        }
+        if(op == 0)
+            break;
+
+        *p = q + op_length;
+        int right = parse_binary(a, p, end, level + 1, known);
+        switch(op) {
+            case '|': left |= right; break;
+            case '^': left ^= right; break;
+            case '&': left &= right; break;
+            case 'l': left <<= right; break;
+            case 'r': left >>= right; break;
+            case '+': left += right; break;
+            case '-': left -= right; break;
+            case '*': left *= right; break;
+            case '/':
+            case '%':
+                if(right == 0) {
+                    //Only an error once every label is known
+                    if(*known)
+                        a->expr_error = "division by zero";
+                    left = 0;
+                } else {
+                    left = (op == '/') ? left / right : left % right;
+                }
+                break;
+        }
+    }
+    return left;
+}
+
+int parse_unary(Asm_State* a, const char** p, const char* end, bool* known) {
+
+    const char* q = skip_spaces(*p, end);
+    if(q == end) {
+        a->expr_error = "expression ends too soon";
+        return 0;
+    }
+
+    int value = 0;
+    char c = *q;
+
+    if(c == '-' || c == '+' || c == '~' || c == '<' || c == '>') {
+        *p = q + 1;
+        value = parse_unary(a, p, end, known);
+        switch(c) {
+            case '-': return -value;
+            case '~': return ~value;
+            case '<': return value & 0xFF;
+            case '>': return (value >> 8) & 0xFF;
+        }
+        return value;
+    }
+
+    if(c == '(') {
+        *p = q + 1;
+        value = parse_binary(a, p, end, 0, known);
+        q = skip_spaces(*p, end);
+        if(q == end || *q != ')') {
+            if(a->expr_error == NULL)
+                a->expr_error = "missing ')'";
+            return 0;
+        }
+        *p = q + 1;
+        return value;
+    }
+
+    if(c == '*') {
+        *p = q + 1;
+        return (int)a->pc;
+    }
+
+    if(c == '\'') {
+        if(end - q < 3 || q[2] != '\'') {
+            a->expr_error = "bad character constant";
+            return 0;
+        }
+        *p = q + 3;
+        return (unsigned char)q[1];
+    }
+
+    if(c == '$' || c == '%' || (c >= '0' && c <= '9')) {
+        int base = (c == '$') ? 16 : (c == '%') ? 2 : 10;
+        if(base != 10)
+            q++;
+        const char* digits = q;
+        while(q < end) {
+            int d;
+            char u = to_upper(*q);
+            if(u >= '0' && u <= '9')
+                d = u - '0';
+            else if(u >= 'A' && u <= 'F')
+                d = u - 'A' + 10;
+            else
+                break;
+            if(d >= base)
+                break;
+            value = value * base + d;
+            q++;
+        }
+        if(q == digits) {
+            a->expr_error = "bad number";
+            return 0;
+        }
+        *p = q;
+        return value;
+    }
+
+    if(is_ident_start(c)) {
+        const char* name = q;
+        while(q < end && is_ident(*q))
+            q++;
+        *p = q;
+        Asm_Symbol* symbol = find_symbol(a, name, (int)(q - name));
+        if(symbol == NULL) {
+            *known = false;
+            return 0;
+        }
+        return symbol->value;
+    }
+
+    a->expr_error = "bad expression";
+    return 0;
+}
@@ -0,0 +1,1276 @@
+//345678901234567890123456789012345678901234567890123456789012345678901234567890
+//       1         2         3         4         5         6         7         8
+// Filename: ../emulator_cpu.cpp
+// Last Modified: Tue Oct 20, 2026  06:00AM
+//
+// 6502 CPU core with a predecode cache.
+//
+// The first time the CPU reaches an address, the opcode there is decoded
+// once into a Decoded_Op: its handler, its operand already put together
+// (immediate value, address, zero page pointer, or for branches the target
+// address), its length and its cycle count. After that, running the
+// instruction is a table read and one call; the opcode and operand bytes
+// aren't looked at again.
+//
+// Each addressing mode and each register is a template argument of the
+// handler, so LDA ($10),Y and LDX $1234 are separate little functions with
+// nothing left to decide at run time beyond the effective address.
+//
+// Self-modifying code: decoding marks every page the instruction's bytes
+// sit on as a code page. Any store (write_byte(), which every handler and
+// the stack use) onto a code page throws away that page's decoded ops,
+// plus the two just before it in case an instruction starts on the
+// previous page and runs into this one, and they're decoded again when
+// they're next run. Code that changes m[] directly, without the CPU, has
+// to call invalidate_decode_cache() (or invalidate_code_page()) itself.
+//
+// Memory is either m[] and nothing else, or a Memory_Bus: a table of 256
+// pages, each a pointer to RAM or ROM or a pair of I/O handlers. Every
+// handler is a template on which of the two it reads and writes through
+// (Ram_Bus or Paged_Bus below), and there's a handler table for each, so a
+// program with no bus attached still compiles down to plain m[] accesses.
+//
+// Profiling and debugging work the same way: Profiled_Bus and Debug_Bus
+// wrap either bus to count or watch data accesses, and run_loop() takes a
+// HOOKS policy that counts each instruction, or checks breakpoints and
+// records the trace. There's nothing left of any of it in the code that
+// runs when neither is attached.
+//
+// A run ends at the RTS that returns from the level it started on (the
+// stack pointer is back where it was), at a BRK when no IRQ vector has
+// been set up at $FFFE, or when max_cycles is used up. Unofficial opcodes
+// do nothing and take a byte, as they always have here.
+
+#include "emulator_6502.h"
+#include <stdlib.h>
+#include <string.h>
+
+enum REGISTERS {
+    REG_A = 0,
+    REG_X,
+    REG_Y,
+    REG_S
+};
+
+template<int REG> inline unsigned char& register_of(CPU* c) {
+    return (REG == REG_A) ? c->a : (REG == REG_X) ? c->x :
+        (REG == REG_Y) ? c->y : c->s;
+}
+
+inline void set_nz(CPU* c, unsigned char value) {
+    c->p = (c->p & ~(FLAG_N | FLAG_Z)) | (value & FLAG_N) |
+        (value ? 0 : FLAG_Z);
+}
+
+inline void set_flag(CPU* c, unsigned char flag, bool on) {
+    c->p = on ? (c->p | flag) : (c->p & ~flag);
+}
+
+// MEMORY /////////////////////////////////////////////////////////////////////
+
+// Every handler that touches memory is a template on one of these, chosen
+// by whether the machine has a Memory_Bus attached. Ram_Bus is m[] and
+// nothing else; Paged_Bus goes through the bus's page table.
+
+struct Ram_Bus {
+    static unsigned char read(Machine* v, unsigned short address) {
+        return v->m[address];
+    }
+    static void write(Machine* v, unsigned short address, unsigned char value) {
+        v->m[address] = value;
+        if(v->cache->code_page[address >> 8])
+            invalidate_code_page(v, address >> 8);
+    }
+};
+
+struct Paged_Bus {
+    static unsigned char read(Machine* v, unsigned short address) {
+        const Bus_Page* page = &v->bus->pages[address >> 8];
+        if(page->read != NULL)
+            return page->read[address & 0xFF];
+        return page->io_read(page->device, address);
+    }
+    static void write(Machine* v, unsigned short address, unsigned char value) {
+        const Bus_Page* page = &v->bus->pages[address >> 8];
+        if(page->write != NULL) {
+            page->write[address & 0xFF] = value;
+            if(v->cache->code_page[address >> 8])
+                invalidate_code_page(v, address >> 8);
+        } else if(page->io_write != NULL) {
+            page->io_write(page->device, address, value);
+        }
+    }
+};
+
+// Counts each access into the machine's profile on the way through
+template<class BUS> struct Profiled_Bus {
+    static unsigned char read(Machine* v, unsigned short address) {
+        v->profile->reads[address]++;
+        return BUS::read(v, address);
+    }
+    static void write(Machine* v, unsigned short address, unsigned char value) {
+        v->profile->writes[address]++;
+        BUS::write(v, address, value);
+    }
+};
+
+// Stops the run after this instruction if the address is watched. Only
+// pages with a watched address need the per-address test.
+template<class BUS> struct Debug_Bus {
+    static unsigned char read(Machine* v, unsigned short address) {
+        unsigned char value = BUS::read(v, address);
+        Debugger* g = v->debugger;
+        if((g->watch_pages[address >> 8] & WATCH_READ) &&
+                (g->watch_reads[address >> 3] & (1 << (address & 7))))
+            stop_at_watch(g, STOP_WATCH_READ, address, value);
+        return value;
+    }
+    static void write(Machine* v, unsigned short address, unsigned char value) {
+        Debugger* g = v->debugger;
+        if((g->watch_pages[address >> 8] & WATCH_WRITE) &&
+                (g->watch_writes[address >> 3] & (1 << (address & 7))))
+            stop_at_watch(g, STOP_WATCH_WRITE, address, value);
+        BUS::write(v, address, value);
+    }
+    static void stop_at_watch(Debugger* g, int reason, unsigned short address,
+            unsigned char value) {
+        if(g->stop_reason == STOP_NONE) {
+            g->stop_reason = reason;
+            g->stop_address = address;
+            g->stop_value = value;
+        }
+    }
+};
+
+unsigned char read_byte(Machine* v, unsigned short address) {
+    return (v->bus == NULL) ? Ram_Bus::read(v, address) :
+        Paged_Bus::read(v, address);
+}
+
+void write_byte(Machine* v, unsigned short address, unsigned char value) {
+    if(v->bus == NULL)
+        Ram_Bus::write(v, address, value);
+    else
+        Paged_Bus::write(v, address, value);
+}
+
+template<class BUS> inline void push(Machine* v, unsigned char value) {
+    BUS::write(v, 0x0100 | v->cpu.s, value);
+    v->cpu.s--;
+}
+
+template<class BUS> inline unsigned char pull(Machine* v) {
+    v->cpu.s++;
+    return BUS::read(v, 0x0100 | v->cpu.s);
+}
+
+// ADDRESSING /////////////////////////////////////////////////////////////////
+
+// MODE is a constant, so each instantiation keeps only its own case
+template<class BUS, int MODE> inline unsigned short address_of(Machine* v,
+        const Decoded_Op* d) {
+
+    unsigned short address = 0;
+    unsigned short base;
+    unsigned char zp;
+
+    switch(MODE) {
+        case MODE_ZERO_PAGE:
+        case MODE_ABSOLUTE:
+            address = d->operand;
+            break;
+        case MODE_ZERO_PAGE_X:
+            address = (d->operand + v->cpu.x) & 0xFF;
+            break;
+        case MODE_ZERO_PAGE_Y:
+            address = (d->operand + v->cpu.y) & 0xFF;
+            break;
+        case MODE_ABSOLUTE_X:
+        case MODE_ABSOLUTE_Y:
+            base = d->operand;
+            address = base + ((MODE == MODE_ABSOLUTE_X) ? v->cpu.x : v->cpu.y);
+            if(d->page_penalty && ((address ^ base) & 0xFF00))
+                v->cycles++;
+            break;
+        case MODE_INDEXED_INDIRECT:
+            zp = (unsigned char)(d->operand + v->cpu.x);
+            address = BUS::read(v, zp) |
+                (BUS::read(v, (unsigned char)(zp + 1)) << 8);
+            break;
+        case MODE_INDIRECT_INDEXED:
+            zp = (unsigned char)d->operand;
+            base = BUS::read(v, zp) |
+                (BUS::read(v, (unsigned char)(zp + 1)) << 8);
+            address = base + v->cpu.y;
+            if(d->page_penalty && ((address ^ base) & 0xFF00))
+                v->cycles++;
+            break;
+    }
+    return address;
+}
+
+template<class BUS, int MODE> inline unsigned char read_operand(Machine* v,
+        const Decoded_Op* d) {
+
+    if(MODE == MODE_IMMEDIATE)
+        return (unsigned char)d->operand;
+    return BUS::read(v, address_of<BUS, MODE>(v, d));
+}
+
+// OPERATIONS /////////////////////////////////////////////////////////////////
+
+// FLAGS = false versions leave p alone, for when nothing reads the flags
+// before they're set again (see emulator_dynarec.cpp)
+
+template<bool FLAGS> void alu_ORA(CPU* c, unsigned char value) {
+    c->a |= value;
+    if(FLAGS)
+        set_nz(c, c->a);
+}
+template<bool FLAGS> void alu_AND(CPU* c, unsigned char value) {
+    c->a &= value;
+    if(FLAGS)
+        set_nz(c, c->a);
+}
+template<bool FLAGS> void alu_EOR(CPU* c, unsigned char value) {
+    c->a ^= value;
+    if(FLAGS)
+        set_nz(c, c->a);
+}
+void alu_none(CPU* c, unsigned char value) {}
+
+void alu_BIT(CPU* c, unsigned char value) {
+    c->p = (c->p & ~(FLAG_N | FLAG_V | FLAG_Z)) | (value & (FLAG_N | FLAG_V)) |
+        ((c->a & value) ? 0 : FLAG_Z);
+}
+
+void compare(CPU* c, unsigned char reg, unsigned char value) {
+    set_flag(c, FLAG_C, reg >= value);
+    set_nz(c, (unsigned char)(reg - value));
+}
+void alu_CMP(CPU* c, unsigned char value) { compare(c, c->a, value); }
+void alu_CPX(CPU* c, unsigned char value) { compare(c, c->x, value); }
+void alu_CPY(CPU* c, unsigned char value) { compare(c, c->y, value); }
+
+void alu_ADC(CPU* c, unsigned char value) {
+
+    unsigned int carry = c->p & FLAG_C;
+    unsigned int sum = c->a + value + carry;
+    set_flag(c, FLAG_V, (~(c->a ^ value) & (c->a ^ sum) & 0x80) != 0);
+
+    if(c->p & FLAG_D) {
+        //Binary coded decimal, one digit per nibble
+        unsigned int low = (c->a & 0x0F) + (value & 0x0F) + carry;
+        unsigned int high = (c->a & 0xF0) + (value & 0xF0);
+        if(low > 0x09)
+            low += 0x06;
+        if(low > 0x0F)
+            high += 0x10;
+        if(high > 0x90)
+            high += 0x60;
+        sum = (high & 0x1F0) | (low & 0x0F);
+    }
+
+    set_flag(c, FLAG_C, sum > 0xFF);
+    c->a = (unsigned char)sum;
+    set_nz(c, c->a);
+}
+
+void alu_SBC(CPU* c, unsigned char value) {
+
+    unsigned int borrow = (c->p & FLAG_C) ? 0 : 1;
+    unsigned int difference = c->a - value - borrow;
+    set_flag(c, FLAG_V, ((c->a ^ value) & (c->a ^ difference) & 0x80) != 0);
+    set_flag(c, FLAG_C, difference < 0x100);
+
+    if(c->p & FLAG_D) {
+        int low = (c->a & 0x0F) - (value & 0x0F) - (int)borrow;
+        int high = (c->a >> 4) - (value >> 4);
+        if(low < 0) {
+            low += 10;
+            high--;
+        }
+        if(high < 0)
+            high += 10;
+        difference = (high << 4) | (low & 0x0F);
+    }
+
+    c->a = (unsigned char)difference;
+    set_nz(c, c->a);
+}
+
+unsigned char modify_ASL(CPU* c, unsigned char value) {
+    set_flag(c, FLAG_C, (value & 0x80) != 0);
+    value <<= 1;
+    set_nz(c, value);
+    return value;
+}
+
+unsigned char modify_LSR(CPU* c, unsigned char value) {
+    set_flag(c, FLAG_C, (value & 0x01) != 0);
+    value >>= 1;
+    set_nz(c, value);
+    return value;
+}
+
+unsigned char modify_ROL(CPU* c, unsigned char value) {
+    unsigned char carry = c->p & FLAG_C;
+    set_flag(c, FLAG_C, (value & 0x80) != 0);
+    value = (value << 1) | carry;
+    set_nz(c, value);
+    return value;
+}
+
+unsigned char modify_ROR(CPU* c, unsigned char value) {
+    unsigned char carry = (c->p & FLAG_C) ? 0x80 : 0;
+    set_flag(c, FLAG_C, (value & 0x01) != 0);
+    value = (value >> 1) | carry;
+    set_nz(c, value);
+    return value;
+}
+
+template<bool FLAGS> unsigned char modify_INC(CPU* c, unsigned char value) {
+    value++;
+    if(FLAGS)
+        set_nz(c, value);
+    return value;
+}
+
+template<bool FLAGS> unsigned char modify_DEC(CPU* c, unsigned char value) {
+    value--;
+    if(FLAGS)
+        set_nz(c, value);
+    return value;
+}
+
+// HANDLERS ///////////////////////////////////////////////////////////////////
+
+// pc has already been moved past the instruction when a handler runs
+
+template<class BUS, int MODE, int REG, bool FLAGS> void op_load(Machine* v,
+        const Decoded_Op* d) {
+    unsigned char value = read_operand<BUS, MODE>(v, d);
+    register_of<REG>(&v->cpu) = value;
+    if(FLAGS)
+        set_nz(&v->cpu, value);
+}
+
+template<class BUS, int MODE, int REG> void op_store(Machine* v,
+        const Decoded_Op* d) {
+    BUS::write(v, address_of<BUS, MODE>(v, d), register_of<REG>(&v->cpu));
+}
+
+template<class BUS, int MODE, void (*F)(CPU*, unsigned char)>
+void op_read(Machine* v, const Decoded_Op* d) {
+    F(&v->cpu, read_operand<BUS, MODE>(v, d));
+}
+
+template<class BUS, int MODE, unsigned char (*F)(CPU*, unsigned char)>
+void op_modify(Machine* v, const Decoded_Op* d) {
+    if(MODE == MODE_ACCUMULATOR) {
+        v->cpu.a = F(&v->cpu, v->cpu.a);
+    } else {
+        unsigned short address = address_of<BUS, MODE>(v, d);
+        BUS::write(v, address, F(&v->cpu, BUS::read(v, address)));
+    }
+}
+
+template<unsigned char FLAG, int SET> void op_branch(Machine* v,
+        const Decoded_Op* d) {
+    if(((v->cpu.p & FLAG) != 0) == (SET != 0)) {
+        //Taken: +1 cycle, +1 more into another page
+        v->cycles += ((v->cpu.pc ^ d->operand) & 0xFF00) ? 2 : 1;
+        v->cpu.pc = d->operand;
+    }
+}
+
+void op_NOP(Machine* v, const Decoded_Op* d) {}
+
+void op_JMP(Machine* v, const Decoded_Op* d) {
+    v->cpu.pc = d->operand;
+}
+
+template<class BUS> void op_JMP_indirect(Machine* v, const Decoded_Op* d) {
+    //The pointer's high byte comes from the same page, as on a real 6502
+    unsigned short low = d->operand;
+    unsigned short high = (low & 0xFF00) | ((low + 1) & 0x00FF);
+    v->cpu.pc = BUS::read(v, low) | (BUS::read(v, high) << 8);
+}
+
+template<class BUS> void op_JSR(Machine* v, const Decoded_Op* d) {
+    unsigned short ret = v->cpu.pc - 1;
+    push<BUS>(v, ret >> 8);
+    push<BUS>(v, ret & 0xFF);
+    v->cpu.pc = d->operand;
+}
+
+template<class BUS> void op_RTS(Machine* v, const Decoded_Op* d) {
+    if(v->cpu.s == v->stack_base) {
+        v->halted = true;      // returning from the program itself
+        return;
+    }
+    unsigned short low = pull<BUS>(v);
+    v->cpu.pc = ((pull<BUS>(v) << 8) | low) + 1;
+}
+
+template<class BUS> void op_RTI(Machine* v, const Decoded_Op* d) {
+    v->cpu.p = (pull<BUS>(v) & ~FLAG_B) | FLAG_U;
+    unsigned short low = pull<BUS>(v);
+    v->cpu.pc = (pull<BUS>(v) << 8) | low;
+}
+
+template<class BUS> void op_BRK(Machine* v, const Decoded_Op* d) {
+    unsigned short vector = BUS::read(v, 0xFFFE) | (BUS::read(v, 0xFFFF) << 8);
+    if(vector == 0) {
+        v->halted = true;      // nothing to handle it
+        return;
+    }
+    unsigned short ret = v->cpu.pc + 1;   // BRK skips a padding byte
+    push<BUS>(v, ret >> 8);
+    push<BUS>(v, ret & 0xFF);
+    push<BUS>(v, v->cpu.p | FLAG_B | FLAG_U);
+    v->cpu.p |= FLAG_I;
+    v->cpu.pc = vector;
+}
+
+template<class BUS> void op_PHA(Machine* v, const Decoded_Op* d) {
+    push<BUS>(v, v->cpu.a);
+}
+template<class BUS> void op_PHP(Machine* v, const Decoded_Op* d) {
+    push<BUS>(v, v->cpu.p | FLAG_B | FLAG_U);
+}
+template<class BUS> void op_PLP(Machine* v, const Decoded_Op* d) {
+    v->cpu.p = (pull<BUS>(v) & ~FLAG_B) | FLAG_U;
+}
+template<class BUS, bool FLAGS> void op_PLA(Machine* v, const Decoded_Op* d) {
+    v->cpu.a = pull<BUS>(v);
+    if(FLAGS)
+        set_nz(&v->cpu, v->cpu.a);
+}
+
+// TAX TAY TXA TYA TSX TXS
+template<int FROM, int TO, bool FLAGS> void op_transfer(Machine* v,
+        const Decoded_Op* d) {
+    unsigned char value = register_of<FROM>(&v->cpu);
+    register_of<TO>(&v->cpu) = value;
+    if(FLAGS && TO != REG_S)
+        set_nz(&v->cpu, value);
+}
+
+// INX INY DEX DEY
+template<int REG, int STEP, bool FLAGS> void op_step(Machine* v,
+        const Decoded_Op* d) {
+    unsigned char value = register_of<REG>(&v->cpu) + STEP;
+    register_of<REG>(&v->cpu) = value;
+    if(FLAGS)
+        set_nz(&v->cpu, value);
+}
+
+void op_CLC(Machine* v, const Decoded_Op* d) { v->cpu.p &= ~FLAG_C; }
+void op_SEC(Machine* v, const Decoded_Op* d) { v->cpu.p |= FLAG_C; }
+void op_CLI(Machine* v, const Decoded_Op* d) { v->cpu.p &= ~FLAG_I; }
+void op_SEI(Machine* v, const Decoded_Op* d) { v->cpu.p |= FLAG_I; }
+void op_CLD(Machine* v, const Decoded_Op* d) { v->cpu.p &= ~FLAG_D; }
+void op_SED(Machine* v, const Decoded_Op* d) { v->cpu.p |= FLAG_D; }
+void op_CLV(Machine* v, const Decoded_Op* d) { v->cpu.p &= ~FLAG_V; }
+
+// One pair of tables per bus, instantiated by op_handlers()
+template<class BUS> struct Op_Tables {
+    static const Op_Handler handlers[256];
+    static const Op_Handler no_flags[256];
+};
+
+// Same order as OPCODES[]
+template<class BUS> const Op_Handler Op_Tables<BUS>::handlers[256] = {
+    op_BRK<BUS>,                                // 0x00 BRK
+    op_read<BUS, MODE_INDEXED_INDIRECT, alu_ORA<true> >,// 0x01 ORA
+    op_NOP,                                     // 0x02 ???
+    op_NOP,                                     // 0x03 ???
+    op_NOP,                                     // 0x04 ???
+    op_read<BUS, MODE_ZERO_PAGE, alu_ORA<true> >,// 0x05 ORA
+    op_modify<BUS, MODE_ZERO_PAGE, modify_ASL>, // 0x06 ASL
+    op_NOP,                                     // 0x07 ???
+    op_PHP<BUS>,                                // 0x08 PHP
+    op_read<BUS, MODE_IMMEDIATE, alu_ORA<true> >,// 0x09 ORA
+    op_modify<BUS, MODE_ACCUMULATOR, modify_ASL>,// 0x0A ASL
+    op_NOP,                                     // 0x0B ???
+    op_NOP,                                     // 0x0C ???
+    op_read<BUS, MODE_ABSOLUTE, alu_ORA<true> >,// 0x0D ORA
+    op_modify<BUS, MODE_ABSOLUTE, modify_ASL>,  // 0x0E ASL
+    op_NOP,                                     // 0x0F ???
+    op_branch<FLAG_N, 0>,                       // 0x10 BPL
+    op_read<BUS, MODE_INDIRECT_INDEXED, alu_ORA<true> >,// 0x11 ORA
+    op_NOP,                                     // 0x12 ???
+    op_NOP,                                     // 0x13 ???
+    op_NOP,                                     // 0x14 ???
+    op_read<BUS, MODE_ZERO_PAGE_X, alu_ORA<true> >,// 0x15 ORA
+    op_modify<BUS, MODE_ZERO_PAGE_X, modify_ASL>,// 0x16 ASL
+    op_NOP,                                     // 0x17 ???
+    op_CLC,                                     // 0x18 CLC
+    op_read<BUS, MODE_ABSOLUTE_Y, alu_ORA<true> >,// 0x19 ORA
+    op_NOP,                                     // 0x1A ???
+    op_NOP,                                     // 0x1B ???
+    op_NOP,                                     // 0x1C ???
+    op_read<BUS, MODE_ABSOLUTE_X, alu_ORA<true> >,// 0x1D ORA
+    op_modify<BUS, MODE_ABSOLUTE_X, modify_ASL>,// 0x1E ASL
+    op_NOP,                                     // 0x1F ???
+    op_JSR<BUS>,                                // 0x20 JSR
+    op_read<BUS, MODE_INDEXED_INDIRECT, alu_AND<true> >,// 0x21 AND
+    op_NOP,                                     // 0x22 ???
+    op_NOP,                                     // 0x23 ???
+    op_read<BUS, MODE_ZERO_PAGE, alu_BIT>,      // 0x24 BIT
+    op_read<BUS, MODE_ZERO_PAGE, alu_AND<true> >,// 0x25 AND
+    op_modify<BUS, MODE_ZERO_PAGE, modify_ROL>, // 0x26 ROL
+    op_NOP,                                     // 0x27 ???
+    op_PLP<BUS>,                                // 0x28 PLP
+    op_read<BUS, MODE_IMMEDIATE, alu_AND<true> >,// 0x29 AND
+    op_modify<BUS, MODE_ACCUMULATOR, modify_ROL>,// 0x2A ROL
+    op_NOP,                                     // 0x2B ???
+    op_read<BUS, MODE_ABSOLUTE, alu_BIT>,       // 0x2C BIT
+    op_read<BUS, MODE_ABSOLUTE, alu_AND<true> >,// 0x2D AND
+    op_modify<BUS, MODE_ABSOLUTE, modify_ROL>,  // 0x2E ROL
+    op_NOP,                                     // 0x2F ???
+    op_branch<FLAG_N, 1>,                       // 0x30 BMI
+    op_read<BUS, MODE_INDIRECT_INDEXED, alu_AND<true> >,// 0x31 AND
+    op_NOP,                                     // 0x32 ???
+    op_NOP,                                     // 0x33 ???
+    op_NOP,                                     // 0x34 ???
+    op_read<BUS, MODE_ZERO_PAGE_X, alu_AND<true> >,// 0x35 AND
+    op_modify<BUS, MODE_ZERO_PAGE_X, modify_ROL>,// 0x36 ROL
+    op_NOP,                                     // 0x37 ???
+    op_SEC,                                     // 0x38 SEC
+    op_read<BUS, MODE_ABSOLUTE_Y, alu_AND<true> >,// 0x39 AND
+    op_NOP,                                     // 0x3A ???
+    op_NOP,                                     // 0x3B ???
+    op_NOP,                                     // 0x3C ???
+    op_read<BUS, MODE_ABSOLUTE_X, alu_AND<true> >,// 0x3D AND
+    op_modify<BUS, MODE_ABSOLUTE_X, modify_ROL>,// 0x3E ROL
+    op_NOP,                                     // 0x3F ???
+    op_RTI<BUS>,                                // 0x40 RTI
+    op_read<BUS, MODE_INDEXED_INDIRECT, alu_EOR<true> >,// 0x41 EOR
+    op_NOP,                                     // 0x42 ???
+    op_NOP,                                     // 0x43 ???
+    op_NOP,                                     // 0x44 ???
+    op_read<BUS, MODE_ZERO_PAGE, alu_EOR<true> >,// 0x45 EOR
+    op_modify<BUS, MODE_ZERO_PAGE, modify_LSR>, // 0x46 LSR
+    op_NOP,                                     // 0x47 ???
+    op_PHA<BUS>,                                // 0x48 PHA
+    op_read<BUS, MODE_IMMEDIATE, alu_EOR<true> >,// 0x49 EOR
+    op_modify<BUS, MODE_ACCUMULATOR, modify_LSR>,// 0x4A LSR
+    op_NOP,                                     // 0x4B ???
+    op_JMP,                                     // 0x4C JMP
+    op_read<BUS, MODE_ABSOLUTE, alu_EOR<true> >,// 0x4D EOR
+    op_modify<BUS, MODE_ABSOLUTE, modify_LSR>,  // 0x4E LSR
+    op_NOP,                                     // 0x4F ???
+    op_branch<FLAG_V, 0>,                       // 0x50 BVC
+    op_read<BUS, MODE_INDIRECT_INDEXED, alu_EOR<true> >,// 0x51 EOR
+    op_NOP,                                     // 0x52 ???
+    op_NOP,                                     // 0x53 ???
+    op_NOP,                                     // 0x54 ???
+    op_read<BUS, MODE_ZERO_PAGE_X, alu_EOR<true> >,// 0x55 EOR
+    op_modify<BUS, MODE_ZERO_PAGE_X, modify_LSR>,// 0x56 LSR
+    op_NOP,                                     // 0x57 ???
+    op_CLI,                                     // 0x58 CLI
+    op_read<BUS, MODE_ABSOLUTE_Y, alu_EOR<true> >,// 0x59 EOR
+    op_NOP,                                     // 0x5A ???
+    op_NOP,                                     // 0x5B ???
+    op_NOP,                                     // 0x5C ???
+    op_read<BUS, MODE_ABSOLUTE_X, alu_EOR<true> >,// 0x5D EOR
+    op_modify<BUS, MODE_ABSOLUTE_X, modify_LSR>,// 0x5E LSR
+    op_NOP,                                     // 0x5F ???
+    op_RTS<BUS>,                                // 0x60 RTS
+    op_read<BUS, MODE_INDEXED_INDIRECT, alu_ADC>,// 0x61 ADC
+    op_NOP,                                     // 0x62 ???
+    op_NOP,                                     // 0x63 ???
+    op_NOP,                                     // 0x64 ???
+    op_read<BUS, MODE_ZERO_PAGE, alu_ADC>,      // 0x65 ADC
+    op_modify<BUS, MODE_ZERO_PAGE, modify_ROR>, // 0x66 ROR
+    op_NOP,                                     // 0x67 ???
+    op_PLA<BUS, true>,                          // 0x68 PLA
+    op_read<BUS, MODE_IMMEDIATE, alu_ADC>,      // 0x69 ADC
+    op_modify<BUS, MODE_ACCUMULATOR, modify_ROR>,// 0x6A ROR
+    op_NOP,                                     // 0x6B ???
+    op_JMP_indirect<BUS>,                       // 0x6C JMP
+    op_read<BUS, MODE_ABSOLUTE, alu_ADC>,       // 0x6D ADC
+    op_modify<BUS, MODE_ABSOLUTE, modify_ROR>,  // 0x6E ROR
+    op_NOP,                                     // 0x6F ???
+    op_branch<FLAG_V, 1>,                       // 0x70 BVS
+    op_read<BUS, MODE_INDIRECT_INDEXED, alu_ADC>,// 0x71 ADC
+    op_NOP,                                     // 0x72 ???
+    op_NOP,                                     // 0x73 ???
+    op_NOP,                                     // 0x74 ???
+    op_read<BUS, MODE_ZERO_PAGE_X, alu_ADC>,    // 0x75 ADC
+    op_modify<BUS, MODE_ZERO_PAGE_X, modify_ROR>,// 0x76 ROR
+    op_NOP,                                     // 0x77 ???
+    op_SEI,                                     // 0x78 SEI
+    op_read<BUS, MODE_ABSOLUTE_Y, alu_ADC>,     // 0x79 ADC
+    op_NOP,                                     // 0x7A ???
+    op_NOP,                                     // 0x7B ???
+    op_NOP,                                     // 0x7C ???
+    op_read<BUS, MODE_ABSOLUTE_X, alu_ADC>,     // 0x7D ADC
+    op_modify<BUS, MODE_ABSOLUTE_X, modify_ROR>,// 0x7E ROR
+    op_NOP,                                     // 0x7F ???
+    op_NOP,                                     // 0x80 ???
+    op_store<BUS, MODE_INDEXED_INDIRECT, REG_A>,// 0x81 STA
+    op_NOP,                                     // 0x82 ???
+    op_NOP,                                     // 0x83 ???
+    op_store<BUS, MODE_ZERO_PAGE, REG_Y>,       // 0x84 STY
+    op_store<BUS, MODE_ZERO_PAGE, REG_A>,       // 0x85 STA
+    op_store<BUS, MODE_ZERO_PAGE, REG_X>,       // 0x86 STX
+    op_NOP,                                     // 0x87 ???
+    op_step<REG_Y, -1, true>,                   // 0x88 DEY
+    op_NOP,                                     // 0x89 ???
+    op_transfer<REG_X, REG_A, true>,            // 0x8A TXA
+    op_NOP,                                     // 0x8B ???
+    op_store<BUS, MODE_ABSOLUTE, REG_Y>,        // 0x8C STY
+    op_store<BUS, MODE_ABSOLUTE, REG_A>,        // 0x8D STA
+    op_store<BUS, MODE_ABSOLUTE, REG_X>,        // 0x8E STX
+    op_NOP,                                     // 0x8F ???
+    op_branch<FLAG_C, 0>,                       // 0x90 BCC
+    op_store<BUS, MODE_INDIRECT_INDEXED, REG_A>,// 0x91 STA
+    op_NOP,                                     // 0x92 ???
+    op_NOP,                                     // 0x93 ???
+    op_store<BUS, MODE_ZERO_PAGE_X, REG_Y>,     // 0x94 STY
+    op_store<BUS, MODE_ZERO_PAGE_X, REG_A>,     // 0x95 STA
+    op_store<BUS, MODE_ZERO_PAGE_Y, REG_X>,     // 0x96 STX
+    op_NOP,                                     // 0x97 ???
+    op_transfer<REG_Y, REG_A, true>,            // 0x98 TYA
+    op_store<BUS, MODE_ABSOLUTE_Y, REG_A>,      // 0x99 STA
+    op_transfer<REG_X, REG_S, true>,            // 0x9A TXS
+    op_NOP,                                     // 0x9B ???
+    op_NOP,                                     // 0x9C ???
+    op_store<BUS, MODE_ABSOLUTE_X, REG_A>,      // 0x9D STA
+    op_NOP,                                     // 0x9E ???
+    op_NOP,                                     // 0x9F ???
+    op_load<BUS, MODE_IMMEDIATE, REG_Y, true>,  // 0xA0 LDY
+    op_load<BUS, MODE_INDEXED_INDIRECT, REG_A, true>,// 0xA1 LDA
+    op_load<BUS, MODE_IMMEDIATE, REG_X, true>,  // 0xA2 LDX
+    op_NOP,                                     // 0xA3 ???
+    op_load<BUS, MODE_ZERO_PAGE, REG_Y, true>,  // 0xA4 LDY
+    op_load<BUS, MODE_ZERO_PAGE, REG_A, true>,  // 0xA5 LDA
+    op_load<BUS, MODE_ZERO_PAGE, REG_X, true>,  // 0xA6 LDX
+    op_NOP,                                     // 0xA7 ???
+    op_transfer<REG_A, REG_Y, true>,            // 0xA8 TAY
+    op_load<BUS, MODE_IMMEDIATE, REG_A, true>,  // 0xA9 LDA
+    op_transfer<REG_A, REG_X, true>,            // 0xAA TAX
+    op_NOP,                                     // 0xAB ???
+    op_load<BUS, MODE_ABSOLUTE, REG_Y, true>,   // 0xAC LDY
+    op_load<BUS, MODE_ABSOLUTE, REG_A, true>,   // 0xAD LDA
+    op_load<BUS, MODE_ABSOLUTE, REG_X, true>,   // 0xAE LDX
+    op_NOP,                                     // 0xAF ???
+    op_branch<FLAG_C, 1>,                       // 0xB0 BCS
+    op_load<BUS, MODE_INDIRECT_INDEXED, REG_A, true>,// 0xB1 LDA
+    op_NOP,                                     // 0xB2 ???
+    op_NOP,                                     // 0xB3 ???
+    op_load<BUS, MODE_ZERO_PAGE_X, REG_Y, true>,// 0xB4 LDY
+    op_load<BUS, MODE_ZERO_PAGE_X, REG_A, true>,// 0xB5 LDA
+    op_load<BUS, MODE_ZERO_PAGE_Y, REG_X, true>,// 0xB6 LDX
+    op_NOP,                                     // 0xB7 ???
+    op_CLV,                                     // 0xB8 CLV
+    op_load<BUS, MODE_ABSOLUTE_Y, REG_A, true>, // 0xB9 LDA
+    op_transfer<REG_S, REG_X, true>,            // 0xBA TSX
+    op_NOP,                                     // 0xBB ???
+    op_load<BUS, MODE_ABSOLUTE_X, REG_Y, true>, // 0xBC LDY
+    op_load<BUS, MODE_ABSOLUTE_X, REG_A, true>, // 0xBD LDA
+    op_load<BUS, MODE_ABSOLUTE_Y, REG_X, true>, // 0xBE LDX
+    op_NOP,                                     // 0xBF ???
+    op_read<BUS, MODE_IMMEDIATE, alu_CPY>,      // 0xC0 CPY
+    op_read<BUS, MODE_INDEXED_INDIRECT, alu_CMP>,// 0xC1 CMP
+    op_NOP,                                     // 0xC2 ???
+    op_NOP,                                     // 0xC3 ???
+    op_read<BUS, MODE_ZERO_PAGE, alu_CPY>,      // 0xC4 CPY
+    op_read<BUS, MODE_ZERO_PAGE, alu_CMP>,      // 0xC5 CMP
+    op_modify<BUS, MODE_ZERO_PAGE, modify_DEC<true> >,// 0xC6 DEC
+    op_NOP,                                     // 0xC7 ???
+    op_step<REG_Y, 1, true>,                    // 0xC8 INY
+    op_read<BUS, MODE_IMMEDIATE, alu_CMP>,      // 0xC9 CMP
+    op_step<REG_X, -1, true>,                   // 0xCA DEX
+    op_NOP,                                     // 0xCB ???
+    op_read<BUS, MODE_ABSOLUTE, alu_CPY>,       // 0xCC CPY
+    op_read<BUS, MODE_ABSOLUTE, alu_CMP>,       // 0xCD CMP
+    op_modify<BUS, MODE_ABSOLUTE, modify_DEC<true> >,// 0xCE DEC
+    op_NOP,                                     // 0xCF ???
+    op_branch<FLAG_Z, 0>,                       // 0xD0 BNE
+    op_read<BUS, MODE_INDIRECT_INDEXED, alu_CMP>,// 0xD1 CMP
+    op_NOP,                                     // 0xD2 ???
+    op_NOP,                                     // 0xD3 ???
+    op_NOP,                                     // 0xD4 ???
+    op_read<BUS, MODE_ZERO_PAGE_X, alu_CMP>,    // 0xD5 CMP
+    op_modify<BUS, MODE_ZERO_PAGE_X, modify_DEC<true> >,// 0xD6 DEC
+    op_NOP,                                     // 0xD7 ???
+    op_CLD,                                     // 0xD8 CLD
+    op_read<BUS, MODE_ABSOLUTE_Y, alu_CMP>,     // 0xD9 CMP
+    op_NOP,                                     // 0xDA ???
+    op_NOP,                                     // 0xDB ???
+    op_NOP,                                     // 0xDC ???
+    op_read<BUS, MODE_ABSOLUTE_X, alu_CMP>,     // 0xDD CMP
+    op_modify<BUS, MODE_ABSOLUTE_X, modify_DEC<true> >,// 0xDE DEC
+    op_NOP,                                     // 0xDF ???
+    op_read<BUS, MODE_IMMEDIATE, alu_CPX>,      // 0xE0 CPX
+    op_read<BUS, MODE_INDEXED_INDIRECT, alu_SBC>,// 0xE1 SBC
+    op_NOP,                                     // 0xE2 ???
+    op_NOP,                                     // 0xE3 ???
+    op_read<BUS, MODE_ZERO_PAGE, alu_CPX>,      // 0xE4 CPX
+    op_read<BUS, MODE_ZERO_PAGE, alu_SBC>,      // 0xE5 SBC
+    op_modify<BUS, MODE_ZERO_PAGE, modify_INC<true> >,// 0xE6 INC
+    op_NOP,                                     // 0xE7 ???
+    op_step<REG_X, 1, true>,                    // 0xE8 INX
+    op_read<BUS, MODE_IMMEDIATE, alu_SBC>,      // 0xE9 SBC
+    op_NOP,                                     // 0xEA NOP
+    op_NOP,                                     // 0xEB ???
+    op_read<BUS, MODE_ABSOLUTE, alu_CPX>,       // 0xEC CPX
+    op_read<BUS, MODE_ABSOLUTE, alu_SBC>,       // 0xED SBC
+    op_modify<BUS, MODE_ABSOLUTE, modify_INC<true> >,// 0xEE INC
+    op_NOP,                                     // 0xEF ???
+    op_branch<FLAG_Z, 1>,                       // 0xF0 BEQ
+    op_read<BUS, MODE_INDIRECT_INDEXED, alu_SBC>,// 0xF1 SBC
+    op_NOP,                                     // 0xF2 ???
+    op_NOP,                                     // 0xF3 ???
+    op_NOP,                                     // 0xF4 ???
+    op_read<BUS, MODE_ZERO_PAGE_X, alu_SBC>,    // 0xF5 SBC
+    op_modify<BUS, MODE_ZERO_PAGE_X, modify_INC<true> >,// 0xF6 INC
+    op_NOP,                                     // 0xF7 ???
+    op_SED,                                     // 0xF8 SED
+    op_read<BUS, MODE_ABSOLUTE_Y, alu_SBC>,     // 0xF9 SBC
+    op_NOP,                                     // 0xFA ???
+    op_NOP,                                     // 0xFB ???
+    op_NOP,                                     // 0xFC ???
+    op_read<BUS, MODE_ABSOLUTE_X, alu_SBC>,     // 0xFD SBC
+    op_modify<BUS, MODE_ABSOLUTE_X, modify_INC<true> >,// 0xFE INC
+    op_NOP,                                     // 0xFF ???
+};
+
+// The same op without setting N and Z (or, for CMP/CPX/CPY/BIT, without
+// doing anything but the read), NULL if there isn't one
+template<class BUS> const Op_Handler Op_Tables<BUS>::no_flags[256] = {
+    NULL,                                       // 0x00 BRK
+    op_read<BUS, MODE_INDEXED_INDIRECT, alu_ORA<false> >,// 0x01 ORA
+    NULL,                                       // 0x02 ???
+    NULL,                                       // 0x03 ???
+    NULL,                                       // 0x04 ???
+    op_read<BUS, MODE_ZERO_PAGE, alu_ORA<false> >,// 0x05 ORA
+    NULL,                                       // 0x06 ASL
+    NULL,                                       // 0x07 ???
+    NULL,                                       // 0x08 PHP
+    op_read<BUS, MODE_IMMEDIATE, alu_ORA<false> >,// 0x09 ORA
+    NULL,                                       // 0x0A ASL
+    NULL,                                       // 0x0B ???
+    NULL,                                       // 0x0C ???
+    op_read<BUS, MODE_ABSOLUTE, alu_ORA<false> >,// 0x0D ORA
+    NULL,                                       // 0x0E ASL
+    NULL,                                       // 0x0F ???
+    NULL,                                       // 0x10 BPL
+    op_read<BUS, MODE_INDIRECT_INDEXED, alu_ORA<false> >,// 0x11 ORA
+    NULL,                                       // 0x12 ???
+    NULL,                                       // 0x13 ???
+    NULL,                                       // 0x14 ???
+    op_read<BUS, MODE_ZERO_PAGE_X, alu_ORA<false> >,// 0x15 ORA
+    NULL,                                       // 0x16 ASL
+    NULL,                                       // 0x17 ???
+    NULL,                                       // 0x18 CLC
+    op_read<BUS, MODE_ABSOLUTE_Y, alu_ORA<false> >,// 0x19 ORA
+    NULL,                                       // 0x1A ???
+    NULL,                                       // 0x1B ???
+    NULL,                                       // 0x1C ???
+    op_read<BUS, MODE_ABSOLUTE_X, alu_ORA<false> >,// 0x1D ORA
+    NULL,                                       // 0x1E ASL
+    NULL,                                       // 0x1F ???
+    NULL,                                       // 0x20 JSR
+    op_read<BUS, MODE_INDEXED_INDIRECT, alu_AND<false> >,// 0x21 AND
+    NULL,                                       // 0x22 ???
+    NULL,                                       // 0x23 ???
+    op_read<BUS, MODE_ZERO_PAGE, alu_none>,     // 0x24 BIT
+    op_read<BUS, MODE_ZERO_PAGE, alu_AND<false> >,// 0x25 AND
+    NULL,                                       // 0x26 ROL
+    NULL,                                       // 0x27 ???
+    NULL,                                       // 0x28 PLP
+    op_read<BUS, MODE_IMMEDIATE, alu_AND<false> >,// 0x29 AND
+    NULL,                                       // 0x2A ROL
+    NULL,                                       // 0x2B ???
+    op_read<BUS, MODE_ABSOLUTE, alu_none>,      // 0x2C BIT
+    op_read<BUS, MODE_ABSOLUTE, alu_AND<false> >,// 0x2D AND
+    NULL,                                       // 0x2E ROL
+    NULL,                                       // 0x2F ???
+    NULL,                                       // 0x30 BMI
+    op_read<BUS, MODE_INDIRECT_INDEXED, alu_AND<false> >,// 0x31 AND
+    NULL,                                       // 0x32 ???
+    NULL,                                       // 0x33 ???
+    NULL,                                       // 0x34 ???
+    op_read<BUS, MODE_ZERO_PAGE_X, alu_AND<false> >,// 0x35 AND
+    NULL,                                       // 0x36 ROL
+    NULL,                                       // 0x37 ???
+    NULL,                                       // 0x38 SEC
+    op_read<BUS, MODE_ABSOLUTE_Y, alu_AND<false> >,// 0x39 AND
+    NULL,                                       // 0x3A ???
+    NULL,                                       // 0x3B ???
+    NULL,                                       // 0x3C ???
+    op_read<BUS, MODE_ABSOLUTE_X, alu_AND<false> >,// 0x3D AND
+    NULL,                                       // 0x3E ROL
+    NULL,                                       // 0x3F ???
+    NULL,                                       // 0x40 RTI
+    op_read<BUS, MODE_INDEXED_INDIRECT, alu_EOR<false> >,// 0x41 EOR
+    NULL,                                       // 0x42 ???
+    NULL,                                       // 0x43 ???
+    NULL,                                       // 0x44 ???
+    op_read<BUS, MODE_ZERO_PAGE, alu_EOR<false> >,// 0x45 EOR
+    NULL,                                       // 0x46 LSR
+    NULL,                                       // 0x47 ???
+    NULL,                                       // 0x48 PHA
+    op_read<BUS, MODE_IMMEDIATE, alu_EOR<false> >,// 0x49 EOR
+    NULL,                                       // 0x4A LSR
+    NULL,                                       // 0x4B ???
+    NULL,                                       // 0x4C JMP
+    op_read<BUS, MODE_ABSOLUTE, alu_EOR<false> >,// 0x4D EOR
+    NULL,                                       // 0x4E LSR
+    NULL,                                       // 0x4F ???
+    NULL,                                       // 0x50 BVC
+    op_read<BUS, MODE_INDIRECT_INDEXED, alu_EOR<false> >,// 0x51 EOR
+    NULL,                                       // 0x52 ???
+    NULL,                                       // 0x53 ???
+    NULL,                                       // 0x54 ???
+    op_read<BUS, MODE_ZERO_PAGE_X, alu_EOR<false> >,// 0x55 EOR
+    NULL,                                       // 0x56 LSR
+    NULL,                                       // 0x57 ???
+    NULL,                                       // 0x58 CLI
+    op_read<BUS, MODE_ABSOLUTE_Y, alu_EOR<false> >,// 0x59 EOR
+    NULL,                                       // 0x5A ???
+    NULL,                                       // 0x5B ???
+    NULL,                                       // 0x5C ???
+    op_read<BUS, MODE_ABSOLUTE_X, alu_EOR<false> >,// 0x5D EOR
+    NULL,                                       // 0x5E LSR
+    NULL,                                       // 0x5F ???
+    NULL,                                       // 0x60 RTS
+    NULL,                                       // 0x61 ADC
+    NULL,                                       // 0x62 ???
+    NULL,                                       // 0x63 ???
+    NULL,                                       // 0x64 ???
+    NULL,                                       // 0x65 ADC
+    NULL,                                       // 0x66 ROR
+    NULL,                                       // 0x67 ???
+    op_PLA<BUS, false>,                         // 0x68 PLA
+    NULL,                                       // 0x69 ADC
+    NULL,                                       // 0x6A ROR
+    NULL,                                       // 0x6B ???
+    NULL,                                       // 0x6C JMP
+    NULL,                                       // 0x6D ADC
+    NULL,                                       // 0x6E ROR
+    NULL,                                       // 0x6F ???
+    NULL,                                       // 0x70 BVS
+    NULL,                                       // 0x71 ADC
+    NULL,                                       // 0x72 ???
+    NULL,                                       // 0x73 ???
+    NULL,                                       // 0x74 ???
+    NULL,                                       // 0x75 ADC
+    NULL,                                       // 0x76 ROR
+    NULL,                                       // 0x77 ???
+    NULL,                                       // 0x78 SEI
+    NULL,                                       // 0x79 ADC
+    NULL,                                       // 0x7A ???
+    NULL,                                       // 0x7B ???
+    NULL,                                       // 0x7C ???
+    NULL,                                       // 0x7D ADC
+    NULL,                                       // 0x7E ROR
+    NULL,                                       // 0x7F ???
+    NULL,                                       // 0x80 ???
+    NULL,                                       // 0x81 STA
+    NULL,                                       // 0x82 ???
+    NULL,                                       // 0x83 ???
+    NULL,                                       // 0x84 STY
+    NULL,                                       // 0x85 STA
+    NULL,                                       // 0x86 STX
+    NULL,                                       // 0x87 ???
+    op_step<REG_Y, -1, false>,                  // 0x88 DEY
+    NULL,                                       // 0x89 ???
+    op_transfer<REG_X, REG_A, false>,           // 0x8A TXA
+    NULL,                                       // 0x8B ???
+    NULL,                                       // 0x8C STY
+    NULL,                                       // 0x8D STA
+    NULL,                                       // 0x8E STX
+    NULL,                                       // 0x8F ???
+    NULL,                                       // 0x90 BCC
+    NULL,                                       // 0x91 STA
+    NULL,                                       // 0x92 ???
+    NULL,                                       // 0x93 ???
+    NULL,                                       // 0x94 STY
+    NULL,                                       // 0x95 STA
+    NULL,                                       // 0x96 STX
+    NULL,                                       // 0x97 ???
+    op_transfer<REG_Y, REG_A, false>,           // 0x98 TYA
+    NULL,                                       // 0x99 STA
+    NULL,                                       // 0x9A TXS
+    NULL,                                       // 0x9B ???
+    NULL,                                       // 0x9C ???
+    NULL,                                       // 0x9D STA
+    NULL,                                       // 0x9E ???
+    NULL,                                       // 0x9F ???
+    op_load<BUS, MODE_IMMEDIATE, REG_Y, false>, // 0xA0 LDY
+    op_load<BUS, MODE_INDEXED_INDIRECT, REG_A, false>,// 0xA1 LDA
+    op_load<BUS, MODE_IMMEDIATE, REG_X, false>, // 0xA2 LDX
+    NULL,                                       // 0xA3 ???
+    op_load<BUS, MODE_ZERO_PAGE, REG_Y, false>, // 0xA4 LDY
+    op_load<BUS, MODE_ZERO_PAGE, REG_A, false>, // 0xA5 LDA
+    op_load<BUS, MODE_ZERO_PAGE, REG_X, false>, // 0xA6 LDX
+    NULL,                                       // 0xA7 ???
+    op_transfer<REG_A, REG_Y, false>,           // 0xA8 TAY
+    op_load<BUS, MODE_IMMEDIATE, REG_A, false>, // 0xA9 LDA
+    op_transfer<REG_A, REG_X, false>,           // 0xAA TAX
+    NULL,                                       // 0xAB ???
+    op_load<BUS, MODE_ABSOLUTE, REG_Y, false>,  // 0xAC LDY
+    op_load<BUS, MODE_ABSOLUTE, REG_A, false>,  // 0xAD LDA
+    op_load<BUS, MODE_ABSOLUTE, REG_X, false>,  // 0xAE LDX
+    NULL,                                       // 0xAF ???
+    NULL,                                       // 0xB0 BCS
+    op_load<BUS, MODE_INDIRECT_INDEXED, REG_A, false>,// 0xB1 LDA
+    NULL,                                       // 0xB2 ???
+    NULL,                                       // 0xB3 ???
+    op_load<BUS, MODE_ZERO_PAGE_X, REG_Y, false>,// 0xB4 LDY
+    op_load<BUS, MODE_ZERO_PAGE_X, REG_A, false>,// 0xB5 LDA
+    op_load<BUS, MODE_ZERO_PAGE_Y, REG_X, false>,// 0xB6 LDX
+    NULL,                                       // 0xB7 ???
+    NULL,                                       // 0xB8 CLV
+    op_load<BUS, MODE_ABSOLUTE_Y, REG_A, false>,// 0xB9 LDA
+    op_transfer<REG_S, REG_X, false>,           // 0xBA TSX
+    NULL,                                       // 0xBB ???
+    op_load<BUS, MODE_ABSOLUTE_X, REG_Y, false>,// 0xBC LDY
+    op_load<BUS, MODE_ABSOLUTE_X, REG_A, false>,// 0xBD LDA
+    op_load<BUS, MODE_ABSOLUTE_Y, REG_X, false>,// 0xBE LDX
+    NULL,                                       // 0xBF ???
+    op_read<BUS, MODE_IMMEDIATE, alu_none>,     // 0xC0 CPY
+    op_read<BUS, MODE_INDEXED_INDIRECT, alu_none>,// 0xC1 CMP
+    NULL,                                       // 0xC2 ???
+    NULL,                                       // 0xC3 ???
+    op_read<BUS, MODE_ZERO_PAGE, alu_none>,     // 0xC4 CPY
+    op_read<BUS, MODE_ZERO_PAGE, alu_none>,     // 0xC5 CMP
+    op_modify<BUS, MODE_ZERO_PAGE, modify_DEC<false> >,// 0xC6 DEC
+    NULL,                                       // 0xC7 ???
+    op_step<REG_Y, 1, false>,                   // 0xC8 INY
+    op_read<BUS, MODE_IMMEDIATE, alu_none>,     // 0xC9 CMP
+    op_step<REG_X, -1, false>,                  // 0xCA DEX
+    NULL,                                       // 0xCB ???
+    op_read<BUS, MODE_ABSOLUTE, alu_none>,      // 0xCC CPY
+    op_read<BUS, MODE_ABSOLUTE, alu_none>,      // 0xCD CMP
+    op_modify<BUS, MODE_ABSOLUTE, modify_DEC<false> >,// 0xCE DEC
+    NULL,                                       // 0xCF ???
+    NULL,                                       // 0xD0 BNE
+    op_read<BUS, MODE_INDIRECT_INDEXED, alu_none>,// 0xD1 CMP
+    NULL,                                       // 0xD2 ???
+    NULL,                                       // 0xD3 ???
+    NULL,                                       // 0xD4 ???
+    op_read<BUS, MODE_ZERO_PAGE_X, alu_none>,   // 0xD5 CMP
+    op_modify<BUS, MODE_ZERO_PAGE_X, modify_DEC<false> >,// 0xD6 DEC
+    NULL,                                       // 0xD7 ???
+    NULL,                                       // 0xD8 CLD
+    op_read<BUS, MODE_ABSOLUTE_Y, alu_none>,    // 0xD9 CMP
+    NULL,                                       // 0xDA ???
+    NULL,                                       // 0xDB ???
+    NULL,                                       // 0xDC ???
+    op_read<BUS, MODE_ABSOLUTE_X, alu_none>,    // 0xDD CMP
+    op_modify<BUS, MODE_ABSOLUTE_X, modify_DEC<false> >,// 0xDE DEC
+    NULL,                                       // 0xDF ???
+    op_read<BUS, MODE_IMMEDIATE, alu_none>,     // 0xE0 CPX
+    NULL,                                       // 0xE1 SBC
+    NULL,                                       // 0xE2 ???
+    NULL,                                       // 0xE3 ???
+    op_read<BUS, MODE_ZERO_PAGE, alu_none>,     // 0xE4 CPX
+    NULL,                                       // 0xE5 SBC
+    op_modify<BUS, MODE_ZERO_PAGE, modify_INC<false> >,// 0xE6 INC
+    NULL,                                       // 0xE7 ???
+    op_step<REG_X, 1, false>,                   // 0xE8 INX
+    NULL,                                       // 0xE9 SBC
+    NULL,                                       // 0xEA NOP
+    NULL,                                       // 0xEB ???
+    op_read<BUS, MODE_ABSOLUTE, alu_none>,      // 0xEC CPX
+    NULL,                                       // 0xED SBC
+    op_modify<BUS, MODE_ABSOLUTE, modify_INC<false> >,// 0xEE INC
+    NULL,                                       // 0xEF ???
+    NULL,                                       // 0xF0 BEQ
+    NULL,                                       // 0xF1 SBC
+    NULL,                                       // 0xF2 ???
+    NULL,                                       // 0xF3 ???
+    NULL,                                       // 0xF4 ???
+    NULL,                                       // 0xF5 SBC
+    op_modify<BUS, MODE_ZERO_PAGE_X, modify_INC<false> >,// 0xF6 INC
+    NULL,                                       // 0xF7 ???
+    NULL,                                       // 0xF8 SED
+    NULL,                                       // 0xF9 SBC
+    NULL,                                       // 0xFA ???
+    NULL,                                       // 0xFB ???
+    NULL,                                       // 0xFC ???
+    NULL,                                       // 0xFD SBC
+    op_modify<BUS, MODE_ABSOLUTE_X, modify_INC<false> >,// 0xFE INC
+    NULL,                                       // 0xFF ???
+};
+
+template<class BUS> const Op_Handler* tables_for(bool flags) {
+    return flags ? Op_Tables<BUS>::handlers : Op_Tables<BUS>::no_flags;
+}
+
+template<class BUS> const Op_Handler* instrumented(Machine* v, bool flags) {
+    if(v->debugger != NULL && v->profile != NULL)
+        return tables_for<Debug_Bus<Profiled_Bus<BUS> > >(flags);
+    if(v->debugger != NULL)
+        return tables_for<Debug_Bus<BUS> >(flags);
+    if(v->profile != NULL)
+        return tables_for<Profiled_Bus<BUS> >(flags);
+    return tables_for<BUS>(flags);
+}
+
+const Op_Handler* op_handlers(Machine* v, bool flags) {
+    if(v->bus == NULL)
+        return instrumented<Ram_Bus>(v, flags);
+    return instrumented<Paged_Bus>(v, flags);
+}
+
+// BUS ////////////////////////////////////////////////////////////////////////
+
+void map_pages(Memory_Bus* bus, int first_page, int pages,
+        unsigned char* read, unsigned char* write, Io_Read io_read,
+        Io_Write io_write, void* device) {
+
+    for(int i = 0; i < pages && first_page + i < 256; i++) {
+        Bus_Page* page = &bus->pages[first_page + i];
+        page->read = (read != NULL) ? read + (i << 8) : NULL;
+        page->write = (write != NULL) ? write + (i << 8) : NULL;
+        page->io_read = io_read;
+        page->io_write = io_write;
+        page->device = device;
+    }
+}
+
+unsigned char io_open_bus(void* device, unsigned short address) {
+    return 0xFF;
+}
+
+void initialize_bus(Memory_Bus* bus, unsigned char* m) {
+    map_ram(bus, 0, 256, m);
+}
+
+void map_ram(Memory_Bus* bus, int first_page, int pages,
+        unsigned char* memory) {
+    map_pages(bus, first_page, pages, memory, memory, NULL, NULL, NULL);
+}
+
+void map_rom(Memory_Bus* bus, int first_page, int pages,
+        unsigned char* memory) {
+    map_pages(bus, first_page, pages, memory, NULL, NULL, NULL, NULL);
+}
+
+void map_io(Memory_Bus* bus, int first_page, int pages, Io_Read io_read,
+        Io_Write io_write, void* device) {
+    map_pages(bus, first_page, pages, NULL, NULL,
+        (io_read != NULL) ? io_read : io_open_bus, io_write, device);
+}
+
+// Everything decoded so far has the handlers op_handlers() gave before
+void forget_decoded_ops(Machine* v) {
+    memset(v->cache, 0, sizeof(Decode_Cache));
+    if(v->blocks != NULL)
+        for(int page = 0; page < 256; page++)
+            invalidate_blocks(v, page);
+}
+
+void attach_bus(Machine* v, Memory_Bus* bus) {
+    v->bus = bus;
+    forget_decoded_ops(v);
+}
+
+void attach_profile(Machine* v, Profile* profile) {
+    v->profile = profile;
+    forget_decoded_ops(v);
+}
+
+void attach_debugger(Machine* v, Debugger* debugger) {
+    v->debugger = debugger;
+    forget_decoded_ops(v);
+}
+
+// DECODE AND RUN /////////////////////////////////////////////////////////////
+
+bool initialize_machine(Machine* v, unsigned char* m) {
+
+    memset(v, 0, sizeof(Machine));
+    v->m = m;
+    v->cpu.s = 0xFF;
+    v->cpu.p = FLAG_U;
+    v->cache = (Decode_Cache*)calloc(1, sizeof(Decode_Cache));
+    return v->cache != NULL;
+}
+
+void free_machine(Machine* v) {
+
+    free_blocks(v);
+    free(v->cache);
+    v->cache = NULL;
+}
+
+const Decoded_Op* decode_at(Machine* v, unsigned short pc) {
+
+    unsigned char opcode = read_byte(v, pc);
+    const Opcode_Info* info = &OPCODES[opcode];
+    Decoded_Op* d = &v->cache->ops[pc];
+
+    d->opcode = opcode;
+    d->length = info->length;
+    d->cycles = info->cycles;
+    d->page_penalty = info->page_penalty;
+    d->operand = 0;
+    if(info->length == 2)
+        d->operand = read_byte(v, pc + 1);
+    else if(info->length == 3)
+        d->operand = read_byte(v, pc + 1) | (read_byte(v, pc + 2) << 8);
+    if(info->mode == MODE_RELATIVE)
+        d->operand = pc + 2 + (signed char)d->operand;
+
+    //Stores to any byte of this instruction must find it
+    v->cache->code_page[pc >> 8] = 1;
+    v->cache->code_page[(unsigned short)(pc + info->length - 1) >> 8] = 1;
+
+    d->execute = op_handlers(v, true)[opcode];
+    return d;
+}
+
+void invalidate_code_page(Machine* v, int page) {
+
+    Decoded_Op* ops = v->cache->ops;
+    for(int i = 0; i < 256; i++)
+        ops[(page << 8) | i].execute = NULL;
+
+    //Instructions starting at the end of the page before can run into this one
+    ops[((page << 8) - 1) & 0xFFFF].execute = NULL;
+    ops[((page << 8) - 2) & 0xFFFF].execute = NULL;
+
+    v->cache->code_page[page] = 0;
+    if(v->blocks != NULL)
+        invalidate_blocks(v, page);
+}
+
+void invalidate_decode_cache(Machine* v) {
+
+    for(int page = 0; page < 256; page++) {
+        if(v->cache->code_page[page])
+            invalidate_code_page(v, page);
+    }
+}
+
+void step_6502(Machine* v) {
+
+    const Decoded_Op* d = &v->cache->ops[v->cpu.pc];
+    if(d->execute == NULL)
+        d = decode_at(v, v->cpu.pc);
+
+    v->cpu.pc += d->length;
+    v->cycles += d->cycles;
+    d->execute(v, d);
+    v->instructions++;
+}
+
+// What the run loop does around each instruction, on top of running it.
+// Either call returns false to end the run there.
+struct No_Hooks {
+    static bool before(Machine* v, const Decoded_Op* d) { return true; }
+    static bool executed(Machine* v, unsigned short pc, const Decoded_Op* d,
+            unsigned long long cycles) { return true; }
+};
+
+struct Profile_Hooks {
+    static bool before(Machine* v, const Decoded_Op* d) { return true; }
+    static bool executed(Machine* v, unsigned short pc, const Decoded_Op* d,
+            unsigned long long cycles) {
+        Profile* profile = v->profile;
+        profile->executions[pc]++;
+        profile->cycles[pc] += cycles;
+        profile->opcodes[d->opcode]++;
+        return true;
+    }
+};
+
+struct Debug_Hooks {
+    static bool before(Machine* v, const Decoded_Op* d) {
+        Debugger* g = v->debugger;
+        unsigned short pc = v->cpu.pc;
+        if((g->breakpoints[pc >> 3] & (1 << (pc & 7))) &&
+                g->ignore_breakpoint != pc) {
+            g->stop_reason = STOP_BREAKPOINT;
+            g->stop_address = pc;
+            g->ignore_breakpoint = pc;     // so continuing runs it
+            return false;
+        }
+        if(g->tracing) {
+            Trace_Entry* t = &g->trace[g->trace_count++ & (TRACE_LENGTH - 1)];
+            t->cpu = v->cpu;
+            t->opcode = d->opcode;
+            t->operand = d->operand;
+            t->cycles = v->cycles;
+        }
+        return true;
+    }
+    static bool executed(Machine* v, unsigned short pc, const Decoded_Op* d,
+            unsigned long long cycles) {
+        v->debugger->ignore_breakpoint = -1;
+        return v->debugger->stop_reason == STOP_NONE;
+    }
+};
+
+template<class FIRST, class SECOND> struct Both_Hooks {
+    static bool before(Machine* v, const Decoded_Op* d) {
+        return FIRST::before(v, d) && SECOND::before(v, d);
+    }
+    static bool executed(Machine* v, unsigned short pc, const Decoded_Op* d,
+            unsigned long long cycles) {
+        bool first = FIRST::executed(v, pc, d, cycles);
+        return SECOND::executed(v, pc, d, cycles) && first;
+    }
+};
+
+template<class HOOKS> unsigned long run_loop(Machine* v,
+        unsigned long long max_cycles) {
+
+    CPU* c = &v->cpu;
+    Decoded_Op* ops = v->cache->ops;
+    unsigned long long limit = v->cycles + max_cycles;
+    unsigned long count = 0;
+
+    while(v->halted == false && v->cycles < limit) {
+
+        const Decoded_Op* d = &ops[c->pc];
+        if(d->execute == NULL)
+            d = decode_at(v, c->pc);
+        if(HOOKS::before(v, d) == false)
+            break;
+
+        unsigned short pc = c->pc;
+        unsigned long long cycles = v->cycles;
+        c->pc += d->length;
+        v->cycles += d->cycles;
+        d->execute(v, d);
+        count++;
+        if(HOOKS::executed(v, pc, d, v->cycles - cycles) == false)
+            break;
+    }
+
+    v->instructions += count;
+    return count;
+}
+
+unsigned long run_6502(Machine* v, unsigned long long max_cycles) {
+
+    //Runs from cpu.pc until the program's own RTS, a BRK with nothing to
+    //handle it, or max_cycles. Returns the instructions executed.
+    Debugger* g = v->debugger;
+    v->halted = false;
+    if(g == NULL || g->resume == false)
+        v->stack_base = v->cpu.s;
+
+    if(g != NULL) {
+        g->stop_reason = STOP_NONE;
+        unsigned long count = (v->profile != NULL) ?
+            run_loop<Both_Hooks<Debug_Hooks, Profile_Hooks> >(v, max_cycles) :
+            run_loop<Debug_Hooks>(v, max_cycles);
+        g->resume = (v->halted == false);
+        return count;
+    }
+
+    if(v->profile != NULL)
+        return run_loop<Profile_Hooks>(v, max_cycles);
+    return run_loop<No_Hooks>(v, max_cycles);
+}
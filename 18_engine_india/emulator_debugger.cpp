@@ -0,0 +1,118 @@
+//345678901234567890123456789012345678901234567890123456789012345678901234567890
+//       1         2         3         4         5         6         7         8
+// Filename: ../emulator_debugger.cpp
+// Last Modified: Tue Oct 20, 2026  06:00AM
+//
+// Breakpoints, watchpoints and the instruction trace for 6502 programs.
+//
+// The checks themselves are in the CPU core (emulator_cpu.cpp): with a
+// Debugger attached, the run loop looks up each pc in the breakpoint
+// bitmap and records the trace, and every data access first checks its
+// page in watch_pages, so only accesses to a page with something watched
+// on it look at the per-address bitmaps. None of this is compiled into
+// the handlers a machine runs without a debugger.
+//
+// This file sets those tables up and reads the results back out; see
+// emulator_monitor.cpp for the textgrid view.
+
+#include "emulator_6502.h"
+#include <stdio.h>
+#include <string.h>
+
+void initialize_debugger(Debugger* g) {
+
+    memset(g, 0, sizeof(Debugger));
+    g->ignore_breakpoint = -1;
+}
+
+void set_breakpoint(Debugger* g, unsigned short address, bool on) {
+
+    if(on)
+        g->breakpoints[address >> 3] |= 1 << (address & 7);
+    else
+        g->breakpoints[address >> 3] &= ~(1 << (address & 7));
+}
+
+void watch_memory(Debugger* g, unsigned short first, unsigned short last,
+        unsigned char kinds) {
+
+    for(unsigned int a = first; a <= last; a++) {
+        unsigned char bit = 1 << (a & 7);
+        if(kinds & WATCH_READ)
+            g->watch_reads[a >> 3] |= bit;
+        else
+            g->watch_reads[a >> 3] &= ~bit;
+        if(kinds & WATCH_WRITE)
+            g->watch_writes[a >> 3] |= bit;
+        else
+            g->watch_writes[a >> 3] &= ~bit;
+    }
+
+    //Work the page summary out again for the pages touched
+    for(int page = first >> 8; page <= last >> 8; page++) {
+        g->watch_pages[page] = 0;
+        for(int i = page << 5; i < (page + 1) << 5; i++) {
+            if(g->watch_reads[i])
+                g->watch_pages[page] |= WATCH_READ;
+            if(g->watch_writes[i])
+                g->watch_pages[page] |= WATCH_WRITE;
+        }
+    }
+}
+
+const Trace_Entry* trace_entry(const Debugger* g, int back) {
+
+    if(back < 0 || back >= TRACE_LENGTH || (unsigned int)back >= g->trace_count)
+        return NULL;
+    return &g->trace[(g->trace_count - 1 - back) & (TRACE_LENGTH - 1)];
+}
+
+void disassemble_trace_entry(const Trace_Entry* t, char* text, size_t size) {
+
+    //Back to the bytes the instruction was decoded from
+    unsigned char bytes[3];
+    bytes[0] = t->opcode;
+    bytes[1] = (unsigned char)t->operand;
+    bytes[2] = (unsigned char)(t->operand >> 8);
+    if(OPCODES[t->opcode].mode == MODE_RELATIVE)
+        bytes[1] = (unsigned char)(t->operand - t->cpu.pc - 2);
+    disassemble_instruction(bytes, t->cpu.pc, text, size);
+}
+
+void print_trace(Debugger* g, int count) {
+
+    //Oldest first, the way it ran
+    char text[32];
+    for(int back = count - 1; back >= 0; back--) {
+
+        const Trace_Entry* t = trace_entry(g, back);
+        if(t == NULL)
+            continue;
+
+        disassemble_trace_entry(t, text, sizeof(text));
+
+        printf(" %10llu  $%04X  %-14s A=%02X X=%02X Y=%02X S=%02X P=%02X\n",
+            t->cycles, t->cpu.pc, text, t->cpu.a, t->cpu.x, t->cpu.y,
+            t->cpu.s, t->cpu.p);
+    }
+}
+
+void describe_stop(const Debugger* g, char* text, size_t size) {
+
+    switch(g->stop_reason) {
+        case STOP_BREAKPOINT:
+            snprintf(text, size, "BREAK AT $%04X", g->stop_address);
+            break;
+        case STOP_WATCH_READ:
+            snprintf(text, size, "READ $%04X = $%02X", g->stop_address,
+                g->stop_value);
+            break;
+        case STOP_WATCH_WRITE:
+            snprintf(text, size, "WRITE $%04X = $%02X", g->stop_address,
+                g->stop_value);
+            break;
+        default:
+            snprintf(text, size, "%s", g->resume ? "STOPPED" : "FINISHED");
+            break;
+    }
+}
@@ -0,0 +1,238 @@
+//345678901234567890123456789012345678901234567890123456789012345678901234567890
+//       1         2         3         4         5         6         7         8
+// Filename: ../emulator_disassembler.cpp
+// Last Modified: Tue Oct 20, 2026  09:00AM
+//
+// 6502 disassembler.
+//
+// Everything about an opcode (mnemonic, addressing mode, length) comes from
+// OPCODES[] in emulator_6502.cpp, the same table the CPU and the assembler
+// are built from, and the operand is written in the syntax the assembler
+// reads, so the output assembles back to the same bytes. An absolute
+// operand under $100, which the assembler would make zero page, gets an
+// a: in front (LDA a:$0010) where the instruction has a zero page form.
+//
+// A Disassembler walks an address range one instruction at a time;
+// next_instruction() fills in a Disasm_Line the caller owns, and
+// disassemble_lines() fills an array of them. Each opcode's text is a head
+// ("LDA (") and tail (",X)") worked out once from OPCODES[], with the
+// operand written between them in hex or by name; there's no printf, so a
+// whole 64KB disassembles in about a millisecond and the monitor can redraw
+// its code view every frame.
+//
+// With a Symbol_Table (kept by assemble_source()), an operand address that
+// has a name is shown by the name, and each line's label is the name at
+// its own address. Immediate operands are always shown as numbers.
+
+#include "emulator_6502.h"
+#include <string.h>
+
+const char HEX_DIGITS[] = "0123456789ABCDEF";
+
+// SYMBOLS ////////////////////////////////////////////////////////////////////
+
+void clear_symbols(Symbol_Table* t) {
+
+    t->count = 0;
+    memset(t->at, 0, sizeof(t->at));
+}
+
+bool add_symbol(Symbol_Table* t, const char* name, int length, int value) {
+
+    if(t->count == MAX_TABLE_SYMBOLS)
+        return false;
+    if(length > MAX_SYMBOL_NAME)
+        length = MAX_SYMBOL_NAME;
+
+    int i = t->count++;
+    memcpy(t->name[i], name, length);
+    t->name[i][length] = 0;
+    t->value[i] = (unsigned short)value;
+
+    //Only addresses can be named in the output
+    if(value >= 0 && value <= 0xFFFF && t->at[value] == 0)
+        t->at[value] = (unsigned short)(i + 1);
+    return true;
+}
+
+const char* symbol_at(const Symbol_Table* t, unsigned short address) {
+
+    int i = t->at[address];
+    return (i != 0) ? t->name[i - 1] : NULL;
+}
+
+// FORMATTING /////////////////////////////////////////////////////////////////
+
+// Built once from OPCODES[]: each opcode's text is head, operand, tail
+struct Disasm_Format {
+    char          head[8];        // "LDA (" ...
+    char          tail[4];        // ... ",X)"
+    unsigned char head_length;
+    unsigned char tail_length;
+    unsigned char digits;         // 0 (no operand), 2 or 4
+    bool          address;        // the operand can have a name
+    bool          zero_page_form; // absolute, with a zero page twin
+};
+
+Disasm_Format disasm_formats[256];
+bool disassembler_tables_ready = false;
+
+void build_disassembler_tables(void) {
+
+    //Operand syntax by addressing mode, as the assembler reads it
+    const char* HEADS[NUM_ADDRESS_MODES] = {
+        "", "", " A", " #", " ", " ", " ", " ", " ", " ", " (", " (", " (", " "
+    };
+    const char* TAILS[NUM_ADDRESS_MODES] = {
+        "", "", "", "", "", ",X", ",Y", "", ",X", ",Y", ")", ",X)", "),Y", ""
+    };
+    const unsigned char DIGITS[NUM_ADDRESS_MODES] = {
+        0, 0, 0, 2, 2, 2, 2, 4, 4, 4, 4, 2, 2, 4
+    };
+
+    for(int op = 0; op < 256; op++) {
+        Disasm_Format* f = &disasm_formats[op];
+        int mode = OPCODES[op].mode;
+        memset(f, 0, sizeof(Disasm_Format));
+        memcpy(f->head, OPCODES[op].mnemonic, 3);
+        f->head_length = 3 + strlen(HEADS[mode]);
+        memcpy(f->head + 3, HEADS[mode], strlen(HEADS[mode]));
+        f->tail_length = strlen(TAILS[mode]);
+        memcpy(f->tail, TAILS[mode], f->tail_length);
+        f->digits = DIGITS[mode];
+        f->address = (mode != MODE_IMMEDIATE);
+
+        //The zero page modes are three before their absolute ones
+        if(mode == MODE_ABSOLUTE || mode == MODE_ABSOLUTE_X ||
+                mode == MODE_ABSOLUTE_Y) {
+            for(int other = 0; other < 256; other++) {
+                const Opcode_Info* twin = &OPCODES[other];
+                if(twin->mode == mode - 3 &&
+                        memcmp(twin->mnemonic, OPCODES[op].mnemonic, 3) == 0)
+                    f->zero_page_form = true;
+            }
+        }
+    }
+    disassembler_tables_ready = true;
+}
+
+int format_instruction(const unsigned char* bytes, unsigned short address,
+        const Symbol_Table* symbols, char* text) {
+
+    if(disassembler_tables_ready == false)
+        build_disassembler_tables();
+
+    //Whole head and tail copied each time, only the length counts; the
+    //longest line, " a:" + MAX_SYMBOL_NAME + ",X", leaves room for it
+    const Disasm_Format* f = &disasm_formats[bytes[0]];
+    const Opcode_Info* info = &OPCODES[bytes[0]];
+    char* out = text;
+    memcpy(out, f->head, sizeof(f->head));
+    out += f->head_length;
+
+    if(f->digits != 0) {
+        unsigned short operand = bytes[1];
+        if(info->length == 3)
+            operand |= bytes[2] << 8;
+        if(info->mode == MODE_RELATIVE)
+            operand = address + 2 + (signed char)bytes[1];
+
+        if(f->zero_page_form && operand < 0x100) {
+            *out++ = 'a';
+            *out++ = ':';
+        }
+
+        int symbol = (symbols != NULL && f->address) ? symbols->at[operand] : 0;
+        if(symbol != 0) {
+            const char* name = symbols->name[symbol - 1];
+            while(*name != 0)
+                *out++ = *name++;
+        } else {
+            *out++ = '$';
+            if(f->digits == 4) {
+                *out++ = HEX_DIGITS[operand >> 12];
+                *out++ = HEX_DIGITS[(operand >> 8) & 15];
+            }
+            *out++ = HEX_DIGITS[(operand >> 4) & 15];
+            *out++ = HEX_DIGITS[operand & 15];
+        }
+
+        memcpy(out, f->tail, sizeof(f->tail));
+        out += f->tail_length;
+    }
+
+    *out = 0;
+    return info->length;
+}
+
+int disassemble_instruction(const unsigned char* bytes, unsigned short address,
+        char* text, size_t size) {
+
+    char line[DISASM_TEXT_SIZE];
+    int length = format_instruction(bytes, address, NULL, line);
+    if(size > 0) {
+        size_t n = strlen(line);
+        if(n > size - 1)
+            n = size - 1;
+        memcpy(text, line, n);
+        text[n] = 0;
+    }
+    return length;
+}
+
+// STREAMING //////////////////////////////////////////////////////////////////
+
+void start_disassembly(Disassembler* d, const unsigned char* m,
+        unsigned short first, unsigned int end, const Symbol_Table* symbols) {
+
+    d->m = m;
+    d->v = NULL;
+    d->address = first;
+    d->end = (end > 65536) ? 65536 : end;
+    d->symbols = symbols;
+}
+
+void start_machine_disassembly(Disassembler* d, Machine* v,
+        unsigned short first, unsigned int end, const Symbol_Table* symbols) {
+
+    //Straight out of m[] unless there's a bus to go through
+    start_disassembly(d, (v->bus == NULL) ? v->m : NULL, first, end, symbols);
+    d->v = v;
+}
+
+bool next_instruction(Disassembler* d, Disasm_Line* line) {
+
+    if(d->address >= d->end)
+        return false;
+
+    //Into locals first: stores to unsigned chars could alias *d
+    unsigned short address = (unsigned short)d->address;
+    const Symbol_Table* symbols = d->symbols;
+    unsigned char bytes[3];
+    if(d->m != NULL && address <= 0xFFFD) {
+        memcpy(bytes, d->m + address, 3);
+    } else {
+        for(int i = 0; i < 3; i++) {
+            unsigned short a = (unsigned short)(address + i);
+            bytes[i] = (d->m != NULL) ? d->m[a] : read_byte(d->v, a);
+        }
+    }
+
+    int length = format_instruction(bytes, address, symbols, line->text);
+    line->address = address;
+    line->length = (unsigned char)length;
+    memcpy(line->bytes, bytes, 3);
+    line->label = (symbols != NULL) ? symbol_at(symbols, address) : NULL;
+
+    //An instruction running past the end is still shown whole
+    d->address = address + length;
+    return true;
+}
+
+int disassemble_lines(Disassembler* d, Disasm_Line* lines, int count) {
+
+    int n = 0;
+    while(n < count && next_instruction(d, &lines[n]))
+        n++;
+    return n;
+}
@@ -0,0 +1,308 @@
+//345678901234567890123456789012345678901234567890123456789012345678901234567890
+//       1         2         3         4         5         6         7         8
+// Filename: ../emulator_dynarec.cpp
+// Last Modified: Tue Oct 20, 2026  08:40AM
+//
+// 6502 block translator.
+//
+// run_6502_blocks() runs the same programs as run_6502(), a basic block at
+// a time. A block is the straight run of instructions starting at some
+// address, up to and including the first one that can jump (a branch,
+// JMP, JSR, RTS, RTI or BRK), MAX_BLOCK_OPS at most. The first time the CPU
+// reaches the address, the block's instructions are copied out of the
+// decode cache into one array of handler + operand closures; from then on
+// the block runs as a plain loop of calls, with pc and the cycle count
+// updated once for the whole block instead of per instruction.
+//
+// Flags are only worked out where something can see them. When a block is
+// translated it's walked backwards keeping track of which flags are still
+// to be read (by a branch, ADC, ROL, PHP, ...) before something else sets
+// them. An instruction whose flags are all overwritten first, like the LDA
+// in LDA / CMP / BNE, gets the version of its handler that leaves p alone
+// (op_handlers(v, false)). Everything is taken to be read at the end of a
+// block and after any store, since the block can end there.
+//
+// Blocks are found by their start address. A store onto a code page (see
+// emulator_cpu.cpp) throws away the blocks with bytes on that page too, and
+// if that's the running block it stops straight after the store, so
+// self-modifying code sees its own changes on the next instruction just as
+// it would in the interpreter. An address whose block has been thrown away
+// MAX_BLOCK_REBUILDS times is left to the interpreter from then on, rather
+// than translating it over and over.
+//
+// This builds chains of calls rather than machine code so that it runs the
+// same on every compiler and OS the engine is built with.
+
+#include "emulator_6502.h"
+#include <stdlib.h>
+#include <string.h>
+
+const int MAX_BLOCK_OPS = 32;
+const int MAX_BLOCK_BYTES = MAX_BLOCK_OPS * 3;
+const int BLOCK_POOL_SIZE = 4096;
+const int MAX_BLOCK_REBUILDS = 8;
+
+struct Block {
+    unsigned short start;
+    unsigned int   end;                    // one past the last byte
+    int            count;
+    unsigned int   cycles;                 // base cycles of every op
+    Decoded_Op     ops[MAX_BLOCK_OPS];
+    bool           writes[MAX_BLOCK_OPS];  // op can store to memory
+    Block*         next_free;
+};
+
+struct Block_Cache {
+    Block*        blocks[65536];           // by start address, NULL if none
+    unsigned char rebuilds[65536];
+    Block*        pool;
+    Block*        free_list;
+    Block*        running;
+    bool          running_killed;          // a store threw away the running
+                                           // block
+};
+
+// Built once from OPCODES[]
+unsigned char flags_written[256];          // always set by the op
+unsigned char flags_read[256];
+bool          ends_block[256];
+bool          writes_memory[256];
+bool          block_tables_ready = false;
+
+struct Flag_Use {
+    const char*   mnemonic;
+    unsigned char written;
+    unsigned char read;
+};
+
+const Flag_Use FLAG_USES[] = {
+    { "LDA", FLAG_N | FLAG_Z, 0 },  { "LDX", FLAG_N | FLAG_Z, 0 },
+    { "LDY", FLAG_N | FLAG_Z, 0 },  { "TAX", FLAG_N | FLAG_Z, 0 },
+    { "TAY", FLAG_N | FLAG_Z, 0 },  { "TXA", FLAG_N | FLAG_Z, 0 },
+    { "TYA", FLAG_N | FLAG_Z, 0 },  { "TSX", FLAG_N | FLAG_Z, 0 },
+    { "INX", FLAG_N | FLAG_Z, 0 },  { "INY", FLAG_N | FLAG_Z, 0 },
+    { "DEX", FLAG_N | FLAG_Z, 0 },  { "DEY", FLAG_N | FLAG_Z, 0 },
+    { "INC", FLAG_N | FLAG_Z, 0 },  { "DEC", FLAG_N | FLAG_Z, 0 },
+    { "ORA", FLAG_N | FLAG_Z, 0 },  { "AND", FLAG_N | FLAG_Z, 0 },
+    { "EOR", FLAG_N | FLAG_Z, 0 },  { "PLA", FLAG_N | FLAG_Z, 0 },
+    { "CMP", FLAG_N | FLAG_Z | FLAG_C, 0 },
+    { "CPX", FLAG_N | FLAG_Z | FLAG_C, 0 },
+    { "CPY", FLAG_N | FLAG_Z | FLAG_C, 0 },
+    { "BIT", FLAG_N | FLAG_Z | FLAG_V, 0 },
+    { "ASL", FLAG_N | FLAG_Z | FLAG_C, 0 },
+    { "LSR", FLAG_N | FLAG_Z | FLAG_C, 0 },
+    { "ROL", FLAG_N | FLAG_Z | FLAG_C, FLAG_C },
+    { "ROR", FLAG_N | FLAG_Z | FLAG_C, FLAG_C },
+    { "ADC", FLAG_N | FLAG_Z | FLAG_C | FLAG_V, FLAG_C | FLAG_D },
+    { "SBC", FLAG_N | FLAG_Z | FLAG_C | FLAG_V, FLAG_C | FLAG_D },
+    { "CLC", FLAG_C, 0 },  { "SEC", FLAG_C, 0 },
+    { "CLD", FLAG_D, 0 },  { "SED", FLAG_D, 0 },
+    { "CLI", FLAG_I, 0 },  { "SEI", FLAG_I, 0 },
+    { "CLV", FLAG_V, 0 },
+    { "PLP", 0xFF, 0 },    { "RTI", 0xFF, 0 },
+    { "PHP", 0, 0xFF },    { "BRK", 0, 0xFF },
+    { "BPL", 0, FLAG_N },  { "BMI", 0, FLAG_N },
+    { "BVC", 0, FLAG_V },  { "BVS", 0, FLAG_V },
+    { "BCC", 0, FLAG_C },  { "BCS", 0, FLAG_C },
+    { "BNE", 0, FLAG_Z },  { "BEQ", 0, FLAG_Z },
+};
+
+void build_block_tables(void) {
+
+    const int num_uses = sizeof(FLAG_USES) / sizeof(FLAG_USES[0]);
+
+    for(int op = 0; op < 256; op++) {
+
+        const char* name = OPCODES[op].mnemonic;
+        for(int i = 0; i < num_uses; i++) {
+            if(strcmp(name, FLAG_USES[i].mnemonic) == 0) {
+                flags_written[op] = FLAG_USES[i].written;
+                flags_read[op] = FLAG_USES[i].read;
+            }
+        }
+
+        ends_block[op] = OPCODES[op].mode == MODE_RELATIVE ||
+            strcmp(name, "JMP") == 0 || strcmp(name, "JSR") == 0 ||
+            strcmp(name, "RTS") == 0 || strcmp(name, "RTI") == 0 ||
+            strcmp(name, "BRK") == 0;
+
+        bool modify = strcmp(name, "INC") == 0 || strcmp(name, "DEC") == 0 ||
+            strcmp(name, "ASL") == 0 || strcmp(name, "LSR") == 0 ||
+            strcmp(name, "ROL") == 0 || strcmp(name, "ROR") == 0;
+        writes_memory[op] = strcmp(name, "STA") == 0 ||
+            strcmp(name, "STX") == 0 || strcmp(name, "STY") == 0 ||
+            strcmp(name, "PHA") == 0 || strcmp(name, "PHP") == 0 ||
+            (modify && OPCODES[op].mode != MODE_ACCUMULATOR);
+    }
+
+    block_tables_ready = true;
+}
+
+void flush_blocks(Block_Cache* bc) {
+
+    memset(bc->blocks, 0, sizeof(bc->blocks));
+    bc->free_list = NULL;
+    for(int i = BLOCK_POOL_SIZE - 1; i >= 0; i--) {
+        bc->pool[i].next_free = bc->free_list;
+        bc->free_list = &bc->pool[i];
+    }
+    bc->running_killed = true;     // the running block may be reused
+}
+
+Block* translate_block(Machine* v, unsigned short pc) {
+
+    Block_Cache* bc = v->blocks;
+    if(bc->free_list == NULL)
+        flush_blocks(bc);
+
+    Block* b = bc->free_list;
+    bc->free_list = b->next_free;
+
+    b->start = pc;
+    b->count = 0;
+    b->cycles = 0;
+
+    unsigned int address = pc;
+    while(b->count < MAX_BLOCK_OPS) {
+
+        const Decoded_Op* d = &v->cache->ops[address];
+        if(d->execute == NULL)
+            d = decode_at(v, (unsigned short)address);
+
+        b->ops[b->count] = *d;
+        b->writes[b->count] = writes_memory[d->opcode];
+        b->cycles += d->cycles;
+        b->count++;
+
+        address += d->length;
+        if(ends_block[d->opcode] || address > 0xFFFF)
+            break;
+    }
+    b->end = address;
+
+    //Backwards: which flags does anything still read?
+    const Op_Handler* no_flags = op_handlers(v, false);
+    unsigned char live = 0xFF;
+    for(int i = b->count - 1; i >= 0; i--) {
+        unsigned char op = b->ops[i].opcode;
+        if(b->writes[i])
+            live = 0xFF;           // the block can end after a store
+        if((flags_written[op] & live) == 0 && no_flags[op] != NULL)
+            b->ops[i].execute = no_flags[op];
+        live = (live & ~flags_written[op]) | flags_read[op];
+    }
+
+    bc->blocks[pc] = b;
+    return b;
+}
+
+void invalidate_blocks(Machine* v, int page) {
+
+    //Any block with a byte on this page
+    Block_Cache* bc = v->blocks;
+    int first = (page << 8) - MAX_BLOCK_BYTES;
+    for(int i = (first < 0) ? 0 : first; i < (page + 1) << 8; i++) {
+
+        Block* b = bc->blocks[i];
+        if(b == NULL || b->end <= (unsigned int)(page << 8))
+            continue;
+
+        if(b == bc->running)
+            bc->running_killed = true;
+        if(bc->rebuilds[i] < 255)
+            bc->rebuilds[i]++;
+        bc->blocks[i] = NULL;
+        b->next_free = bc->free_list;
+        bc->free_list = b;
+    }
+}
+
+void reset_blocks(Machine* v) {
+
+    //Blocks are only made from code pages, so invalidate_decode_cache() has
+    //thrown them all away already; a different program starts with no
+    //rebuilds counted against it
+    if(v->blocks != NULL)
+        memset(v->blocks->rebuilds, 0, sizeof(v->blocks->rebuilds));
+}
+
+void free_blocks(Machine* v) {
+
+    if(v->blocks != NULL) {
+        free(v->blocks->pool);
+        free(v->blocks);
+        v->blocks = NULL;
+    }
+}
+
+unsigned long run_6502_blocks(Machine* v, unsigned long long max_cycles) {
+
+    if(block_tables_ready == false)
+        build_block_tables();
+    if(v->profile != NULL || v->debugger != NULL)
+        return run_6502(v, max_cycles);    // hooks every instruction
+
+    if(v->blocks == NULL) {
+        v->blocks = (Block_Cache*)calloc(1, sizeof(Block_Cache));
+        if(v->blocks == NULL)
+            return run_6502(v, max_cycles);
+        v->blocks->pool = (Block*)malloc(BLOCK_POOL_SIZE * sizeof(Block));
+        if(v->blocks->pool == NULL) {
+            free_blocks(v);
+            return run_6502(v, max_cycles);
+        }
+        flush_blocks(v->blocks);
+    }
+
+    CPU* c = &v->cpu;
+    Block_Cache* bc = v->blocks;
+    unsigned long long limit = v->cycles + max_cycles;
+    unsigned long long instructions = v->instructions;
+
+    v->halted = false;
+    v->stack_base = c->s;
+
+    while(v->halted == false && v->cycles < limit) {
+
+        Block* b = bc->blocks[c->pc];
+        if(b == NULL) {
+            if(bc->rebuilds[c->pc] >= MAX_BLOCK_REBUILDS) {
+                step_6502(v);      // keeps changing, interpret it
+                continue;
+            }
+            b = translate_block(v, c->pc);
+        }
+
+        bc->running = b;
+        bc->running_killed = false;
+
+        //Only the last op can jump or needs pc
+        const Decoded_Op* ops = b->ops;
+        int last = b->count - 1;
+        int i = 0;
+        for(; i < last; i++) {
+            ops[i].execute(v, &ops[i]);
+            if(b->writes[i] && bc->running_killed)
+                break;
+        }
+
+        if(i == last) {
+            c->pc = (unsigned short)b->end;
+            v->cycles += b->cycles;
+            v->instructions += b->count;
+            ops[last].execute(v, &ops[last]);
+        } else {
+            //A store changed this block's code: carry on after the store
+            unsigned int pc = b->start;
+            for(int j = 0; j <= i; j++) {
+                pc += ops[j].length;
+                v->cycles += ops[j].cycles;
+            }
+            c->pc = (unsigned short)pc;
+            v->instructions += i + 1;
+        }
+    }
+
+    bc->running = NULL;
+    return (unsigned long)(v->instructions - instructions);
+}
@@ -0,0 +1,110 @@
+//345678901234567890123456789012345678901234567890123456789012345678901234567890
+//       1         2         3         4         5         6         7         8
+// Filename: ../emulator_monitor.cpp
+// Last Modified: Tue Oct 20, 2026  06:40AM
+//
+// Machine monitor on the textgrid.
+//
+// draw_monitor() fills the 40x25 textgrid with a view of a machine that's
+// being debugged (see emulator_debugger.cpp):
+//
+//     registers, flags and the cycle count
+//     why the last run stopped
+//     the last instructions traced, oldest at the top
+//     the code from pc on (> marks pc, * a breakpoint), with the labels
+//         from a Symbol_Table if there is one
+//     the memory around pc
+//
+// It's meant to be called once a frame; test_program.cpp does with -d.
+
+#include "engine_india.h"
+#include "emulator_6502.h"
+#include <stdarg.h>
+
+const int MONITOR_TRACE_ROWS = 8;
+const int MONITOR_CODE_ROWS = 6;
+const int MONITOR_MEMORY_ROWS = 4;
+
+// A whole row, padded with spaces so it covers what was there before
+void monitor_row(int row, const char* format, ...) {
+
+    char line[TEXTGRID_WIDTH + 1];
+    va_list args;
+    va_start(args, format);
+    vsnprintf(line, sizeof(line), format, args);
+    va_end(args);
+
+    int c = 0;
+    for(; line[c] != 0 && c < TEXTGRID_WIDTH; c++)
+        textgrid_foreground[row][c] = line[c];
+    for(; c < TEXTGRID_WIDTH; c++)
+        textgrid_foreground[row][c] = ' ';
+}
+
+void draw_monitor(Machine* v, const Symbol_Table* symbols) {
+
+    Debugger* g = v->debugger;
+    CPU* c = &v->cpu;
+    char text[32];
+    int row = 0;
+
+    monitor_row(row++, "PC   A  X  Y  S  NV-BDIZC  CYCLES");
+    char flags[9];
+    for(int bit = 0; bit < 8; bit++)
+        flags[bit] = (c->p & (0x80 >> bit)) ? '1' : '0';
+    flags[8] = 0;
+    monitor_row(row++, "%04X %02X %02X %02X %02X %s  %llu", c->pc, c->a, c->x,
+        c->y, c->s, flags, v->cycles);
+
+    if(g != NULL)
+        describe_stop(g, text, sizeof(text));
+    else
+        snprintf(text, sizeof(text), "NO DEBUGGER");
+    monitor_row(row++, "%s", text);
+
+    //Trace, oldest first
+    monitor_row(row++, "-- TRACE ------------------------------");
+    for(int i = 0; i < MONITOR_TRACE_ROWS; i++) {
+        const Trace_Entry* t = (g != NULL) ?
+            trace_entry(g, MONITOR_TRACE_ROWS - 1 - i) : NULL;
+        if(t == NULL) {
+            monitor_row(row++, "");
+            continue;
+        }
+        disassemble_trace_entry(t, text, sizeof(text));
+        monitor_row(row++, "%04X %-13s A%02X X%02X Y%02X", t->cpu.pc, text,
+            t->cpu.a, t->cpu.x, t->cpu.y);
+    }
+
+    //Code from pc
+    monitor_row(row++, "-- CODE -------------------------------");
+    Disassembler d;
+    Disasm_Line lines[MONITOR_CODE_ROWS];
+    start_machine_disassembly(&d, v, c->pc, 65536, symbols);
+    int count = disassemble_lines(&d, lines, MONITOR_CODE_ROWS);
+    for(int i = 0; i < MONITOR_CODE_ROWS; i++) {
+        if(i >= count) {
+            monitor_row(row++, "");
+            continue;
+        }
+        unsigned short address = lines[i].address;
+        const char* label = lines[i].label;
+        bool breakpoint = g != NULL &&
+            (g->breakpoints[address >> 3] & (1 << (address & 7)));
+        monitor_row(row++, "%c%c%04X %-18s %s%s", (i == 0) ? '>' : ' ',
+            breakpoint ? '*' : ' ', address, lines[i].text,
+            (label != NULL) ? label : "", (label != NULL) ? ":" : "");
+    }
+
+    //Memory around pc, 8 bytes a row
+    monitor_row(row++, "-- MEMORY -----------------------------");
+    unsigned short address = (c->pc & 0xFFF8) - 8;
+    for(int i = 0; i < MONITOR_MEMORY_ROWS; i++, address += 8) {
+        char hex[3 * 8 + 1];
+        for(int b = 0; b < 8; b++)
+            snprintf(hex + 3 * b, 4, "%02X ", read_byte(v, address + b));
+        monitor_row(row++, "%04X %s", address, hex);
+    }
+
+    monitor_row(TEXTGRID_HEIGHT - 1, "F10 STEP  F5 RUN  F9 BREAK AT PC");
+}
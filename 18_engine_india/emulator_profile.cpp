@@ -0,0 +1,184 @@
+//345678901234567890123456789012345678901234567890123456789012345678901234567890
+//       1         2         3         4         5         6         7         8
+// Filename: ../emulator_profile.cpp
+// Last Modified: Tue Oct 20, 2026  05:10AM
+//
+// Profile report for 6502 programs.
+//
+// Attach a zeroed Profile to a machine (attach_profile(), the counting is
+// done by the CPU core in emulator_cpu.cpp), run it, then print_profile()
+// lists where the time went:
+//
+//     the top addresses by cycles, disassembled
+//     the top basic blocks by cycles (straight runs of instructions that
+//         were executed the same number of times, up to a branch or jump)
+//     the top opcodes by count
+//     the most read and written data addresses
+//     a map of data accesses per 256-byte page
+//
+// Instructions are disassembled from memory as it is when the report is
+// printed, which is what ran unless the program changed its own code.
+
+#include "emulator_6502.h"
+#include <stdio.h>
+#include <string.h>
+
+const int MAX_PROFILE_TOP = 64;
+
+const char* MODE_NAMES[NUM_ADDRESS_MODES] = {
+    "", "", "A", "#", "zp", "zp,X", "zp,Y", "abs", "abs,X", "abs,Y", "(ind)",
+    "(zp,X)", "(zp),Y", "rel"
+};
+
+// Keeps the n largest keys seen, largest first
+void insert_top(int* top, unsigned long long* keys, int* count, int n,
+        int index, unsigned long long key) {
+
+    if(key == 0 || (*count == n && key <= keys[n - 1]))
+        return;
+
+    int i = (*count < n) ? (*count)++ : n - 1;
+    while(i > 0 && keys[i - 1] < key) {
+        top[i] = top[i - 1];
+        keys[i] = keys[i - 1];
+        i--;
+    }
+    top[i] = index;
+    keys[i] = key;
+}
+
+void disassemble_at(Machine* v, unsigned short address, char* text,
+        size_t size) {
+
+    unsigned char bytes[3];
+    for(int i = 0; i < 3; i++)
+        bytes[i] = read_byte(v, address + i);
+    disassemble_instruction(bytes, address, text, size);
+}
+
+// A block runs up to a branch or jump, or to an instruction that was
+// executed a different number of times. Returns the address after it.
+int walk_block(Machine* v, const Profile* p, int start, int* last,
+        int* length, unsigned long long* cycles) {
+
+    int a = start;
+    *length = 0;
+    *cycles = 0;
+    while(true) {
+        unsigned char opcode = read_byte(v, a);
+        *last = a;
+        *length += 1;
+        *cycles += p->cycles[a];
+        a += OPCODES[opcode].length;
+        if(ends_block[opcode] || a >= 65536 ||
+                p->executions[a] != p->executions[start])
+            return a;
+    }
+}
+
+double percent(unsigned long long part, unsigned long long whole) {
+    return (whole > 0) ? part * 100.0 / whole : 0.0;
+}
+
+void print_profile(Machine* v, int top) {
+
+    const Profile* p = v->profile;
+    if(p == NULL)
+        return;
+    if(top > MAX_PROFILE_TOP)
+        top = MAX_PROFILE_TOP;
+    build_block_tables();
+
+    unsigned long long instructions = 0, cycles = 0, accesses = 0;
+    for(int a = 0; a < 65536; a++) {
+        instructions += p->executions[a];
+        cycles += p->cycles[a];
+        accesses += (unsigned long long)p->reads[a] + p->writes[a];
+    }
+    printf("\n PROFILE: %llu INSTRUCTIONS, %llu CYCLES\n", instructions,
+        cycles);
+
+    int hot[MAX_PROFILE_TOP];
+    unsigned long long keys[MAX_PROFILE_TOP];
+    int count = 0;
+    char text[32];
+
+    //Addresses
+    for(int a = 0; a < 65536; a++)
+        insert_top(hot, keys, &count, top, a, p->cycles[a]);
+
+    printf("\n HOT ADDRESSES            EXECUTED      CYCLES\n");
+    for(int i = 0; i < count; i++) {
+        disassemble_at(v, hot[i], text, sizeof(text));
+        printf("  $%04X  %-14s %10llu  %10llu  %5.1f%%\n", hot[i], text,
+            p->executions[hot[i]], keys[i], percent(keys[i], cycles));
+    }
+
+    //Blocks
+    count = 0;
+    int last, length;
+    unsigned long long block_cycles;
+    for(int a = 0; a < 65536; ) {
+        if(p->executions[a] == 0) {
+            a++;
+            continue;
+        }
+        int start = a;
+        a = walk_block(v, p, start, &last, &length, &block_cycles);
+        insert_top(hot, keys, &count, top, start, block_cycles);
+    }
+
+    printf("\n HOT BLOCKS                ENTERED      CYCLES\n");
+    for(int i = 0; i < count; i++) {
+        walk_block(v, p, hot[i], &last, &length, &block_cycles);
+        printf("  $%04X-$%04X  %3d OPS  %10llu  %10llu  %5.1f%%\n", hot[i],
+            last, length, p->executions[hot[i]], keys[i],
+            percent(keys[i], cycles));
+    }
+
+    //Opcodes
+    count = 0;
+    for(int op = 0; op < 256; op++)
+        insert_top(hot, keys, &count, top, op, p->opcodes[op]);
+
+    printf("\n HOT OPCODES               EXECUTED\n");
+    for(int i = 0; i < count; i++) {
+        printf("  $%02X  %s %-12s %10llu  %5.1f%%\n", hot[i],
+            OPCODES[hot[i]].mnemonic, MODE_NAMES[OPCODES[hot[i]].mode],
+            keys[i], percent(keys[i], instructions));
+    }
+
+    //Data
+    count = 0;
+    for(int a = 0; a < 65536; a++)
+        insert_top(hot, keys, &count, top, a,
+            (unsigned long long)p->reads[a] + p->writes[a]);
+
+    printf("\n HOT DATA          READS      WRITES\n");
+    for(int i = 0; i < count; i++) {
+        printf("  $%04X  %10u  %10u  %5.1f%%\n", hot[i], p->reads[hot[i]],
+            p->writes[hot[i]], percent(keys[i], accesses));
+    }
+
+    //Map of accesses per page, darker is busier
+    unsigned long long pages[256];
+    unsigned long long busiest = 0;
+    memset(pages, 0, sizeof(pages));
+    for(int a = 0; a < 65536; a++) {
+        pages[a >> 8] += (unsigned long long)p->reads[a] + p->writes[a];
+        if(pages[a >> 8] > busiest)
+            busiest = pages[a >> 8];
+    }
+
+    const char SHADES[] = " .:-=+*#%@";
+    printf("\n DATA ACCESSES BY PAGE   0123456789ABCDEF\n");
+    for(int row = 0; row < 16; row++) {
+        printf("                 $%X000  ", row);
+        for(int column = 0; column < 16; column++) {
+            unsigned long long n = pages[row * 16 + column];
+            int shade = (n == 0) ? 0 : 1 + (int)(n * 8 / busiest);
+            putchar(SHADES[shade]);
+        }
+        printf("\n");
+    }
+}
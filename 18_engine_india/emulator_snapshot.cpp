@@ -0,0 +1,213 @@
+//345678901234567890123456789012345678901234567890123456789012345678901234567890
+//       1         2         3         4         5         6         7         8
+// Filename: ../emulator_snapshot.cpp
+// Last Modified: Tue Oct 20, 2026  08:30AM
+//
+// Machine snapshots with copy-on-write memory.
+//
+// A machine set up with initialize_cow_memory() keeps its 64KB as 256
+// separately allocated, reference counted pages behind a Memory_Bus (see
+// emulator_cpu.cpp), instead of one array. A snapshot is the CPU, the
+// counters and a table of 256 page pointers; taking one doesn't copy any
+// memory, it just shares the pages. Restoring one points the machine's
+// pages back at the snapshot's.
+//
+// A shared page is mapped read-only with cow_write() as its I/O write
+// handler, so the first store to it copies the page (or, if nothing else
+// holds it any more, just takes it back), maps the copy writable and marks
+// the page dirty. Stores to a page that is already dirty are plain pointer
+// writes like any RAM. Taking a snapshot only has to remap the pages in
+// the dirty bitmap, the ones written since the last snapshot or restore.
+//
+// Restore throws away decoded ops only for code pages whose page pointer
+// changed. A snapshot can be restored into another machine's Cow_Memory,
+// to fork a run.
+//
+// Machines on different threads can share pages: reference counts change
+// atomically and the list of free pages is behind a spinlock, so each
+// thread can take, restore (the same snapshot too) and free snapshots on
+// its own Cow_Memory at the same time as the others. One Cow_Memory still
+// only belongs to one thread at a time. The atomics are GCC builtins, as
+// the Makefile builds with g++.
+
+#include "emulator_6502.h"
+#include <stdlib.h>
+#include <string.h>
+
+struct Cow_Page {
+    unsigned char bytes[256];
+    volatile int  refs;
+    Cow_Page*     next_free;
+};
+
+Cow_Page*    free_pages = NULL;
+volatile int free_pages_lock = 0;
+
+void lock_free_pages(void) {
+    while(__sync_lock_test_and_set(&free_pages_lock, 1)) {
+        while(__atomic_load_n(&free_pages_lock, __ATOMIC_RELAXED) != 0)
+            ;
+    }
+}
+
+void unlock_free_pages(void) {
+    __sync_lock_release(&free_pages_lock);
+}
+
+Cow_Page* allocate_page(void) {
+
+    lock_free_pages();
+    Cow_Page* page = free_pages;
+    if(page != NULL)
+        free_pages = page->next_free;
+    unlock_free_pages();
+
+    if(page == NULL)
+        page = (Cow_Page*)malloc(sizeof(Cow_Page));
+    if(page != NULL)
+        page->refs = 1;
+    return page;
+}
+
+void share_page(Cow_Page* page) {
+    __sync_add_and_fetch(&page->refs, 1);
+}
+
+void release_page(Cow_Page* page) {
+
+    if(page != NULL && __sync_sub_and_fetch(&page->refs, 1) == 0) {
+        lock_free_pages();
+        page->next_free = free_pages;
+        free_pages = page;
+        unlock_free_pages();
+    }
+}
+
+void cow_write(void* device, unsigned short address, unsigned char value);
+
+void map_shared(Cow_Memory* cow, int page) {
+    map_pages(&cow->bus, page, 1, cow->pages[page]->bytes, NULL, NULL,
+        cow_write, cow);
+}
+
+void map_dirty(Cow_Memory* cow, int page) {
+    map_pages(&cow->bus, page, 1, cow->pages[page]->bytes,
+        cow->pages[page]->bytes, NULL, NULL, NULL);
+    cow->dirty[page >> 5] |= 1u << (page & 31);
+}
+
+// A page mapped to a device since isn't ours to remap
+bool page_is_ours(Cow_Memory* cow, int page) {
+    return cow->bus.pages[page].read == cow->pages[page]->bytes;
+}
+
+void cow_write(void* device, unsigned short address, unsigned char value) {
+
+    Cow_Memory* cow = (Cow_Memory*)device;
+    int page = address >> 8;
+
+    //At 1 nothing else holds the page, so nothing else can start sharing
+    //it; above 1 the other holders only ever read it
+    Cow_Page* shared = cow->pages[page];
+    if(__atomic_load_n(&shared->refs, __ATOMIC_ACQUIRE) > 1) {
+        Cow_Page* copy = allocate_page();
+        if(copy == NULL)
+            return;            // out of memory: the store is lost
+        memcpy(copy->bytes, shared->bytes, 256);
+        release_page(shared);
+        cow->pages[page] = copy;
+    }
+    map_dirty(cow, page);
+
+    //Same bytes at the same address, so decoded ops still hold; this goes
+    //through the normal store for the code page check
+    write_byte(cow->v, address, value);
+}
+
+bool initialize_cow_memory(Cow_Memory* cow, Machine* v,
+        const unsigned char* image) {
+
+    memset(cow, 0, sizeof(Cow_Memory));
+    cow->v = v;
+    for(int page = 0; page < 256; page++) {
+        cow->pages[page] = allocate_page();
+        if(cow->pages[page] == NULL) {
+            free_cow_memory(cow);
+            return false;
+        }
+        if(image != NULL)
+            memcpy(cow->pages[page]->bytes, image + (page << 8), 256);
+        else
+            memset(cow->pages[page]->bytes, 0, 256);
+        map_dirty(cow, page);
+    }
+
+    attach_bus(v, &cow->bus);
+    return true;
+}
+
+void free_cow_memory(Cow_Memory* cow) {
+
+    if(cow->v != NULL && cow->v->bus == &cow->bus)
+        attach_bus(cow->v, NULL);
+    for(int page = 0; page < 256; page++) {
+        release_page(cow->pages[page]);
+        cow->pages[page] = NULL;
+    }
+}
+
+void take_snapshot(Cow_Memory* cow, Snapshot* s) {
+
+    //Only pages written since the last snapshot or restore are writable,
+    //and they're the only ones that need mapping read-only again
+    for(int word = 0; word < 8; word++) {
+        unsigned int bits = cow->dirty[word];
+        cow->dirty[word] = 0;
+        for(int bit = 0; bits != 0; bit++, bits >>= 1) {
+            int page = (word << 5) | bit;
+            if((bits & 1) && page_is_ours(cow, page))
+                map_shared(cow, page);
+        }
+    }
+
+    for(int page = 0; page < 256; page++) {
+        s->pages[page] = cow->pages[page];
+        share_page(s->pages[page]);
+    }
+    s->cpu = cow->v->cpu;
+    s->cycles = cow->v->cycles;
+    s->instructions = cow->v->instructions;
+}
+
+void restore_snapshot(Cow_Memory* cow, const Snapshot* s) {
+
+    Machine* v = cow->v;
+    for(int page = 0; page < 256; page++) {
+
+        Cow_Page* old = cow->pages[page];
+        if(old == s->pages[page])
+            continue;              // still shared, so unchanged and read-only
+
+        bool ours = page_is_ours(cow, page);
+        share_page(s->pages[page]);
+        cow->pages[page] = s->pages[page];
+        if(ours)
+            map_shared(cow, page);
+        if(v->cache->code_page[page])
+            invalidate_code_page(v, page);
+        release_page(old);
+    }
+    memset(cow->dirty, 0, sizeof(cow->dirty));
+
+    v->cpu = s->cpu;
+    v->cycles = s->cycles;
+    v->instructions = s->instructions;
+}
+
+void free_snapshot(Snapshot* s) {
+
+    for(int page = 0; page < 256; page++) {
+        release_page(s->pages[page]);
+        s->pages[page] = NULL;
+    }
+}
@@ -1,7 +1,7 @@
 //345678901234567890123456789012345678901234567890123456789012345678901234567890
 //       1         2         3         4         5         6         7         8
 // Filename: ../test_program.cpp
-// Last Modified: Tue Jun 02, 2020  10:42PM
+// Last Modified: Tue Oct 20, 2026  08:50AM
 // LOC: 641
 // Filesize: 28826 bytes
 
@@ -33,15 +33,16 @@
 
 // ENGINE CODE (BEGIN)  //////////////////////////////////////////////////////
 #include "engine_india.h"
+#include "emulator_6502.h"
 
 void user_starting_loop(void) {}
 void user_keyboard_key_up_handler(SDL_Keycode kc) {}
-void user_keyboard_key_down_handler(SDL_Keycode kc) {}
+void user_keyboard_key_down_handler(SDL_Keycode kc);
 void user_keyboard_alpha_numeric_handler(SDL_Keycode kc) {}
 void user_create_all_textures(void) {}
 void user_destroy_all_textures(void) {}
 void user_gamepad_button_handler(SDL_Event e) {}
-void user_update_sprites(void) {}
+void user_update_sprites(void);
 void user_collision_detection(void) {}
 void user_render_graphics(void) {}
 void user_ending_loop(void) {}
@@ -57,21 +58,18 @@ void user_shutdown(void) {}
 #include <string.h>   // for strcpy() function
 #include <stdlib.h>   // for atoi() function
 
-// Global helpers
-char string_store[256];  // for copying literal strings inside functions
-
 // Hardware constants
 const int MEMORY_SIZE = pow(2,16);  // 65,536 bytes
+const unsigned long long RUN_CYCLE_LIMIT = 100000000;  // stops runaway programs
+const int PROFILE_TOP = 10;           // hot addresses etc. listed by -p
+Profile* profile = NULL;              // set by -p after the file name
+Symbol_Table* symbols = NULL;         // labels of the assembled file
 
-// Hardware
-typedef struct {
-    unsigned char   a;
-    unsigned char   x;
-    unsigned char   y;
-    unsigned short pc; //Program Counter;
-    unsigned char   s; //Stack Pointer
-    unsigned char   p; //Processor Status Register: N V - B D I Z C
-} CPU;
+// -d: the program runs under the monitor instead of straight away
+// (-b, -r and -w add a breakpoint or read/write watchpoint and imply -d)
+bool     debugging = false;
+Machine  debug_machine;
+Debugger debugger;
 
 // Operations on Hardware
 void initialize_cpu(CPU* c) {
@@ -88,9 +86,10 @@ void initialize_memory(unsigned char *m);
 unsigned long fetch_decode_execute(CPU* c, unsigned char *m);
 void print_binary(size_t const size, void const * const ptr);
 void print_cpu_register_content(CPU* c); 
-void print_memory_disassembled(unsigned char *m, unsigned short start_address);
-void format_16bit_int(char *n_string, unsigned char *m, unsigned short s); 
-unsigned short assemble_file_into_memory(char* filename, unsigned char* m); 
+void print_memory_disassembled(unsigned char *m, unsigned short start_address,
+        unsigned int end_address, const Profile* p);
+unsigned short assemble_file_into_memory(char* filename, unsigned char* m,
+        unsigned short* end_address); 
 void test_1(unsigned char m, unsigned char n);
 // EMULATOR CODE (END)     ////////////////////////////////////////////////////
 
@@ -117,11 +116,33 @@ int main(int argc, char* argv[]) {
     printf("\n ARGUMENT COUNT: %d\n", argc);
 
     unsigned short s; // starting address in RAM (16-bit address)
+    unsigned short e; // one past the program's last byte
+    initialize_debugger(&debugger);
+    debugger.tracing = true;
+    for (int i = 2; i < argc; i++) {
+        if (strcmp(argv[i], "-p") == 0) {
+            profile = (Profile*)calloc(1, sizeof(Profile));
+        } else if (strcmp(argv[i], "-d") == 0) {
+            debugging = true;
+        } else if (i + 1 < argc && (strcmp(argv[i], "-b") == 0 ||
+                strcmp(argv[i], "-r") == 0 || strcmp(argv[i], "-w") == 0)) {
+            const char* n = argv[i + 1];
+            unsigned short a = (n[0] == '$') ? strtol(n + 1, NULL, 16) :
+                strtol(n, NULL, 0);
+            if (argv[i][1] == 'b')
+                set_breakpoint(&debugger, a, true);
+            else
+                watch_memory(&debugger, a, a,
+                        (argv[i][1] == 'r') ? WATCH_READ : WATCH_WRITE);
+            debugging = true;
+            i++;
+        }
+    }
     if (argc > 1) {
         printf(" FILE FOUND: %s\n", argv[1]);
-        s = assemble_file_into_memory(argv[1], memory);
+        s = assemble_file_into_memory(argv[1], memory, &e);
         printf(" FILE CONTENTS ASSEMBLED AND LOADED INTO RAM AT LOCATION: %d\n", s);
-        print_memory_disassembled(memory, s);
+        print_memory_disassembled(memory, s, e, NULL);
     }
     else {
         printf(" NO FILE FOUND (ADD AS ARGUMENT)\n");
@@ -141,12 +162,31 @@ int main(int argc, char* argv[]) {
         memory[s+11] = 0x85;
         memory[s+12] = 0x03;
         memory[s+13] = 0x60;  //RTS
-        print_memory_disassembled(memory, s);
+        e = s + 14;
+        print_memory_disassembled(memory, s, e, NULL);
     }
 
     cpu.pc = s; 
     printf("\n CPU pc register (Program Counter) set to %d\n", s);
 
+    if (debugging) {
+        //Stepped from the keyboard in user_keyboard_key_down_handler()
+        keyboard_cursor_enabled = false;
+        initialize_machine(&debug_machine, memory);
+        debug_machine.cpu = cpu;
+        attach_debugger(&debug_machine, &debugger);
+        if (profile != NULL)
+            attach_profile(&debug_machine, profile);
+        printf(" DEBUGGING: F10 STEPS, F5 RUNS, F9 SETS A BREAKPOINT AT PC\n");
+        main_game_loop();
+        SDL_Quit();
+        shutdown_engine();
+        print_trace(&debugger, TRACE_LENGTH);
+        print_profile(&debug_machine, PROFILE_TOP);
+        free_machine(&debug_machine);
+        return 0;
+    }
+
     ////////////////////////////////////////////////////////////
     printf(" CPU now running Fetch-Decode-Execute cycle...\n");
         instructions_executed = 
@@ -158,6 +198,12 @@ int main(int argc, char* argv[]) {
     printf("\n FINAL CPU CONTENTS: \n");
     print_cpu_register_content(&cpu);
 
+    if (profile != NULL) {
+        printf(" PROFILED PROGRAM:");
+        print_memory_disassembled(memory, s, e, profile);
+        free(profile);
+    }
+
 
     // RUN ENGINE ////////////////
     main_game_loop();
@@ -175,6 +221,29 @@ int main(int argc, char* argv[]) {
 
 
 
+void user_update_sprites(void) {
+    if (debugging)
+        draw_monitor(&debug_machine, symbols);
+}
+
+void user_keyboard_key_down_handler(SDL_Keycode kc) {
+
+    //Nothing to run once the program has finished
+    if (debugging == false ||
+            (debugger.resume == false && debug_machine.instructions > 0))
+        return;
+
+    if (kc == SDLK_F10) {
+        run_6502(&debug_machine, 1);
+    } else if (kc == SDLK_F5) {
+        run_6502(&debug_machine, RUN_CYCLE_LIMIT);
+    } else if (kc == SDLK_F9) {
+        unsigned short pc = debug_machine.cpu.pc;
+        set_breakpoint(&debugger, pc,
+                (debugger.breakpoints[pc >> 3] & (1 << (pc & 7))) == 0);
+    }
+}
+
 void initialize_memory(unsigned char *m) {
     for (int i = 0; i < MEMORY_SIZE; i++) {
         m[i] = 0;
@@ -185,273 +254,28 @@ unsigned long fetch_decode_execute(CPU* c, unsigned char *m) {
 
     //This function puts the CPU in charge, as it pulls instructions one
     //by one from RAM and executes them (this is a Turing Machine) until it
-    //encounters a RET instruction, upon which this function exits by 
+    //encounters the program's final RTS, upon which this function exits by 
     //returning a count of the total number of instructions executed.
+    //The full instruction set runs in emulator_cpu.cpp, which decodes each
+    //instruction once and keeps it.
     //
     //Arguments:
     //
     //    c -> CPU
     //    m -> RAM
 
-    //decode helpers
-    unsigned char   low_byte = 0;
-    unsigned char  high_byte = 0;
-    unsigned short   address = 0;
-    unsigned char temp_value = 0;
-    unsigned short  temp_sum = 0;
-    unsigned char  num_bytes = 0;   // size of instruction, used to increment 
-                                    // program counter
-
-    unsigned long instruction_count = 0;     // to count instructions executed 
-
-    while(1) {
-
-        switch( m[c->pc] ) {
-
-            case 0xAE: //LDX Load the x index register with the contents of
-                       //memory (absolute)
-                low_byte = m[c->pc + 1];
-                high_byte = m[c->pc + 2];
-                address = high_byte*256 + low_byte;
-                c->x = m[address];
-                //Update p (Processor Status Register): N V - B D I Z C
-                    // update N (Negative Flag)
-                    if(c->x > 127) {
-                        c->p = (0x80 | c->p); // negative result, SET N
-                    } else {
-                        c->p = (0x7F & c->p); // not negative, CLEAR N
-                    }
-                    // update Z (Zero Flag)
-                    if(c->x == 0) {
-                        c->p = (0x02 | c->p); // zero, SET Z
-                    } else {
-                        c->p = (0xFD & c->p); // not zero, CLEAR Z
-                    }
-                num_bytes = 3;
-                break;
-            case 0xA2: //LDXIM Load x register with immediate value (0-255)
-                c->x = m[c->pc + 1];
-                //Update p (Processor Status Register): N V - B D I Z C
-                    // update N (Negative Flag)
-                    if(c->x > 127) {
-                        c->p = (0x80 | c->p); // negative result, SET N
-                    } else {
-                        c->p = (0x7F & c->p); // not negative, CLEAR N
-                    }
-                    // update Z (Zero Flag)
-                    if(c->x == 0) {
-                        c->p = (0x02 | c->p); // zero, SET Z
-                    } else {
-                        c->p = (0xFD & c->p); // not zero, CLEAR Z
-                    }
-                num_bytes = 2;
-                break;
-            case 0x8E: //STX Store contents of x register at specified memory 
-                       //location (using absolute addressing)
-                low_byte = m[c->pc + 1];
-                high_byte = m[c->pc + 2];
-                address = high_byte*256 + low_byte;
-                m[address] = c->x;
-                num_bytes = 3;
-                break;
-            case 0xAC: //LDY Load the y index register with the contents of
-                       //memory (absolute)
-                low_byte = m[c->pc + 1];
-                high_byte = m[c->pc + 2];
-                address = high_byte*256 + low_byte;
-                c->y = m[address];
-                //Update p (Processor Status Register): N V - B D I Z C
-                    // update N (Negative Flag)
-                    if(c->y > 127) {
-                        c->p = (0x80 | c->p); // negative result, SET N
-                    } else {
-                        c->p = (0x7F & c->p); // not negative, CLEAR N
-                    }
-                    // update Z (Zero Flag)
-                    if(c->y == 0) {
-                        c->p = (0x02 | c->p); // zero, SET Z
-                    } else {
-                        c->p = (0xFD & c->p); // not zero, CLEAR Z
-                    }
-                num_bytes = 3;
-                break;
-            case 0xA0: //LDYIM Load y register with immediate value (0-255)
-                c->y = m[c->pc + 1];
-                //Update p (Processor Status Register): N V - B D I Z C
-                    // update N (Negative Flag)
-                    if(c->y > 127) {
-                        c->p = (0x80 | c->p); // negative result, SET N
-                    } else {
-                        c->p = (0x7F & c->p); // not negative, CLEAR N
-                    }
-                    // update Z (Zero Flag)
-                    if(c->y == 0) {
-                        c->p = (0x02 | c->p); // zero, SET Z
-                    } else {
-                        c->p = (0xFD & c->p); // not zero, CLEAR Z
-                    }
-                num_bytes = 2;
-                break;
-            case 0x8C: //STY Store contents of y register at specified memory 
-                       //location (using absolute addressing)
-                low_byte = m[c->pc + 1];
-                high_byte = m[c->pc + 2];
-                address = high_byte*256 + low_byte;
-                m[address] = c->y;
-                num_bytes = 3;
-                break;
-            case 0xA9: //LDA Load accumulator with immediate value (0-255)
-                c->a = m[c->pc + 1];
-                //Update p (Processor Status Register): N V - B D I Z C
-                    // update N (Negative Flag)
-                    if(c->a > 127) {
-                        c->p = (0x80 | c->p); // negative result, SET N
-                    } else {
-                        c->p = (0x7F & c->p); // not negative, CLEAR N
-                    }
-                    // update Z (Zero Flag)
-                    if(c->a == 0) {
-                        c->p = (0x02 | c->p); // zero, SET Z
-                    } else {
-                        c->p = (0xFD & c->p); // not zero, CLEAR Z
-                    }
-                num_bytes = 2;
-                break;
-            case 0x6D: //ADC Add to accumulator the contents of specified 
-                       //address (absolute), including the carry bit in P
-                low_byte = m[c->pc + 1];
-                high_byte = m[c->pc + 2];
-                address = high_byte*256 + low_byte;
-                temp_sum = m[address] + c->a + (0x01 & c->p);
-                //Update p (Processor Status Register): N V - B D I Z C
-                    // update N (Negative Flag)
-                    if((unsigned char)temp_sum > 127) {
-                        c->p = (0x80 | c->p); // negative result, SET N
-                    } else {
-                        c->p = (0x7F & c->p); // not negative, CLEAR N
-                    }
-                    // update V (Overflow Flag)
-                    if(m[address] > 127 && c->a > 127 && (unsigned char)temp_sum < 128) {
-                        c->p = (0x40 | c->p); // overflow, SET V
-                    } else if(m[address] < 128 && c->a < 128 && (unsigned char)temp_sum > 127) {
-                        c->p = (0x40 | c->p); // overflow, SET V
-                    } else {
-                        c->p = (0xBF & c->p); // no overflow, CLEAR V
-                    }
-                    // update Z (Zero Flag)
-                    if(temp_sum == 0) {
-                        c->p = (0x02 | c->p); // zero, SET Z
-                    } else {
-                        c->p = (0xFD & c->p); // not zero, CLEAR Z
-                    }
-                    // update C (Carry Flag)
-                    if(temp_sum > 255) {
-                        c->p = (0x01 | c->p); // carry, SET C
-                    } else {
-                        c->p = (0xFE & c->p); // no carry, CLEAR C
-                    }
-                c->a = (unsigned char)temp_sum;
-                num_bytes = 3;
-                break;
-            case 0x8D: //STA Store contents of accumulator at specified memory 
-                       //location using absolute addressing.
-                low_byte = m[c->pc + 1];
-                high_byte = m[c->pc + 2];
-                address = high_byte*256 + low_byte;
-                m[address] = c->a;
-                num_bytes = 3;
-                break;
-            case 0xD8: //CLD Clear decimal mode
-                c->p = (0xF7 & c->p); 
-                num_bytes = 1;
-                break;
-            case 0x18: //CLC Clear carry flag 
-                c->p = (0xFE & c->p); 
-                num_bytes = 1;
-                break;
-            case 0x60: //RTS Return From Subroutine
-                c->pc++;
-                instruction_count++;
-                return instruction_count;
-                break;
-            case 0xAA: //TAX Transfer contents of A to X index register
-                c->x = c->a;
-                //Update p (Processor Status Register): N V - B D I Z C
-                    // update N (Negative Flag)
-                    if(c->x > 127) {
-                        c->p = (0x80 | c->p); // negative result, SET N
-                    } else {
-                        c->p = (0x7F & c->p); // not negative, CLEAR N
-                    }
-                    // update Z (Zero Flag)
-                    if(c->x == 0) {
-                        c->p = (0x02 | c->p); // zero, SET Z
-                    } else {
-                        c->p = (0xFD & c->p); // not zero, CLEAR Z
-                    }
-                num_bytes = 1;
-                break;
-            case 0x8A: //TXA Transfer contents of X to A (accumulator) 
-                c->a = c->x;
-                //Update p (Processor Status Register): N V - B D I Z C
-                    // update N (Negative Flag)
-                    if(c->a > 127) {
-                        c->p = (0x80 | c->p); // negative result, SET N
-                    } else {
-                        c->p = (0x7F & c->p); // not negative, CLEAR N
-                    }
-                    // update Z (Zero Flag)
-                    if(c->a == 0) {
-                        c->p = (0x02 | c->p); // zero, SET Z
-                    } else {
-                        c->p = (0xFD & c->p); // not zero, CLEAR Z
-                    }
-                num_bytes = 1;
-                break;
-            case 0xA8: //TAY Transfer contents of A to Y index register
-                c->y = c->a;
-                //Update p (Processor Status Register): N V - B D I Z C
-                    // update N (Negative Flag)
-                    if(c->y > 127) {
-                        c->p = (0x80 | c->p); // negative result, SET N
-                    } else {
-                        c->p = (0x7F & c->p); // not negative, CLEAR N
-                    }
-                    // update Z (Zero Flag)
-                    if(c->y == 0) {
-                        c->p = (0x02 | c->p); // zero, SET Z
-                    } else {
-                        c->p = (0xFD & c->p); // not zero, CLEAR Z
-                    }
-                num_bytes = 1;
-                break;
-            case 0x98: //TYA Transfer contents of Y to A (accumulator) 
-                c->a = c->y;
-                //Update p (Processor Status Register): N V - B D I Z C
-                    // update N (Negative Flag)
-                    if(c->a > 127) {
-                        c->p = (0x80 | c->p); // negative result, SET N
-                    } else {
-                        c->p = (0x7F & c->p); // not negative, CLEAR N
-                    }
-                    // update Z (Zero Flag)
-                    if(c->a == 0) {
-                        c->p = (0x02 | c->p); // zero, SET Z
-                    } else {
-                        c->p = (0xFD & c->p); // not zero, CLEAR Z
-                    }
-                num_bytes = 1;
-                break;
-            default:
-                num_bytes = 1;
-                break;
-        }
-                
-        c->pc += num_bytes;
+    Machine machine;
+    if(initialize_machine(&machine, m) == false)
+        return 0;
+    machine.cpu = *c;
+    if(profile != NULL)
+        attach_profile(&machine, profile);
 
-        instruction_count++;
-    }
+    unsigned long instruction_count = run_6502(&machine, RUN_CYCLE_LIMIT);
 
+    *c = machine.cpu;
+    print_profile(&machine, PROFILE_TOP);
+    free_machine(&machine);
     return instruction_count;
 }
 
@@ -501,289 +325,69 @@ void print_cpu_register_content(CPU* c) {
     printf("\n");
 }
 
-void print_memory_disassembled(unsigned char *m, unsigned short start_address) {
+void print_memory_disassembled(unsigned char *m, unsigned short start_address,
+        unsigned int end_address, const Profile* p) {
 
     // This would be an OS function available at the command line.
     // > MEMORY 4588  
+    //
+    // Every instruction from start_address up to end_address (see
+    // emulator_disassembler.cpp), with the assembled file's labels. With a
+    // profile, each line ends with how many times the instruction ran and
+    // the cycles it took.
+
+    Disassembler d;
+    Disasm_Line line;
+    start_disassembly(&d, m, start_address, end_address, symbols);
+
+    while (next_instruction(&d, &line)) {
+
+        if (line.label != NULL)
+            printf("\n %s:", line.label);
+
+        char hex[3 * 3 + 1];
+        for (int b = 0; b < 3; b++) {
+            if (b < line.length)
+                snprintf(hex + 3 * b, 4, "%02X ", line.bytes[b]);
+            else
+                strcpy(hex + 3 * b, "   ");
+        }
+        printf("\n RAM $%04X: %s %-20s", line.address, hex, line.text);
 
-    //decode helpers
-    unsigned char low_byte = 0;
-    unsigned char high_byte = 0;
-    unsigned short address = 0;
-    unsigned char temp_value = 0;
-
-    unsigned short end_address = start_address + 100;
-
-    for (int i = start_address; i < end_address; i++) {
-
-        temp_value = m[i];
-
-        switch(temp_value) {
-
-            case 0xAE:
-                strcpy(string_store, "LDX");
-                low_byte = m[i+1];
-                high_byte = m[i+2];
-                address = high_byte*256 + low_byte;
-                printf("\n RAM %d: %s %d", i, string_store, address);
-                i += 2;
-                break;
-            case 0xA2:
-                strcpy(string_store, "LDXIM");
-                temp_value = m[i+1];
-                printf("\n RAM %d: %s %d", i, string_store, temp_value);
-                i += 1;
-                break;
-            case 0x8E:
-                strcpy(string_store, "STX");
-                low_byte = m[i+1];
-                high_byte = m[i+2];
-                address = high_byte*256 + low_byte;
-                printf("\n RAM %d: %s %d", i, string_store, address);
-                i += 2;
-                break;
-            case 0xAC:
-                strcpy(string_store, "LDY");
-                low_byte = m[i+1];
-                high_byte = m[i+2];
-                address = high_byte*256 + low_byte;
-                printf("\n RAM %d: %s %d", i, string_store, address);
-                i += 2;
-                break;
-            case 0xA0:
-                strcpy(string_store, "LDYIM");
-                temp_value = m[i+1];
-                printf("\n RAM %d: %s %d", i, string_store, temp_value);
-                i += 1;
-                break;
-            case 0x8C:
-                strcpy(string_store, "STY");
-                low_byte = m[i+1];
-                high_byte = m[i+2];
-                address = high_byte*256 + low_byte;
-                printf("\n RAM %d: %s %d", i, string_store, address);
-                i += 2;
-                break;
-            case 0xA9:
-                strcpy(string_store, "LDAIM");
-                temp_value = m[i+1];
-                printf("\n RAM %d: %s %d", i, string_store, temp_value);
-                i += 1;
-                break;
-            case 0x6D:
-                strcpy(string_store, "ADC");
-                low_byte = m[i+1];
-                high_byte = m[i+2];
-                address = high_byte*256 + low_byte;
-                printf("\n RAM %d: %s %d", i, string_store, address);
-                i += 2;
-                break;
-            case 0x8D:
-                strcpy(string_store, "STA");
-                low_byte = m[i+1];
-                high_byte = m[i+2];
-                address = high_byte*256 + low_byte;
-                printf("\n RAM %d: %s %d", i, string_store, address);
-                i += 2;
-                break;
-            case 0xD8:
-                strcpy(string_store, "CLD");
-                printf("\n RAM %d: %s", i, string_store);
-                break;
-            case 0x18:
-                strcpy(string_store, "CLC");
-                printf("\n RAM %d: %s", i, string_store);
-                break;
-            case 0x60:
-                strcpy(string_store, "RTS");
-                printf("\n RAM %d: %s", i, string_store);
-                i = end_address;
-                break;
-            case 0xAA:
-                strcpy(string_store, "TAX");
-                printf("\n RAM %d: %s", i, string_store);
-                break;
-            case 0x8A:
-                strcpy(string_store, "TXA");
-                printf("\n RAM %d: %s", i, string_store);
-                break;
-            case 0xA8:
-                strcpy(string_store, "TAY");
-                printf("\n RAM %d: %s", i, string_store);
-                break;
-            case 0x98:
-                strcpy(string_store, "TYA");
-                printf("\n RAM %d: %s", i, string_store);
-                break;
-            default:
-                strcpy(string_store, "???");
-                printf("\n RAM %d: %s", i, string_store);
+        if (p != NULL && p->executions[line.address] > 0) {
+            printf("    ; %llu x, %llu cycles",
+                    p->executions[line.address],
+                    p->cycles[line.address]);
         }
     }
 
     printf("\n");
 }
 
-void format_16bit_int(char *n_string, unsigned char *m, 
-        unsigned short s) {
-
-    // This function takes a string and a memory address.
-    // The string contains a number (range 0 - 65535). 
-    // The function converts this to a numerical data type,
-    // then splits the number into high-order and low-order
-    // bytes (2 bytes total) and stores them at 'address'
-    // and 'address+1' (storing first the low order then the
-    // high order byte).
-    
-    int i = atoi(n_string);
-
-    unsigned char high_byte = (int)(i/256);
-    unsigned char low_byte = i % 256;
-
-    m[s+0] = low_byte;
-    m[s+1] = high_byte;
-}
-
-unsigned short assemble_file_into_memory(char* filename, unsigned char* m) {
-
-    //This function is an assembler. It reads a text file that contains assembly
-    //instructions, and then translates that to 6502 machine code and puts that
-    //code into main memory (along with all that code's data and memory
-    //references).
-
-    // Two Psuedo-Op-Codes exist:
-    // the first line of any .asm file should be the starting address to
-    // load the program at. 
-    // The second psuedo code is END, which signals EOF.
-    		
-    FILE *file_ptr;
-    char full_line[1000];
-    char* token = NULL;
-    unsigned short start = 0;
-
-    file_ptr = fopen(filename, "r");
-
-    // First read starting memory address
-    fgets(full_line, 1000, file_ptr);
-    start = atoi(full_line);
-
-    // Second, set index to start address
-    unsigned short index = start;
-
-    // Loop through file, one full-line at a time
-    while (fgets(full_line, 1000, file_ptr) != NULL) {
-
-        token = strtok(full_line, " ");
-
-        // Tokenize current line
-        while (token) {
-           
-            if (strcmp(token, "LDX") == 0) {
-                m[index] = 0xAE;
-                index++;
-                token = strtok(NULL, " ");
-                format_16bit_int(token, m, index);
-                index += 2;
-            }
-            else if (strcmp(token, "LDXIM") == 0) {
-                m[index] = 0xA2;
-                index++;
-                token = strtok(NULL, " ");
-                m[index] = atoi(token);
-                index++;
-            }
-            else if (strcmp(token, "STX") == 0) {
-                m[index] = 0x8E;
-                index++;
-                token = strtok(NULL, " ");
-                format_16bit_int(token, m, index);
-                index += 2;
-            }
-            else if (strcmp(token, "LDY") == 0) {
-                m[index] = 0xAC;
-                index++;
-                token = strtok(NULL, " ");
-                format_16bit_int(token, m, index);
-                index += 2;
-            }
-            else if (strcmp(token, "LDYIM") == 0) {
-                m[index] = 0xA0;
-                index++;
-                token = strtok(NULL, " ");
-                m[index] = atoi(token);
-                index++;
-            }
-            else if (strcmp(token, "STY") == 0) {
-                m[index] = 0x8C;
-                index++;
-                token = strtok(NULL, " ");
-                format_16bit_int(token, m, index);
-                index += 2;
-            }
-            else if (strcmp(token, "LDAIM") == 0) {
-                m[index] = 0xA9;
-                index++;
-                token = strtok(NULL, " ");
-                m[index] = atoi(token);
-                index++;
-            }
-            else if (strcmp(token, "ADC") == 0) {
-                m[index] = 0x6D;
-                index++;
-                token = strtok(NULL, " ");
-                format_16bit_int(token, m, index);
-                index += 2;
-            }
-            else if (strcmp(token, "STA") == 0) {
-                m[index] = 0x8D;
-                index++;
-                token = strtok(NULL, " ");
-                format_16bit_int(token, m, index);
-                index += 2;
-            }
-            else if (strcmp(token, "CLC\n") == 0) {
-                m[index] = 0x18;
-                index++;
-            }
-            else if (strcmp(token, "CLD\n") == 0) {
-                m[index] = 0xD8;
-                index++;
-            }
-            else if (strcmp(token, "RTS\n") == 0) {
-                m[index] = 0x60;
-                index++;
-            }
-            else if (strcmp(token, "END\n") == 0) {
-                fclose(file_ptr);
-                return start;
-            }
-            else if (strcmp(token, "TAX\n") == 0) {
-                m[index] = 0xAA;
-                index++;
-            }
-            else if (strcmp(token, "TXA\n") == 0) {
-                m[index] = 0x8A;
-                index++;
-            }
-            else if (strcmp(token, "TAY\n") == 0) {
-                m[index] = 0xA8;
-                index++;
-            }
-            else if (strcmp(token, "TYA\n") == 0) {
-                m[index] = 0x98;
-                index++;
-            }
-            else {
-                printf("\n Unidentified Op-Code Found in File: %s\n", full_line);
-            }
-        
-            token = strtok(NULL, " ");
-        }
-    }
-
-    fclose(file_ptr);
-
-    return start;
+unsigned short assemble_file_into_memory(char* filename, unsigned char* m,
+        unsigned short* end_address) {
+
+    //Assembles the file into main memory (see emulator_assembler.cpp) and
+    //returns the address the program was loaded at, and the end in
+    //end_address. Errors are printed with their line numbers as they're
+    //found. The labels are kept in symbols for the disassembly.
+
+    Asm_Result result;
+    if (symbols == NULL)
+        symbols = (Symbol_Table*)malloc(sizeof(Symbol_Table));
+    if (symbols != NULL)
+        clear_symbols(symbols);    // stays empty if the file can't be read
+    Uint64 start_time = SDL_GetPerformanceCounter();
+    assemble_file(filename, m, &result, symbols);
+    double ms = (SDL_GetPerformanceCounter() - start_time) * 1000.0 /
+        SDL_GetPerformanceFrequency();
+
+    printf(" ASSEMBLED %d LINES, %d BYTES (%d TO %d) IN %.3f MS, %d ERRORS\n",
+            result.lines, result.bytes, result.start, result.end, ms,
+            result.errors);
+
+    *end_address = result.end;
+    return result.start;
 }
 
 void test_1(unsigned char m, unsigned char n) {
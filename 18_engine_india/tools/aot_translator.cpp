@@ -0,0 +1,536 @@
+//345678901234567890123456789012345678901234567890123456789012345678901234567890
+//       1         2         3         4         5         6         7         8
+// Filename: ../tools/aot_translator.cpp
+// Last Modified: Tue Oct 20, 2026  05:10AM
+//
+// Ahead-of-time 6502 to C++ translator (see emulator_aot.cpp).
+//
+// Usage:
+//
+//     aot_translator code_05.asm code_05_aot.cpp code_05
+//
+// The program is assembled exactly as assemble_file_into_memory() would,
+// then every instruction reachable from its start address is found by
+// following fall-through, branches, JMP and JSR (and JSR's return point).
+// Each basic block becomes one C++ function working on the registers as
+// locals and on memory directly; the flag updates nobody reads are left
+// out, as in the block translator. The output defines
+//
+//     Aot_Program AOT_<name>;
+//
+// which is compiled in with the engine and run with run_6502_aot().
+//
+// JMP (indirect) ends the translated code: wherever it goes at run time is
+// interpreted until the program comes back to a translated block. Stores
+// that can't be shown to miss the translated code are checked as they
+// happen; if the program writes over its own code, the block stops there
+// and the rest of the run is interpreted.
+
+#include "../emulator_6502.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+
+unsigned char memory[65536];
+bool          visited[65536];      // an instruction starts here
+bool          code_byte[65536];    // part of a translated instruction
+bool          leader[65536];       // a block starts here
+unsigned short block_addresses[65536];  // instructions of the block being
+bool          block_need_flags[65536]; // written
+int           worklist[2 * 65536 + 2];  // up to two entries per instruction
+int           num_work = 0;
+
+const char*   name = NULL;
+FILE*         out = NULL;
+
+void find_code(unsigned short start);
+void write_block(unsigned short address);
+void write_instruction(unsigned short address, bool need_flags,
+        int cycles_after, int instructions_after);
+bool store_may_hit_code(int mode, unsigned short operand);
+void emit(const char* format, ...);
+
+int main(int argc, char* argv[]) {
+
+    if(argc < 4) {
+        printf("usage: aot_translator <program.asm> <output.cpp> <name>\n");
+        return 1;
+    }
+    name = argv[3];
+
+    Asm_Result result;
+    if(assemble_file(argv[1], memory, &result, NULL) == false)
+        return 1;
+
+    find_code(result.start);
+
+    int low = 65536, high = 0, blocks = 0;
+    for(int i = 0; i < 65536; i++) {
+        if(code_byte[i]) {
+            if(i < low)
+                low = i;
+            high = i + 1;
+        }
+        if(leader[i])
+            blocks++;
+    }
+    if(blocks == 0) {
+        printf(" no code found at %d\n", result.start);
+        return 1;
+    }
+    for(int i = 0x0100; i < 0x0200; i++) {
+        if(code_byte[i]) {
+            printf(" warning: code on the stack page, pushes over it go unnoticed\n");
+            break;
+        }
+    }
+
+    out = fopen(argv[2], "w");
+    if(out == NULL) {
+        printf(" unable to write %s\n", argv[2]);
+        return 1;
+    }
+
+    emit("// Generated by aot_translator from %s, do not edit.\n", argv[1]);
+    emit("// %d blocks, code at $%04X-$%04X\n\n", blocks, low, high - 1);
+    emit("#include \"emulator_aot.h\"\n\n");
+    emit("extern Aot_Program AOT_%s;\n\n", name);
+    emit("#define SAVE_REGISTERS c->a = a; c->x = x; c->y = y; c->s = s; c->p = p\n\n");
+
+    build_block_tables();
+    for(int i = 0; i < 65536; i++) {
+        if(leader[i])
+            write_block((unsigned short)i);
+    }
+
+    //Which bytes were translated, and what they were
+    emit("const unsigned char AOT_%s_CODE_MAP[] = {", name);
+    for(int i = low; i < high; i += 8) {
+        int bits = 0;
+        for(int b = 0; b < 8 && i + b < high; b++)
+            bits |= code_byte[i + b] << b;
+        emit("%s0x%02X,", ((i - low) % 96 == 0) ? "\n    " : " ", bits);
+    }
+    emit("\n};\n\n");
+
+    emit("const unsigned char AOT_%s_CODE[] = {", name);
+    for(int i = low; i < high; i++)
+        emit("%s0x%02X,", ((i - low) % 12 == 0) ? "\n    " : " ", memory[i]);
+    emit("\n};\n\n");
+
+    emit("const Aot_Block AOT_%s_BLOCKS[] = {\n", name);
+    for(int i = 0; i < 65536; i++) {
+        if(leader[i])
+            emit("    { 0x%04X, aot_%s_%04X },\n", i, name, i);
+    }
+    emit("};\n\n");
+
+    emit("Aot_Program AOT_%s = {\n", name);
+    emit("    \"%s\", 0x%04X, AOT_%s_BLOCKS, %d,\n", name, result.start, name, blocks);
+    emit("    0x%04X, 0x%X, AOT_%s_CODE_MAP, AOT_%s_CODE, NULL\n", low, high,
+            name, name);
+    emit("};\n");
+    fclose(out);
+
+    printf(" %s: %d blocks, %d bytes of code translated to %s\n", argv[1],
+            blocks, high - low, argv[2]);
+    return 0;
+}
+
+void find_code(unsigned short start) {
+
+    leader[start] = true;
+    worklist[num_work++] = start;
+
+    while(num_work > 0) {
+
+        unsigned short address = worklist[--num_work];
+        if(visited[address])
+            continue;
+        visited[address] = true;
+
+        const Opcode_Info* info = &OPCODES[memory[address]];
+        for(int i = 0; i < info->length; i++)
+            code_byte[(unsigned short)(address + i)] = true;
+
+        unsigned short next = address + info->length;
+        unsigned short operand = memory[(unsigned short)(address + 1)] |
+            (memory[(unsigned short)(address + 2)] << 8);
+        const char* mnemonic = info->mnemonic;
+
+        int targets[2];
+        int num_targets = 0;
+        bool falls_through = true;
+
+        if(info->mode == MODE_RELATIVE) {
+            targets[num_targets++] = (unsigned short)(next +
+                    (signed char)memory[(unsigned short)(address + 1)]);
+            leader[next] = true;
+        } else if(strcmp(mnemonic, "JMP") == 0) {
+            if(info->mode == MODE_ABSOLUTE)
+                targets[num_targets++] = operand;
+            falls_through = false;
+        } else if(strcmp(mnemonic, "JSR") == 0) {
+            targets[num_targets++] = operand;
+            leader[next] = true;           // where RTS comes back to
+        } else if(strcmp(mnemonic, "RTS") == 0 || strcmp(mnemonic, "RTI") == 0 ||
+                strcmp(mnemonic, "BRK") == 0) {
+            falls_through = false;
+        }
+
+        for(int i = 0; i < num_targets; i++) {
+            leader[targets[i]] = true;
+            worklist[num_work++] = targets[i];
+        }
+        if(falls_through)
+            worklist[num_work++] = next;
+    }
+}
+
+void write_block(unsigned short start) {
+
+    //The block runs to the first jump, or up to the next block
+    unsigned short* addresses = block_addresses;
+    int count = 0;
+    int cycles = 0;
+    unsigned short address = start;
+    while(true) {
+        addresses[count++] = address;
+        unsigned char opcode = memory[address];
+        cycles += OPCODES[opcode].cycles;
+        address += OPCODES[opcode].length;
+        if(ends_block[opcode] || leader[address] || visited[address] == false ||
+                count == 65536)
+            break;
+    }
+
+    //Backwards: which flags does anything still read?
+    bool* need_flags = block_need_flags;
+    unsigned char live = 0xFF;
+    for(int i = count - 1; i >= 0; i--) {
+        unsigned char opcode = memory[addresses[i]];
+        const Opcode_Info* info = &OPCODES[opcode];
+        unsigned short operand = memory[(unsigned short)(addresses[i] + 1)] |
+            (memory[(unsigned short)(addresses[i] + 2)] << 8);
+        if(writes_memory[opcode] && store_may_hit_code(info->mode, operand))
+            live = 0xFF;                   // the block can end after it
+        need_flags[i] = (flags_written[opcode] & live) != 0;
+        live = (live & ~flags_written[opcode]) | flags_read[opcode];
+    }
+
+    emit("int aot_%s_%04X(Machine* v) {\n", name, start);
+    emit("    CPU* c = &v->cpu;\n");
+    emit("    unsigned char* m = v->m;\n");
+    emit("    unsigned char a = c->a, x = c->x, y = c->y, s = c->s, p = c->p;\n");
+    emit("    unsigned int t;\n");
+    emit("    unsigned short ea;\n");
+    emit("    (void)m; (void)t; (void)ea;\n");
+    emit("    v->cycles += %d;\n", cycles);
+    emit("    v->instructions += %d;\n\n", count);
+
+    int cycles_after = cycles;
+    for(int i = 0; i < count; i++) {
+        cycles_after -= OPCODES[memory[addresses[i]]].cycles;
+        write_instruction(addresses[i], need_flags[i], cycles_after,
+                count - i - 1);
+    }
+
+    unsigned char last = memory[addresses[count - 1]];
+    if(ends_block[last] == false) {
+        emit("    SAVE_REGISTERS;\n");
+        emit("    c->pc = 0x%04X;\n", address);
+        emit("    return AOT_CONTINUE;\n");
+    }
+    emit("}\n\n");
+}
+
+bool store_may_hit_code(int mode, unsigned short operand) {
+
+    switch(mode) {
+        case MODE_ZERO_PAGE:
+            return code_byte[operand & 0xFF];
+        case MODE_ABSOLUTE:
+            return code_byte[operand];
+        case MODE_ZERO_PAGE_X:
+        case MODE_ZERO_PAGE_Y:
+            for(int i = 0; i < 256; i++) {
+                if(code_byte[i])
+                    return true;
+            }
+            return false;
+        case MODE_ABSOLUTE_X:
+        case MODE_ABSOLUTE_Y:
+            for(int i = 0; i < 256; i++) {
+                if(code_byte[(unsigned short)(operand + i)])
+                    return true;
+            }
+            return false;
+        case MODE_IMPLIED:
+            return false;                  // stack (see main())
+    }
+    return true;                           // indirect
+}
+
+// Sets ea (or returns a constant) for the operand's address; the string is
+// the C++ for it
+const char* address_of(const Opcode_Info* info, unsigned short operand) {
+
+    static char expression[32];
+    unsigned char zp = operand & 0xFF;
+
+    switch(info->mode) {
+        case MODE_ZERO_PAGE:
+            sprintf(expression, "0x%02X", zp);
+            return expression;
+        case MODE_ABSOLUTE:
+            sprintf(expression, "0x%04X", operand);
+            return expression;
+        case MODE_ZERO_PAGE_X:
+            emit("    ea = (unsigned char)(0x%02X + x);\n", zp);
+            break;
+        case MODE_ZERO_PAGE_Y:
+            emit("    ea = (unsigned char)(0x%02X + y);\n", zp);
+            break;
+        case MODE_ABSOLUTE_X:
+        case MODE_ABSOLUTE_Y:
+            emit("    ea = (unsigned short)(0x%04X + %c);\n", operand,
+                    (info->mode == MODE_ABSOLUTE_X) ? 'x' : 'y');
+            if(info->page_penalty)
+                emit("    v->cycles += (ea >> 8) != 0x%02X;\n", operand >> 8);
+            break;
+        case MODE_INDEXED_INDIRECT:
+            emit("    t = (unsigned char)(0x%02X + x);\n", zp);
+            emit("    ea = m[t] | (m[(unsigned char)(t + 1)] << 8);\n");
+            break;
+        case MODE_INDIRECT_INDEXED:
+            emit("    t = m[0x%02X] | (m[0x%02X] << 8);\n", zp,
+                    (unsigned char)(zp + 1));
+            emit("    ea = (unsigned short)(t + y);\n");
+            if(info->page_penalty)
+                emit("    v->cycles += ((ea ^ t) & 0xFF00) != 0;\n");
+            break;
+    }
+    return "ea";
+}
+
+void write_store(const char* address, const char* value, bool checked,
+        unsigned short next, int cycles_after, int instructions_after) {
+
+    if(checked == false) {
+        emit("    m[%s] = %s;\n", address, value);
+        emit("    if(v->cache->code_page[(%s) >> 8])\n", address);
+        emit("        invalidate_code_page(v, (%s) >> 8);\n", address);
+        return;
+    }
+
+    emit("    if(aot_store(v, &AOT_%s, %s, %s)) {\n", name, address, value);
+    emit("        SAVE_REGISTERS;\n");
+    emit("        c->pc = 0x%04X;\n", next);
+    if(cycles_after > 0)
+        emit("        v->cycles -= %d;\n", cycles_after);
+    if(instructions_after > 0)
+        emit("        v->instructions -= %d;\n", instructions_after);
+    emit("        return AOT_CODE_CHANGED;\n");
+    emit("    }\n");
+}
+
+void write_push(const char* value) {
+    emit("    m[0x0100 | s] = %s;\n", value);
+    emit("    if(v->cache->code_page[0x01])\n");
+    emit("        invalidate_code_page(v, 0x01);\n");
+    emit("    s--;\n");
+}
+
+void write_jump(const char* target) {
+    emit("    SAVE_REGISTERS;\n");
+    emit("    c->pc = %s;\n", target);
+    emit("    return AOT_CONTINUE;\n");
+}
+
+void write_instruction(unsigned short address, bool need_flags,
+        int cycles_after, int instructions_after) {
+
+    unsigned char opcode = memory[address];
+    const Opcode_Info* info = &OPCODES[opcode];
+    const char* mn = info->mnemonic;
+    unsigned short operand = memory[(unsigned short)(address + 1)] |
+        (memory[(unsigned short)(address + 2)] << 8);
+    if(info->length == 2)
+        operand &= 0xFF;
+    unsigned short next = address + info->length;
+    unsigned char bytes[3] = { opcode, (unsigned char)operand,
+        (unsigned char)(operand >> 8) };
+    char text[64];
+    disassemble_instruction(bytes, address, text, sizeof(text));
+    emit("    // $%04X %s\n", address, text);
+
+    if(info->mode == MODE_NONE || strcmp(mn, "NOP") == 0)
+        return;
+
+    //Operand value, and address for the modes that have one
+    const char* ea = "";
+    char value[32] = "";
+    if(info->mode == MODE_IMMEDIATE) {
+        sprintf(value, "0x%02X", operand);
+    } else if(info->mode == MODE_ACCUMULATOR) {
+        sprintf(value, "a");
+    } else if(info->mode != MODE_IMPLIED && info->mode != MODE_RELATIVE &&
+            strcmp(mn, "JMP") != 0 && strcmp(mn, "JSR") != 0) {
+        ea = address_of(info, operand);
+        sprintf(value, "m[%s]", ea);
+    }
+    bool checked = store_may_hit_code(info->mode, operand);
+
+    //Loads, transfers and register steps
+    char reg = 0;
+    if(strcmp(mn, "LDA") == 0 || strcmp(mn, "LDX") == 0 || strcmp(mn, "LDY") == 0) {
+        reg = mn[2] + 32;
+        emit("    %c = %s;\n", reg, value);
+    } else if(mn[0] == 'T' && strcmp(mn, "TXS") != 0) {
+        reg = (mn[2] == 'S') ? 's' : mn[2] + 32;
+        emit("    %c = %c;\n", reg, (mn[1] == 'S') ? 's' : mn[1] + 32);
+    } else if(strcmp(mn, "TXS") == 0) {
+        emit("    s = x;\n");
+    } else if(strcmp(mn, "INX") == 0 || strcmp(mn, "INY") == 0 ||
+            strcmp(mn, "DEX") == 0 || strcmp(mn, "DEY") == 0) {
+        reg = mn[2] + 32;
+        emit("    %c%s;\n", reg, (mn[0] == 'I') ? "++" : "--");
+    } else if(strcmp(mn, "PLA") == 0) {
+        reg = 'a';
+        emit("    s++;\n");
+        emit("    a = m[0x0100 | s];\n");
+    }
+    if(reg != 0) {
+        if(need_flags)
+            emit("    p = aot_nz(p, %c);\n", reg);
+        return;
+    }
+
+    if(strcmp(mn, "STA") == 0 || strcmp(mn, "STX") == 0 || strcmp(mn, "STY") == 0) {
+        sprintf(text, "%c", mn[2] + 32);
+        write_store(ea, text, checked, next, cycles_after, instructions_after);
+    } else if(strcmp(mn, "ORA") == 0 || strcmp(mn, "AND") == 0 ||
+            strcmp(mn, "EOR") == 0) {
+        emit("    a %c= %s;\n", (mn[0] == 'O') ? '|' : (mn[0] == 'A') ? '&' : '^',
+                value);
+        if(need_flags)
+            emit("    p = aot_nz(p, a);\n");
+    } else if(strcmp(mn, "ADC") == 0 || strcmp(mn, "SBC") == 0) {
+        emit("    aot_%s(a, p, %s);\n", (mn[0] == 'A') ? "adc" : "sbc", value);
+    } else if(strcmp(mn, "CMP") == 0 || strcmp(mn, "CPX") == 0 ||
+            strcmp(mn, "CPY") == 0) {
+        if(need_flags) {
+            emit("    p = aot_compare(p, %c, %s);\n",
+                    (mn[2] == 'P') ? 'a' : mn[2] + 32, value);
+        }
+    } else if(strcmp(mn, "BIT") == 0) {
+        if(need_flags)
+            emit("    p = aot_bit(p, a, %s);\n", value);
+    } else if(strcmp(mn, "ASL") == 0 || strcmp(mn, "LSR") == 0 ||
+            strcmp(mn, "ROL") == 0 || strcmp(mn, "ROR") == 0) {
+        char kind = (mn[0] == 'A') ? 'A' : (mn[0] == 'L') ? 'L' :
+            (mn[2] == 'L') ? 'O' : 'R';
+        if(info->mode == MODE_ACCUMULATOR) {
+            emit("    a = aot_shift(p, a, '%c');\n", kind);
+        } else {
+            emit("    t = aot_shift(p, %s, '%c');\n", value, kind);
+            write_store(ea, "(unsigned char)t", checked, next, cycles_after,
+                    instructions_after);
+        }
+    } else if(strcmp(mn, "INC") == 0 || strcmp(mn, "DEC") == 0) {
+        emit("    t = (unsigned char)(%s %c 1);\n", value, (mn[0] == 'I') ? '+' : '-');
+        if(need_flags)
+            emit("    p = aot_nz(p, (unsigned char)t);\n");
+        write_store(ea, "(unsigned char)t", checked, next, cycles_after,
+                instructions_after);
+    } else if(info->mode == MODE_RELATIVE) {
+        unsigned short target = next + (signed char)operand;
+        unsigned char flag = (mn[1] == 'P' || mn[1] == 'M') ? FLAG_N :
+            (mn[1] == 'V') ? FLAG_V : (mn[1] == 'C') ? FLAG_C : FLAG_Z;
+        bool when_set = strcmp(mn, "BMI") == 0 || strcmp(mn, "BVS") == 0 ||
+            strcmp(mn, "BCS") == 0 || strcmp(mn, "BEQ") == 0;
+        emit("    if(%s(p & 0x%02X)) {\n", when_set ? "" : "!", flag);
+        emit("        v->cycles += %d;\n", ((next ^ target) & 0xFF00) ? 2 : 1);
+        emit("        SAVE_REGISTERS;\n");
+        emit("        c->pc = 0x%04X;\n", target);
+        emit("        return AOT_CONTINUE;\n");
+        emit("    }\n");
+        sprintf(text, "0x%04X", next);
+        write_jump(text);
+    } else if(strcmp(mn, "JMP") == 0) {
+        if(info->mode == MODE_ABSOLUTE) {
+            sprintf(text, "0x%04X", operand);
+        } else {
+            emit("    ea = m[0x%04X] | (m[0x%04X] << 8);\n", operand,
+                    (operand & 0xFF00) | ((operand + 1) & 0xFF));
+            sprintf(text, "ea");
+        }
+        write_jump(text);
+    } else if(strcmp(mn, "JSR") == 0) {
+        sprintf(text, "0x%02X", (unsigned short)(next - 1) >> 8);
+        write_push(text);
+        sprintf(text, "0x%02X", (next - 1) & 0xFF);
+        write_push(text);
+        sprintf(text, "0x%04X", operand);
+        write_jump(text);
+    } else if(strcmp(mn, "RTS") == 0) {
+        emit("    if(s == v->stack_base) {\n");
+        emit("        v->halted = true;\n");
+        emit("        SAVE_REGISTERS;\n");
+        emit("        c->pc = 0x%04X;\n", next);
+        emit("        return AOT_CONTINUE;\n");
+        emit("    }\n");
+        emit("    s++;\n");
+        emit("    t = m[0x0100 | s];\n");
+        emit("    s++;\n");
+        emit("    t |= m[0x0100 | s] << 8;\n");
+        write_jump("(unsigned short)(t + 1)");
+    } else if(strcmp(mn, "RTI") == 0) {
+        emit("    s++;\n");
+        emit("    p = (m[0x0100 | s] & ~FLAG_B) | FLAG_U;\n");
+        emit("    s++;\n");
+        emit("    t = m[0x0100 | s];\n");
+        emit("    s++;\n");
+        emit("    t |= m[0x0100 | s] << 8;\n");
+        write_jump("(unsigned short)t");
+    } else if(strcmp(mn, "BRK") == 0) {
+        emit("    ea = m[0xFFFE] | (m[0xFFFF] << 8);\n");
+        emit("    if(ea == 0) {\n");
+        emit("        v->halted = true;\n");
+        emit("        SAVE_REGISTERS;\n");
+        emit("        c->pc = 0x%04X;\n", next);
+        emit("        return AOT_CONTINUE;\n");
+        emit("    }\n");
+        sprintf(text, "0x%02X", (unsigned short)(next + 1) >> 8);
+        write_push(text);
+        sprintf(text, "0x%02X", (next + 1) & 0xFF);
+        write_push(text);
+        write_push("(unsigned char)(p | FLAG_B | FLAG_U)");
+        emit("    p |= FLAG_I;\n");
+        write_jump("ea");
+    } else if(strcmp(mn, "PHA") == 0) {
+        write_push("a");
+    } else if(strcmp(mn, "PHP") == 0) {
+        write_push("(unsigned char)(p | FLAG_B | FLAG_U)");
+    } else if(strcmp(mn, "PLP") == 0) {
+        emit("    s++;\n");
+        emit("    p = (m[0x0100 | s] & ~FLAG_B) | FLAG_U;\n");
+    } else if(mn[0] == 'C' || mn[0] == 'S') {
+        //CLC SEC CLD SED CLI SEI CLV
+        unsigned char flag = (mn[2] == 'C') ? FLAG_C : (mn[2] == 'D') ? FLAG_D :
+            (mn[2] == 'I') ? FLAG_I : FLAG_V;
+        if(mn[0] == 'C')
+            emit("    p &= ~0x%02X;\n", flag);
+        else
+            emit("    p |= 0x%02X;\n", flag);
+    }
+}
+
+void emit(const char* format, ...) {
+
+    va_list args;
+    va_start(args, format);
+    vfprintf(out, format, args);
+    va_end(args);
+}
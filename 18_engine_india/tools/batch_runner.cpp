@@ -0,0 +1,461 @@
+//345678901234567890123456789012345678901234567890123456789012345678901234567890
+//       1         2         3         4         5         6         7         8
+// Filename: ../tools/batch_runner.cpp
+// Last Modified: Tue Oct 20, 2026  08:40AM
+//
+// Headless batch runner for 6502 programs.
+//
+// Usage:
+//
+//     batch_runner [-j threads] [-c max_cycles] [-b] [-v] programs.txt
+//
+// Each line of the list is a program and what it should leave behind:
+//
+//     code_03.asm   a=160 x=80 y=0 $0384=80
+//     spin.asm      limit=5000 pc=$0600     # per-program cycle limit
+//
+// Registers are a, x, y, s, p and pc; $addr=value (or a decimal address)
+// checks a byte of memory. Numbers are decimal or $hex, # starts a comment,
+// and file names are relative to where the runner is started.
+//
+// All the programs are assembled first, each kept as just the bytes it
+// wrote. Then a thread per core (or -j) runs them, each thread with its
+// own Machine and 64KB, set up the way test_program does for one program
+// (registers zeroed, pc at the start address). A program fails if it
+// doesn't finish (RTS from the top level or BRK) within its cycle limit or
+// any expected value differs. -b runs them with the block translator
+// instead of the interpreter; -v lists the programs that pass too.
+//
+// Work is shared out by stealing: each thread starts with an equal run
+// of the list and takes programs from the front of it; a thread that runs
+// out takes the back half of whichever other thread has most left. Short
+// and long programs mix without one thread ending up with all the slow
+// ones. Results are printed in list order once every thread is done.
+
+#define SDL_MAIN_HANDLED
+#include <SDL.h>
+#include "../emulator_6502.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+const int MAX_EXPECTED = 32;
+const int MAX_WORKERS = 64;
+const unsigned long long DEFAULT_CYCLE_LIMIT = 100000000;
+
+enum EXPECT_KINDS {
+    EXPECT_A = 0,
+    EXPECT_X,
+    EXPECT_Y,
+    EXPECT_S,
+    EXPECT_P,
+    EXPECT_PC,
+    EXPECT_MEMORY
+};
+
+struct Expected {
+    int            kind;
+    unsigned short address;        // EXPECT_MEMORY
+    unsigned short value;
+};
+
+struct Batch_Job {
+    char               filename[256];
+    int                list_line;
+    unsigned short     start;
+    unsigned short     image_low;      // bytes the program wrote lie in
+    int                image_size;     // [image_low, image_low + size)
+    unsigned char*     image;
+    unsigned long long cycle_limit;
+    Expected           expected[MAX_EXPECTED];
+    int                num_expected;
+
+    bool               passed;         // filled in by a worker
+    char               message[128];
+    unsigned long long instructions;
+    unsigned long long cycles;
+};
+
+struct Worker {
+    SDL_SpinLock       lock;           // guards next and end
+    int                next;           // jobs [next, end) still to run
+    int                end;
+    SDL_Thread*        thread;
+    Machine            machine;
+    unsigned char*     memory;
+    int                jobs_run;
+    int                jobs_stolen;
+    unsigned long long instructions;
+};
+
+Batch_Job*  jobs = NULL;
+int         num_jobs = 0;
+Worker      workers[MAX_WORKERS];
+int         num_workers = 0;
+bool        use_blocks = false;
+
+bool read_job_list(const char* filename, unsigned long long cycle_limit);
+bool parse_number(const char* s, int* value);
+bool load_job(Batch_Job* job, unsigned char* scratch);
+int  SDLCALL worker_thread(void* data);
+bool take_job(Worker* w, int* job);
+bool steal_jobs(Worker* w);
+void run_job(Worker* w, Batch_Job* job);
+
+int main(int argc, char* argv[]) {
+
+    int threads = SDL_GetCPUCount();
+    unsigned long long cycle_limit = DEFAULT_CYCLE_LIMIT;
+    bool verbose = false;
+    const char* list = NULL;
+
+    for(int i = 1; i < argc; i++) {
+        if(strcmp(argv[i], "-j") == 0 && i + 1 < argc)
+            threads = atoi(argv[++i]);
+        else if(strcmp(argv[i], "-c") == 0 && i + 1 < argc)
+            cycle_limit = strtoull(argv[++i], NULL, 10);
+        else if(strcmp(argv[i], "-b") == 0)
+            use_blocks = true;
+        else if(strcmp(argv[i], "-v") == 0)
+            verbose = true;
+        else
+            list = argv[i];
+    }
+    if(list == NULL) {
+        printf("usage: batch_runner [-j threads] [-c max_cycles] [-b] [-v] "
+            "<programs.txt>\n");
+        return 1;
+    }
+    if(threads < 1)
+        threads = 1;
+    if(threads > MAX_WORKERS)
+        threads = MAX_WORKERS;
+
+    if(read_job_list(list, cycle_limit) == false)
+        return 1;
+    if(threads > num_jobs)
+        threads = (num_jobs > 0) ? num_jobs : 1;
+
+    //The shared tables are built here, before any thread could race to
+    //build them
+    build_block_tables();
+
+    //Equal runs of the list to start with
+    num_workers = threads;
+    for(int i = 0; i < num_workers; i++) {
+        Worker* w = &workers[i];
+        memset(w, 0, sizeof(Worker));
+        w->next = (int)((long long)num_jobs * i / num_workers);
+        w->end = (int)((long long)num_jobs * (i + 1) / num_workers);
+        w->memory = (unsigned char*)calloc(65536, 1);
+        if(w->memory == NULL || initialize_machine(&w->machine, w->memory)
+                == false) {
+            printf(" BATCH ERROR: out of memory\n");
+            return 1;
+        }
+    }
+
+    Uint64 started = SDL_GetPerformanceCounter();
+    for(int i = 1; i < num_workers; i++)
+        workers[i].thread = SDL_CreateThread(worker_thread, "6502 batch",
+            &workers[i]);
+    worker_thread(&workers[0]);
+    for(int i = 1; i < num_workers; i++) {
+        if(workers[i].thread != NULL)
+            SDL_WaitThread(workers[i].thread, NULL);
+        else
+            worker_thread(&workers[i]);    // couldn't start, run it here
+    }
+    double seconds = (double)(SDL_GetPerformanceCounter() - started) /
+        SDL_GetPerformanceFrequency();
+
+    //Report in list order
+    int passed = 0;
+    unsigned long long instructions = 0;
+    for(int i = 0; i < num_jobs; i++) {
+        Batch_Job* job = &jobs[i];
+        instructions += job->instructions;
+        if(job->passed)
+            passed++;
+        if(job->passed == false)
+            printf(" FAIL %s (line %d): %s\n", job->filename, job->list_line,
+                job->message);
+        else if(verbose)
+            printf(" PASS %s (%llu instructions, %llu cycles)\n",
+                job->filename, job->instructions, job->cycles);
+    }
+
+    printf(" RAN %d PROGRAMS ON %d THREADS: %d PASSED, %d FAILED\n",
+        num_jobs, num_workers, passed, num_jobs - passed);
+    if(seconds > 0) {
+        printf(" %llu INSTRUCTIONS IN %.3f S: %.1f M INSTRUCTIONS/S\n",
+            instructions, seconds, instructions / seconds / 1000000.0);
+    }
+    for(int i = 0; i < num_workers; i++) {
+        Worker* w = &workers[i];
+        printf("   THREAD %d: %d PROGRAMS (%d STOLEN), %llu INSTRUCTIONS\n",
+            i, w->jobs_run, w->jobs_stolen, w->instructions);
+        free_machine(&w->machine);
+        free(w->memory);
+    }
+
+    for(int i = 0; i < num_jobs; i++)
+        free(jobs[i].image);
+    free(jobs);
+    return (passed == num_jobs) ? 0 : 1;
+}
+
+// LOADING ////////////////////////////////////////////////////////////////////
+
+bool read_job_list(const char* filename, unsigned long long cycle_limit) {
+
+    FILE* f = fopen(filename, "r");
+    if(f == NULL) {
+        printf(" BATCH ERROR: unable to open %s\n", filename);
+        return false;
+    }
+
+    unsigned char* scratch = (unsigned char*)malloc(65536);
+    int capacity = 0;
+    int errors = 0;
+    int line_number = 0;
+    char line[1024];
+
+    while(scratch != NULL && fgets(line, sizeof(line), f) != NULL) {
+
+        line_number++;
+        char* comment = strchr(line, '#');
+        if(comment != NULL)
+            *comment = '\0';
+
+        char* token = strtok(line, " \t\r\n");
+        if(token == NULL)
+            continue;
+
+        if(num_jobs == capacity) {
+            capacity = (capacity == 0) ? 64 : capacity * 2;
+            jobs = (Batch_Job*)realloc(jobs, capacity * sizeof(Batch_Job));
+            if(jobs == NULL)
+                break;
+        }
+        Batch_Job* job = &jobs[num_jobs];
+        memset(job, 0, sizeof(Batch_Job));
+        strncpy(job->filename, token, sizeof(job->filename) - 1);
+        job->list_line = line_number;
+        job->cycle_limit = cycle_limit;
+
+        bool ok = true;
+        while((token = strtok(NULL, " \t\r\n")) != NULL) {
+
+            char* equals = strchr(token, '=');
+            int value = 0;
+            if(equals == NULL || parse_number(equals + 1, &value) == false) {
+                ok = false;
+                break;
+            }
+            *equals = '\0';
+
+            if(strcmp(token, "limit") == 0) {
+                job->cycle_limit = (unsigned long long)value;
+                continue;
+            }
+            if(job->num_expected == MAX_EXPECTED) {
+                ok = false;
+                break;
+            }
+
+            Expected* e = &job->expected[job->num_expected++];
+            e->value = (unsigned short)value;
+            int address;
+            if(strcmp(token, "a") == 0)       e->kind = EXPECT_A;
+            else if(strcmp(token, "x") == 0)  e->kind = EXPECT_X;
+            else if(strcmp(token, "y") == 0)  e->kind = EXPECT_Y;
+            else if(strcmp(token, "s") == 0)  e->kind = EXPECT_S;
+            else if(strcmp(token, "p") == 0)  e->kind = EXPECT_P;
+            else if(strcmp(token, "pc") == 0) e->kind = EXPECT_PC;
+            else if(parse_number(token, &address) && address < 65536) {
+                e->kind = EXPECT_MEMORY;
+                e->address = (unsigned short)address;
+            } else {
+                ok = false;
+                break;
+            }
+        }
+
+        if(ok == false) {
+            printf(" BATCH ERROR (line %d): can't read \"%s\"\n", line_number,
+                token);
+            errors++;
+        } else if(load_job(job, scratch) == false) {
+            errors++;
+        } else {
+            num_jobs++;
+        }
+    }
+
+    fclose(f);
+    free(scratch);
+    if(scratch == NULL || (jobs == NULL && capacity > 0)) {
+        printf(" BATCH ERROR: out of memory\n");
+        return false;
+    }
+    return errors == 0;
+}
+
+bool parse_number(const char* s, int* value) {
+
+    char* end;
+    long n;
+    if(*s == '$')
+        n = strtol(s + 1, &end, 16);
+    else
+        n = strtol(s, &end, 10);
+    *value = (int)n;
+    return end != s && *end == '\0' && n >= 0;
+}
+
+bool load_job(Batch_Job* job, unsigned char* scratch) {
+
+    //Memory starts zeroed, so the nonzero bytes are all a program needs
+    memset(scratch, 0, 65536);
+    Asm_Result result;
+    if(assemble_file(job->filename, scratch, &result, NULL) == false)
+        return false;
+
+    int low = 0, high = 65535;
+    while(low <= high && scratch[low] == 0)
+        low++;
+    while(high >= low && scratch[high] == 0)
+        high--;
+
+    job->start = result.start;
+    job->image_low = (unsigned short)((low <= high) ? low : 0);
+    job->image_size = (low <= high) ? high - low + 1 : 0;
+    job->image = (unsigned char*)malloc(job->image_size + 1);
+    if(job->image == NULL)
+        return false;
+    memcpy(job->image, scratch + job->image_low, job->image_size);
+    return true;
+}
+
+// RUNNING ////////////////////////////////////////////////////////////////////
+
+int SDLCALL worker_thread(void* data) {
+
+    Worker* w = (Worker*)data;
+    int job;
+    while(take_job(w, &job) || (steal_jobs(w) && take_job(w, &job))) {
+        run_job(w, &jobs[job]);
+        w->jobs_run++;
+    }
+    return 0;
+}
+
+bool take_job(Worker* w, int* job) {
+
+    SDL_AtomicLock(&w->lock);
+    bool found = w->next < w->end;
+    if(found)
+        *job = w->next++;
+    SDL_AtomicUnlock(&w->lock);
+    return found;
+}
+
+bool steal_jobs(Worker* w) {
+
+    //Keep going until there's nothing left anywhere; the victim can finish
+    //its last jobs while we look
+    while(true) {
+
+        Worker* victim = NULL;
+        int most = 0;
+        for(int i = 0; i < num_workers; i++) {
+            int left = workers[i].end - workers[i].next;   // a guess, unlocked
+            if(&workers[i] != w && left > most) {
+                most = left;
+                victim = &workers[i];
+            }
+        }
+        if(victim == NULL)
+            return false;
+
+        int first = 0, end = 0;
+        SDL_AtomicLock(&victim->lock);
+        int left = victim->end - victim->next;
+        if(left > 0) {
+            end = victim->end;
+            first = end - (left + 1) / 2;
+            victim->end = first;
+        }
+        SDL_AtomicUnlock(&victim->lock);
+
+        if(end > first) {
+            SDL_AtomicLock(&w->lock);
+            w->next = first;
+            w->end = end;
+            SDL_AtomicUnlock(&w->lock);
+            w->jobs_stolen += end - first;
+            return true;
+        }
+    }
+}
+
+void run_job(Worker* w, Batch_Job* job) {
+
+    Machine* v = &w->machine;
+    unsigned char* m = w->memory;
+
+    memset(m, 0, 65536);
+    memcpy(m + job->image_low, job->image, job->image_size);
+    invalidate_decode_cache(v);    // the last program's code is gone
+    reset_blocks(v);               // its blocks and their rebuild counts too
+
+    memset(&v->cpu, 0, sizeof(CPU));
+    v->cpu.pc = job->start;
+    v->cycles = 0;
+    v->instructions = 0;
+
+    if(use_blocks)
+        run_6502_blocks(v, job->cycle_limit);
+    else
+        run_6502(v, job->cycle_limit);
+
+    job->instructions = v->instructions;
+    job->cycles = v->cycles;
+    w->instructions += v->instructions;
+
+    job->passed = v->halted;
+    if(v->halted == false) {
+        snprintf(job->message, sizeof(job->message),
+            "still running after %llu cycles (pc=$%04X)", v->cycles,
+            v->cpu.pc);
+        return;
+    }
+
+    const char* NAMES[] = { "a", "x", "y", "s", "p", "pc" };
+    for(int i = 0; i < job->num_expected; i++) {
+
+        Expected* e = &job->expected[i];
+        int got;
+        switch(e->kind) {
+            case EXPECT_A:  got = v->cpu.a; break;
+            case EXPECT_X:  got = v->cpu.x; break;
+            case EXPECT_Y:  got = v->cpu.y; break;
+            case EXPECT_S:  got = v->cpu.s; break;
+            case EXPECT_P:  got = v->cpu.p; break;
+            case EXPECT_PC: got = v->cpu.pc; break;
+            default:        got = m[e->address]; break;
+        }
+
+        if(got != e->value) {
+            job->passed = false;
+            if(e->kind == EXPECT_MEMORY)
+                snprintf(job->message, sizeof(job->message),
+                    "$%04X=%d, expected %d", e->address, got, e->value);
+            else
+                snprintf(job->message, sizeof(job->message),
+                    "%s=%d, expected %d", NAMES[e->kind], got, e->value);
+            return;
+        }
+    }
+}
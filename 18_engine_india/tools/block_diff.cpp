@@ -0,0 +1,148 @@
+//345678901234567890123456789012345678901234567890123456789012345678901234567890
+//       1         2         3         4         5         6         7         8
+// Filename: ../tools/block_diff.cpp
+// Last Modified: Tue Oct 20, 2026  10:20AM
+//
+// Differential test of the block translator (see emulator_dynarec.cpp)
+// against the interpreter.
+//
+// Usage:
+//
+//     block_diff [programs] [seed]
+//
+// Each program is a run of random instructions at $0600 (5 to 64 of them,
+// 20000 programs by default) in a 64KB of random bytes, followed by RTS.
+// Anything that leaves the program or the stack behind is left out, so
+// every program runs straight through: JMP, JSR, RTS, RTI, BRK, the stack
+// ops and TXS. Branches only go forward, and about a quarter of absolute
+// addresses land in the program itself, so self-modifying code gets tried
+// too.
+//
+// Every program runs once with run_6502() and once with run_6502_blocks()
+// from the same registers, and the two must end with the same registers,
+// memory, cycle count and instruction count. The ones that don't halt
+// within the cycle limit are counted but not compared. Returns 0 if
+// nothing differed.
+
+#include "../emulator_6502.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+const int DEFAULT_PROGRAMS = 20000;
+const int MAX_PROGRAM_OPS = 64;
+const unsigned long long CYCLE_LIMIT = 100000;
+const int MAX_PRINTED_MISMATCHES = 5;
+
+unsigned char interpreted[65536];
+unsigned char translated[65536];
+int           usable_ops[256];     // opcodes a program can be made of
+int           num_usable_ops = 0;
+unsigned int  random_state = 1;
+
+// Same numbers on every compiler, so a seed always gives the same programs
+unsigned int next_random(void) {
+    random_state = random_state * 1103515245u + 12345u;
+    return random_state >> 8;
+}
+
+void make_program(void);
+bool same_cpu(const CPU* a, const CPU* b);
+
+int main(int argc, char* argv[]) {
+
+    int programs = (argc > 1) ? atoi(argv[1]) : DEFAULT_PROGRAMS;
+    random_state = (argc > 2) ? (unsigned int)atoi(argv[2]) : 1;
+
+    const char* LEFT_OUT[] = {
+        "JMP", "JSR", "RTS", "RTI", "BRK", "PHA", "PLA", "PHP", "PLP", "TXS"
+    };
+    for(int op = 0; op < 256; op++) {
+        bool usable = (OPCODES[op].mode != MODE_NONE);
+        for(int i = 0; i < (int)(sizeof(LEFT_OUT) / sizeof(LEFT_OUT[0])); i++) {
+            if(memcmp(OPCODES[op].mnemonic, LEFT_OUT[i], 3) == 0)
+                usable = false;
+        }
+        if(usable)
+            usable_ops[num_usable_ops++] = op;
+    }
+
+    int passed = 0, failed = 0, unfinished = 0;
+    for(int t = 0; t < programs; t++) {
+
+        make_program();
+        memcpy(translated, interpreted, 65536);
+
+        Machine a, b;
+        initialize_machine(&a, interpreted);
+        initialize_machine(&b, translated);
+        a.cpu.a = (unsigned char)next_random();
+        a.cpu.x = (unsigned char)next_random();
+        a.cpu.y = (unsigned char)next_random();
+        a.cpu.pc = 0x0600;
+        a.cpu.s = 0xFF;
+        a.cpu.p = (unsigned char)(next_random() & 0xF7);   // not decimal
+        b.cpu = a.cpu;
+
+        run_6502(&a, CYCLE_LIMIT);
+        run_6502_blocks(&b, CYCLE_LIMIT);
+
+        if(a.halted == false || b.halted == false) {
+            unfinished++;
+        } else if(same_cpu(&a.cpu, &b.cpu) == false ||
+                memcmp(interpreted, translated, 65536) != 0 ||
+                a.cycles != b.cycles || a.instructions != b.instructions) {
+            if(failed < MAX_PRINTED_MISMATCHES) {
+                printf(" MISMATCH in program %d: pc $%04X/$%04X a $%02X/$%02X"
+                    " p $%02X/$%02X, %llu/%llu cycles\n", t, a.cpu.pc,
+                    b.cpu.pc, a.cpu.a, b.cpu.a, a.cpu.p, b.cpu.p, a.cycles,
+                    b.cycles);
+            }
+            failed++;
+        } else {
+            passed++;
+        }
+
+        free_machine(&a);
+        free_machine(&b);
+    }
+
+    printf(" %d PROGRAMS: %d SAME, %d DIFFERENT, %d DIDN'T FINISH\n",
+        programs, passed, failed, unfinished);
+    return (failed == 0) ? 0 : 1;
+}
+
+void make_program(void) {
+
+    for(int i = 0; i < 65536; i++)
+        interpreted[i] = (unsigned char)next_random();
+
+    int pc = 0x0600;
+    int count = 5 + next_random() % (MAX_PROGRAM_OPS - 4);
+    for(int i = 0; i < count; i++) {
+
+        int op = usable_ops[next_random() % num_usable_ops];
+        interpreted[pc] = (unsigned char)op;
+
+        if(OPCODES[op].mode == MODE_RELATIVE) {
+            interpreted[pc + 1] = (unsigned char)(next_random() % 12);
+        } else if(OPCODES[op].length == 3) {
+            int address = (next_random() % 4 == 0) ?
+                0x0600 + next_random() % 200 : next_random() % 0x0800;
+            interpreted[pc + 1] = (unsigned char)address;
+            interpreted[pc + 2] = (unsigned char)(address >> 8);
+        } else if(OPCODES[op].length == 2) {
+            interpreted[pc + 1] = (unsigned char)next_random();
+        }
+        pc += OPCODES[op].length;
+    }
+
+    //Branches reach at most 13 bytes past the end
+    for(int i = 0; i < 16; i++)
+        interpreted[pc + i] = 0x60;    // RTS
+}
+
+bool same_cpu(const CPU* a, const CPU* b) {
+    return a->a == b->a && a->x == b->x && a->y == b->y && a->pc == b->pc &&
+        a->s == b->s && a->p == b->p;
+}
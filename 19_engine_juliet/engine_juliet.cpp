@@ -1,7 +1,7 @@
 //345678901234567890123456789012345678901234567890123456789012345678901234567890
 //       1         2         3         4         5         6         7         8
 // Filename: ../engine_juliet.cpp
-// Last Modified: Wed Jul 01, 2020  02:32PM
+// Last Modified: Tue Oct 20, 2026  09:30AM
 // LOC: 1017
 // Filesize: 48078 bytes
 //  
@@ -123,6 +123,14 @@ int keyboard_cursor_y = 0;
 void keyboard_key_down_handler(SDL_Event e);
 void keyboard_key_up_handler(SDL_Event e);
 void keyboard_alpha_numeric_handler(SDL_Event e);
+SDL_Event input_batch[INPUT_BATCH_SIZE];
+Uint32 rng_seed = 0;
+int next_input_batch(SDL_Event* batch, int max);
+bool headless_mode = false;
+void render_frame(void);
+void handle_input_events(void);
+void begin_input_frame(Uint32 frame);
+void record_input_event(const SDL_Event* e);
 
 //INPUT (ARRAYS OF FUNCTION POINTERS)
 void (*action_pointer_gamepad[ NUMBER_OF_GAMEPAD_INPUTS ]) (int action);
@@ -140,6 +148,34 @@ SDL_AudioDeviceID   audio_device_id;
 SDL_AudioFormat     audio_format = AUDIO_U8; // 0 to 255, 8-bit sound
 int                 audio_frequency = 44100; // hearing range: 120 Hz to 11000 Hz
 void initialize_audio(void);
+void initialize_synth(int frequency);
+void SDLCALL synth_audio_callback(void* userdata, Uint8* stream, int len);
+void free_sound_effect_cache(void);
+void rehook_streaming_music(void);
+bool open_synth_device(Uint16 samples);
+bool open_mixer(void);
+void tune_audio_buffer(void);
+void check_audio_health(void);
+void SDLCALL mixer_post_mix(void* udata, Uint8* stream, int len);
+
+// Audio telemetry. Each device's callback reports when it ran; a callback
+// arriving more than a buffer and a half after the previous one means the
+// device ran dry in between (an underrun). Both devices' threads update
+// the totals while the main thread reads them, so they're atomic.
+Uint16                audio_buffer_samples = 2048;
+double                audio_latency_ms = 0.0;
+SDL_atomic_t          audio_underruns;
+SDL_atomic_t          audio_callback_count;
+SDL_atomic_t          audio_callback_max_us;
+bool                  audio_auto_retune = false;
+Audio_Callback_Timing synth_callback_timing;
+Audio_Callback_Timing mixer_callback_timing;
+int                   mixer_frame_bytes = 4;  // set in open_mixer()
+const int             NUM_AUDIO_BUFFER_SIZES = 5;
+const Uint16          AUDIO_BUFFER_SIZES[NUM_AUDIO_BUFFER_SIZES] = {
+                          256, 512, 1024, 2048, 4096 };
+const Uint32          AUDIO_PROBE_MS = 120; // listen time per buffer size
+int                   underruns_at_last_check = 0;
 
 //USER DEFINED CALLS (functions that must be implemented in game code) 
 void user_create_all_textures(void);
@@ -162,6 +198,17 @@ Uint32 cumulative_loop_duration = 0;
 Uint32 cumulative_frame_count = 0;
 Uint32 spin_cycle = 0;
 
+// Frame pacing (see wait_for_next_frame)
+FRAME_PACING frame_pacing = PACE_SYSTEM_TIMER;
+double       av_drift_ms = 0.0;
+Uint32       audio_clock_resyncs = 0;
+double       next_frame_audio_ms = -1.0;  // < 0 means not scheduled yet
+double       audio_clock_origin_ms = 0.0;
+Uint32       system_timer_origin = 0;
+const double AUDIO_CLOCK_MAX_SLIP = 4.0;  // frames behind before resync
+const double AUDIO_CLOCK_MAX_WAIT = 2.0;  // frames waited before giving up
+void wait_for_next_frame(void);
+
 // Sound effects
 Mix_Chunk * sound_effect_list[NUM_SOUND_EFFECTS];
 const int   MAX_MUSIC_IN_LIST = 10;
@@ -230,6 +277,33 @@ struct Sprite {
 // Sprite control functions
 int sprite_id_counter; // track total number of sprites
 SDL_Texture* create_optimized_texture(const char* filename);
+SDL_Texture* create_texture_from_pack(const struct Asset_Pack_Entry* e);
+Mix_Chunk* create_chunk_from_pack(const struct Asset_Pack_Entry* e);
+const char* ASSET_PACK_FILENAME = "assets.jpak"; // opened if present
+void start_asset_loader(void);
+void stop_asset_loader(void);
+void process_asset_loads(Uint32 budget_ms);
+void start_hot_reload(void);
+void stop_hot_reload(void);
+void apply_hot_reloads(void);
+void forget_all_textures(void);
+void start_flight_recorder(void);
+void stop_flight_recorder(void);
+void begin_flight_frame(Uint32 frame);
+void enter_flight_phase(FLIGHT_PHASES phase);
+Uint32 renderer_vsync_flag(void);
+void track_input_latency(const SDL_Event* e);
+void wait_for_late_input(void);
+void begin_present(void);
+void end_present(void);
+int SDLCALL initialize_lookup_tables(void* data);
+int SDLCALL decode_glyph_sheet(void* data);
+int SDLCALL initialize_sound_system(void* data);
+int join_startup_threads(SDL_Thread* tables_thread, SDL_Thread* font_thread,
+        SDL_Thread* audio_thread);
+const char* GLYPH_SHEET_FILENAME = "../graphics/c64_font.bmp";
+SDL_Surface* glyph_surface = NULL;  // decoded off the main thread at startup
+int first_frame_step = -1;          // startup trace, see report_startup_trace
 void create_sprite_texture(struct Sprite* s, const char *filename1,
         const char *filename2);
 void destroy_sprite_texture(struct Sprite* s);
@@ -285,101 +359,29 @@ int main_game_loop() {
     bool quit_program = false;
     while(quit_program == false) {
 
+        TRACE_ZONE("frame");
+
         // Start of logic section 
         loop_start_time = SDL_GetTicks();
+        begin_flight_frame(cumulative_frame_count); // crash flight recorder
+
+        //In LATENCY_LATE_INPUT mode the frame's wait happens here, so input
+        //is polled as close to the next present as possible
+        if(latency_mode == LATENCY_LATE_INPUT) {
+            enter_flight_phase(FLIGHT_WAIT);
+            wait_for_late_input();
+            enter_flight_phase(FLIGHT_START);
+        }
 
-        user_starting_loop(); // USER DEFINED CALL
-
-        //Handle user input:
-        //This will loop until no further input events are found in the 
-        //event queue.
-        while(SDL_PollEvent(&input_event) != 0) {
-
-            switch(input_event.type) {
-
-                // KEYBOARD INPUT /////////////////////////
-                case SDL_KEYDOWN:
-                    if(input_event.key.repeat == 0)
-                        keyboard_key_down_handler(input_event); 
-                    break;
-                case SDL_KEYUP:
-                    keyboard_key_up_handler(input_event); 
-                    break;
-                case SDL_TEXTINPUT: 
-                    keyboard_alpha_numeric_handler(input_event);
-                    break;
-
-                // JOYSTICK INPUT /////////////////////////
-                case SDL_CONTROLLERBUTTONDOWN:
-                    if(gamepad_enabled == true) {
-                        (*action_pointer_gamepad[input_event.cbutton.button]) (START_ACTION);
-                    }
-                    break;
-                case SDL_CONTROLLERBUTTONUP:
-                    if(gamepad_enabled == true) {
-                        (*action_pointer_gamepad[input_event.cbutton.button]) (STOP_ACTION);
-                    }
-                    break;
-               
-                // MOUSE INPUT ///////////////////////////
-                case SDL_MOUSEMOTION:
-                    if(mouse_enabled == true) {
-                        if(current_graphics_mode == FULLSCREEN_MODE) {
-                            user_mouse_motion_handler(
-                                (input_event.motion.x / current_scale_factor) - target_texture_rect.x, 
-                                (input_event.motion.y / current_scale_factor) - target_texture_rect.y);
-                            if(mouse_cursor_enabled == true) {
-                                mouse_cursor_x = (input_event.motion.x / current_scale_factor) 
-                                                    - target_texture_rect.x;
-                                mouse_cursor_y = (input_event.motion.y / current_scale_factor)
-                                                    - target_texture_rect.y;
-                            }
-                        } else {
-                            user_mouse_motion_handler(
-                                    input_event.motion.x / current_scale_factor, 
-                                    input_event.motion.y / current_scale_factor);
-                            if(mouse_cursor_enabled == true) {
-                                mouse_cursor_x = (input_event.motion.x / current_scale_factor);
-                                mouse_cursor_y = (input_event.motion.y / current_scale_factor);
-                            }
-                        }
-                    } 
-                    break;
-                case SDL_MOUSEBUTTONDOWN:
-                    if(mouse_enabled == true) {
-                        (*action_pointer_mouse[input_event.button.button]) (START_ACTION);
-                    }
-                    break;
-                case SDL_MOUSEBUTTONUP:
-                    if(mouse_enabled == true) {
-                        (*action_pointer_mouse[input_event.button.button]) (STOP_ACTION);
-                    }
-                    break;
-               
-                case SDL_WINDOWEVENT:
-                    if(input_event.window.event == 
-                        SDL_WINDOWEVENT_ENTER) {
-                        printf(" >>> SDL_WINDOWEVENT (mouse has entered)\n");
-                    } else if(input_event.window.event == 
-                        SDL_WINDOWEVENT_LEAVE) {
-                        printf(" >>> SDL_WINDOWEVENT (mouse has exited)\n");
-                    }
-                    break;
-
-
-                // WINDOW INPUT ///////////////////////////
-                case SDL_QUIT: //clicking 'x' button on window
-                    keep_main_loop_running = false;
-                    break;
-
-                default:
-                    //printf(" >>> UNKNOWN INPUT %d <<<\n", input_event.type);
-                    break;
-            } 
-            
-            fflush(stdout);
+        {
+            TRACE_ZONE("user_starting_loop");
+            user_starting_loop(); // USER DEFINED CALL
         }
 
+        //Handle user input
+        enter_flight_phase(FLIGHT_INPUT);
+        handle_input_events();
+
         //Check for user wanting to exit main loop 
         if(keep_main_loop_running == false) {
             quit_program = true;
@@ -387,120 +389,65 @@ int main_game_loop() {
         }
 
         //Move sprites, update state, handle AI, etc.
-        user_update_sprites(); //USER DEFINED CALL
+        {
+            TRACE_ZONE("user_update_sprites");
+            enter_flight_phase(FLIGHT_UPDATE);
+            user_update_sprites(); //USER DEFINED CALL
+        }
 
         //Collision detection
-        user_collision_detection(); //USER DEFINED CALL
+        {
+            TRACE_ZONE("user_collision_detection");
+            enter_flight_phase(FLIGHT_COLLIDE);
+            user_collision_detection(); //USER DEFINED CALL
+        }
 
-        //Change rendering targets here for fullscreen mode
-        if(current_graphics_mode == FULLSCREEN_MODE)
-            SDL_SetRenderTarget(window_renderer, target_texture);
+        //Turn whatever the background loader has decoded into textures
+        enter_flight_phase(FLIGHT_UPLOAD);
+        process_asset_loads(asset_upload_budget_ms);
 
-        //Render SOLID BACKGROUND LAYER
-        SDL_SetRenderDrawColor(window_renderer, 
-                r_val[background_layer_color],
-                g_val[background_layer_color],
-                b_val[background_layer_color],
-                0xFF);
-        SDL_RenderFillRect(window_renderer, &game_screen_rect);
-        
-        //Render graphics
-        user_render_graphics(); //USER DEFINED CALL
-   
-        //Render TEXTGRID BACKGROUND
-        if(text_background_enabled == true) {
-            for(cell_row = 0; cell_row < TEXTGRID_HEIGHT; cell_row++) {
-                for(cell_col = 0; cell_col < TEXTGRID_WIDTH; cell_col++) {
-                    if(textgrid_background[cell_row][cell_col] != EMPTY) {
-
-                        cell_color = textgrid_background[cell_row][cell_col];
-
-                        SDL_SetRenderDrawColor(window_renderer, 
-                                r_val[cell_color],
-                                g_val[cell_color],
-                                b_val[cell_color],
-                                0xFF);
-
-                        SDL_RenderFillRect(window_renderer, 
-                                &text_rect[cell_row][cell_col]);
-                    }
-                }
-            }
+        //Swap in any images that were edited while the game was running
+        if(hot_reload_enabled == true) {
+            apply_hot_reloads();
         }
 
-        //Render TEXTGRID FOREGROUND (actual text)
-        if(text_foreground_enabled == true) {
-            render_textgrid();
+        //Draw the frame (skipped when running headless, e.g. when
+        //replaying a recording as a benchmark)
+        enter_flight_phase(FLIGHT_RENDER);
+        if(headless_mode == false) {
+            render_frame();
         }
-        
-        //Render cursors, if any are enabled
-        if(keyboard_cursor_enabled) {
-
-            cursor_blink--;
-
-            if(cursor_blink > CURSOR_BLINK_HALF) {
-                SDL_SetRenderDrawColor(window_renderer, 
-                        r_val[YELLOW],
-                        g_val[YELLOW],
-                        b_val[YELLOW],
-                        0xFF);
-
-                SDL_RenderFillRect(window_renderer, 
-                        &text_rect[keyboard_cursor_y][keyboard_cursor_x]);
-
-            } else if(cursor_blink < 0) {
-                cursor_blink = CURSOR_BLINK_RESET;
-            }
-        } 
-        
-        if(mouse_cursor_enabled) {
 
-            SDL_SetRenderDrawColor(window_renderer, 
-                    r_val[BLUE],
-                    g_val[BLUE],
-                    b_val[BLUE],
-                    0xFF);
-
-            SDL_RenderFillRect(window_renderer, 
-                    &text_rect[(int)(mouse_cursor_y/FONT_HEIGHT)]
-                              [(int)(mouse_cursor_x/FONT_WIDTH)]);
-        } 
-
-        //Render setup
-        if(current_graphics_mode == FULLSCREEN_MODE) {
-            SDL_SetRenderTarget(window_renderer, NULL);
-            SDL_RenderCopy(window_renderer, 
-                    target_texture,
-                    NULL,
-                    &target_texture_rect);
+        //Startup is over once the first frame is up
+        if(cumulative_frame_count == 0) {
+            end_startup_step(first_frame_step);
+            report_startup_trace();
         }
-
-        // render here
-        SDL_RenderPresent(window_renderer);
         
         // let user have a chance to do stuff at the end of the game loop
-        user_ending_loop(); // USER DEFINED CALL
+        {
+            TRACE_ZONE("user_ending_loop");
+            enter_flight_phase(FLIGHT_END);
+            user_ending_loop(); // USER DEFINED CALL
+        }
        
         //Calculate and record loop duration, pause here until
         //desired FPS is reached
-        calculated_loop_duration = 0;
-        spin_cycle = 0;
-        while(calculated_loop_duration < target_loop_duration) {
-
-            loop_end_time = SDL_GetTicks();
-            calculated_loop_duration = (loop_end_time - loop_start_time);
-            spin_cycle++; // count wasted cycles here
-
-        }
+        enter_flight_phase(FLIGHT_WAIT);
+        wait_for_next_frame();
+        enter_flight_phase(FLIGHT_START); // closes out the wait
 
         //Save cumulative info
         cumulative_loop_duration += calculated_loop_duration;
         cumulative_frame_count += 1;
 
+        if(cumulative_frame_count % DESIRED_FPS == 0) {
+            check_audio_health();
+        }
+
         if(show_spin_cycle == true) {
-            printf(" SPIN CYCLES: %d (FRAME: %d)\n", spin_cycle, 
+            LOG_INFO(LOG_ENGINE, " SPIN CYCLES: %d (FRAME: %d)", spin_cycle, 
                     cumulative_frame_count);
-            fflush(stdout);
         }
     }
 
@@ -510,10 +457,23 @@ int main_game_loop() {
     //Report on framerate statistics
     double avg_loop = (double)cumulative_loop_duration / 
         (double)cumulative_frame_count;
-    printf(" FRAMERATE: Average game-loop duration: %f ms (%d FPS)\n",
+    LOG_INFO(LOG_VIDEO, " FRAMERATE: Average game-loop duration: %f ms (%d FPS)",
             avg_loop, (int)(1000.0 / 
                 round(avg_loop)));
-    fflush(stdout);
+
+    //Report on audio statistics
+    LOG_INFO(LOG_AUDIO, " AUDIO: buffer %d samples (%.1f ms), %d underruns in %d callbacks,"
+            " longest callback %.3f ms",
+            audio_buffer_samples, audio_latency_ms,
+            SDL_AtomicGet(&audio_underruns), SDL_AtomicGet(&audio_callback_count),
+            SDL_AtomicGet(&audio_callback_max_us) / 1000.0);
+    if(frame_pacing == PACE_AUDIO_CLOCK) {
+        LOG_INFO(LOG_AUDIO, " AUDIO: paced on audio clock, drift vs system timer %.1f ms,"
+                " %d resyncs", av_drift_ms, audio_clock_resyncs);
+    }
+
+    //Report on input latency
+    report_input_latency();
 }
 
 bool add_music_file(const char* filename) {
@@ -533,9 +493,11 @@ bool add_music_file(const char* filename) {
 
             } else {
 
-                printf("Failed to load sound file %d: SDL_mixer Error: %s\n", 
+                LOG_ERROR(LOG_AUDIO, "Failed to load sound file %d: SDL_mixer Error: %s", 
                     i, Mix_GetError());
             }
+
+            break; // one slot per file
         }
     }
 
@@ -568,102 +530,103 @@ bool initialize_engine() {
 
     //Return value 
     bool success = true; 
-    
-    //Standard C++ way of seeding random number generator
-    srand(time(NULL)); 
-    printf(" INIT ENGINE: Random number generator seeded\n");
-    fflush(stdout);
-    
-    //Calculate each RGB value in the color system.
-    int color_index = 0;
-    for(int r = 0; r < 0xFF; r += 127) {
-        for(int g = 0; g < 0xFF; g += 127) {
-            for(int b = 0; b < 0xFF; b += 127) {
-                r_val[color_index] = r;
-                g_val[color_index] = g;
-                b_val[color_index] = b;
-                color_index++;
-            }
-        }
-    }
-    printf(" INIT ENGINE: RGB values calculated for 27 colors\n");
-    fflush(stdout);
-    
-    //The glyph sheet holds 128 cells arranged in 16 columns and 8 rows.
-    for (int i = 0; i < NUM_GLYPHS; i++) {
-        glyph_rect[i].x = (i % 16) * FONT_WIDTH;
-        glyph_rect[i].y = (i / 16) * FONT_HEIGHT;
-        glyph_rect[i].w = FONT_WIDTH;
-        glyph_rect[i].h = FONT_HEIGHT;
-    }
-    printf(" INIT ENGINE: Rects for glyph sheet Texture calculated\n");
-    fflush(stdout);
-    
-    //Pre-calculate all textgrid Rects 
-    SDL_Rect text_target = {0, 0, FONT_WIDTH, FONT_HEIGHT};
-    for (int r = 0; r < TEXTGRID_HEIGHT; r++) {
-        for (int c = 0; c < TEXTGRID_WIDTH; c++) {
 
-            text_target.x = c * FONT_WIDTH;
-            text_target.y = r * FONT_HEIGHT;
+    //Frame trace first, so the log thread's zones are recorded too
+    //(does nothing unless built with ENGINE_TRACE)
+    start_frame_trace();
+    TRACE_THREAD("main");
 
-            text_rect[r][c].x = text_target.x;
-            text_rect[r][c].y = text_target.y;
-            text_rect[r][c].w = text_target.w;
-            text_rect[r][c].h = text_target.h;
-        }
-    }
-    printf(" INIT ENGINE: Rects for textgrid locations calculated\n");
-    fflush(stdout);
+    //Everything from here on logs through the log thread
+    start_logging();
+
+    //From here on a crash leaves a flight_recorder.txt behind
+    start_flight_recorder();
+    int engine_step = begin_startup_step("initialize_engine");
+    
+    //Standard C++ way of seeding random number generator. The seed is
+    //kept so input recordings can reproduce a run (see
+    //engine_juliet_replay.cpp)
+    rng_seed = (Uint32)time(NULL);
+    srand(rng_seed); 
+    LOG_INFO(LOG_ENGINE, " INIT ENGINE: Random number generator seeded (%u)", rng_seed);
     
     //Set colors of letterbox/pillarbox 
     letterbox_color = GRAY;
-    printf(" INIT ENGINE: Letterbox color set for fullscreen: %s\n",
+    LOG_INFO(LOG_ENGINE, " INIT ENGINE: Letterbox color set for fullscreen: %s",
             COLOR_NAME[GRAY]);
-    fflush(stdout);
     
     //Initialize SDL
+    int step = begin_startup_step("SDL_Init");
     if(SDL_Init(SDL_INIT_VIDEO |
                 SDL_INIT_AUDIO |
                 SDL_INIT_GAMECONTROLLER |
                 SDL_INIT_TIMER |
                 SDL_INIT_EVENTS) < 0) {  
-        printf(" SDL could not initialize (SDL_Error: %s)\n", 
+        LOG_ERROR(LOG_ENGINE, " SDL could not initialize (SDL_Error: %s)", 
                 SDL_GetError());
-        fflush(stdout);
         success = false;
     }
-    printf(" INIT ENGINE: SDL_Init() called\n");
-    fflush(stdout);
+    end_startup_step(step);
+    LOG_INFO(LOG_ENGINE, " INIT ENGINE: SDL_Init() called");
+
+    //Use pre-converted assets where there's a pack to take them from
+    step = begin_startup_step("open asset pack");
+    if(open_asset_pack(ASSET_PACK_FILENAME) == false) {
+        LOG_INFO(LOG_ENGINE, " INIT ENGINE: no %s, loading loose asset files",
+                ASSET_PACK_FILENAME);
+    }
+    end_startup_step(step);
+
+    //Load support for PNG image formats (before anything decodes images)
+    step = begin_startup_step("IMG_Init");
+    int flags = IMG_INIT_PNG;
+    int initted = IMG_Init(flags);
+    if((initted & flags) != flags) {
+        LOG_ERROR(LOG_VIDEO, " Failed to init png support (IMG_Init: %s)", 
+                IMG_GetError());
+        success = false;
+    }
+    end_startup_step(step);
+    LOG_INFO(LOG_ENGINE, " INIT ENGINE: PNG image format enabled");
+    
+    //These don't depend on each other or on the window, so they run on
+    //their own threads while the main thread sets up video: the lookup
+    //tables, decoding the font, and the audio device probe (which spends
+    //most of its time listening for underruns, see tune_audio_buffer)
+    SDL_Thread* tables_thread = SDL_CreateThread(
+            initialize_lookup_tables, "init tables", NULL);
+    SDL_Thread* font_thread = SDL_CreateThread(
+            decode_glyph_sheet, "init font", NULL);
+    SDL_Thread* audio_thread = SDL_CreateThread(
+            initialize_sound_system, "init audio", NULL);
 
     //Enable Text Input to handle upper/lowercase keyboard input
     SDL_StartTextInput();
-    printf(" INIT ENGINE: SDL_StartTextInput() called\n");
-    fflush(stdout);
+    LOG_INFO(LOG_ENGINE, " INIT ENGINE: SDL_StartTextInput() called");
 
     //Set graphics mode
     current_graphics_mode = WINDOWED_MODE;  
-    printf(" INIT ENGINE: Graphics mode set to WINDOWED\n");
-    fflush(stdout);
+    LOG_INFO(LOG_ENGINE, " INIT ENGINE: Graphics mode set to WINDOWED");
     
     //Capture native desktop resolution, must be called after SDL_Init()
+    step = begin_startup_step("desktop display mode");
     SDL_DisplayMode dm;
     if(SDL_GetDesktopDisplayMode(0, &dm) != 0) {
-        printf(" SDL_GetDesktopDisplayMode failed: %s", 
+        LOG_ERROR(LOG_VIDEO, " SDL_GetDesktopDisplayMode failed: %s", 
                 SDL_GetError());
-        fflush(stdout);
+        join_startup_threads(tables_thread, font_thread, audio_thread);
         return 1;
     }
     Uint32 f = dm.format;
-    printf(" INIT ENGINE: Desktop Resolution: %i x %i @ %i Hz\n", 
+    LOG_INFO(LOG_ENGINE, " INIT ENGINE: Desktop Resolution: %i x %i @ %i Hz", 
             dm.w, dm.h, dm.refresh_rate);
     DESKTOP_SCREEN_WIDTH = dm.w;   //setting global parameters here
     DESKTOP_SCREEN_HEIGHT = dm.h;  //setting global parameters here
     window_refresh_rate = dm.refresh_rate; //critical value captured here
-    printf(" INIT ENGINE: Desktop Pixel Format: %s, %i (bpp)\n", 
+    end_startup_step(step);
+    LOG_INFO(LOG_ENGINE, " INIT ENGINE: Desktop Pixel Format: %s, %i (bpp)", 
             SDL_GetPixelFormatName(f), 
             SDL_BITSPERPIXEL(f) );
-    fflush(stdout);
 
     //Calculate and set scale factor to maximize screen size
     int scale_x;
@@ -676,22 +639,19 @@ bool initialize_engine() {
     else
         final_scale = scale_y;
     MAX_SCALE_FACTOR = final_scale;
-    printf(" INIT ENGINE: Maximum SCALING FACTOR found to be x%d\n", 
+    LOG_INFO(LOG_ENGINE, " INIT ENGINE: Maximum SCALING FACTOR found to be x%d", 
             MAX_SCALE_FACTOR);
-    fflush(stdout);
     current_scale_factor = 1; //Make initial window non-scaled 
-    printf(" INIT ENGINE: Current scale factor: x%d\n", 
-           current_scale_factor); 
-    fflush(stdout);
+    LOG_INFO(LOG_ENGINE, " INIT ENGINE: Current scale factor: x%d", 
+           current_scale_factor);
     
     //Setup a Rect object with the window's logical pixel resolution.
     game_screen_rect.x = 0;
     game_screen_rect.y = 0;
     game_screen_rect.w = GAME_SCREEN_WIDTH;
     game_screen_rect.h = GAME_SCREEN_HEIGHT;
-    printf(" INIT ENGINE: Game screen logical resolution: %d x %d\n", 
-           game_screen_rect.w, game_screen_rect.h); 
-    fflush(stdout);
+    LOG_INFO(LOG_ENGINE, " INIT ENGINE: Game screen logical resolution: %d x %d", 
+           game_screen_rect.w, game_screen_rect.h);
         
     //Use the native desktop resolution to calculate where the game 
     //screen should be located in fullscreen mode. The maximum scaling
@@ -707,51 +667,25 @@ bool initialize_engine() {
                     MAX_SCALE_FACTOR;
     target_texture_rect.w = GAME_SCREEN_WIDTH;
     target_texture_rect.h = GAME_SCREEN_HEIGHT;
-    printf(" INIT ENGINE: Target texture Rect calculated\n");
-    fflush(stdout);
+    LOG_INFO(LOG_ENGINE, " INIT ENGINE: Target texture Rect calculated");
     
-    //Load support for PNG image formats
-    int flags = IMG_INIT_PNG;
-    int initted = IMG_Init(flags);
-    if((initted & flags) != flags) {
-        printf(" Failed to init png support (IMG_Init: %s)\n", 
-                IMG_GetError());
-        fflush(stdout);
-        success = false;
-    }
-    printf(" INIT ENGINE: PNG image format enabled\n");
-    fflush(stdout);
-    
-    //Initialize SDL_mixer
-    if(Mix_OpenAudio(44100, MIX_DEFAULT_FORMAT, 2, 2048 ) < 0) {
-        printf(" SDL_mixer could not initialize! SDL_mixer Error: %s\n", 
-                Mix_GetError());
-        success = false;
-    }
-    printf(" INIT ENGINE: SDL_mixer initialized\n");
-    fflush(stdout);
-
     //Setup gamepad
+    step = begin_startup_step("gamepad enumeration");
     gamepad = NULL;
     for(int i = 0; i < SDL_NumJoysticks(); ++i) {
         if(SDL_IsGameController(i)) {
             gamepad = SDL_GameControllerOpen(i);
             if(gamepad) {
-                printf(" INIT ENGINE: Gamepad set up and initialized\n");
-                fflush(stdout);
+                LOG_INFO(LOG_ENGINE, " INIT ENGINE: Gamepad set up and initialized");
                 break;
             } else {
-                printf(" INIT ENGINE: Could not find gamepad %i: %s\n", 
+                LOG_WARN(LOG_ENGINE, " INIT ENGINE: Could not find gamepad %i: %s", 
                         i, SDL_GetError());
-                fflush(stdout);
             }
         }
     }
+    end_startup_step(step);
 
-    //Setup sound (digitial sound synthesis)
-    initialize_audio(); 
-    printf(" INIT ENGINE: Audio initialized\n");
-    fflush(stdout);
 
     // initialize sound and music lists 
     for(int i = 0; i < NUM_SOUND_EFFECTS; i++) {
@@ -760,37 +694,54 @@ bool initialize_engine() {
     for(int i = 0; i < MAX_MUSIC_IN_LIST; i++) {
         music_list[i] = NULL;
     }
-    printf(" INIT ENGINE: cleared arrays that hold sound effects and music\n");
-    fflush(stdout);
+    LOG_INFO(LOG_ENGINE, " INIT ENGINE: cleared arrays that hold sound effects and music");
     
     //Create main window, renderer, target textures, etc.
+    step = begin_startup_step("window and renderer");
     if(build_window_and_renderer() == false) {
-        printf(" Failed build_window_and_renderer() call\n");
-        fflush(stdout);
+        LOG_ERROR(LOG_ENGINE, " Failed build_window_and_renderer() call");
+        join_startup_threads(tables_thread, font_thread, audio_thread);
         return 1;
     }
-    printf(" INIT ENGINE: Main window and renderer created!\n");
-    fflush(stdout);
+    end_startup_step(step);
+    LOG_INFO(LOG_ENGINE, " INIT ENGINE: Main window and renderer created!");
+
+    //Collect the other threads
+    if(join_startup_threads(tables_thread, font_thread, audio_thread) == 0)
+        success = false;
+
+    //Development mode: watch image files for changes (before any
+    //textures are made, so they all get registered)
+    start_hot_reload();
+
+    //Initialize text/font system. The texture has to be made here, on
+    //the thread that owns the renderer.
+    step = begin_startup_step("glyph sheet texture");
+    if(glyph_surface != NULL) {
+        glyph_sheet = SDL_CreateTextureFromSurface(window_renderer,
+                glyph_surface);
+        SDL_FreeSurface(glyph_surface);
+        glyph_surface = NULL;
+        watch_texture(GLYPH_SHEET_FILENAME, glyph_sheet);
+    } else {
+        //In the asset pack (or the decode failed, and this reports why)
+        glyph_sheet = create_optimized_texture(GLYPH_SHEET_FILENAME);
+    }
+    watch_texture_slot(&glyph_sheet);
+    end_startup_step(step);
+    LOG_INFO(LOG_ENGINE, " INIT ENGINE: loaded glyph_sheet optimized texture");
     
-    //Initialize text/font system
-    glyph_sheet = create_optimized_texture(
-            "../graphics/c64_font.bmp");
-    printf(" INIT ENGINE: loaded glyph_sheet optimized texture\n");
-    fflush(stdout);
     initialize_textgrid_background_array();
-    printf(" INIT ENGINE: cleared textgrid_background array\n");
-    fflush(stdout);
+    LOG_INFO(LOG_ENGINE, " INIT ENGINE: cleared textgrid_background array");
     
     //Report what the native pixel format is (main Window)
     window_pixel_format = SDL_GetWindowPixelFormat(window);
     const char* temp = SDL_GetPixelFormatName(window_pixel_format);
-    printf(" INIT ENGINE: Window pixel format: %s\n", temp);
-    fflush(stdout);
+    LOG_INFO(LOG_ENGINE, " INIT ENGINE: Window pixel format: %s", temp);
 
     //Display some information about the renderer (once)
     SDL_GetRenderDriverInfo(0, &renderer_info);
-    printf(" INIT ENGINE: Renderer name: %s\n", renderer_info.name);
-    fflush(stdout);
+    LOG_INFO(LOG_ENGINE, " INIT ENGINE: Renderer name: %s", renderer_info.name);
 
     //Set text window
     TEXT_WINDOW_TOP_ROW = 0;
@@ -799,8 +750,7 @@ bool initialize_engine() {
     TEXT_WINDOW_RIGHT_COLUMN = TEXTGRID_WIDTH - 1;
     keyboard_cursor_x = TEXT_WINDOW_LEFT_COLUMN;
     keyboard_cursor_y = TEXT_WINDOW_TOP_ROW;
-    printf(" INIT ENGINE: Text window set to full-screen\n");
-    fflush(stdout);
+    LOG_INFO(LOG_ENGINE, " INIT ENGINE: Text window set to full-screen");
     
     //Point every key/button input to dummy_game_action function
     for(int i = 0; i < 285; i++) {
@@ -813,25 +763,439 @@ bool initialize_engine() {
         action_pointer_gamepad[i] = dummy_game_action;
     }
 
-    printf(" INIT ENGINE: function complete!\n");
-    fflush(stdout);
+    //Worker threads for queue_texture_load() and queue_sound_load()
+    start_asset_loader();
+    LOG_INFO(LOG_ENGINE, " INIT ENGINE: background asset loader started");
+
+    LOG_INFO(LOG_ENGINE, " INIT ENGINE: function complete!");
+    end_startup_step(engine_step);
+
+    //Ended once the first frame is on screen (see main_game_loop)
+    first_frame_step = begin_startup_step("first frame");
 
     return success;
 }
 
+int join_startup_threads(SDL_Thread* tables_thread, SDL_Thread* font_thread,
+        SDL_Thread* audio_thread) {
+
+    //Waits for the threads initialize_engine() started, on every way out
+    //of it, so none is left running (the audio one opening devices) while
+    //the caller tears down. Each one runs here instead if its thread
+    //couldn't be started. Returns initialize_sound_system()'s result.
+
+    if(tables_thread != NULL)
+        SDL_WaitThread(tables_thread, NULL);
+    else
+        initialize_lookup_tables(NULL);
+
+    if(font_thread != NULL)
+        SDL_WaitThread(font_thread, NULL);
+    else
+        decode_glyph_sheet(NULL);
+
+    int audio_ok = 0;
+    if(audio_thread != NULL)
+        SDL_WaitThread(audio_thread, &audio_ok);
+    else
+        audio_ok = initialize_sound_system(NULL);
+
+    return audio_ok;
+}
+
+int SDLCALL initialize_lookup_tables(void* data) {
+
+    int step = begin_startup_step("color and rect tables");
+
+    //Calculate each RGB value in the color system.
+    int color_index = 0;
+    for(int r = 0; r < 0xFF; r += 127) {
+        for(int g = 0; g < 0xFF; g += 127) {
+            for(int b = 0; b < 0xFF; b += 127) {
+                r_val[color_index] = r;
+                g_val[color_index] = g;
+                b_val[color_index] = b;
+                color_index++;
+            }
+        }
+    }
+    LOG_INFO(LOG_ENGINE, " INIT ENGINE: RGB values calculated for 27 colors");
+    
+    //The glyph sheet holds 128 cells arranged in 16 columns and 8 rows.
+    for (int i = 0; i < NUM_GLYPHS; i++) {
+        glyph_rect[i].x = (i % 16) * FONT_WIDTH;
+        glyph_rect[i].y = (i / 16) * FONT_HEIGHT;
+        glyph_rect[i].w = FONT_WIDTH;
+        glyph_rect[i].h = FONT_HEIGHT;
+    }
+    LOG_INFO(LOG_ENGINE, " INIT ENGINE: Rects for glyph sheet Texture calculated");
+    
+    //Pre-calculate all textgrid Rects 
+    SDL_Rect text_target = {0, 0, FONT_WIDTH, FONT_HEIGHT};
+    for (int r = 0; r < TEXTGRID_HEIGHT; r++) {
+        for (int c = 0; c < TEXTGRID_WIDTH; c++) {
+
+            text_target.x = c * FONT_WIDTH;
+            text_target.y = r * FONT_HEIGHT;
+
+            text_rect[r][c].x = text_target.x;
+            text_rect[r][c].y = text_target.y;
+            text_rect[r][c].w = text_target.w;
+            text_rect[r][c].h = text_target.h;
+        }
+    }
+    LOG_INFO(LOG_ENGINE, " INIT ENGINE: Rects for textgrid locations calculated");
+
+    end_startup_step(step);
+    return 0;
+}
+
+int SDLCALL decode_glyph_sheet(void* data) {
+
+    //Only the file read and decode happen here. Nothing to do if the
+    //sheet is in the asset pack, it's already decoded.
+    int step = begin_startup_step("decode glyph sheet");
+    if(find_pack_entry(GLYPH_SHEET_FILENAME) == NULL) {
+        glyph_surface = IMG_Load(GLYPH_SHEET_FILENAME);
+        if(glyph_surface != NULL) {
+            SDL_SetColorKey(glyph_surface, SDL_TRUE,
+                    SDL_MapRGB(glyph_surface->format, 10, 10, 10));
+        }
+    }
+    end_startup_step(step);
+    return 0;
+}
+
+int SDLCALL initialize_sound_system(void* data) {
+
+    bool success = true;
+
+    //Setup sound (digitial sound synthesis). This also picks the
+    //smallest buffer size that plays without underruns.
+    int step = begin_startup_step("audio devices and buffer probe");
+    initialize_audio(); 
+    end_startup_step(step);
+    LOG_INFO(LOG_AUDIO, " INIT ENGINE: Audio initialized");
+
+    //Initialize SDL_mixer, same buffer size as the synth device
+    step = begin_startup_step("SDL_mixer");
+    if(open_mixer() == false) {
+        success = false;
+    }
+    end_startup_step(step);
+    LOG_INFO(LOG_AUDIO, " INIT ENGINE: SDL_mixer initialized");
+
+    return success ? 1 : 0;
+}
+
+void handle_input_events(void) {
+
+    TRACE_ZONE("input");
+
+    //Events are taken off SDL's queue (or a replay) in batches,
+    //recorded into the per-frame input snapshot, then passed to the
+    //handlers. This will loop until no further input events are found
+    //in the event queue.
+    begin_input_frame(cumulative_frame_count);
+    bool mouse_moved = false;
+    SDL_MouseMotionEvent last_mouse_motion;
+    SDL_PumpEvents();
+
+    int num_events;
+    while((num_events = next_input_batch(input_batch, 
+                    INPUT_BATCH_SIZE)) > 0) {
+
+        for(int e = 0; e < num_events; e++) {
+
+            input_event = input_batch[e];
+            record_input_event(&input_event);
+            track_input_latency(&input_event);
+
+            switch(input_event.type) {
+
+                // KEYBOARD INPUT /////////////////////////
+                case SDL_KEYDOWN:
+                    if(input_event.key.repeat == 0)
+                        keyboard_key_down_handler(input_event); 
+                    break;
+                case SDL_KEYUP:
+                    keyboard_key_up_handler(input_event); 
+                    break;
+                case SDL_TEXTINPUT: 
+                    keyboard_alpha_numeric_handler(input_event);
+                    break;
+
+                // JOYSTICK INPUT /////////////////////////
+                case SDL_CONTROLLERBUTTONDOWN:
+                    if(gamepad_enabled == true) {
+                        (*action_pointer_gamepad[input_event.cbutton.button]) (START_ACTION);
+                    }
+                    break;
+                case SDL_CONTROLLERBUTTONUP:
+                    if(gamepad_enabled == true) {
+                        (*action_pointer_gamepad[input_event.cbutton.button]) (STOP_ACTION);
+                    }
+                    break;
+           
+                // MOUSE INPUT ///////////////////////////
+                case SDL_MOUSEMOTION:
+                    //Floods of these are common, only the last one
+                    //of the frame is passed on (see below)
+                    mouse_moved = true;
+                    last_mouse_motion = input_event.motion;
+                    break;
+                case SDL_MOUSEBUTTONDOWN:
+                    if(mouse_enabled == true) {
+                        (*action_pointer_mouse[input_event.button.button]) (START_ACTION);
+                    }
+                    break;
+                case SDL_MOUSEBUTTONUP:
+                    if(mouse_enabled == true) {
+                        (*action_pointer_mouse[input_event.button.button]) (STOP_ACTION);
+                    }
+                    break;
+           
+                case SDL_WINDOWEVENT:
+                    if(input_event.window.event == 
+                        SDL_WINDOWEVENT_ENTER) {
+                        LOG_DEBUG(LOG_INPUT, " >>> SDL_WINDOWEVENT (mouse has entered)");
+                    } else if(input_event.window.event == 
+                        SDL_WINDOWEVENT_LEAVE) {
+                        LOG_DEBUG(LOG_INPUT, " >>> SDL_WINDOWEVENT (mouse has exited)");
+                    }
+                    break;
+
+
+                // WINDOW INPUT ///////////////////////////
+                case SDL_QUIT: //clicking 'x' button on window
+                    keep_main_loop_running = false;
+                    break;
+
+                default:
+                    //printf(" >>> UNKNOWN INPUT %d <<<\n", input_event.type);
+                    break;
+            } 
+        }
+    }
+
+    if(mouse_moved == true) {
+        int x = last_mouse_motion.x / current_scale_factor;
+        int y = last_mouse_motion.y / current_scale_factor;
+        if(current_graphics_mode == FULLSCREEN_MODE) {
+            x -= target_texture_rect.x;
+            y -= target_texture_rect.y;
+        }
+        input.mouse_x = x;
+        input.mouse_y = y;
+
+        if(mouse_enabled == true) {
+            user_mouse_motion_handler(x, y);
+            if(mouse_cursor_enabled == true) {
+                mouse_cursor_x = x;
+                mouse_cursor_y = y;
+            }
+        }
+    }
+}
+
+void render_frame(void) {
+
+    TRACE_ZONE("render_frame");
+
+    //Change rendering targets here for fullscreen mode
+    if(current_graphics_mode == FULLSCREEN_MODE)
+        SDL_SetRenderTarget(window_renderer, target_texture);
+
+    //Render SOLID BACKGROUND LAYER
+    SDL_SetRenderDrawColor(window_renderer, 
+            r_val[background_layer_color],
+            g_val[background_layer_color],
+            b_val[background_layer_color],
+            0xFF);
+    SDL_RenderFillRect(window_renderer, &game_screen_rect);
+    
+    //Render graphics
+    user_render_graphics(); //USER DEFINED CALL
+   
+    //Render TEXTGRID BACKGROUND
+    if(text_background_enabled == true) {
+        for(cell_row = 0; cell_row < TEXTGRID_HEIGHT; cell_row++) {
+            for(cell_col = 0; cell_col < TEXTGRID_WIDTH; cell_col++) {
+                if(textgrid_background[cell_row][cell_col] != EMPTY) {
+
+                    cell_color = textgrid_background[cell_row][cell_col];
+
+                    SDL_SetRenderDrawColor(window_renderer, 
+                            r_val[cell_color],
+                            g_val[cell_color],
+                            b_val[cell_color],
+                            0xFF);
+
+                    SDL_RenderFillRect(window_renderer, 
+                            &text_rect[cell_row][cell_col]);
+                }
+            }
+        }
+    }
+
+    //Render TEXTGRID FOREGROUND (actual text)
+    if(text_foreground_enabled == true) {
+        render_textgrid();
+    }
+    
+    //Render cursors, if any are enabled
+    if(keyboard_cursor_enabled) {
+
+        cursor_blink--;
+
+        if(cursor_blink > CURSOR_BLINK_HALF) {
+            SDL_SetRenderDrawColor(window_renderer, 
+                    r_val[YELLOW],
+                    g_val[YELLOW],
+                    b_val[YELLOW],
+                    0xFF);
+
+            SDL_RenderFillRect(window_renderer, 
+                    &text_rect[keyboard_cursor_y][keyboard_cursor_x]);
+
+        } else if(cursor_blink < 0) {
+            cursor_blink = CURSOR_BLINK_RESET;
+        }
+    } 
+    
+    if(mouse_cursor_enabled) {
+
+        SDL_SetRenderDrawColor(window_renderer, 
+                r_val[BLUE],
+                g_val[BLUE],
+                b_val[BLUE],
+                0xFF);
+
+        SDL_RenderFillRect(window_renderer, 
+                &text_rect[(int)(mouse_cursor_y/FONT_HEIGHT)]
+                          [(int)(mouse_cursor_x/FONT_WIDTH)]);
+    } 
+
+    //Render setup
+    if(current_graphics_mode == FULLSCREEN_MODE) {
+        SDL_SetRenderTarget(window_renderer, NULL);
+        SDL_RenderCopy(window_renderer, 
+                target_texture,
+                NULL,
+                &target_texture_rect);
+    }
+
+    // render here
+    {
+        TRACE_ZONE("SDL_RenderPresent");
+        begin_present();
+        SDL_RenderPresent(window_renderer);
+        end_present(); // input latency is measured to here
+    }
+}
+
+void wait_for_next_frame(void) {
+
+    TRACE_ZONE("wait_for_next_frame");
+
+    calculated_loop_duration = 0;
+    spin_cycle = 0;
+
+    //Replays can run as fast as the machine allows, and late input mode
+    //waited at the start of the frame (vsync does the rest)
+    if(input_replay_uncapped() == true || latency_mode == LATENCY_LATE_INPUT) {
+        loop_end_time = SDL_GetTicks();
+        calculated_loop_duration = (loop_end_time - loop_start_time);
+        return;
+    }
+
+    if(frame_pacing == PACE_AUDIO_CLOCK && audio_device_id != 0) {
+
+        //Frames are scheduled on the audio clock: frame N ends when
+        //N frames' worth of sound has played. Deadlines are kept as an
+        //absolute schedule (not "now + frame") so rounding never adds
+        //up to drift. If we fall too far behind (a stall, the device
+        //being reopened), start a fresh schedule instead of rushing
+        //through a burst of frames to catch up.
+        const double frame_ms = 1000.0 / DESIRED_FPS;
+        double now = audio_clock_ms();
+
+        if(next_frame_audio_ms < 0.0 ||
+                now - next_frame_audio_ms > frame_ms * AUDIO_CLOCK_MAX_SLIP) {
+            if(next_frame_audio_ms >= 0.0)
+                audio_clock_resyncs++;
+            next_frame_audio_ms = now + frame_ms;
+            audio_clock_origin_ms = now;
+            system_timer_origin = SDL_GetTicks();
+        }
+
+        //Sleep through most of the wait and only spin the last couple of
+        //ms, SDL_Delay can oversleep by about that much. The deadline is
+        //never more than a frame away, so a clock that hasn't got there
+        //after AUDIO_CLOCK_MAX_WAIT frames of real time has stopped (the
+        //callback stalled or never started): this frame goes by the
+        //system timer instead, and the next one starts a fresh schedule.
+        Uint32 wait_start = SDL_GetTicks();
+        bool clock_stopped = false;
+        while(now < next_frame_audio_ms) {
+            if(SDL_GetTicks() - wait_start > frame_ms * AUDIO_CLOCK_MAX_WAIT) {
+                clock_stopped = true;
+                break;
+            }
+            double remaining_ms = next_frame_audio_ms - now;
+            if(remaining_ms > 2.0)
+                SDL_Delay((Uint32)(remaining_ms - 2.0));
+            now = audio_clock_ms();
+            spin_cycle++; // count wasted cycles here
+        }
+
+        if(clock_stopped == false) {
+            next_frame_audio_ms += frame_ms;
+
+            loop_end_time = SDL_GetTicks();
+            calculated_loop_duration = (loop_end_time - loop_start_time);
+            av_drift_ms = (now - audio_clock_origin_ms) - 
+                (double)(loop_end_time - system_timer_origin);
+            return;
+        }
+        audio_clock_resyncs++;
+    }
+
+    next_frame_audio_ms = -1.0; // re-schedule if audio pacing is turned on
+    while(calculated_loop_duration < target_loop_duration) {
+
+        loop_end_time = SDL_GetTicks();
+        calculated_loop_duration = (loop_end_time - loop_start_time);
+        spin_cycle++; // count wasted cycles here
+
+    }
+}
+
 void initialize_audio(void) {
 
     int nad;
     const char* audio_device_name;
 
     nad = SDL_GetNumAudioDevices(0);
-    printf(" SOUND: number of audio devices found: %d\n", nad);
-    fflush(stdout);
+    LOG_INFO(LOG_AUDIO, " SOUND: number of audio devices found: %d", nad);
 
     for(int i = 0; i < nad; i++) {
         audio_device_name = SDL_GetAudioDeviceName(i, 0);
-        printf(" SOUND: audio device name: %s\n", audio_device_name);
-        fflush(stdout);
+        LOG_INFO(LOG_AUDIO, " SOUND: audio device name: %s", audio_device_name);
+    }
+
+    tune_audio_buffer();
+}
+
+bool open_synth_device(Uint16 samples) {
+
+    //(Re)opens the synth device with a given buffer size. Tracker and
+    //voice state live in globals and initialize_synth() only retunes them
+    //to the new rate, so music carries on after a reopen.
+
+    if(audio_device_id != 0) {
+        SDL_CloseAudioDevice(audio_device_id);
+        audio_device_id = 0;
     }
 
     SDL_AudioSpec want, have;
@@ -839,33 +1203,184 @@ void initialize_audio(void) {
     want.freq = audio_frequency;
     want.format = audio_format;  
     want.channels = 1; // 1 = mono, 2 = stereo
-    want.samples = 2048; // how to decide on this? must be power of 2
-    want.callback = NULL; 
+    want.samples = samples; // must be power of 2, see tune_audio_buffer()
+    want.callback = synth_audio_callback; // synth voices + tracker music
     
+    //The synth renders 8-bit mono, so only let the frequency change.
+    //If the hardware wants something else SDL converts for us.
     audio_device_id = SDL_OpenAudioDevice(
             NULL, // choose best device based on 'want' struct
             0, // want a playback device, not a recording device
             &want, 
             &have, 
-            SDL_AUDIO_ALLOW_FORMAT_CHANGE);
-    printf(" SOUND: chosen audio device id: %d\n", audio_device_id);
-    fflush(stdout);
-
-    printf(" SOUND: available frequency: %d\n", have.freq);
-    printf(" SOUND: available format: %d\n", have.format);
-    printf(" SOUND: available channels: %d\n", have.channels);
-    printf(" SOUND: available samples: %d\n", have.samples);
-    fflush(stdout);
+            SDL_AUDIO_ALLOW_FREQUENCY_CHANGE);
+
+    if(audio_device_id == 0) {
+        LOG_ERROR(LOG_AUDIO, " SOUND: could not open audio device (SDL Error: %s)",
+                SDL_GetError());
+        return false;
+    }
+
+    audio_buffer_samples = have.samples;
+    audio_latency_ms = (1000.0 * have.samples) / have.freq;
+    SDL_memset(&synth_callback_timing, 0, sizeof(Audio_Callback_Timing));
+
+    //Devices start paused, callback runs from here on
+    initialize_synth(have.freq);
+    SDL_PauseAudioDevice(audio_device_id, 0);
+
+    return true;
+}
+
+bool open_mixer(void) {
+
+    if(Mix_OpenAudio(44100, MIX_DEFAULT_FORMAT, 2, audio_buffer_samples) < 0) {
+        LOG_ERROR(LOG_AUDIO, " SDL_mixer could not initialize! SDL_mixer Error: %s", 
+                Mix_GetError());
+        return false;
+    }
+
+    int frequency, channels;
+    Uint16 format;
+    Mix_QuerySpec(&frequency, &format, &channels);
+    mixer_frame_bytes = (SDL_AUDIO_BITSIZE(format) / 8) * channels;
+
+    SDL_memset(&mixer_callback_timing, 0, sizeof(Audio_Callback_Timing));
+    Mix_SetPostMix(mixer_post_mix, NULL);
+
+    return true;
+}
+
+void tune_audio_buffer(void) {
+
+    //Tries each buffer size from smallest to largest, lets the device run
+    //for AUDIO_PROBE_MS, and keeps the first one that didn't underrun.
+    //Smaller buffers mean sound effects are heard sooner after the input
+    //that triggered them (2048 samples is ~46 ms, 256 is ~6 ms).
+
+    for(int i = 0; i < NUM_AUDIO_BUFFER_SIZES; i++) {
+
+        if(open_synth_device(AUDIO_BUFFER_SIZES[i]) == false)
+            return;
+
+        int underruns_before = SDL_AtomicGet(&audio_underruns);
+        SDL_Delay(AUDIO_PROBE_MS);
+
+        bool stable = (SDL_AtomicGet(&audio_underruns) == underruns_before) &&
+            (SDL_AtomicGet(&synth_callback_timing.count) > 2);
+
+        LOG_INFO(LOG_AUDIO, " SOUND: buffer %d samples (%.1f ms): %s",
+                audio_buffer_samples, audio_latency_ms,
+                stable ? "stable" : "underruns");
+
+        if(stable)
+            break;
+    }
+
+    underruns_at_last_check = SDL_AtomicGet(&audio_underruns);
+}
+
+void retune_audio_buffer(void) {
+
+    //Re-runs the startup probe and reopens SDL_mixer at the new size.
+    //Anything playing on mixer channels is cut off; streamed music and
+    //tracker songs pick up where they were.
+
+    Mix_CloseAudio();
+
+    tune_audio_buffer();
+    open_mixer();
+    rehook_streaming_music();
+}
+
+void check_audio_health(void) {
+
+    //Called once a second from the main loop. If audio_auto_retune is on
+    //and the device underran since the last check, step up to the next
+    //buffer size (trading a little latency for no more crackling).
+
+    int underruns = SDL_AtomicGet(&audio_underruns);
+    if(audio_auto_retune == false || underruns == underruns_at_last_check)
+        return;
+
+    underruns_at_last_check = underruns;
+
+    for(int i = 0; i < NUM_AUDIO_BUFFER_SIZES; i++) {
+        if(AUDIO_BUFFER_SIZES[i] > audio_buffer_samples) {
+
+            LOG_WARN(LOG_AUDIO, " SOUND: underruns detected, buffer %d -> %d samples",
+                    audio_buffer_samples, AUDIO_BUFFER_SIZES[i]);
+
+            Mix_CloseAudio();
+            open_synth_device(AUDIO_BUFFER_SIZES[i]);
+            open_mixer();
+            rehook_streaming_music();
+            return;
+        }
+    }
+}
+
+void record_audio_callback(Audio_Callback_Timing* t, int frames, int frequency,
+        Uint64 start) {
+
+    //Runs on the audio thread at the end of every callback. The first few
+    //callbacks after opening a device come in bursts while SDL fills its
+    //buffers, so they're not judged.
+
+    Uint64 now = SDL_GetPerformanceCounter();
+    double ticks_per_ms = SDL_GetPerformanceFrequency() / 1000.0;
+    double period_ms = (1000.0 * frames) / frequency;
+
+    //Both devices' threads can be raising the maximum at once
+    int busy_us = (int)((now - start) * 1000 / ticks_per_ms);
+    int longest = SDL_AtomicGet(&audio_callback_max_us);
+    while(busy_us > longest &&
+            SDL_AtomicCAS(&audio_callback_max_us, longest, busy_us) == SDL_FALSE)
+        longest = SDL_AtomicGet(&audio_callback_max_us);
+
+    //last_start is only ever touched by this device's thread
+    if(SDL_AtomicGet(&t->count) > 2) {
+        double gap_ms = (start - t->last_start) / ticks_per_ms;
+        if(gap_ms > period_ms * 1.5)
+            SDL_AtomicIncRef(&audio_underruns);
+    }
+
+    t->last_start = start;
+    SDL_AtomicIncRef(&t->count);
+    SDL_AtomicIncRef(&audio_callback_count);
+}
+
+void SDLCALL mixer_post_mix(void* udata, Uint8* stream, int len) {
+
+    TRACE_THREAD("audio (mixer)");
+    TRACE_ZONE("mixer_post_mix");
+
+    //SDL_mixer's callback has already done its work by now, so this only
+    //tells us when the mixer thread ran, not how long it took
+    Uint64 now = SDL_GetPerformanceCounter();
+    int frequency = 44100;
+    Mix_QuerySpec(&frequency, NULL, NULL);
+    record_audio_callback(&mixer_callback_timing, len / mixer_frame_bytes,
+            frequency, now);
 }
 
 void shutdown_engine() {
 
     user_shutdown(); //USER DEFINED CALL
+
+    stop_input_recording(); // writes the end marker
+    stop_input_replay();
+    stop_asset_loader(); // before the chunks it may still hand over
+    stop_hot_reload();
+    stop_streaming_music(); // joins the prefetch thread
+    SDL_CloseAudioDevice(audio_device_id); // stops the synth callback
     
     for(int i = 0; i < NUM_SOUND_EFFECTS; i++) {
         Mix_FreeChunk(sound_effect_list[i]);
         sound_effect_list[i] = NULL;
     }
+    free_sound_effect_cache(); // samples behind generated effects
+    close_asset_pack(); // packed sounds played straight from the mapping
 
     SDL_GameControllerClose(gamepad); 
     gamepad = NULL; 
@@ -881,6 +1396,14 @@ void shutdown_engine() {
     Mix_Quit();
     IMG_Quit();
     SDL_Quit();
+
+    //Every thread that recorded zones has stopped by now
+    if(frame_trace_json != NULL) {
+        write_frame_trace(frame_trace_json);
+    }
+
+    stop_flight_recorder();
+    stop_logging(); // writes out anything still buffered
 }
  
 bool build_window_and_renderer() {
@@ -917,9 +1440,8 @@ bool build_window_and_renderer() {
     //Create renderer 
     if(window == NULL) {
 
-        printf(" Window could not be created (SDL Error: %s)\n", 
+        LOG_ERROR(LOG_VIDEO, " Window could not be created (SDL Error: %s)", 
                 SDL_GetError());
-        fflush(stdout);
         success = false;
         
     } else {
@@ -928,7 +1450,7 @@ bool build_window_and_renderer() {
 
             //Create renderer for window
             window_renderer = SDL_CreateRenderer(window, -1, 
-                    SDL_RENDERER_PRESENTVSYNC |
+                    renderer_vsync_flag() |
                     SDL_RENDERER_ACCELERATED |
                     SDL_RENDERER_TARGETTEXTURE
                     );
@@ -951,9 +1473,8 @@ bool build_window_and_renderer() {
             //rendering calls
             if(SDL_RenderSetScale(window_renderer, 
                         MAX_SCALE_FACTOR, MAX_SCALE_FACTOR) != 0) {
-                printf(" SDL_RenderSetScale() returned error: %s\n",
+                LOG_ERROR(LOG_VIDEO, " SDL_RenderSetScale() returned error: %s",
                         SDL_GetError());
-                fflush(stdout);
             }
 
             //Make sure to update global variable tracking scale factor
@@ -972,7 +1493,7 @@ bool build_window_and_renderer() {
             
             //Create renderer for window
             window_renderer = SDL_CreateRenderer(window, -1, 
-                    SDL_RENDERER_PRESENTVSYNC |
+                    renderer_vsync_flag() |
                     SDL_RENDERER_ACCELERATED 
                     );
             
@@ -981,9 +1502,8 @@ bool build_window_and_renderer() {
             //rendering calls
             if(SDL_RenderSetScale(window_renderer, 
                         current_scale_factor, current_scale_factor) != 0) {
-                printf(" SDL_RenderSetScale() returned error: %s\n",
+                LOG_ERROR(LOG_VIDEO, " SDL_RenderSetScale() returned error: %s",
                         SDL_GetError());
-                fflush(stdout);
             }
            
             //Make certain to set main window as render target 
@@ -992,9 +1512,8 @@ bool build_window_and_renderer() {
 
         if(window_renderer == NULL) {
                 
-            printf(" Renderer could not be created (SDL Error: %s)\n", 
+            LOG_ERROR(LOG_VIDEO, " Renderer could not be created (SDL Error: %s)", 
                     SDL_GetError());
-            fflush(stdout);
             success = false;
         } 
     }
@@ -1011,11 +1530,16 @@ void destroy_all_textures(void) {
     SDL_DestroyTexture(glyph_sheet);
 
     user_destroy_all_textures(); //USER DEFINED CALL
+
+    //Everything is remade (and registered again) by create_all_textures()
+    forget_all_textures();
 }
 
 void destroy_sprite_texture(struct Sprite* s) {
 
     if(s != NULL) {
+        forget_texture(s->body);
+        forget_texture(s->animation_sheet);
         SDL_DestroyTexture(s->body);
         SDL_DestroyTexture(s->animation_sheet);
     }
@@ -1024,8 +1548,8 @@ void destroy_sprite_texture(struct Sprite* s) {
 void create_all_textures(void) {
 
     // load font sheet texture 
-    glyph_sheet = create_optimized_texture(
-            "../graphics/c64_font.bmp");
+    glyph_sheet = create_optimized_texture(GLYPH_SHEET_FILENAME);
+    watch_texture_slot(&glyph_sheet);
 
     user_create_all_textures(); //USER DEFINED CALL
 }
@@ -1035,6 +1559,8 @@ void create_sprite_texture(struct Sprite* s, const char *filename1,
 
     s->body = create_optimized_texture(filename1);
     s->animation_sheet = create_optimized_texture(filename2);
+    watch_texture_slot(&s->body);
+    watch_texture_slot(&s->animation_sheet);
 }
 
 struct Sprite* create_sprite(const char *filename1, 
@@ -1064,6 +1590,10 @@ struct Sprite* create_sprite(const char *filename1,
     
     s->animation_sheet = create_optimized_texture(filename2);
 
+    //Hot reload repoints these if an edited image changes size
+    watch_texture_slot(&s->body);
+    watch_texture_slot(&s->animation_sheet);
+
     return s;
 }
 
@@ -1072,14 +1602,21 @@ SDL_Texture* create_optimized_texture(const char* filename) {
     //The final texture
     SDL_Texture* newTexture = NULL;
 
+    //Already decoded and converted in the asset pack?
+    const Asset_Pack_Entry* packed = find_pack_entry(filename);
+    if(packed != NULL && packed->type == ASSET_IMAGE) {
+        newTexture = create_texture_from_pack(packed);
+        watch_texture(filename, newTexture);
+        return newTexture;
+    }
+
     //Load image at specified path
     SDL_Surface* loadedSurface = IMG_Load(filename);
 
     if(loadedSurface == NULL) {
             
-        printf(" Unable to load image %s! SDL_image Error: %s\n", 
+        LOG_ERROR(LOG_VIDEO, " Unable to load image %s! SDL_image Error: %s", 
                filename, IMG_GetError() );
-        fflush(stdout);
         
     } else {
     
@@ -1094,15 +1631,15 @@ SDL_Texture* create_optimized_texture(const char* filename) {
             
         if(newTexture == NULL) {
                 
-            printf(" Unable to create texture from %s! SDL Error: %s\n", 
+            LOG_ERROR(LOG_VIDEO, " Unable to create texture from %s! SDL Error: %s", 
                    filename, SDL_GetError());
-            fflush(stdout);
         }
 
         //Get rid of old loaded surface
         SDL_FreeSurface(loadedSurface);
     }
 
+    watch_texture(filename, newTexture); // development mode only
     return newTexture;
 }
 
@@ -1134,16 +1671,29 @@ void load_wav_sound_file(const char *filename, int i) {
             sound_effect_list[i] = NULL;
         }
 
-        sound_effect_list[i] = Mix_LoadWAV(filename);
+        const Asset_Pack_Entry* packed = find_pack_entry(filename);
+        if(packed != NULL && packed->type == ASSET_SOUND) {
+            sound_effect_list[i] = create_chunk_from_pack(packed);
+        }
+
+        if(sound_effect_list[i] == NULL) {
+            sound_effect_list[i] = Mix_LoadWAV(filename);
+        }
             
         if(sound_effect_list[i] == NULL) {
-            printf("Failed to load sound file %d: SDL_mixer Error: %s\n", 
+            LOG_ERROR(LOG_AUDIO, "Failed to load sound file %d: SDL_mixer Error: %s", 
                     i, Mix_GetError());
-            fflush(stdout);
         }
     }
 }
 
+void play_sound_effect(int i) {
+
+    if(i >= 0 && i < NUM_SOUND_EFFECTS && sound_effect_list[i] != NULL) {
+        Mix_PlayChannel(-1, sound_effect_list[i], 0); //first free channel
+    }
+}
+
 void move_sprite(struct Sprite* s, int dx, int dy) {
 
     // Move sprite by supplied dx and dy, not by the sprite's internal dx,dy
@@ -1387,7 +1937,7 @@ void keyboard_key_down_handler(SDL_Event e) {
                 current_scale_factor++;
                 if(current_scale_factor > MAX_SCALE_FACTOR)
                     current_scale_factor = 1;
-                printf(" GRAPHICS ENGINE: Current scale factor: x%d\n", 
+                LOG_INFO(LOG_VIDEO, " GRAPHICS ENGINE: Current scale factor: x%d", 
                        current_scale_factor); 
                 destroy_all_textures();
                 build_window_and_renderer();
@@ -59,6 +59,107 @@ bool initialize_engine();
 int  main_game_loop();
 void shutdown_engine();
 
+// logging (see engine_juliet_log.cpp). Messages are buffered per thread
+// and written by a background thread, so logging never waits on stdout.
+// Calls below LOG_MIN_LEVEL are removed at compile time; build with
+// -DLOG_MIN_LEVEL=0 to keep LOG_DEBUG() calls.
+enum LOG_LEVELS {
+    LOG_LEVEL_DEBUG = 0,
+    LOG_LEVEL_INFO,
+    LOG_LEVEL_WARN,
+    LOG_LEVEL_ERROR
+};
+enum LOG_CATEGORIES {
+    LOG_ENGINE = 0,
+    LOG_VIDEO,
+    LOG_AUDIO,
+    LOG_INPUT,
+    LOG_GAME,
+    NUM_LOG_CATEGORIES
+};
+extern LOG_LEVELS log_level;  // runtime minimum (default LOG_LEVEL_INFO)
+extern bool log_category_enabled[NUM_LOG_CATEGORIES];
+void start_logging(void);     // called by initialize_engine()
+void stop_logging(void);      // called by shutdown_engine(), flushes
+void log_message(LOG_LEVELS level, LOG_CATEGORIES category,
+        const char* format, ...);
+
+#ifndef LOG_MIN_LEVEL
+#define LOG_MIN_LEVEL 1       // LOG_LEVEL_INFO
+#endif
+#if LOG_MIN_LEVEL <= 0
+#define LOG_DEBUG(category, ...) log_message(LOG_LEVEL_DEBUG, category, __VA_ARGS__)
+#else
+#define LOG_DEBUG(category, ...) ((void)0)
+#endif
+#if LOG_MIN_LEVEL <= 1
+#define LOG_INFO(category, ...)  log_message(LOG_LEVEL_INFO, category, __VA_ARGS__)
+#else
+#define LOG_INFO(category, ...)  ((void)0)
+#endif
+#if LOG_MIN_LEVEL <= 2
+#define LOG_WARN(category, ...)  log_message(LOG_LEVEL_WARN, category, __VA_ARGS__)
+#else
+#define LOG_WARN(category, ...)  ((void)0)
+#endif
+#define LOG_ERROR(category, ...) log_message(LOG_LEVEL_ERROR, category, __VA_ARGS__)
+
+// startup trace (see engine_juliet_trace.cpp). Every initialize_engine()
+// step is timed and reported as a table after the first frame; set
+// startup_trace_json to a filename beforehand to also get a Chrome trace.
+// Game code can time its own startup work the same way.
+extern const char* startup_trace_json;
+int  begin_startup_step(const char* name);    // returns the step's id
+void end_startup_step(int step);
+void report_startup_trace(void);
+
+// crash flight recorder (see engine_juliet_flight.cpp). Always on: on a
+// crash the last 300 frames' phase timings and counts, recent
+// input and recent log lines are written to FLIGHT_RECORDER_FILENAME.
+// Games add their own per-frame counts, e.g.
+// record_flight_count("bullets", num_bullets), with a string literal name.
+enum FLIGHT_PHASES {
+    FLIGHT_START = 0,    // user_starting_loop()
+    FLIGHT_INPUT,
+    FLIGHT_UPDATE,       // user_update_sprites()
+    FLIGHT_COLLIDE,      // user_collision_detection()
+    FLIGHT_UPLOAD,       // background loads, hot reload
+    FLIGHT_RENDER,
+    FLIGHT_END,          // user_ending_loop()
+    FLIGHT_WAIT,
+    NUM_FLIGHT_PHASES
+};
+extern const char* FLIGHT_RECORDER_FILENAME;
+void record_flight_count(const char* name, int value);
+
+// frame trace (see engine_juliet_trace.cpp). Build with -DENGINE_TRACE to
+// record TRACE_ZONE()s from every thread; without it the macros are empty.
+// write_frame_trace() writes trace-event JSON for chrome://tracing or
+// ui.perfetto.dev, and shutdown_engine() does so if frame_trace_json is set.
+extern const char* frame_trace_json;
+void start_frame_trace(void);                 // called by initialize_engine()
+void write_frame_trace(const char* filename);
+
+#ifdef ENGINE_TRACE
+void record_trace_zone(const char* name, Uint64 start, Uint64 end);
+void name_trace_thread(const char* name);
+
+struct Trace_Zone {
+    const char* name;
+    Uint64      start;
+    Trace_Zone(const char* n) : name(n), start(SDL_GetPerformanceCounter()) {}
+    ~Trace_Zone() { record_trace_zone(name, start, SDL_GetPerformanceCounter()); }
+};
+
+#define TRACE_JOIN2(a, b) a##b
+#define TRACE_JOIN(a, b)  TRACE_JOIN2(a, b)
+#define TRACE_ZONE(name)  Trace_Zone TRACE_JOIN(trace_zone_, __LINE__)(name)
+#define TRACE_THREAD(name) name_trace_thread(name)
+#else
+#define TRACE_ZONE(name)   ((void)0)
+#define TRACE_THREAD(name) ((void)0)
+#endif
+
 // user controls (of how engine functions)
 extern bool show_spin_cycle;
 extern bool text_foreground_enabled;  
@@ -80,6 +181,53 @@ extern Uint32 cumulative_loop_duration;
 extern Uint32 cumulative_frame_count;
 extern Uint32 spin_cycle;
 
+// frame pacing: PACE_SYSTEM_TIMER waits on SDL_GetTicks(), PACE_AUDIO_CLOCK
+// waits on how much sound the synth device has played, so video stays
+// locked to audio (music-synced games, emulated machines)
+enum FRAME_PACING {
+    PACE_SYSTEM_TIMER = 0,
+    PACE_AUDIO_CLOCK
+};
+extern FRAME_PACING frame_pacing;
+extern double av_drift_ms;          // audio clock minus system timer
+extern Uint32 audio_clock_resyncs;  // times pacing gave up catching up
+double audio_clock_ms(void);
+
+// input-to-present latency (see engine_juliet_latency.cpp). Set
+// latency_mode before initialize_engine(); every press is timed from SDL's
+// event timestamp to the SDL_RenderPresent() that first shows it, and
+// report_input_latency() logs a histogram per device.
+enum LATENCY_MODES {
+    LATENCY_VSYNC = 0,      // frame pacing, then present on vertical blank
+    LATENCY_LATE_INPUT,     // sleep first, poll input just before present
+    LATENCY_NO_VSYNC        // frame pacing only, present immediately
+};
+enum LATENCY_DEVICES {
+    LATENCY_KEYBOARD = 0,
+    LATENCY_MOUSE,
+    LATENCY_GAMEPAD,
+    NUM_LATENCY_DEVICES
+};
+extern LATENCY_MODES latency_mode;
+void report_input_latency(void);
+
+// audio globals (buffer size is picked at startup by trying sizes from
+// 256 samples up and keeping the first one that doesn't underrun)
+extern Uint16 audio_buffer_samples;
+extern double audio_latency_ms;         // one buffer's worth of sound
+extern SDL_atomic_t audio_underruns;    // late callbacks, both devices
+extern SDL_atomic_t audio_callback_count;
+extern SDL_atomic_t audio_callback_max_us;  // longest synth callback so far
+extern bool   audio_auto_retune;        // grow the buffer if underruns occur
+void retune_audio_buffer(void);
+
+struct Audio_Callback_Timing {
+    Uint64       last_start;   // performance counter at previous callback
+    SDL_atomic_t count;        // read by the main thread while probing
+};
+void record_audio_callback(struct Audio_Callback_Timing* t, int frames,
+        int frequency, Uint64 start);
+
 // text window for keyboard cursor and text insertion via keyboard
 extern int TEXT_WINDOW_LEFT_COLUMN;
 extern int TEXT_WINDOW_RIGHT_COLUMN;
@@ -153,6 +301,54 @@ extern void (*action_pointer_keyboard[ NUMBER_OF_KEYBOARD_INPUTS ]) (int action)
 extern void (*action_pointer_mouse[ NUMBER_OF_MOUSE_INPUTS ]) (int action);
 extern void (*action_pointer_gamepad[ NUMBER_OF_GAMEPAD_INPUTS ]) (int action);
 
+// per-frame input state (see engine_juliet_input.cpp). Bit i of key_down
+// is scancode i; mouse and gamepad buttons use one Uint32 each.
+const int INPUT_KEY_WORDS = (NUMBER_OF_KEYBOARD_INPUTS + 31) / 32;
+const int INPUT_RING_SIZE = 256;  // must be a power of 2
+const int INPUT_BATCH_SIZE = 64;  // events taken per SDL_PeepEvents() call
+
+struct Input_Snapshot {
+    Uint32 frame;                          // cumulative_frame_count
+    Uint32 key_down[INPUT_KEY_WORDS];
+    Uint32 key_pressed[INPUT_KEY_WORDS];   // went down this frame
+    Uint32 key_released[INPUT_KEY_WORDS];  // came up this frame
+    Uint32 mouse_down, mouse_pressed, mouse_released;
+    Uint32 gamepad_down, gamepad_pressed, gamepad_released;
+    Sint16 gamepad_axis[SDL_CONTROLLER_AXIS_MAX];
+    int    mouse_x, mouse_y;               // game screen pixels
+    int    mouse_dx, mouse_dy;             // window pixels moved this frame
+    int    event_count;                    // events drained this frame
+};
+
+struct Input_Event_Record {
+    Uint32    timestamp;  // SDL_GetTicks() when SDL queued the event
+    Uint32    frame;      // frame it was handled in
+    SDL_Event event;
+};
+
+extern Input_Snapshot input;
+bool key_down(SDL_Scancode sc);
+bool key_pressed(SDL_Scancode sc);
+bool key_released(SDL_Scancode sc);
+bool mouse_button_down(int button);        // SDL_BUTTON_LEFT etc.
+bool mouse_button_pressed(int button);
+bool mouse_button_released(int button);
+bool gamepad_down(int button);             // SDL_CONTROLLER_BUTTON_A etc.
+bool gamepad_pressed(int button);
+bool gamepad_released(int button);
+const Input_Event_Record* get_recent_input_event(int n);  // 0 = newest
+
+// input recording and replay (see engine_juliet_replay.cpp). Start either
+// one right after initialize_engine(); both reseed rand().
+extern Uint32 rng_seed;     // seed used for srand()
+extern bool   headless_mode; // skip all drawing (window still opens)
+bool start_input_recording(const char* filename);
+void stop_input_recording(void);
+bool start_input_replay(const char* filename, bool uncapped);
+void stop_input_replay(void);
+bool input_replay_active(void);
+bool input_replay_uncapped(void);
+
 
 
 
@@ -170,6 +366,148 @@ enum SOUND_EFFECTS {
 void load_sound_effect_wav_file(const char *filename, int i);
 void play_sound_effect(int i);
 
+// music (Mix_LoadMUS, whole file decoded by SDL_mixer)
+bool add_music_file(const char* filename);
+
+// streaming music (.wav read from disk in chunks on a background thread,
+// memory use is fixed no matter how long the track is)
+bool play_streaming_music(const char* filename, bool loop);
+void stop_streaming_music(void);
+bool streaming_music_playing(void);
+extern int    music_stream_volume;     // 0 to MIX_MAX_VOLUME
+extern Uint32 music_stream_underruns;  // times the mixer found the buffer dry
+
+// synth voices and tracker music (rendered by the engine's own audio device,
+// see engine_juliet_synth.cpp for the song file layout)
+const int NUM_SYNTH_VOICES = 4;
+const int SYNTH_NOTE_MAX = 96;     // notes 1-96 are C-0 to B-7
+const int SYNTH_NOTE_OFF = 255;    // note value that releases the voice
+
+enum SYNTH_WAVEFORMS {
+    SYNTH_SQUARE = 0,
+    SYNTH_TRIANGLE,
+    SYNTH_SAWTOOTH,
+    SYNTH_NOISE
+};
+
+struct Instrument {
+    Uint8 waveform;   // SYNTH_WAVEFORMS
+    Uint8 duty;       // square wave only, 128 = 50%
+    Uint8 volume;     // 0-64
+    Uint8 attack;     // ticks to reach full level
+    Uint8 decay;      // ticks to fall to sustain level
+    Uint8 sustain;    // level 0-255 held until note off
+    Uint8 release;    // ticks to fall to silence
+};
+
+struct Note_Cell {
+    Uint8 note;       // 0 = nothing, 1-96, or SYNTH_NOTE_OFF
+    Uint8 instrument;
+    Uint8 effect;
+    Uint8 param;
+};
+
+struct Song {
+    Uint8       speed;             // ticks per row
+    Uint8       tick_rate;         // ticks per second
+    int         rows_per_pattern;
+    int         num_instruments;
+    int         num_patterns;
+    int         order_length;
+    int         restart_position;  // order index to loop back to
+    Instrument* instruments;
+    Note_Cell*  patterns;          // [pattern][row][voice]
+    Uint8*      order;
+};
+
+struct Song* load_tracker_song(const char* filename);
+void free_tracker_song(struct Song* s);
+void play_tracker_song(const struct Song* s);
+void stop_tracker_song(void);
+bool tracker_song_playing(void);
+
+// procedural sound effects (rendered in memory, no .wav needed). Effects are
+// cached by their parameters; generate_sound_effects() renders a whole list
+// at startup across all CPU cores.
+struct Sfx_Params {
+    int   waveform;         // SYNTH_WAVEFORMS
+    float base_frequency;   // Hz
+    float frequency_slide;  // Hz per second, negative slides down
+    float duty;             // square wave only, 0.0 - 1.0
+    float duty_slide;       // per second
+    float attack;           // seconds
+    float sustain;          // seconds
+    float decay;            // seconds
+    float noise;            // 0.0 (pure tone) to 1.0 (pure noise)
+    float volume;           // 0.0 - 1.0
+};
+
+void generate_sound_effects(const struct Sfx_Params* list, int count);
+void load_sound_effect_params(const struct Sfx_Params* p, int i);
+
+// asset packs (see engine_juliet_pack.cpp, built by tools/asset_packer.cpp).
+// Images are stored already converted to ASSET_PACK_PIXEL_FORMAT with the
+// (10,10,10) color key turned into alpha; sounds are stored in the mixer's
+// format. Entries are named by the path the game loads them with, sorted.
+const Uint32 ASSET_PACK_VERSION = 1;
+const int    ASSET_NAME_LENGTH = 64;
+const Uint32 ASSET_PACK_PIXEL_FORMAT = SDL_PIXELFORMAT_ARGB8888;
+const int    ASSET_PACK_FREQUENCY = 44100;   // matches Mix_OpenAudio() call
+const Uint16 ASSET_PACK_AUDIO_FORMAT = AUDIO_S16LSB;
+const int    ASSET_PACK_CHANNELS = 2;
+const Uint32 ASSET_PACK_ALIGNMENT = 16;
+
+enum ASSET_TYPES {
+    ASSET_IMAGE = 1,
+    ASSET_SOUND
+};
+
+struct Asset_Pack_Header {
+    char   id[4];             // "JPAK"
+    Uint32 version;
+    Uint32 num_entries;       // directory follows the header
+    Uint32 pixel_format;
+    Uint32 sound_frequency;
+    Uint16 sound_format;
+    Uint16 sound_channels;
+};
+
+struct Asset_Pack_Entry {
+    char   name[ASSET_NAME_LENGTH];
+    Uint32 type;              // ASSET_TYPES
+    Uint32 offset;            // from start of file, ASSET_PACK_ALIGNMENT
+    Uint32 size;              // bytes
+    Uint32 width;             // images only
+    Uint32 height;
+    Uint32 pitch;
+};
+
+bool open_asset_pack(const char* filename);  // maps the whole file
+void close_asset_pack(void);
+const struct Asset_Pack_Entry* find_pack_entry(const char* name);
+
+// background asset loading (see engine_juliet_loader.cpp). Files are
+// decoded on worker threads; textures are created in main_game_loop()
+// within asset_upload_budget_ms each frame. Pointers/slots are filled in
+// when done.
+extern Uint32 asset_upload_budget_ms;
+bool  queue_texture_load(const char* filename, SDL_Texture** texture);
+bool  queue_sound_load(const char* filename, int i);
+int   asset_loads_pending(void);
+float asset_load_progress(void);              // 0.0 - 1.0
+void  print_loading_progress(int r, int c);   // progress bar in textgrid
+
+// texture hot reload (see engine_juliet_hotreload.cpp). Development only:
+// set hot_reload_enabled before initialize_engine() and edited images are
+// swapped into their textures before the next frame is drawn. Textures
+// from create_optimized_texture() and the loader are watched already;
+// register any SDL_Texture* variable that should follow a texture if the
+// image changes size, and forget a texture before destroying it.
+extern bool hot_reload_enabled;
+void watch_texture(const char* filename, SDL_Texture* texture);
+void watch_texture_slot(SDL_Texture** slot);
+void forget_texture(SDL_Texture* texture);
+
 //SOLID BACKGROUND LAYER
 extern COLORS background_layer_color;
 
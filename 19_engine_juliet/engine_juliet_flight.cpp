@@ -0,0 +1,350 @@
+//345678901234567890123456789012345678901234567890123456789012345678901234567890
+//       1         2         3         4         5         6         7         8
+// Filename: ../engine_juliet_flight.cpp
+// Last Modified: Mon Oct 19, 2026  08:45PM
+//
+// Crash flight recorder.
+//
+// Always on. For each of the last FLIGHT_FRAMES frames main_game_loop()
+// keeps how long every phase took (input, the user callbacks, uploads,
+// drawing, waiting) plus the game's own counts (record_flight_count(),
+// e.g. how many bullets are live). log_message() copies every line it
+// accepts into a ring of the last FLIGHT_LOG_LINES, and the input
+// snapshot already keeps the last INPUT_RING_SIZE events.
+//
+// If the process dies on SIGSEGV, SIGABRT, SIGFPE or SIGILL, the handler
+// writes all of that to FLIGHT_RECORDER_FILENAME: the frames oldest first,
+// the phase the last frame was in when it died, the recent input events
+// and the log lines (including ones the log thread never got to print).
+// Then it puts the default handler back and raises the signal again, so
+// the crash itself still happens as before.
+//
+// Recording is a performance counter read and a store per phase, so it
+// costs nanoseconds a frame. The handler only calls open(), write() and
+// close() and formats numbers itself, as nothing else is safe to call
+// from a signal handler.
+
+#include "engine_juliet.h"
+#include <signal.h>
+#include <fcntl.h>
+#ifdef _WIN32
+#include <io.h>
+#include <sys/stat.h>
+#define flight_open(name) _open(name, _O_WRONLY | _O_CREAT | _O_TRUNC | \
+        _O_BINARY, _S_IREAD | _S_IWRITE)
+#define flight_write      _write
+#define flight_close      _close
+#else
+#include <unistd.h>
+#define flight_open(name) open(name, O_WRONLY | O_CREAT | O_TRUNC, 0644)
+#define flight_write      write
+#define flight_close      close
+#endif
+
+extern Input_Event_Record input_ring[INPUT_RING_SIZE];
+extern Uint32             input_ring_total;
+extern int                sprite_id_counter;
+
+const int FLIGHT_FRAMES = 300;
+const int FLIGHT_COUNTERS = 8;
+const int FLIGHT_LOG_LINES = 64;
+const int FLIGHT_LOG_LINE_LENGTH = 160;
+
+const char* FLIGHT_PHASE_NAMES[NUM_FLIGHT_PHASES] = {
+    "start", "input", "update", "collide", "upload", "render", "end", "wait"
+};
+
+struct Flight_Frame {
+    Uint32 frame;
+    Uint32 ticks;                            // SDL_GetTicks() at the start
+    Uint32 phase[NUM_FLIGHT_PHASES];         // performance counter ticks
+    int    count[FLIGHT_COUNTERS];
+};
+
+const char*  FLIGHT_RECORDER_FILENAME = "flight_recorder.txt";
+
+Flight_Frame flight_frames[FLIGHT_FRAMES];
+Uint32       flight_frames_total = 0;        // frames ever begun
+Flight_Frame* flight_current = NULL;
+FLIGHT_PHASES flight_phase = FLIGHT_START;
+Uint64       flight_phase_start = 0;
+Uint64       flight_frequency = 1;
+const char*  flight_count_names[FLIGHT_COUNTERS];
+int          flight_num_counts = 0;
+
+char         flight_log[FLIGHT_LOG_LINES][FLIGHT_LOG_LINE_LENGTH];
+SDL_atomic_t flight_log_total;
+
+const int    FLIGHT_SIGNALS[] = { SIGSEGV, SIGABRT, SIGFPE, SIGILL };
+const char*  FLIGHT_SIGNAL_NAMES[] = { "SIGSEGV", "SIGABRT", "SIGFPE", "SIGILL" };
+const int    NUM_FLIGHT_SIGNALS = 4;
+void       (*flight_previous_handler[NUM_FLIGHT_SIGNALS])(int);
+bool         flight_recorder_running = false;
+
+void flight_signal_handler(int sig);
+
+void start_flight_recorder(void) {
+
+    if(flight_recorder_running == true)
+        return;
+
+    flight_frequency = SDL_GetPerformanceFrequency();
+    flight_count_names[flight_num_counts++] = "sprites made";
+
+    for(int i = 0; i < NUM_FLIGHT_SIGNALS; i++)
+        flight_previous_handler[i] = signal(FLIGHT_SIGNALS[i], flight_signal_handler);
+    flight_recorder_running = true;
+}
+
+void stop_flight_recorder(void) {
+
+    if(flight_recorder_running == false)
+        return;
+
+    for(int i = 0; i < NUM_FLIGHT_SIGNALS; i++)
+        signal(FLIGHT_SIGNALS[i], flight_previous_handler[i]);
+    flight_recorder_running = false;
+}
+
+void begin_flight_frame(Uint32 frame) {
+
+    Flight_Frame* f = &flight_frames[flight_frames_total % FLIGHT_FRAMES];
+    SDL_memset(f, 0, sizeof(Flight_Frame));
+    f->frame = frame;
+    f->ticks = SDL_GetTicks();
+    f->count[0] = sprite_id_counter;
+
+    flight_current = f;
+    flight_frames_total++;
+    flight_phase = FLIGHT_START;
+    flight_phase_start = SDL_GetPerformanceCounter();
+}
+
+void enter_flight_phase(FLIGHT_PHASES phase) {
+
+    //Closes whatever phase was running
+    Uint64 now = SDL_GetPerformanceCounter();
+    if(flight_current != NULL)
+        flight_current->phase[flight_phase] += (Uint32)(now - flight_phase_start);
+    flight_phase = phase;
+    flight_phase_start = now;
+}
+
+void record_flight_count(const char* name, int value) {
+
+    //Names are compared by pointer, so pass the same literal every frame
+    int i = 0;
+    while(i < flight_num_counts && flight_count_names[i] != name)
+        i++;
+    if(i == flight_num_counts) {
+        if(i == FLIGHT_COUNTERS)
+            return;
+        flight_count_names[flight_num_counts++] = name;
+    }
+    if(flight_current != NULL)
+        flight_current->count[i] = value;
+}
+
+void record_flight_log(const char* line, int len) {
+
+    //Any thread. Lines can be overwritten while being read by the crash
+    //handler, which at worst garbles one of them.
+    int i = SDL_AtomicAdd(&flight_log_total, 1) % FLIGHT_LOG_LINES;
+    if(len > FLIGHT_LOG_LINE_LENGTH - 1)
+        len = FLIGHT_LOG_LINE_LENGTH - 1;
+    SDL_memcpy(flight_log[i], line, len);
+    flight_log[i][len] = '\0';
+}
+
+// CRASH HANDLER (async-signal-safe from here on) /////////////////////////////
+
+struct Flight_Writer {
+    int  fd;
+    int  len;
+    char line[512];
+};
+
+void flight_put(Flight_Writer* w, const char* s) {
+    while(*s != '\0' && *s != '\n' && w->len < (int)sizeof(w->line) - 1)
+        w->line[w->len++] = *s++;
+}
+
+void flight_put_int(Flight_Writer* w, Sint64 value, int width) {
+
+    char digits[24];
+    int n = 0;
+    bool negative = value < 0;
+    Uint64 v = negative ? (Uint64)(-value) : (Uint64)value;
+    do {
+        digits[n++] = '0' + (char)(v % 10);
+        v /= 10;
+    } while(v > 0);
+    if(negative)
+        digits[n++] = '-';
+
+    for(int i = n; i < width && w->len < (int)sizeof(w->line) - 1; i++)
+        w->line[w->len++] = ' ';
+    while(n > 0 && w->len < (int)sizeof(w->line) - 1)
+        w->line[w->len++] = digits[--n];
+}
+
+void flight_put_ms(Flight_Writer* w, Uint64 ticks, int width) {
+
+    //Performance counter ticks as milliseconds with two decimals
+    Uint64 hundredths = ticks * 100000 / flight_frequency;
+    flight_put_int(w, (Sint64)(hundredths / 100), width - 3);
+    char tail[3] = { '.', (char)('0' + (hundredths / 10) % 10),
+        (char)('0' + hundredths % 10) };
+    for(int i = 0; i < 3 && w->len < (int)sizeof(w->line) - 1; i++)
+        w->line[w->len++] = tail[i];
+}
+
+void flight_end_line(Flight_Writer* w) {
+    w->line[w->len++] = '\n';
+    if(flight_write(w->fd, w->line, w->len) < 0) { } // nothing to do about it
+    w->len = 0;
+}
+
+void flight_signal_handler(int sig) {
+
+    //A second crash in here goes straight to the default handler
+    signal(sig, SIG_DFL);
+
+    const char* signal_name = "signal";
+    for(int i = 0; i < NUM_FLIGHT_SIGNALS; i++) {
+        if(FLIGHT_SIGNALS[i] == sig)
+            signal_name = FLIGHT_SIGNAL_NAMES[i];
+    }
+
+    Flight_Writer w;
+    w.len = 0;
+    w.fd = flight_open(FLIGHT_RECORDER_FILENAME);
+    bool written = (w.fd >= 0);
+
+    if(written == true) {
+
+        flight_put(&w, "ENGINE JULIET FLIGHT RECORDER");
+        flight_end_line(&w);
+        flight_put(&w, signal_name);
+        flight_put(&w, " in frame ");
+        flight_put_int(&w, flight_current ? flight_current->frame : 0, 0);
+        flight_put(&w, " during '");
+        flight_put(&w, FLIGHT_PHASE_NAMES[flight_phase]);
+        flight_put(&w, "', ");
+        flight_put_ms(&w, SDL_GetPerformanceCounter() - flight_phase_start, 0);
+        flight_put(&w, " ms into it");
+        flight_end_line(&w);
+        flight_end_line(&w);
+
+        //Frames, oldest first, phases in milliseconds
+        flight_put(&w, "   frame    ticks");
+        for(int p = 0; p < NUM_FLIGHT_PHASES; p++) {
+            const char* name = FLIGHT_PHASE_NAMES[p];
+            int len = 0;
+            while(name[len] != '\0')
+                len++;
+            for(int pad = len; pad < 9; pad++)
+                flight_put(&w, " ");
+            flight_put(&w, name);
+        }
+        for(int c = 0; c < flight_num_counts; c++) {
+            flight_put(&w, "  ");
+            flight_put(&w, flight_count_names[c]);
+        }
+        flight_end_line(&w);
+
+        Uint32 first = (flight_frames_total > (Uint32)FLIGHT_FRAMES) ?
+            flight_frames_total - FLIGHT_FRAMES : 0;
+        for(Uint32 i = first; i < flight_frames_total; i++) {
+            Flight_Frame* f = &flight_frames[i % FLIGHT_FRAMES];
+            flight_put_int(&w, f->frame, 8);
+            flight_put_int(&w, f->ticks, 9);
+            for(int p = 0; p < NUM_FLIGHT_PHASES; p++) {
+                flight_put(&w, "  ");
+                flight_put_ms(&w, f->phase[p], 7);
+            }
+            for(int c = 0; c < flight_num_counts; c++) {
+                flight_put(&w, "  ");
+                flight_put_int(&w, f->count[c], 0);
+            }
+            flight_end_line(&w);
+        }
+        flight_end_line(&w);
+
+        //Input events, oldest first
+        flight_put(&w, "recent input (frame, ticks, event)");
+        flight_end_line(&w);
+        Uint32 first_event = (input_ring_total > (Uint32)INPUT_RING_SIZE) ?
+            input_ring_total - INPUT_RING_SIZE : 0;
+        for(Uint32 i = first_event; i < input_ring_total; i++) {
+            Input_Event_Record* r = &input_ring[i % INPUT_RING_SIZE];
+            flight_put_int(&w, r->frame, 8);
+            flight_put_int(&w, r->timestamp, 9);
+            flight_put(&w, "  ");
+            switch(r->event.type) {
+                case SDL_KEYDOWN:
+                case SDL_KEYUP:
+                    flight_put(&w, r->event.type == SDL_KEYDOWN ?
+                            "key down " : "key up ");
+                    flight_put_int(&w, r->event.key.keysym.scancode, 0);
+                    break;
+                case SDL_MOUSEBUTTONDOWN:
+                case SDL_MOUSEBUTTONUP:
+                    flight_put(&w, r->event.type == SDL_MOUSEBUTTONDOWN ?
+                            "mouse down " : "mouse up ");
+                    flight_put_int(&w, r->event.button.button, 0);
+                    break;
+                case SDL_MOUSEMOTION:
+                    flight_put(&w, "mouse motion ");
+                    flight_put_int(&w, r->event.motion.x, 0);
+                    flight_put(&w, ",");
+                    flight_put_int(&w, r->event.motion.y, 0);
+                    break;
+                case SDL_CONTROLLERBUTTONDOWN:
+                case SDL_CONTROLLERBUTTONUP:
+                    flight_put(&w, r->event.type == SDL_CONTROLLERBUTTONDOWN ?
+                            "gamepad down " : "gamepad up ");
+                    flight_put_int(&w, r->event.cbutton.button, 0);
+                    break;
+                case SDL_TEXTINPUT:
+                    flight_put(&w, "text ");
+                    flight_put(&w, r->event.text.text);
+                    break;
+                default:
+                    flight_put(&w, "event 0x");
+                    for(int shift = 12; shift >= 0; shift -= 4) {
+                        char hex[2] = { "0123456789abcdef"[(r->event.type >> shift) & 15],
+                            '\0' };
+                        flight_put(&w, hex);
+                    }
+                    break;
+            }
+            flight_end_line(&w);
+        }
+        flight_end_line(&w);
+
+        //Log lines, oldest first
+        flight_put(&w, "recent log");
+        flight_end_line(&w);
+        int total = SDL_AtomicGet(&flight_log_total);
+        int first_line = (total > FLIGHT_LOG_LINES) ? total - FLIGHT_LOG_LINES : 0;
+        for(int i = first_line; i < total; i++) {
+            flight_put(&w, flight_log[i % FLIGHT_LOG_LINES]);
+            flight_end_line(&w);
+        }
+
+        flight_close(w.fd);
+    }
+
+    //Let whoever is watching know where to look
+    w.fd = 2;
+    flight_put(&w, " CRASH: ");
+    flight_put(&w, signal_name);
+    if(written == true) {
+        flight_put(&w, ", flight recorder written to ");
+        flight_put(&w, FLIGHT_RECORDER_FILENAME);
+    }
+    flight_end_line(&w);
+
+    raise(sig);
+}
@@ -0,0 +1,468 @@
+//345678901234567890123456789012345678901234567890123456789012345678901234567890
+//       1         2         3         4         5         6         7         8
+// Filename: ../engine_juliet_hotreload.cpp
+// Last Modified: Mon Oct 19, 2026  07:40PM
+//
+// Texture hot reload (development mode).
+//
+// With hot_reload_enabled set before initialize_engine(), every texture made
+// from a file (create_optimized_texture(), the background loader) is
+// remembered along with the file it came from, and a watcher thread keeps
+// an eye on the directories those files live in. Save a new
+// robot_animation_sheet.png and the watcher decodes it, on its own thread,
+// into the same pixels the engine would have made (color key resolved to
+// alpha). Once a frame, just before drawing, main_game_loop() calls
+// apply_hot_reloads(), which copies the new pixels into every texture made
+// from that file.
+//
+// If the image is the same size the texture is updated in place, so the
+// SDL_Texture* every sprite holds stays valid. If it changed size a new
+// texture has to be made; any SDL_Texture* variable registered with
+// watch_texture_slot() (create_sprite() registers the sprite's body and
+// animation sheet) is pointed at the new texture before the old one is
+// destroyed. Call destroy_sprite_texture() before freeing a sprite so its
+// slots are forgotten.
+//
+// On Linux the watcher uses inotify and wakes as soon as an editor closes
+// the file (or renames its temporary copy over it). Elsewhere it checks
+// each file's modification time every HOT_RELOAD_POLL_MS.
+//
+// The loose file always wins, so an image that's also in the asset pack
+// can be worked on without rebuilding the pack.
+
+#include "engine_juliet.h"
+#include <sys/stat.h>
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <poll.h>
+#include <unistd.h>
+#endif
+
+extern SDL_Renderer* window_renderer;
+
+struct Watched_Texture {
+    char         filename[256];
+    SDL_Texture* texture;
+    Uint32       format;          // the texture's, pixels are converted to it
+    int          w;
+    int          h;
+};
+
+// A file the watcher has decoded, waiting for the main thread
+struct Reloaded_Image {
+    char            filename[256];
+    SDL_Surface*    surface;      // ASSET_PACK_PIXEL_FORMAT, key resolved
+    Uint64          detected;     // performance counter
+    Reloaded_Image* next;
+};
+
+const int    MAX_WATCHED_TEXTURES = 512;
+const int    MAX_WATCHED_SLOTS = 512;
+const Uint32 HOT_RELOAD_POLL_MS = 250;
+
+bool            hot_reload_enabled = false;
+
+// Main thread writes, the watcher reads the filenames (hot_reload_lock)
+Watched_Texture watched_textures[MAX_WATCHED_TEXTURES];
+int             num_watched_textures = 0;
+SDL_Texture**   watched_slots[MAX_WATCHED_SLOTS];   // main thread only
+int             num_watched_slots = 0;
+SDL_mutex*      hot_reload_lock = NULL;
+
+SDL_Thread*     hot_reload_thread = NULL;
+SDL_atomic_t    hot_reload_quit;
+void*           reloaded_images = NULL;   // watcher pushes, main thread takes
+
+int  SDLCALL hot_reload_thread_function(void* data);
+void         reload_image(const char* filename, Uint64 detected);
+void         apply_reloaded_image(Reloaded_Image* image);
+int          copy_watched_filenames(char (*names)[256], int max);
+void         forget_all_textures(void);
+
+void start_hot_reload(void) {
+
+    if(hot_reload_enabled == false || hot_reload_thread != NULL)
+        return;
+
+    hot_reload_lock = SDL_CreateMutex();
+    SDL_AtomicSet(&hot_reload_quit, 0);
+    hot_reload_thread = SDL_CreateThread(hot_reload_thread_function,
+            "hot reload", NULL);
+
+    if(hot_reload_thread == NULL) {
+        LOG_WARN(LOG_ENGINE, " HOT RELOAD: could not start watcher (SDL Error: %s)",
+                SDL_GetError());
+    }
+}
+
+void stop_hot_reload(void) {
+
+    if(hot_reload_thread != NULL) {
+        SDL_AtomicSet(&hot_reload_quit, 1);
+        SDL_WaitThread(hot_reload_thread, NULL);
+        hot_reload_thread = NULL;
+    }
+
+    Reloaded_Image* image = (Reloaded_Image*)SDL_AtomicSetPtr(&reloaded_images, NULL);
+    while(image != NULL) {
+        Reloaded_Image* next = image->next;
+        SDL_FreeSurface(image->surface);
+        SDL_free(image);
+        image = next;
+    }
+
+    forget_all_textures();
+    if(hot_reload_lock != NULL) {
+        SDL_DestroyMutex(hot_reload_lock);
+        hot_reload_lock = NULL;
+    }
+}
+
+void watch_texture(const char* filename, SDL_Texture* texture) {
+
+    if(hot_reload_lock == NULL || texture == NULL || filename == NULL)
+        return;
+
+    if(num_watched_textures == MAX_WATCHED_TEXTURES) {
+        LOG_WARN(LOG_ENGINE, " HOT RELOAD: too many textures, %s won't reload",
+                filename);
+        return;
+    }
+
+    Watched_Texture w;
+    SDL_strlcpy(w.filename, filename, sizeof(w.filename));
+    w.texture = texture;
+    SDL_QueryTexture(texture, &w.format, NULL, &w.w, &w.h);
+
+    SDL_LockMutex(hot_reload_lock);
+    watched_textures[num_watched_textures++] = w;
+    SDL_UnlockMutex(hot_reload_lock);
+}
+
+void watch_texture_slot(SDL_Texture** slot) {
+
+    if(hot_reload_lock == NULL || slot == NULL)
+        return;
+
+    for(int i = 0; i < num_watched_slots; i++) {
+        if(watched_slots[i] == slot)
+            return;
+    }
+    if(num_watched_slots < MAX_WATCHED_SLOTS)
+        watched_slots[num_watched_slots++] = slot;
+}
+
+void forget_texture(SDL_Texture* texture) {
+
+    if(hot_reload_lock == NULL || texture == NULL)
+        return;
+
+    //Order doesn't matter, fill gaps from the end
+    SDL_LockMutex(hot_reload_lock);
+    for(int i = 0; i < num_watched_textures; i++) {
+        if(watched_textures[i].texture == texture)
+            watched_textures[i--] = watched_textures[--num_watched_textures];
+    }
+    SDL_UnlockMutex(hot_reload_lock);
+
+    for(int i = 0; i < num_watched_slots; i++) {
+        if(*watched_slots[i] == texture)
+            watched_slots[i--] = watched_slots[--num_watched_slots];
+    }
+}
+
+void forget_all_textures(void) {
+
+    if(hot_reload_lock == NULL)
+        return;
+
+    SDL_LockMutex(hot_reload_lock);
+    num_watched_textures = 0;
+    SDL_UnlockMutex(hot_reload_lock);
+    num_watched_slots = 0;
+}
+
+void apply_hot_reloads(void) {
+
+    if(SDL_AtomicGetPtr(&reloaded_images) == NULL)
+        return;
+
+    TRACE_ZONE("apply_hot_reloads");
+
+    //Oldest first, so if a file was saved twice the last save wins
+    Reloaded_Image* image = (Reloaded_Image*)SDL_AtomicSetPtr(&reloaded_images, NULL);
+    Reloaded_Image* oldest_first = NULL;
+    while(image != NULL) {
+        Reloaded_Image* next = image->next;
+        image->next = oldest_first;
+        oldest_first = image;
+        image = next;
+    }
+
+    while(oldest_first != NULL) {
+        Reloaded_Image* next = oldest_first->next;
+        apply_reloaded_image(oldest_first);
+        SDL_FreeSurface(oldest_first->surface);
+        SDL_free(oldest_first);
+        oldest_first = next;
+    }
+}
+
+void apply_reloaded_image(Reloaded_Image* image) {
+
+    int updated = 0;
+    int recreated = 0;
+    SDL_Surface* s = image->surface;
+
+    //Only the main thread changes the list, so no lock is needed to read it
+    for(int i = 0; i < num_watched_textures; i++) {
+
+        Watched_Texture* w = &watched_textures[i];
+        if(SDL_strcmp(w->filename, image->filename) != 0)
+            continue;
+
+        if(s->w == w->w && s->h == w->h) {
+
+            //Same size: new pixels, same texture
+            if(w->format == ASSET_PACK_PIXEL_FORMAT) {
+                SDL_UpdateTexture(w->texture, NULL, s->pixels, s->pitch);
+            } else {
+                SDL_Surface* c = SDL_ConvertSurfaceFormat(s, w->format, 0);
+                if(c != NULL) {
+                    SDL_UpdateTexture(w->texture, NULL, c->pixels, c->pitch);
+                    SDL_FreeSurface(c);
+                }
+            }
+            updated++;
+
+        } else {
+
+            //Different size: new texture, then repoint everything that
+            //held the old one
+            SDL_Texture* t = SDL_CreateTextureFromSurface(window_renderer, s);
+            if(t == NULL) {
+                LOG_ERROR(LOG_VIDEO, " HOT RELOAD: unable to create texture for %s"
+                        " (SDL Error: %s)", image->filename, SDL_GetError());
+                continue;
+            }
+            SDL_SetTextureBlendMode(t, SDL_BLENDMODE_BLEND);
+
+            SDL_Texture* old = w->texture;
+            for(int j = 0; j < num_watched_slots; j++) {
+                if(*watched_slots[j] == old)
+                    *watched_slots[j] = t;
+            }
+            SDL_DestroyTexture(old);
+
+            SDL_LockMutex(hot_reload_lock);
+            w->texture = t;
+            SDL_QueryTexture(t, &w->format, NULL, &w->w, &w->h);
+            SDL_UnlockMutex(hot_reload_lock);
+            recreated++;
+        }
+    }
+
+    double ms = (SDL_GetPerformanceCounter() - image->detected) * 1000.0 /
+        SDL_GetPerformanceFrequency();
+    LOG_INFO(LOG_VIDEO, " HOT RELOAD: %s (%d x %d), %d updated, %d recreated,"
+            " %.1f ms after save", image->filename, s->w, s->h, updated,
+            recreated, ms);
+}
+
+// WATCHER THREAD /////////////////////////////////////////////////////////////
+
+int copy_watched_filenames(char (*names)[256], int max) {
+
+    //Unique filenames, for the watcher to work from without the lock
+    int count = 0;
+    SDL_LockMutex(hot_reload_lock);
+    for(int i = 0; i < num_watched_textures && count < max; i++) {
+        bool seen = false;
+        for(int j = 0; j < count && seen == false; j++)
+            seen = (SDL_strcmp(names[j], watched_textures[i].filename) == 0);
+        if(seen == false)
+            SDL_strlcpy(names[count++], watched_textures[i].filename, 256);
+    }
+    SDL_UnlockMutex(hot_reload_lock);
+    return count;
+}
+
+void reload_image(const char* filename, Uint64 detected) {
+
+    TRACE_ZONE("reload_image");
+
+    //The same conversion tools/asset_packer.cpp does, so a reloaded image
+    //looks exactly like one loaded at startup
+    SDL_Surface* loaded = IMG_Load(filename);
+    if(loaded == NULL) {
+        LOG_WARN(LOG_VIDEO, " HOT RELOAD: unable to load %s (%s)", filename,
+                IMG_GetError());
+        return;
+    }
+
+    SDL_Surface* s = SDL_ConvertSurfaceFormat(loaded, ASSET_PACK_PIXEL_FORMAT, 0);
+    SDL_FreeSurface(loaded);
+    if(s == NULL)
+        return;
+
+    Uint32 key = SDL_MapRGBA(s->format, 10, 10, 10, 0xFF);
+    for(int y = 0; y < s->h; y++) {
+        Uint32* row = (Uint32*)((Uint8*)s->pixels + y * s->pitch);
+        for(int x = 0; x < s->w; x++) {
+            if(row[x] == key)
+                row[x] = 0;
+        }
+    }
+
+    Reloaded_Image* image = (Reloaded_Image*)SDL_malloc(sizeof(Reloaded_Image));
+    SDL_strlcpy(image->filename, filename, sizeof(image->filename));
+    image->surface = s;
+    image->detected = detected;
+
+    void* head;
+    do {
+        head = SDL_AtomicGetPtr(&reloaded_images);
+        image->next = (Reloaded_Image*)head;
+    } while(SDL_AtomicCASPtr(&reloaded_images, head, image) == SDL_FALSE);
+}
+
+#ifdef __linux__
+
+struct Watched_Directory {
+    char prefix[256];     // "../graphics/", or "" for the current directory
+    int  wd;
+};
+
+int SDLCALL hot_reload_thread_function(void* data) {
+
+    TRACE_THREAD("hot reload");
+
+    int fd = inotify_init1(IN_NONBLOCK);
+    if(fd < 0) {
+        LOG_WARN(LOG_ENGINE, " HOT RELOAD: inotify unavailable, nothing will reload");
+        return 0;
+    }
+
+    static char names[MAX_WATCHED_TEXTURES][256];
+    static Watched_Directory dirs[MAX_WATCHED_TEXTURES];
+    int num_dirs = 0;
+    int num_names = 0;
+
+    while(SDL_AtomicGet(&hot_reload_quit) == 0) {
+
+        //Watch the directory of anything registered since last time
+        num_names = copy_watched_filenames(names, MAX_WATCHED_TEXTURES);
+        for(int i = 0; i < num_names; i++) {
+
+            char prefix[256];
+            SDL_strlcpy(prefix, names[i], sizeof(prefix));
+            char* slash = SDL_strrchr(prefix, '/');
+            if(slash != NULL)
+                slash[1] = '\0';
+            else
+                prefix[0] = '\0';
+
+            int d = 0;
+            while(d < num_dirs && SDL_strcmp(dirs[d].prefix, prefix) != 0)
+                d++;
+            if(d < num_dirs || num_dirs == MAX_WATCHED_TEXTURES)
+                continue;
+
+            int wd = inotify_add_watch(fd, prefix[0] ? prefix : ".",
+                    IN_CLOSE_WRITE | IN_MOVED_TO);
+            if(wd < 0)
+                continue;
+            SDL_strlcpy(dirs[num_dirs].prefix, prefix, 256);
+            dirs[num_dirs].wd = wd;
+            num_dirs++;
+            LOG_INFO(LOG_ENGINE, " HOT RELOAD: watching %s",
+                    prefix[0] ? prefix : "./");
+        }
+
+        struct pollfd p = { fd, POLLIN, 0 };
+        if(poll(&p, 1, 100) <= 0)
+            continue;
+
+        Uint64 detected = SDL_GetPerformanceCounter();
+        char buffer[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+        ssize_t len;
+        while((len = read(fd, buffer, sizeof(buffer))) > 0) {
+
+            for(char* c = buffer; c < buffer + len; ) {
+
+                struct inotify_event* ev = (struct inotify_event*)c;
+                c += sizeof(struct inotify_event) + ev->len;
+                if(ev->len == 0)
+                    continue;
+
+                int d = 0;
+                while(d < num_dirs && dirs[d].wd != ev->wd)
+                    d++;
+                if(d == num_dirs)
+                    continue;
+
+                char path[256];
+                SDL_snprintf(path, sizeof(path), "%s%s", dirs[d].prefix,
+                        ev->name);
+                for(int i = 0; i < num_names; i++) {
+                    if(SDL_strcmp(path, names[i]) == 0) {
+                        reload_image(path, detected);
+                        break;
+                    }
+                }
+            }
+        }
+    }
+
+    close(fd);
+    return 0;
+}
+
+#else
+
+int SDLCALL hot_reload_thread_function(void* data) {
+
+    TRACE_THREAD("hot reload");
+
+    static char names[MAX_WATCHED_TEXTURES][256];
+    static char known[MAX_WATCHED_TEXTURES][256];
+    static time_t known_mtime[MAX_WATCHED_TEXTURES];
+    static off_t known_size[MAX_WATCHED_TEXTURES];
+    int num_known = 0;
+
+    while(SDL_AtomicGet(&hot_reload_quit) == 0) {
+
+        int num_names = copy_watched_filenames(names, MAX_WATCHED_TEXTURES);
+        for(int i = 0; i < num_names; i++) {
+
+            struct stat st;
+            if(stat(names[i], &st) != 0)
+                continue;
+
+            int k = 0;
+            while(k < num_known && SDL_strcmp(known[k], names[i]) != 0)
+                k++;
+
+            if(k == num_known) {
+                //First look at this file, nothing to reload yet
+                if(num_known < MAX_WATCHED_TEXTURES) {
+                    SDL_strlcpy(known[num_known], names[i], 256);
+                    known_mtime[num_known] = st.st_mtime;
+                    known_size[num_known] = st.st_size;
+                    num_known++;
+                }
+            } else if(st.st_mtime != known_mtime[k] ||
+                    st.st_size != known_size[k]) {
+                known_mtime[k] = st.st_mtime;
+                known_size[k] = st.st_size;
+                reload_image(names[i], SDL_GetPerformanceCounter());
+            }
+        }
+
+        SDL_Delay(HOT_RELOAD_POLL_MS);
+    }
+
+    return 0;
+}
+
+#endif
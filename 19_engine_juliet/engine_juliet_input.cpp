@@ -0,0 +1,183 @@
+//345678901234567890123456789012345678901234567890123456789012345678901234567890
+//       1         2         3         4         5         6         7         8
+// Filename: ../engine_juliet_input.cpp
+// Last Modified: Tue Oct 20, 2026  09:40AM
+//
+// Per-frame input state.
+//
+// main_game_loop() drains SDL's event queue in batches with SDL_PeepEvents()
+// and hands each event to record_input_event(). That does two things:
+//
+//   1. appends the event (with a timestamp and frame number) to a ring
+//      buffer, so the last INPUT_RING_SIZE events can be looked at later
+//   2. updates the Input_Snapshot for the current frame: which keys,
+//      mouse buttons and gamepad buttons are down, which went down this
+//      frame (pressed) and which came up this frame (released)
+//
+// Game code can then ask key_down(SDL_SCANCODE_LEFT) or
+// gamepad_pressed(SDL_CONTROLLER_BUTTON_B) at any point in the frame, each
+// a single bit test, instead of mirroring state into its own globals from
+// the action_pointer callbacks (which still work as before).
+//
+// Pressed/released are edges, and are kept even if both happen within one
+// frame, so a quick tap is never lost between two frames.
+
+#include "engine_juliet.h"
+
+// Event ring buffer (main thread only)
+Input_Event_Record input_ring[INPUT_RING_SIZE];
+Uint32             input_ring_total = 0;   // events ever recorded
+
+// State for the frame being played, and the frame number it belongs to
+Input_Snapshot     input;
+
+void set_bit(Uint32* bits, int i, bool on);
+bool get_bit(const Uint32* bits, int i);
+
+void begin_input_frame(Uint32 frame) {
+
+    //Edges only last one frame; down state carries over
+    SDL_memset(input.key_pressed, 0, sizeof(input.key_pressed));
+    SDL_memset(input.key_released, 0, sizeof(input.key_released));
+    input.mouse_pressed = 0;
+    input.mouse_released = 0;
+    input.gamepad_pressed = 0;
+    input.gamepad_released = 0;
+    input.mouse_dx = 0;
+    input.mouse_dy = 0;
+    input.event_count = 0;
+    input.frame = frame;
+}
+
+void record_input_event(const SDL_Event* e) {
+
+    Input_Event_Record* r = &input_ring[input_ring_total % INPUT_RING_SIZE];
+    r->timestamp = e->common.timestamp;
+    r->frame = input.frame;
+    r->event = *e;
+    input_ring_total++;
+    input.event_count++;
+
+    int i;
+    switch(e->type) {
+
+        case SDL_KEYDOWN:
+            i = e->key.keysym.scancode;
+            if(i < NUMBER_OF_KEYBOARD_INPUTS && e->key.repeat == 0) {
+                set_bit(input.key_down, i, true);
+                set_bit(input.key_pressed, i, true);
+            }
+            break;
+        case SDL_KEYUP:
+            i = e->key.keysym.scancode;
+            if(i < NUMBER_OF_KEYBOARD_INPUTS) {
+                set_bit(input.key_down, i, false);
+                set_bit(input.key_released, i, true);
+            }
+            break;
+
+        case SDL_MOUSEBUTTONDOWN:
+            if(e->button.button < NUMBER_OF_MOUSE_INPUTS) {
+                input.mouse_down |= (1u << e->button.button);
+                input.mouse_pressed |= (1u << e->button.button);
+            }
+            break;
+        case SDL_MOUSEBUTTONUP:
+            if(e->button.button < NUMBER_OF_MOUSE_INPUTS) {
+                input.mouse_down &= ~(1u << e->button.button);
+                input.mouse_released |= (1u << e->button.button);
+            }
+            break;
+        case SDL_MOUSEMOTION:
+            //Window coordinates; main_game_loop() converts the final
+            //position to game screen coordinates once per frame
+            input.mouse_dx += e->motion.xrel;
+            input.mouse_dy += e->motion.yrel;
+            break;
+
+        case SDL_CONTROLLERBUTTONDOWN:
+            if(e->cbutton.button < NUMBER_OF_GAMEPAD_INPUTS) {
+                input.gamepad_down |= (1u << e->cbutton.button);
+                input.gamepad_pressed |= (1u << e->cbutton.button);
+            }
+            break;
+        case SDL_CONTROLLERBUTTONUP:
+            if(e->cbutton.button < NUMBER_OF_GAMEPAD_INPUTS) {
+                input.gamepad_down &= ~(1u << e->cbutton.button);
+                input.gamepad_released |= (1u << e->cbutton.button);
+            }
+            break;
+        case SDL_CONTROLLERAXISMOTION:
+            if(e->caxis.axis < SDL_CONTROLLER_AXIS_MAX) {
+                input.gamepad_axis[e->caxis.axis] = e->caxis.value;
+            }
+            break;
+
+        default:
+            break;
+    }
+}
+
+const Input_Event_Record* get_recent_input_event(int n) {
+
+    //n = 0 is the most recent event, NULL once n goes past what the ring
+    //still holds
+    if(n < 0 || (Uint32)n >= input_ring_total || n >= INPUT_RING_SIZE)
+        return NULL;
+
+    return &input_ring[(input_ring_total - 1 - n) % INPUT_RING_SIZE];
+}
+
+bool key_down(SDL_Scancode sc) {
+    return (sc < NUMBER_OF_KEYBOARD_INPUTS) && get_bit(input.key_down, sc);
+}
+
+bool key_pressed(SDL_Scancode sc) {
+    return (sc < NUMBER_OF_KEYBOARD_INPUTS) && get_bit(input.key_pressed, sc);
+}
+
+bool key_released(SDL_Scancode sc) {
+    return (sc < NUMBER_OF_KEYBOARD_INPUTS) && get_bit(input.key_released, sc);
+}
+
+bool mouse_button_down(int button) {
+    return (button >= 0 && button < NUMBER_OF_MOUSE_INPUTS) &&
+        ((input.mouse_down >> button) & 1);
+}
+
+bool mouse_button_pressed(int button) {
+    return (button >= 0 && button < NUMBER_OF_MOUSE_INPUTS) &&
+        ((input.mouse_pressed >> button) & 1);
+}
+
+bool mouse_button_released(int button) {
+    return (button >= 0 && button < NUMBER_OF_MOUSE_INPUTS) &&
+        ((input.mouse_released >> button) & 1);
+}
+
+bool gamepad_down(int button) {
+    return (button >= 0 && button < NUMBER_OF_GAMEPAD_INPUTS) &&
+        ((input.gamepad_down >> button) & 1);
+}
+
+bool gamepad_pressed(int button) {
+    return (button >= 0 && button < NUMBER_OF_GAMEPAD_INPUTS) &&
+        ((input.gamepad_pressed >> button) & 1);
+}
+
+bool gamepad_released(int button) {
+    return (button >= 0 && button < NUMBER_OF_GAMEPAD_INPUTS) &&
+        ((input.gamepad_released >> button) & 1);
+}
+
+void set_bit(Uint32* bits, int i, bool on) {
+
+    if(on)
+        bits[i >> 5] |= (1u << (i & 31));
+    else
+        bits[i >> 5] &= ~(1u << (i & 31));
+}
+
+bool get_bit(const Uint32* bits, int i) {
+    return (bits[i >> 5] >> (i & 31)) & 1;
+}
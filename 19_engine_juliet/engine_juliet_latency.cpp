@@ -0,0 +1,198 @@
+//345678901234567890123456789012345678901234567890123456789012345678901234567890
+//       1         2         3         4         5         6         7         8
+// Filename: ../engine_juliet_latency.cpp
+// Last Modified: Mon Oct 19, 2026  09:20PM
+//
+// Input-to-present latency.
+//
+// Every key, mouse button and gamepad button press handled in a frame is
+// remembered with the timestamp SDL gave it when it was queued. Right
+// after that frame's SDL_RenderPresent() returns, the first frame that can
+// show its effect is on its way to the screen, so the difference is the
+// press's latency. It goes into a histogram for its device (1 ms buckets),
+// and report_input_latency() prints them all (shutdown does so too).
+// Replayed input is left out, its timestamps are from the recording.
+//
+// latency_mode, set before initialize_engine(), picks how frames line up
+// with the display:
+//
+//     LATENCY_VSYNC       the renderer waits for vertical blank in
+//                         SDL_RenderPresent(), after frame pacing (default,
+//                         as before)
+//     LATENCY_LATE_INPUT  vsync as well, but each frame sleeps first and
+//                         only polls input just long enough before the next
+//                         present to simulate and draw. How long that is
+//                         is learned from the last second of frames, plus
+//                         LATE_INPUT_SAFETY_MS.
+//     LATENCY_NO_VSYNC    no vsync at all, frames are paced by
+//                         wait_for_next_frame() alone (may tear)
+//
+// Run the game once in each mode and compare the histograms to pick one
+// for a particular machine and monitor.
+
+#include "engine_juliet.h"
+
+const int    LATENCY_BUCKETS = 100;     // 1 ms each, the last is 99+ ms
+const int    MAX_LATENCY_PENDING = 64;  // presses per frame
+const double LATE_INPUT_SAFETY_MS = 1.0;
+
+const char*  LATENCY_DEVICE_NAMES[NUM_LATENCY_DEVICES] = {
+    "keyboard", "mouse", "gamepad"
+};
+const char*  LATENCY_MODE_NAMES[] = { "vsync", "late input", "no vsync" };
+
+struct Latency_Histogram {
+    Uint32 bucket[LATENCY_BUCKETS];
+    Uint32 count;
+    Uint64 total_ms;
+    Uint32 max_ms;
+};
+
+LATENCY_MODES     latency_mode = LATENCY_VSYNC;
+Latency_Histogram latency_histograms[NUM_LATENCY_DEVICES];
+
+// Presses handled this frame, waiting for the present
+Uint32            pending_timestamp[MAX_LATENCY_PENDING];
+LATENCY_DEVICES   pending_device[MAX_LATENCY_PENDING];
+int               num_pending = 0;
+
+// Late input scheduling (performance counter)
+Uint64            last_present = 0;
+Uint64            work_start = 0;
+double            work_peak_ms = 0.0;   // decays, so a spike is forgotten
+
+Uint32 renderer_vsync_flag(void) {
+    return (latency_mode == LATENCY_NO_VSYNC) ? 0 : SDL_RENDERER_PRESENTVSYNC;
+}
+
+void track_input_latency(const SDL_Event* e) {
+
+    if(num_pending == MAX_LATENCY_PENDING || input_replay_active() == true)
+        return;
+
+    LATENCY_DEVICES device;
+    switch(e->type) {
+        case SDL_KEYDOWN:
+            if(e->key.repeat != 0)
+                return;
+            device = LATENCY_KEYBOARD;
+            break;
+        case SDL_MOUSEBUTTONDOWN:
+            device = LATENCY_MOUSE;
+            break;
+        case SDL_CONTROLLERBUTTONDOWN:
+            device = LATENCY_GAMEPAD;
+            break;
+        default:
+            return;
+    }
+
+    pending_timestamp[num_pending] = e->common.timestamp;
+    pending_device[num_pending] = device;
+    num_pending++;
+}
+
+void begin_present(void) {
+
+    //Everything from the late input wait to here was simulating and drawing
+    if(work_start != 0) {
+        double ms = (SDL_GetPerformanceCounter() - work_start) * 1000.0 /
+            SDL_GetPerformanceFrequency();
+        work_peak_ms *= 0.98;
+        if(ms > work_peak_ms)
+            work_peak_ms = ms;
+    }
+}
+
+void end_present(void) {
+
+    last_present = SDL_GetPerformanceCounter();
+    Uint32 now = SDL_GetTicks();
+
+    for(int i = 0; i < num_pending; i++) {
+        Uint32 ms = now - pending_timestamp[i];
+        Latency_Histogram* h = &latency_histograms[pending_device[i]];
+        h->bucket[SDL_min(ms, (Uint32)LATENCY_BUCKETS - 1)]++;
+        h->count++;
+        h->total_ms += ms;
+        if(ms > h->max_ms)
+            h->max_ms = ms;
+    }
+    num_pending = 0;
+}
+
+void wait_for_late_input(void) {
+
+    //Sleep until just enough time is left before the next present to
+    //simulate and draw, then let the frame go on and poll input
+    if(last_present == 0 || input_replay_uncapped() == true) {
+        work_start = SDL_GetPerformanceCounter();
+        return;
+    }
+
+    Uint64 frequency = SDL_GetPerformanceFrequency();
+    double lead_ms = SDL_min(work_peak_ms + LATE_INPUT_SAFETY_MS,
+            1000.0 / DESIRED_FPS);
+    Uint64 wake = last_present + (Uint64)((1000.0 / DESIRED_FPS - lead_ms) *
+            frequency / 1000.0);
+
+    //Sleep most of the way (SDL_Delay() can overshoot by a millisecond or
+    //two), then spin
+    Uint64 now = SDL_GetPerformanceCounter();
+    while(now < wake) {
+        double left_ms = (wake - now) * 1000.0 / frequency;
+        if(left_ms > 2.0)
+            SDL_Delay((Uint32)(left_ms - 2.0));
+        else
+            spin_cycle++;
+        now = SDL_GetPerformanceCounter();
+    }
+
+    work_start = now;
+}
+
+int latency_percentile(const Latency_Histogram* h, int percent) {
+
+    Uint32 wanted = (Uint32)(((Uint64)h->count * percent + 99) / 100);
+    Uint32 seen = 0;
+    for(int i = 0; i < LATENCY_BUCKETS; i++) {
+        seen += h->bucket[i];
+        if(seen >= wanted)
+            return i;
+    }
+    return LATENCY_BUCKETS - 1;
+}
+
+void report_input_latency(void) {
+
+    LOG_INFO(LOG_INPUT, " LATENCY: input to present, mode '%s'",
+            LATENCY_MODE_NAMES[latency_mode]);
+
+    for(int d = 0; d < NUM_LATENCY_DEVICES; d++) {
+
+        Latency_Histogram* h = &latency_histograms[d];
+        if(h->count == 0)
+            continue;
+
+        LOG_INFO(LOG_INPUT, " LATENCY: %-8s %u presses, mean %.1f ms, p50 %d ms,"
+                " p95 %d ms, p99 %d ms, max %u ms", LATENCY_DEVICE_NAMES[d],
+                h->count, (double)h->total_ms / h->count,
+                latency_percentile(h, 50), latency_percentile(h, 95),
+                latency_percentile(h, 99), h->max_ms);
+
+        Uint32 tallest = 0;
+        for(int i = 0; i < LATENCY_BUCKETS; i++)
+            tallest = SDL_max(tallest, h->bucket[i]);
+
+        for(int i = 0; i < LATENCY_BUCKETS; i++) {
+            if(h->bucket[i] == 0)
+                continue;
+            char bar[41];
+            int length = (int)((Uint64)h->bucket[i] * 40 / tallest);
+            SDL_memset(bar, '#', SDL_max(length, 1));
+            bar[SDL_max(length, 1)] = '\0';
+            LOG_INFO(LOG_INPUT, " LATENCY:   %2d%s ms %-40s %u", i,
+                    (i == LATENCY_BUCKETS - 1) ? "+" : " ", bar, h->bucket[i]);
+        }
+    }
+}
@@ -0,0 +1,340 @@
+//345678901234567890123456789012345678901234567890123456789012345678901234567890
+//       1         2         3         4         5         6         7         8
+// Filename: ../engine_juliet_loader.cpp
+// Last Modified: Tue Oct 20, 2026  09:50AM
+//
+// Background asset loading.
+//
+// queue_texture_load() and queue_sound_load() return straight away. Worker
+// threads read and decode the files (IMG_Load, Mix_LoadWAV) and push each
+// finished job onto a lock-free completion list. Once a frame,
+// main_game_loop() calls process_asset_loads(), which turns decoded
+// surfaces into textures (that has to happen on the thread that owns the
+// renderer) until asset_upload_budget_ms is used up; anything left over
+// waits for the next frame, so the game keeps drawing while it loads.
+//
+// A game can put up a loading screen in the textgrid on the first frame
+// and watch asset_load_progress(), or queue the next room's graphics while
+// the current one plays.
+//
+// Assets found in the asset pack (see engine_juliet_pack.cpp) don't need
+// decoding, so their jobs come straight back to the main thread. A packed
+// sound is only used if the mixer has the pack's format; otherwise the
+// worker loads the loose file, just as load_wav_sound_file() falls back.
+//
+// Jobs live in a fixed ring. The main thread is the only one that adds
+// jobs and the only one that retires them, so the ring never needs a lock;
+// workers claim the next job with an atomic counter, and hand it back by
+// pushing it onto the completion list with a compare-and-swap.
+
+#include "engine_juliet.h"
+
+extern SDL_Renderer* window_renderer;
+extern Mix_Chunk*    sound_effect_list[NUM_SOUND_EFFECTS];
+SDL_Texture* create_texture_from_pack(const struct Asset_Pack_Entry* e);
+Mix_Chunk*   create_chunk_from_pack(const struct Asset_Pack_Entry* e);
+bool         pack_sounds_usable(void);
+SDL_Texture* create_optimized_texture(const char* filename);
+void         load_wav_sound_file(const char *filename, int i);
+
+struct Asset_Load_Job {
+    char                    filename[256];
+    int                     type;          // ASSET_IMAGE or ASSET_SOUND
+    SDL_Texture**           texture;       // filled in when done
+    int                     sound_slot;    // index into sound_effect_list
+    const Asset_Pack_Entry* packed;        // NULL if loading a loose file
+    SDL_Surface*            surface;       // decoded by a worker
+    Mix_Chunk*              chunk;
+    Asset_Load_Job*         next;          // completion list link
+};
+
+const int      MAX_LOAD_JOBS = 256;        // in flight at once
+const int      MAX_LOADER_THREADS = 4;
+Uint32         asset_upload_budget_ms = 4; // per frame, main thread
+
+Asset_Load_Job load_jobs[MAX_LOAD_JOBS];
+SDL_Thread*    loader_threads[MAX_LOADER_THREADS];
+int            num_loader_threads = 0;
+SDL_sem*       load_jobs_waiting = NULL;
+SDL_atomic_t   load_job_claimed;           // next job a worker takes
+Uint32         load_jobs_queued = 0;       // main thread only
+Uint32         load_jobs_retired = 0;      // main thread only
+void*          load_jobs_done = NULL;      // completion list (workers push)
+Asset_Load_Job* load_jobs_ready = NULL;    // taken off it, not yet uploaded
+SDL_atomic_t   loader_quit;
+
+// Progress since the queue was last empty (for loading screens)
+Uint32         load_batch_start = 0;
+
+int  SDLCALL asset_loader_thread(void* data);
+Asset_Load_Job* add_load_job(const char* filename, int type);
+void finish_load_job(Asset_Load_Job* job);
+
+void start_asset_loader(void) {
+
+    if(num_loader_threads > 0)
+        return;
+
+    //Loading is mostly waiting on the disk and decompressing, leave a
+    //core for the game
+    int count = SDL_GetCPUCount() - 1;
+    if(count < 1)
+        count = 1;
+    if(count > MAX_LOADER_THREADS)
+        count = MAX_LOADER_THREADS;
+
+    load_jobs_waiting = SDL_CreateSemaphore(0);
+    SDL_AtomicSet(&load_job_claimed, 0);
+    SDL_AtomicSet(&loader_quit, 0);
+
+    for(int i = 0; i < count; i++) {
+        loader_threads[num_loader_threads] =
+            SDL_CreateThread(asset_loader_thread, "asset loader", NULL);
+        if(loader_threads[num_loader_threads] != NULL)
+            num_loader_threads++;
+    }
+
+    if(num_loader_threads == 0) {
+        LOG_WARN(LOG_ENGINE, " LOADER: no worker threads, loads will block");
+    }
+}
+
+void stop_asset_loader(void) {
+
+    if(num_loader_threads == 0)
+        return;
+
+    SDL_AtomicSet(&loader_quit, 1);
+    for(int i = 0; i < num_loader_threads; i++)
+        SDL_SemPost(load_jobs_waiting);
+    for(int i = 0; i < num_loader_threads; i++)
+        SDL_WaitThread(loader_threads[i], NULL);
+    num_loader_threads = 0;
+
+    SDL_DestroySemaphore(load_jobs_waiting);
+    load_jobs_waiting = NULL;
+
+    //Decoded but never collected
+    for(Uint32 i = load_jobs_retired; i != load_jobs_queued; i++) {
+        Asset_Load_Job* job = &load_jobs[i % MAX_LOAD_JOBS];
+        if(job->surface != NULL)
+            SDL_FreeSurface(job->surface);
+        if(job->chunk != NULL)
+            Mix_FreeChunk(job->chunk);
+    }
+    load_jobs_retired = load_jobs_queued;
+    load_jobs_done = NULL;
+    load_jobs_ready = NULL;
+}
+
+bool queue_texture_load(const char* filename, SDL_Texture** texture) {
+
+    Asset_Load_Job* job = add_load_job(filename, ASSET_IMAGE);
+    if(job == NULL) {
+        *texture = create_optimized_texture(filename); // the slow way
+        return false;
+    }
+
+    job->texture = texture;
+    SDL_SemPost(load_jobs_waiting);
+    return true;
+}
+
+bool queue_sound_load(const char* filename, int i) {
+
+    if(i < 0 || i >= NUM_SOUND_EFFECTS)
+        return false;
+
+    Asset_Load_Job* job = add_load_job(filename, ASSET_SOUND);
+    if(job == NULL) {
+        load_wav_sound_file(filename, i);
+        return false;
+    }
+
+    job->sound_slot = i;
+    SDL_SemPost(load_jobs_waiting);
+    return true;
+}
+
+Asset_Load_Job* add_load_job(const char* filename, int type) {
+
+    if(num_loader_threads == 0 ||
+            load_jobs_queued - load_jobs_retired == (Uint32)MAX_LOAD_JOBS) {
+        return NULL;
+    }
+
+    if(load_jobs_queued == load_jobs_retired)
+        load_batch_start = load_jobs_queued;
+
+    Asset_Load_Job* job = &load_jobs[load_jobs_queued % MAX_LOAD_JOBS];
+    SDL_memset(job, 0, sizeof(Asset_Load_Job));
+    SDL_strlcpy(job->filename, filename, sizeof(job->filename));
+    job->type = type;
+    job->sound_slot = -1;
+    job->packed = find_pack_entry(filename);
+    if(job->packed != NULL && job->packed->type != (Uint32)type)
+        job->packed = NULL;
+    if(job->packed != NULL && type == ASSET_SOUND &&
+            pack_sounds_usable() == false)
+        job->packed = NULL;
+
+    //Workers only see the job after the caller's SDL_SemPost(), which
+    //happens after it has been filled in
+    load_jobs_queued++;
+    return job;
+}
+
+int SDLCALL asset_loader_thread(void* data) {
+
+    TRACE_THREAD("asset loader");
+
+    while(true) {
+
+        SDL_SemWait(load_jobs_waiting);
+        if(SDL_AtomicGet(&loader_quit) == 1)
+            break;
+
+        int claimed = SDL_AtomicAdd(&load_job_claimed, 1);
+        Asset_Load_Job* job = &load_jobs[claimed % MAX_LOAD_JOBS];
+
+        if(job->packed == NULL) {
+            TRACE_ZONE("decode asset");
+            if(job->type == ASSET_IMAGE) {
+                job->surface = IMG_Load(job->filename);
+                if(job->surface != NULL) {
+                    SDL_SetColorKey(job->surface, SDL_TRUE,
+                            SDL_MapRGB(job->surface->format, 10, 10, 10));
+                } else {
+                    LOG_ERROR(LOG_VIDEO, " LOADER: unable to load %s (%s)",
+                            job->filename, IMG_GetError());
+                }
+            } else {
+                job->chunk = Mix_LoadWAV(job->filename);
+                if(job->chunk == NULL) {
+                    LOG_ERROR(LOG_AUDIO, " LOADER: unable to load %s (%s)",
+                            job->filename, Mix_GetError());
+                }
+            }
+        }
+
+        //Push onto the completion list
+        void* head;
+        do {
+            head = SDL_AtomicGetPtr(&load_jobs_done);
+            job->next = (Asset_Load_Job*)head;
+        } while(SDL_AtomicCASPtr(&load_jobs_done, head, job) == SDL_FALSE);
+    }
+
+    return 0;
+}
+
+void process_asset_loads(Uint32 budget_ms) {
+
+    if(load_jobs_queued == load_jobs_retired)
+        return;
+
+    TRACE_ZONE("process_asset_loads");
+
+    //Take everything the workers have finished in one go
+    Asset_Load_Job* done = (Asset_Load_Job*)SDL_AtomicSetPtr(&load_jobs_done, NULL);
+    while(done != NULL) {
+        Asset_Load_Job* next = done->next;
+        done->next = load_jobs_ready;
+        load_jobs_ready = done;
+        done = next;
+    }
+
+    //Always do at least one, so a tiny budget still makes progress
+    Uint64 start = SDL_GetPerformanceCounter();
+    Uint64 budget = SDL_GetPerformanceFrequency() * budget_ms / 1000;
+    while(load_jobs_ready != NULL) {
+
+        Asset_Load_Job* job = load_jobs_ready;
+        load_jobs_ready = job->next;
+        finish_load_job(job);
+
+        if(SDL_GetPerformanceCounter() - start >= budget)
+            break;
+    }
+}
+
+void finish_load_job(Asset_Load_Job* job) {
+
+    if(job->type == ASSET_IMAGE) {
+
+        SDL_Texture* t = NULL;
+        if(job->packed != NULL) {
+            t = create_texture_from_pack(job->packed);
+        } else if(job->surface != NULL) {
+            t = SDL_CreateTextureFromSurface(window_renderer, job->surface);
+            SDL_FreeSurface(job->surface);
+        }
+        job->surface = NULL;
+        if(job->texture != NULL)
+            *job->texture = t;
+
+        watch_texture(job->filename, t);
+        watch_texture_slot(job->texture);
+
+    } else {
+
+        if(job->packed != NULL) {
+            job->chunk = create_chunk_from_pack(job->packed);
+            if(job->chunk == NULL)
+                job->chunk = Mix_LoadWAV(job->filename);  // the slow way
+            if(job->chunk == NULL) {
+                LOG_ERROR(LOG_AUDIO, " LOADER: unable to load %s (%s)",
+                        job->filename, Mix_GetError());
+            }
+        }
+
+        if(sound_effect_list[job->sound_slot] != NULL)
+            Mix_FreeChunk(sound_effect_list[job->sound_slot]);
+        sound_effect_list[job->sound_slot] = job->chunk;
+        job->chunk = NULL;
+    }
+
+    //Jobs can finish in any order, but slots are only reused in order, so
+    //retire from the oldest end as far as everything's been finished
+    job->type = 0;
+    while(load_jobs_retired != load_jobs_queued &&
+            load_jobs[load_jobs_retired % MAX_LOAD_JOBS].type == 0) {
+        load_jobs_retired++;
+    }
+}
+
+int asset_loads_pending(void) {
+    return (int)(load_jobs_queued - load_jobs_retired);
+}
+
+float asset_load_progress(void) {
+
+    //1.0 when nothing is loading, otherwise how much of everything queued
+    //since the loader was last idle has been finished
+    Uint32 total = load_jobs_queued - load_batch_start;
+    if(total == 0 || load_jobs_queued == load_jobs_retired)
+        return 1.0f;
+
+    Uint32 finished = load_jobs_retired - load_batch_start;
+    for(Uint32 i = load_jobs_retired; i != load_jobs_queued; i++) {
+        if(load_jobs[i % MAX_LOAD_JOBS].type == 0)
+            finished++;
+    }
+    return (float)finished / total;
+}
+
+void print_loading_progress(int r, int c) {
+
+    //Ready-made loading screen line for the textgrid, e.g.
+    //"LOADING [#######.............]  35%"
+    char line[40];
+    int percent = (int)(asset_load_progress() * 100.0f);
+    int filled = percent / 5;
+
+    SDL_snprintf(line, sizeof(line), "LOADING [");
+    for(int i = 0; i < 20; i++)
+        line[9 + i] = (i < filled) ? '#' : '.';
+    SDL_snprintf(&line[29], sizeof(line) - 29, "] %3d%%", percent);
+
+    print_to_textgrid(line, r, c);
+}
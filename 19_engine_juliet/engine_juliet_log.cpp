@@ -0,0 +1,222 @@
+//345678901234567890123456789012345678901234567890123456789012345678901234567890
+//       1         2         3         4         5         6         7         8
+// Filename: ../engine_juliet_log.cpp
+// Last Modified: Mon Oct 19, 2026  04:40PM
+//
+// Buffered logging.
+//
+// printf() followed by fflush(stdout) waits for the terminal (or whatever
+// stdout is piped into) every time, which can cost a frame when the
+// terminal is slow. The LOG_INFO()/LOG_WARN()/... macros in engine_juliet.h
+// instead format the message into a buffer owned by the calling thread and
+// return. A background thread copies finished lines out of every buffer
+// to stdout and flushes once per pass.
+//
+// Each thread's buffer is a single-producer/single-consumer ring: the
+// owning thread only moves 'head', the log thread only moves 'tail', so
+// neither side takes a lock. Threads get a buffer the first time they log
+// and hand it back when they exit. If more threads log at once than there
+// are buffers, the extras share the last one behind a spinlock.
+//
+// Lines from one thread come out in order; lines from different threads
+// can be interleaved slightly differently than they happened. If a ring
+// is full the message is dropped and counted in log_messages_dropped.
+//
+// Before start_logging() and after stop_logging() messages are printed
+// straight away, so nothing is lost during startup or shutdown.
+
+#include "engine_juliet.h"
+#include <stdarg.h>
+
+const int    LOG_BUFFER_SIZE = 16384;     // per thread, power of 2
+const int    MAX_LOG_BUFFERS = 8;         // last one is shared
+const int    MAX_LOG_LINE = 512;
+const Uint32 LOG_FLUSH_INTERVAL_MS = 10;
+
+struct Log_Buffer {
+    char         data[LOG_BUFFER_SIZE];
+    SDL_atomic_t head;    // bytes written (owning thread)
+    SDL_atomic_t tail;    // bytes copied out (log thread)
+    SDL_atomic_t in_use;
+    SDL_SpinLock lock;    // shared buffer only
+};
+
+Log_Buffer   log_buffers[MAX_LOG_BUFFERS];
+SDL_TLSID    log_tls = 0;
+SDL_Thread*  log_thread = NULL;
+SDL_sem*     log_wakeup = NULL;
+SDL_atomic_t log_running;
+
+// Runtime filters, on top of the compile-time LOG_MIN_LEVEL
+LOG_LEVELS   log_level = LOG_LEVEL_INFO;
+bool         log_category_enabled[NUM_LOG_CATEGORIES] = {
+                 true, true, true, true, true };
+SDL_atomic_t log_messages_dropped;
+
+int  SDLCALL log_thread_function(void* data);
+void SDLCALL release_log_buffer(void* data);
+Log_Buffer*  get_log_buffer(void);
+void         drain_log_buffers(void);
+void         record_flight_log(const char* line, int len);
+
+void start_logging(void) {
+
+    if(log_thread != NULL)
+        return;
+
+    SDL_memset(log_buffers, 0, sizeof(log_buffers));
+    SDL_AtomicSet(&log_messages_dropped, 0);
+    log_tls = SDL_TLSCreate();
+    log_wakeup = SDL_CreateSemaphore(0);
+    SDL_AtomicSet(&log_running, 1);
+
+    log_thread = SDL_CreateThread(log_thread_function, "log", NULL);
+    if(log_thread == NULL) {
+        SDL_AtomicSet(&log_running, 0);
+        printf(" LOG: could not start log thread, logging directly "
+                "(SDL Error: %s)\n", SDL_GetError());
+        fflush(stdout);
+    }
+}
+
+void stop_logging(void) {
+
+    if(log_thread == NULL)
+        return;
+
+    SDL_AtomicSet(&log_running, 0);
+    SDL_SemPost(log_wakeup);
+    SDL_WaitThread(log_thread, NULL);
+    log_thread = NULL;
+    SDL_DestroySemaphore(log_wakeup);
+    log_wakeup = NULL;
+
+    if(SDL_AtomicGet(&log_messages_dropped) > 0) {
+        printf(" LOG: %d messages dropped (buffers full)\n",
+                SDL_AtomicGet(&log_messages_dropped));
+        fflush(stdout);
+    }
+}
+
+void log_message(LOG_LEVELS level, LOG_CATEGORIES category,
+        const char* format, ...) {
+
+    if(level < log_level || log_category_enabled[category] == false)
+        return;
+
+    char line[MAX_LOG_LINE];
+    va_list args;
+    va_start(args, format);
+    int len = SDL_vsnprintf(line, MAX_LOG_LINE - 1, format, args);
+    va_end(args);
+
+    if(len < 0)
+        return;
+    if(len > MAX_LOG_LINE - 2)
+        len = MAX_LOG_LINE - 2;
+    if(len == 0 || line[len - 1] != '\n')
+        line[len++] = '\n';
+
+    //Kept for the crash flight recorder too, even if it never gets printed
+    record_flight_log(line, len - 1);
+
+    if(SDL_AtomicGet(&log_running) == 0) {
+        fwrite(line, 1, len, stdout);
+        fflush(stdout);
+        return;
+    }
+
+    Log_Buffer* b = get_log_buffer();
+    bool shared = (b == &log_buffers[MAX_LOG_BUFFERS - 1]);
+    if(shared)
+        SDL_AtomicLock(&b->lock);
+
+    int head = SDL_AtomicGet(&b->head);
+    int tail = SDL_AtomicGet(&b->tail);
+
+    if(LOG_BUFFER_SIZE - (head - tail) < len) {
+        SDL_AtomicIncRef(&log_messages_dropped);
+    } else {
+        int start = head & (LOG_BUFFER_SIZE - 1);
+        int first = SDL_min(len, LOG_BUFFER_SIZE - start);
+        SDL_memcpy(&b->data[start], line, first);
+        SDL_memcpy(&b->data[0], line + first, len - first);
+        SDL_AtomicSet(&b->head, head + len); // publish the whole line
+    }
+
+    if(shared)
+        SDL_AtomicUnlock(&b->lock);
+
+    //Errors go out as soon as possible, as does a buffer that's filling
+    //up. Everything else waits for the next pass of the log thread.
+    if(level >= LOG_LEVEL_ERROR || (head + len - tail) > LOG_BUFFER_SIZE / 2)
+        SDL_SemPost(log_wakeup);
+}
+
+Log_Buffer* get_log_buffer(void) {
+
+    Log_Buffer* b = (Log_Buffer*)SDL_TLSGet(log_tls);
+    if(b != NULL)
+        return b;
+
+    b = &log_buffers[MAX_LOG_BUFFERS - 1];
+    for(int i = 0; i < MAX_LOG_BUFFERS - 1; i++) {
+        if(SDL_AtomicCAS(&log_buffers[i].in_use, 0, 1)) {
+            b = &log_buffers[i];
+            break;
+        }
+    }
+
+    SDL_TLSSet(log_tls, b, release_log_buffer);
+    return b;
+}
+
+void SDLCALL release_log_buffer(void* data) {
+
+    //Called by SDL when a thread that logged exits. Anything still in
+    //the ring is written out by the next owner's drain as usual.
+    Log_Buffer* b = (Log_Buffer*)data;
+    if(b != &log_buffers[MAX_LOG_BUFFERS - 1])
+        SDL_AtomicSet(&b->in_use, 0);
+}
+
+int SDLCALL log_thread_function(void* data) {
+
+    SDL_SetThreadPriority(SDL_THREAD_PRIORITY_LOW);
+    TRACE_THREAD("log");
+
+    while(SDL_AtomicGet(&log_running) == 1) {
+        SDL_SemWaitTimeout(log_wakeup, LOG_FLUSH_INTERVAL_MS);
+        TRACE_ZONE("drain_log_buffers");
+        drain_log_buffers();
+    }
+
+    drain_log_buffers(); // whatever was logged before stop_logging()
+    return 0;
+}
+
+void drain_log_buffers(void) {
+
+    bool wrote = false;
+
+    for(int i = 0; i < MAX_LOG_BUFFERS; i++) {
+
+        Log_Buffer* b = &log_buffers[i];
+        int tail = SDL_AtomicGet(&b->tail);
+        int head = SDL_AtomicGet(&b->head);
+        if(head == tail)
+            continue;
+
+        int start = tail & (LOG_BUFFER_SIZE - 1);
+        int len = head - tail;
+        int first = SDL_min(len, LOG_BUFFER_SIZE - start);
+        fwrite(&b->data[start], 1, first, stdout);
+        fwrite(&b->data[0], 1, len - first, stdout);
+
+        SDL_AtomicSet(&b->tail, head);
+        wrote = true;
+    }
+
+    if(wrote)
+        fflush(stdout);
+}
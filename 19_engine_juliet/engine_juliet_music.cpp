@@ -0,0 +1,377 @@
+//345678901234567890123456789012345678901234567890123456789012345678901234567890
+//       1         2         3         4         5         6         7         8
+// Filename: ../engine_juliet_music.cpp
+// Last Modified: Mon Oct 19, 2026  09:12AM
+//
+// Streaming music player.
+//
+// Music tracks are never loaded whole. A low priority prefetch thread reads
+// the file from disk in small chunks, converts the samples to whatever
+// format SDL_mixer opened the device with, and writes them into a fixed size
+// ring buffer. The mixer (via Mix_HookMusic) only ever copies out of that
+// ring buffer, so a slow disk can never stall the audio callback: the worst
+// that can happen is a short stretch of silence, which is counted in
+// music_stream_underruns.
+//
+// Memory use is MUSIC_RING_SIZE plus two chunk buffers, no matter how long
+// the track is.
+//
+// Supported files: uncompressed .wav (8-bit, 16-bit, 32-bit int or float,
+// any channel count and frequency). Anything else (ogg, mp3, mod) still has
+// to go through add_music_file(), which uses Mix_LoadMUS.
+//
+// Threads involved:
+//
+//     main thread      play_streaming_music(), stop_streaming_music()
+//     prefetch thread  music_prefetch_thread() (the only ring buffer writer)
+//     mixer thread     music_stream_mixer() (the only ring buffer reader)
+
+#include "engine_juliet.h"
+
+// Ring buffer (single producer, single consumer). The read and write
+// positions only ever count up; the index into music_ring is the position
+// modulo MUSIC_RING_SIZE, which must be a power of 2.
+const int           MUSIC_RING_SIZE = 1 << 18;   // 256 KB, ~1.5 s of CD audio
+const int           MUSIC_CHUNK_SIZE = 1 << 14;  // bytes read from disk at once
+Uint8               music_ring[MUSIC_RING_SIZE];
+SDL_atomic_t        music_ring_read;
+SDL_atomic_t        music_ring_write;
+
+// Prefetch thread control
+SDL_Thread*         music_thread = NULL;
+SDL_sem*            music_thread_wakeup = NULL;
+SDL_atomic_t        music_thread_quit;
+SDL_atomic_t        music_thread_done;    // track finished (and not looping)
+
+// Track being streamed (owned by the prefetch thread while it runs)
+SDL_RWops*          music_file = NULL;
+SDL_AudioStream*    music_converter = NULL;
+Sint64              music_data_start = 0;  // file offset of first sample
+Uint32              music_data_length = 0; // bytes of sample data
+int                 music_source_frame = 0; // bytes per sample frame (file)
+bool                music_loop = false;
+
+// Public controls/stats (see engine_juliet.h)
+int                 music_stream_volume = MIX_MAX_VOLUME;
+Uint32              music_stream_underruns = 0;
+
+// Format the mixer is running at (from Mix_QuerySpec)
+int                 mixer_frequency = 0;
+Uint16              mixer_format = 0;
+int                 mixer_channels = 0;
+int                 mixer_frame = 0;       // bytes per sample frame (mixer)
+
+bool open_wav_for_streaming(const char* filename);
+int  music_prefetch_thread(void* data);
+void SDLCALL music_stream_mixer(void* udata, Uint8* stream, int len);
+
+bool play_streaming_music(const char* filename, bool loop) {
+
+    //Only one streamed track at a time
+    stop_streaming_music();
+
+    if(Mix_QuerySpec(&mixer_frequency, &mixer_format, &mixer_channels) == 0) {
+        LOG_ERROR(LOG_AUDIO, " MUSIC: mixer not open, can't stream %s (%s)",
+                filename, Mix_GetError());
+        return false;
+    }
+    mixer_frame = (SDL_AUDIO_BITSIZE(mixer_format) / 8) * mixer_channels;
+
+    if(open_wav_for_streaming(filename) == false) {
+        return false;
+    }
+
+    music_loop = loop;
+    SDL_AtomicSet(&music_ring_read, 0);
+    SDL_AtomicSet(&music_ring_write, 0);
+    SDL_AtomicSet(&music_thread_quit, 0);
+    SDL_AtomicSet(&music_thread_done, 0);
+    music_stream_underruns = 0;
+
+    music_thread_wakeup = SDL_CreateSemaphore(0);
+    music_thread = SDL_CreateThread(music_prefetch_thread,
+            "music_prefetch", NULL);
+
+    if(music_thread == NULL) {
+        LOG_ERROR(LOG_AUDIO, " MUSIC: could not start prefetch thread (SDL Error: %s)",
+                SDL_GetError());
+        SDL_DestroySemaphore(music_thread_wakeup);
+        music_thread_wakeup = NULL;
+        SDL_FreeAudioStream(music_converter);
+        music_converter = NULL;
+        SDL_RWclose(music_file);
+        music_file = NULL;
+        return false;
+    }
+
+    //Hand the mixer our callback last, once there's a thread feeding it
+    Mix_HookMusic(music_stream_mixer, NULL);
+
+    return true;
+}
+
+void stop_streaming_music(void) {
+
+    if(music_thread == NULL)
+        return;
+
+    //Unhook first so the mixer stops reading the ring buffer.
+    //Mix_HookMusic() locks the audio device, so once it returns the
+    //callback is guaranteed not to be running.
+    Mix_HookMusic(NULL, NULL);
+
+    SDL_AtomicSet(&music_thread_quit, 1);
+    SDL_SemPost(music_thread_wakeup);
+    SDL_WaitThread(music_thread, NULL);
+    music_thread = NULL;
+
+    SDL_DestroySemaphore(music_thread_wakeup);
+    music_thread_wakeup = NULL;
+
+    SDL_FreeAudioStream(music_converter);
+    music_converter = NULL;
+    SDL_RWclose(music_file);
+    music_file = NULL;
+}
+
+void rehook_streaming_music(void) {
+
+    //The mixer forgets its music hook when it's closed and reopened
+    //(retune_audio_buffer), so put ours back if a track is still going.
+    //Same open parameters, so the ring buffer's format is still right.
+    if(music_thread != NULL)
+        Mix_HookMusic(music_stream_mixer, NULL);
+}
+
+bool streaming_music_playing(void) {
+
+    if(music_thread == NULL)
+        return false;
+
+    //Still playing while the thread has more to read or the ring buffer
+    //still has samples the mixer hasn't consumed yet.
+    return SDL_AtomicGet(&music_thread_done) == 0 ||
+        SDL_AtomicGet(&music_ring_write) != SDL_AtomicGet(&music_ring_read);
+}
+
+bool open_wav_for_streaming(const char* filename) {
+
+    //Walks the RIFF chunks of a .wav file, remembers where the sample data
+    //lives, and builds an SDL_AudioStream to convert it to the mixer format.
+    //Nothing but the header is read here.
+
+    music_file = SDL_RWFromFile(filename, "rb");
+    if(music_file == NULL) {
+        LOG_ERROR(LOG_AUDIO, " MUSIC: unable to open %s (SDL Error: %s)",
+                filename, SDL_GetError());
+        return false;
+    }
+
+    Uint32 riff = SDL_ReadLE32(music_file);
+    SDL_ReadLE32(music_file); // riff size, not needed
+    Uint32 wave = SDL_ReadLE32(music_file);
+
+    if(riff != 0x46464952 || wave != 0x45564157) { // "RIFF", "WAVE"
+        LOG_ERROR(LOG_AUDIO, " MUSIC: %s is not a .wav file, use add_music_file()",
+                filename);
+        SDL_RWclose(music_file);
+        music_file = NULL;
+        return false;
+    }
+
+    Uint16 wav_encoding = 0;
+    Uint16 wav_channels = 0;
+    Uint32 wav_frequency = 0;
+    Uint16 wav_bits = 0;
+    music_data_length = 0;
+
+    while(music_data_length == 0) {
+
+        Uint32 chunk_id = SDL_ReadLE32(music_file);
+        Uint32 chunk_size = SDL_ReadLE32(music_file);
+        Sint64 chunk_start = SDL_RWtell(music_file);
+
+        if(chunk_size == 0 && chunk_id == 0)
+            break; // end of file, no data chunk found
+
+        if(chunk_id == 0x20746D66) {          // "fmt "
+            wav_encoding = SDL_ReadLE16(music_file);
+            wav_channels = SDL_ReadLE16(music_file);
+            wav_frequency = SDL_ReadLE32(music_file);
+            SDL_ReadLE32(music_file); // byte rate
+            SDL_ReadLE16(music_file); // block align
+            wav_bits = SDL_ReadLE16(music_file);
+        } else if(chunk_id == 0x61746164) {   // "data"
+            music_data_start = chunk_start;
+            music_data_length = chunk_size;
+            break;
+        }
+
+        //Chunks are padded to an even number of bytes
+        SDL_RWseek(music_file, chunk_start + chunk_size + (chunk_size & 1),
+                RW_SEEK_SET);
+    }
+
+    SDL_AudioFormat source_format = 0;
+    if(wav_encoding == 1 && wav_bits == 8)
+        source_format = AUDIO_U8;
+    else if(wav_encoding == 1 && wav_bits == 16)
+        source_format = AUDIO_S16LSB;
+    else if(wav_encoding == 1 && wav_bits == 32)
+        source_format = AUDIO_S32LSB;
+    else if(wav_encoding == 3 && wav_bits == 32)
+        source_format = AUDIO_F32LSB;
+
+    if(music_data_length == 0 || source_format == 0 || wav_channels == 0) {
+        LOG_ERROR(LOG_AUDIO, " MUSIC: %s has no streamable PCM data (encoding %d, %d bit)",
+                filename, wav_encoding, wav_bits);
+        SDL_RWclose(music_file);
+        music_file = NULL;
+        return false;
+    }
+
+    music_source_frame = (wav_bits / 8) * wav_channels;
+    music_converter = SDL_NewAudioStream(
+            source_format, (Uint8)wav_channels, wav_frequency,
+            mixer_format, (Uint8)mixer_channels, mixer_frequency);
+
+    if(music_converter == NULL) {
+        LOG_ERROR(LOG_AUDIO, " MUSIC: no converter for %s (SDL Error: %s)",
+                filename, SDL_GetError());
+        SDL_RWclose(music_file);
+        music_file = NULL;
+        return false;
+    }
+
+    SDL_RWseek(music_file, music_data_start, RW_SEEK_SET);
+
+    LOG_INFO(LOG_AUDIO, " MUSIC: streaming %s (%d Hz, %d channels, %d bit)",
+            filename, wav_frequency, wav_channels, wav_bits);
+
+    return true;
+}
+
+int music_prefetch_thread(void* data) {
+
+    //Producer side of the ring buffer. Reads a chunk from disk, runs it
+    //through the converter, and copies the converted samples into the ring
+    //as space becomes available. Sleeps on music_thread_wakeup whenever the
+    //ring is full; the mixer posts it every time it drains a block.
+
+    SDL_SetThreadPriority(SDL_THREAD_PRIORITY_LOW);
+    TRACE_THREAD("music prefetch");
+
+    static Uint8 file_chunk[MUSIC_CHUNK_SIZE];
+    static Uint8 converted_chunk[MUSIC_CHUNK_SIZE];
+
+    Uint32 data_remaining = music_data_length;
+    bool   end_of_track = false;
+
+    while(SDL_AtomicGet(&music_thread_quit) == 0) {
+
+        //Top up the converter from disk if it has run dry
+        if(SDL_AudioStreamAvailable(music_converter) == 0 && !end_of_track) {
+
+            TRACE_ZONE("music read");
+
+            if(data_remaining == 0) {
+                if(music_loop) {
+                    SDL_RWseek(music_file, music_data_start, RW_SEEK_SET);
+                    data_remaining = music_data_length;
+                } else {
+                    SDL_AudioStreamFlush(music_converter);
+                    end_of_track = true;
+                }
+            }
+
+            if(data_remaining > 0) {
+                //The converter only accepts whole sample frames
+                size_t want = MUSIC_CHUNK_SIZE;
+                if(want > data_remaining)
+                    want = data_remaining;
+                want -= want % music_source_frame;
+                size_t got = SDL_RWread(music_file, file_chunk, 1, want);
+                got -= got % music_source_frame;
+                if(got == 0) {
+                    data_remaining = 0; // truncated file, treat as the end
+                } else {
+                    data_remaining -= got;
+                    SDL_AudioStreamPut(music_converter, file_chunk, got);
+                }
+                continue;
+            }
+        }
+
+        if(end_of_track && SDL_AudioStreamAvailable(music_converter) == 0) {
+            SDL_AtomicSet(&music_thread_done, 1);
+            break;
+        }
+
+        //How much room is in the ring buffer right now?
+        Uint32 write_pos = (Uint32)SDL_AtomicGet(&music_ring_write);
+        Uint32 read_pos = (Uint32)SDL_AtomicGet(&music_ring_read);
+        int    space = MUSIC_RING_SIZE - (int)(write_pos - read_pos);
+
+        if(space < MUSIC_CHUNK_SIZE / 4) {
+            SDL_SemWaitTimeout(music_thread_wakeup, 100);
+            continue;
+        }
+
+        if(space > MUSIC_CHUNK_SIZE)
+            space = MUSIC_CHUNK_SIZE;
+        space -= space % mixer_frame;
+
+        int n = SDL_AudioStreamGet(music_converter, converted_chunk, space);
+        if(n <= 0)
+            continue;
+
+        //Copy in (wrapping around the end of the ring if needed), then
+        //publish the new write position
+        int index = write_pos & (MUSIC_RING_SIZE - 1);
+        int first = MUSIC_RING_SIZE - index;
+        if(first > n)
+            first = n;
+        SDL_memcpy(&music_ring[index], converted_chunk, first);
+        SDL_memcpy(&music_ring[0], converted_chunk + first, n - first);
+
+        SDL_MemoryBarrierRelease();
+        SDL_AtomicSet(&music_ring_write, (int)(write_pos + n));
+    }
+
+    return 0;
+}
+
+void SDLCALL music_stream_mixer(void* udata, Uint8* stream, int len) {
+
+    //Consumer side of the ring buffer, runs on the mixer thread. Never
+    //blocks: whatever isn't in the ring buffer yet is left as silence.
+    TRACE_THREAD("audio (mixer)");
+    TRACE_ZONE("music_stream_mixer");
+
+    Uint32 read_pos = (Uint32)SDL_AtomicGet(&music_ring_read);
+    Uint32 write_pos = (Uint32)SDL_AtomicGet(&music_ring_write);
+    SDL_MemoryBarrierAcquire();
+
+    int available = (int)(write_pos - read_pos);
+    int n = len;
+    if(n > available) {
+        n = available;
+        if(SDL_AtomicGet(&music_thread_done) == 0)
+            music_stream_underruns++;
+    }
+
+    int index = read_pos & (MUSIC_RING_SIZE - 1);
+    int first = MUSIC_RING_SIZE - index;
+    if(first > n)
+        first = n;
+
+    //The mixer hands us a silenced buffer, so mixing in is the same as
+    //copying at full volume (and lets music_stream_volume work)
+    SDL_MixAudioFormat(stream, &music_ring[index], mixer_format,
+            first, music_stream_volume);
+    SDL_MixAudioFormat(stream + first, &music_ring[0], mixer_format,
+            n - first, music_stream_volume);
+
+    SDL_AtomicSet(&music_ring_read, (int)(read_pos + n));
+    SDL_SemPost(music_thread_wakeup);
+}
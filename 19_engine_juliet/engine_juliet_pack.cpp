@@ -0,0 +1,246 @@
+//345678901234567890123456789012345678901234567890123456789012345678901234567890
+//       1         2         3         4         5         6         7         8
+// Filename: ../engine_juliet_pack.cpp
+// Last Modified: Tue Oct 20, 2026  09:50AM
+//
+// Asset packs.
+//
+// tools/asset_packer.cpp bakes images and sounds into one file, already in
+// the form the engine needs: pixels in ASSET_PACK_PIXEL_FORMAT with the
+// color key resolved to alpha, samples in the mixer's format. At runtime
+// the pack is memory mapped (nothing is read up front) and
+// create_optimized_texture() / load_wav_sound_file() look each filename
+// up in the pack's directory before touching the disk. A hit means a
+// texture is created and filled straight from the mapped pixels, with no
+// PNG decode and no format conversion, and a sound effect plays straight
+// out of the mapping. A miss falls back to the loose file as before.
+//
+// initialize_engine() opens ASSET_PACK_FILENAME if it exists, so the font
+// sheet benefits too. Sound chunks point into the mapping, so the pack is
+// closed after they've been freed in shutdown_engine().
+
+#include "engine_juliet.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+extern SDL_Renderer* window_renderer;
+
+// Mapped pack (main thread only)
+const Uint8*                   pack_data = NULL;
+size_t                         pack_size = 0;
+const Asset_Pack_Header*       pack_header = NULL;
+const Asset_Pack_Entry*        pack_entries = NULL;
+int                            pack_sound_usable = -1;
+#ifdef _WIN32
+HANDLE                         pack_file_handle = INVALID_HANDLE_VALUE;
+HANDLE                         pack_mapping = NULL;
+#endif
+
+const Uint8* map_pack_file(const char* filename, size_t* size);
+void         unmap_pack_file(void);
+
+bool open_asset_pack(const char* filename) {
+
+    close_asset_pack();
+
+    size_t size = 0;
+    const Uint8* data = map_pack_file(filename, &size);
+    if(data == NULL)
+        return false;
+
+    pack_data = data;
+    pack_size = size;
+
+    //Check the header and that the directory and every entry actually lie
+    //inside the file, so lookups never have to
+    const Asset_Pack_Header* h = (const Asset_Pack_Header*)data;
+    bool valid = (size >= sizeof(Asset_Pack_Header)) &&
+        SDL_memcmp(h->id, "JPAK", 4) == 0 &&
+        h->version == ASSET_PACK_VERSION &&
+        h->num_entries <= (size - sizeof(Asset_Pack_Header)) /
+            sizeof(Asset_Pack_Entry);
+
+    const Asset_Pack_Entry* e = (const Asset_Pack_Entry*)(h + 1);
+    for(Uint32 i = 0; valid && i < h->num_entries; i++) {
+        if(e[i].offset > size || e[i].size > size - e[i].offset ||
+                e[i].name[ASSET_NAME_LENGTH - 1] != '\0' ||
+                (e[i].type == ASSET_IMAGE &&
+                 (Uint64)e[i].pitch * e[i].height > e[i].size)) {
+            valid = false;
+        }
+    }
+
+    if(valid == false) {
+        LOG_ERROR(LOG_ENGINE, " PACK: %s is not a valid version %d asset pack",
+                filename, ASSET_PACK_VERSION);
+        close_asset_pack();
+        return false;
+    }
+
+    pack_header = h;
+    pack_entries = e;
+    pack_sound_usable = -1; // checked on first use, the mixer may not be open
+
+    LOG_INFO(LOG_ENGINE, " PACK: mapped %s (%u assets, %u KB)", filename,
+            h->num_entries, (Uint32)(size / 1024));
+    return true;
+}
+
+void close_asset_pack(void) {
+
+    if(pack_data != NULL)
+        unmap_pack_file();
+
+    pack_data = NULL;
+    pack_size = 0;
+    pack_header = NULL;
+    pack_entries = NULL;
+}
+
+const Asset_Pack_Entry* find_pack_entry(const char* name) {
+
+    if(pack_header == NULL || name == NULL)
+        return NULL;
+
+    //The packer sorts the directory by name
+    int low = 0;
+    int high = (int)pack_header->num_entries - 1;
+    while(low <= high) {
+        int mid = (low + high) / 2;
+        int cmp = SDL_strcmp(name, pack_entries[mid].name);
+        if(cmp == 0)
+            return &pack_entries[mid];
+        if(cmp < 0)
+            high = mid - 1;
+        else
+            low = mid + 1;
+    }
+
+    return NULL;
+}
+
+SDL_Texture* create_texture_from_pack(const Asset_Pack_Entry* e) {
+
+    //If the renderer prefers another format SDL converts during the
+    //upload, which is still far cheaper than decoding a PNG
+    SDL_Texture* t = SDL_CreateTexture(window_renderer,
+            pack_header->pixel_format, SDL_TEXTUREACCESS_STATIC,
+            e->width, e->height);
+
+    if(t == NULL) {
+        LOG_ERROR(LOG_VIDEO, " PACK: unable to create texture for %s (SDL Error: %s)",
+                e->name, SDL_GetError());
+        return NULL;
+    }
+
+    SDL_UpdateTexture(t, NULL, pack_data + e->offset, e->pitch);
+    SDL_SetTextureBlendMode(t, SDL_BLENDMODE_BLEND);
+    return t;
+}
+
+bool pack_sounds_usable(void) {
+
+    //Sounds can only be played straight from the pack if the mixer ended
+    //up with the format they were baked in
+    if(pack_header == NULL)
+        return false;
+    if(pack_sound_usable == -1) {
+        int frequency = 0, channels = 0;
+        Uint16 format = 0;
+        Mix_QuerySpec(&frequency, &format, &channels);
+        pack_sound_usable = (frequency == (int)pack_header->sound_frequency &&
+                format == pack_header->sound_format &&
+                channels == pack_header->sound_channels) ? 1 : 0;
+    }
+    return pack_sound_usable == 1;
+}
+
+Mix_Chunk* create_chunk_from_pack(const Asset_Pack_Entry* e) {
+
+    if(pack_sounds_usable() == false)
+        return NULL;
+
+    //Mix_QuickLoad_RAW() doesn't copy or free the samples, and the mixer
+    //only ever reads them
+    return Mix_QuickLoad_RAW((Uint8*)(pack_data + e->offset), e->size);
+}
+
+#ifdef _WIN32
+
+const Uint8* map_pack_file(const char* filename, size_t* size) {
+
+    pack_file_handle = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ,
+            NULL, OPEN_EXISTING, FILE_FLAG_RANDOM_ACCESS, NULL);
+    if(pack_file_handle == INVALID_HANDLE_VALUE)
+        return NULL;
+
+    LARGE_INTEGER file_size;
+    GetFileSizeEx(pack_file_handle, &file_size);
+
+    pack_mapping = CreateFileMappingA(pack_file_handle, NULL, PAGE_READONLY,
+            0, 0, NULL);
+    const Uint8* data = NULL;
+    if(pack_mapping != NULL)
+        data = (const Uint8*)MapViewOfFile(pack_mapping, FILE_MAP_READ, 0, 0, 0);
+
+    if(data == NULL) {
+        LOG_ERROR(LOG_ENGINE, " PACK: unable to map %s (error %lu)", filename,
+                GetLastError());
+        if(pack_mapping != NULL)
+            CloseHandle(pack_mapping);
+        CloseHandle(pack_file_handle);
+        pack_mapping = NULL;
+        pack_file_handle = INVALID_HANDLE_VALUE;
+        return NULL;
+    }
+
+    *size = (size_t)file_size.QuadPart;
+    return data;
+}
+
+void unmap_pack_file(void) {
+
+    UnmapViewOfFile(pack_data);
+    CloseHandle(pack_mapping);
+    CloseHandle(pack_file_handle);
+    pack_mapping = NULL;
+    pack_file_handle = INVALID_HANDLE_VALUE;
+}
+
+#else
+
+const Uint8* map_pack_file(const char* filename, size_t* size) {
+
+    int fd = open(filename, O_RDONLY);
+    if(fd < 0)
+        return NULL;
+
+    struct stat st;
+    void* data = MAP_FAILED;
+    if(fstat(fd, &st) == 0 && st.st_size > 0)
+        data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd); // the mapping keeps the file open
+
+    if(data == MAP_FAILED) {
+        LOG_ERROR(LOG_ENGINE, " PACK: unable to map %s", filename);
+        return NULL;
+    }
+
+    *size = (size_t)st.st_size;
+    return (const Uint8*)data;
+}
+
+void unmap_pack_file(void) {
+    munmap((void*)pack_data, pack_size);
+}
+
+#endif
@@ -0,0 +1,358 @@
+//345678901234567890123456789012345678901234567890123456789012345678901234567890
+//       1         2         3         4         5         6         7         8
+// Filename: ../engine_juliet_replay.cpp
+// Last Modified: Mon Oct 19, 2026  03:55PM
+//
+// Input recording and replay.
+//
+// A recording is the random number seed plus every input event the game
+// saw, each tagged with the frame it was handled in. Playing it back feeds
+// those events through the same batch dispatch in main_game_loop() on the
+// same frames, so a game that only uses rand() and the input system for
+// its decisions will play out exactly the same way. That gives repeatable
+// runs for profiling and for checking a change didn't alter behaviour.
+//
+// Anything a game does based on wall-clock time (SDL_GetTicks()) is not
+// reproduced.
+//
+// Typical use, right after initialize_engine():
+//
+//     start_input_recording("session.jrec");     // or...
+//     start_input_replay("session.jrec", true);  // uncapped, headless
+//
+// File format (little endian):
+//
+//     "JREC"  Uint16 version  Uint32 seed  Uint16 frames per second
+//     records: Uint32 frame  Uint32 SDL event type  payload (see below)
+//     end:     Uint32 frame  Uint32 0
+//
+// Only events the engine dispatches are stored, and only the fields it
+// reads, so a recording takes a few bytes per keypress.
+
+#include "engine_juliet.h"
+
+extern Uint32 cumulative_frame_count;
+extern Uint32 rng_seed;
+
+const Uint16 REPLAY_VERSION = 1;
+
+// Recording
+SDL_RWops* record_file = NULL;
+Uint32     record_start_frame = 0;
+Uint32     record_event_count = 0;
+
+// Replay
+SDL_RWops* replay_file = NULL;
+Uint32     replay_start_frame = 0;
+Uint32     replay_start_ticks = 0;
+bool       replay_have_pending = false;
+Uint32     replay_pending_frame = 0;
+SDL_Event  replay_pending;
+bool       replay_finished = false;
+bool       replay_uncapped = false;
+
+void write_input_event(const SDL_Event* e, Uint32 frame);
+bool read_input_event(void);
+
+bool start_input_recording(const char* filename) {
+
+    stop_input_recording();
+
+    record_file = SDL_RWFromFile(filename, "wb");
+    if(record_file == NULL) {
+        LOG_ERROR(LOG_INPUT, " REPLAY: can't create %s (SDL Error: %s)", filename,
+                SDL_GetError());
+        return false;
+    }
+
+    SDL_RWwrite(record_file, "JREC", 1, 4);
+    SDL_WriteLE16(record_file, REPLAY_VERSION);
+    SDL_WriteLE32(record_file, rng_seed);
+    SDL_WriteLE16(record_file, (Uint16)DESIRED_FPS);
+
+    //Reseed so the recording starts from a known random number state
+    srand(rng_seed);
+    record_start_frame = cumulative_frame_count;
+    record_event_count = 0;
+
+    LOG_INFO(LOG_INPUT, " REPLAY: recording input to %s (seed %u)", filename, rng_seed);
+    return true;
+}
+
+void stop_input_recording(void) {
+
+    if(record_file == NULL)
+        return;
+
+    SDL_WriteLE32(record_file, cumulative_frame_count - record_start_frame);
+    SDL_WriteLE32(record_file, 0);
+    SDL_RWclose(record_file);
+    record_file = NULL;
+
+    LOG_INFO(LOG_INPUT, " REPLAY: recorded %u events over %u frames", record_event_count,
+            cumulative_frame_count - record_start_frame);
+}
+
+bool start_input_replay(const char* filename, bool uncapped) {
+
+    stop_input_replay();
+
+    replay_file = SDL_RWFromFile(filename, "rb");
+    if(replay_file == NULL) {
+        LOG_ERROR(LOG_INPUT, " REPLAY: can't open %s (SDL Error: %s)", filename,
+                SDL_GetError());
+        return false;
+    }
+
+    char id[4];
+    Uint16 version = 0;
+    if(SDL_RWread(replay_file, id, 1, 4) == 4 &&
+            SDL_memcmp(id, "JREC", 4) == 0) {
+        version = SDL_ReadLE16(replay_file);
+    }
+    if(version != REPLAY_VERSION) {
+        LOG_ERROR(LOG_INPUT, " REPLAY: %s is not a version %d recording", filename,
+                REPLAY_VERSION);
+        SDL_RWclose(replay_file);
+        replay_file = NULL;
+        return false;
+    }
+
+    rng_seed = SDL_ReadLE32(replay_file);
+    Uint16 fps = SDL_ReadLE16(replay_file);
+    if(fps != DESIRED_FPS) {
+        LOG_WARN(LOG_INPUT, " REPLAY: warning, recorded at %d FPS, running at %d FPS",
+                fps, DESIRED_FPS);
+    }
+
+    srand(rng_seed);
+    replay_start_frame = cumulative_frame_count;
+    replay_start_ticks = SDL_GetTicks();
+    replay_finished = false;
+    replay_uncapped = uncapped;
+    replay_have_pending = read_input_event();
+
+    LOG_INFO(LOG_INPUT, " REPLAY: playing back %s (seed %u)%s", filename, rng_seed,
+            uncapped ? ", uncapped" : "");
+    return true;
+}
+
+void stop_input_replay(void) {
+
+    if(replay_file == NULL)
+        return;
+
+    SDL_RWclose(replay_file);
+    replay_file = NULL;
+    replay_have_pending = false;
+    replay_uncapped = false;
+}
+
+bool input_replay_active(void) {
+    return replay_file != NULL;
+}
+
+bool input_replay_uncapped(void) {
+    return replay_file != NULL && replay_uncapped;
+}
+
+int next_input_batch(SDL_Event* batch, int max) {
+
+    //Called by main_game_loop() until it returns 0. Normally this is just
+    //SDL's queue (recorded if a recording is running). During a replay
+    //the real queue is thrown away, apart from SDL_QUIT so the window can
+    //still be closed, and the recorded events for this frame are handed
+    //out instead.
+
+    if(replay_file == NULL) {
+
+        int n = SDL_PeepEvents(batch, max, SDL_GETEVENT, SDL_FIRSTEVENT,
+                SDL_LASTEVENT);
+
+        if(record_file != NULL) {
+            for(int i = 0; i < n; i++)
+                write_input_event(&batch[i],
+                        cumulative_frame_count - record_start_frame);
+        }
+        return n;
+    }
+
+    int n = SDL_PeepEvents(batch, max, SDL_GETEVENT, SDL_QUIT, SDL_QUIT);
+    if(n < 0)
+        n = 0;
+    SDL_FlushEvents(SDL_FIRSTEVENT, SDL_LASTEVENT);
+
+    Uint32 frame = cumulative_frame_count - replay_start_frame;
+    while(n < max && replay_have_pending && replay_pending_frame <= frame) {
+        batch[n] = replay_pending;
+        batch[n].common.timestamp = SDL_GetTicks();
+        n++;
+        replay_have_pending = read_input_event();
+    }
+
+    //End of the recording: report and quit, so a replay can be used as
+    //a benchmark run
+    if(replay_have_pending == false && replay_finished == false &&
+            replay_pending_frame <= frame && n < max) {
+
+        Uint32 ms = SDL_GetTicks() - replay_start_ticks;
+        LOG_INFO(LOG_INPUT, " REPLAY: finished, %u frames in %u ms (%.3f ms/frame)",
+                frame, ms, (frame > 0) ? (double)ms / frame : 0.0);
+
+        replay_finished = true;
+        SDL_memset(&batch[n], 0, sizeof(SDL_Event));
+        batch[n].type = SDL_QUIT;
+        batch[n].common.timestamp = SDL_GetTicks();
+        n++;
+    }
+
+    return n;
+}
+
+void write_input_event(const SDL_Event* e, Uint32 frame) {
+
+    SDL_RWops* f = record_file;
+
+    switch(e->type) {
+
+        case SDL_KEYDOWN:
+        case SDL_KEYUP:
+            SDL_WriteLE32(f, frame);
+            SDL_WriteLE32(f, e->type);
+            SDL_WriteLE16(f, (Uint16)e->key.keysym.scancode);
+            SDL_WriteLE32(f, (Uint32)e->key.keysym.sym);
+            SDL_WriteLE16(f, e->key.keysym.mod);
+            SDL_WriteU8(f, e->key.repeat);
+            break;
+
+        case SDL_TEXTINPUT: {
+            Uint8 len = (Uint8)SDL_strlen(e->text.text);
+            SDL_WriteLE32(f, frame);
+            SDL_WriteLE32(f, e->type);
+            SDL_WriteU8(f, len);
+            SDL_RWwrite(f, e->text.text, 1, len);
+            break;
+        }
+
+        case SDL_MOUSEMOTION:
+            SDL_WriteLE32(f, frame);
+            SDL_WriteLE32(f, e->type);
+            SDL_WriteLE32(f, e->motion.state);
+            SDL_WriteLE32(f, (Uint32)e->motion.x);
+            SDL_WriteLE32(f, (Uint32)e->motion.y);
+            SDL_WriteLE32(f, (Uint32)e->motion.xrel);
+            SDL_WriteLE32(f, (Uint32)e->motion.yrel);
+            break;
+
+        case SDL_MOUSEBUTTONDOWN:
+        case SDL_MOUSEBUTTONUP:
+            SDL_WriteLE32(f, frame);
+            SDL_WriteLE32(f, e->type);
+            SDL_WriteU8(f, e->button.button);
+            SDL_WriteU8(f, e->button.clicks);
+            SDL_WriteLE32(f, (Uint32)e->button.x);
+            SDL_WriteLE32(f, (Uint32)e->button.y);
+            break;
+
+        case SDL_CONTROLLERBUTTONDOWN:
+        case SDL_CONTROLLERBUTTONUP:
+            SDL_WriteLE32(f, frame);
+            SDL_WriteLE32(f, e->type);
+            SDL_WriteU8(f, e->cbutton.button);
+            break;
+
+        case SDL_CONTROLLERAXISMOTION:
+            SDL_WriteLE32(f, frame);
+            SDL_WriteLE32(f, e->type);
+            SDL_WriteU8(f, e->caxis.axis);
+            SDL_WriteLE16(f, (Uint16)e->caxis.value);
+            break;
+
+        case SDL_QUIT:
+            SDL_WriteLE32(f, frame);
+            SDL_WriteLE32(f, e->type);
+            break;
+
+        default:
+            return; // window events etc. don't affect the game
+    }
+
+    record_event_count++;
+}
+
+bool read_input_event(void) {
+
+    //Decodes the next record into replay_pending. Returns false at the
+    //end marker (replay_pending_frame is then the last frame) or on a
+    //damaged file.
+
+    SDL_RWops* f = replay_file;
+    SDL_Event* e = &replay_pending;
+    SDL_memset(e, 0, sizeof(SDL_Event));
+
+    replay_pending_frame = SDL_ReadLE32(f);
+    e->type = SDL_ReadLE32(f);
+
+    switch(e->type) {
+
+        case 0:
+            return false;
+
+        case SDL_KEYDOWN:
+        case SDL_KEYUP:
+            e->key.state = (e->type == SDL_KEYDOWN) ? SDL_PRESSED : SDL_RELEASED;
+            e->key.keysym.scancode = (SDL_Scancode)SDL_ReadLE16(f);
+            e->key.keysym.sym = (SDL_Keycode)SDL_ReadLE32(f);
+            e->key.keysym.mod = SDL_ReadLE16(f);
+            e->key.repeat = SDL_ReadU8(f);
+            break;
+
+        case SDL_TEXTINPUT: {
+            Uint8 len = SDL_ReadU8(f);
+            if(len >= SDL_TEXTINPUTEVENT_TEXT_SIZE)
+                return false;
+            SDL_RWread(f, e->text.text, 1, len);
+            e->text.text[len] = '\0';
+            break;
+        }
+
+        case SDL_MOUSEMOTION:
+            e->motion.state = SDL_ReadLE32(f);
+            e->motion.x = (Sint32)SDL_ReadLE32(f);
+            e->motion.y = (Sint32)SDL_ReadLE32(f);
+            e->motion.xrel = (Sint32)SDL_ReadLE32(f);
+            e->motion.yrel = (Sint32)SDL_ReadLE32(f);
+            break;
+
+        case SDL_MOUSEBUTTONDOWN:
+        case SDL_MOUSEBUTTONUP:
+            e->button.state = (e->type == SDL_MOUSEBUTTONDOWN) ?
+                SDL_PRESSED : SDL_RELEASED;
+            e->button.button = SDL_ReadU8(f);
+            e->button.clicks = SDL_ReadU8(f);
+            e->button.x = (Sint32)SDL_ReadLE32(f);
+            e->button.y = (Sint32)SDL_ReadLE32(f);
+            break;
+
+        case SDL_CONTROLLERBUTTONDOWN:
+        case SDL_CONTROLLERBUTTONUP:
+            e->cbutton.state = (e->type == SDL_CONTROLLERBUTTONDOWN) ?
+                SDL_PRESSED : SDL_RELEASED;
+            e->cbutton.button = SDL_ReadU8(f);
+            break;
+
+        case SDL_CONTROLLERAXISMOTION:
+            e->caxis.axis = SDL_ReadU8(f);
+            e->caxis.value = (Sint16)SDL_ReadLE16(f);
+            break;
+
+        case SDL_QUIT:
+            break;
+
+        default:
+            LOG_ERROR(LOG_INPUT, " REPLAY: damaged recording (event type %u)", e->type);
+            return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,417 @@
+//345678901234567890123456789012345678901234567890123456789012345678901234567890
+//       1         2         3         4         5         6         7         8
+// Filename: ../engine_juliet_sfx.cpp
+// Last Modified: Tue Oct 20, 2026  07:10AM
+//
+// Procedural sound effects (in the spirit of sfxr).
+//
+// Instead of loading a .wav for every blip and explosion, a game describes
+// the effect with a Sfx_Params struct (waveform, base frequency, slide,
+// envelope, noise, duty) and the engine renders it straight into the
+// mixer's format. Nothing is read from disk.
+//
+// Rendered sounds are kept in a small cache keyed by a hash of the
+// parameters, so asking for the same effect twice costs a table lookup.
+// When the cache is full, an effect that no sound effect slot is using is
+// evicted to make room; the cache holds more than NUM_SOUND_EFFECTS, so
+// there always is one and tweaking params at runtime never runs out.
+// At startup a whole list of effects can be rendered at once with
+// generate_sound_effects(), which spreads the work over one thread per CPU
+// core and fills the cache before the first frame.
+//
+// The cache owns the sample memory. Chunks handed to the mixer are made
+// with Mix_QuickLoad_RAW(), which only points at those samples, so
+// Mix_FreeChunk() on them never frees cached memory.
+
+#include "engine_juliet.h"
+
+extern Mix_Chunk* sound_effect_list[NUM_SOUND_EFFECTS];
+
+// Cache (open addressing, main thread only)
+const int     SFX_CACHE_SIZE = 256;        // must be a power of 2
+const float   SFX_MAX_SECONDS = 5.0f;
+
+struct Sfx_Cache_Entry {
+    bool        used;
+    Uint32      hash;
+    Sfx_Params  params;
+    Uint8*      samples;                   // already in the mixer's format
+    Uint32      length;                    // bytes
+};
+
+Sfx_Cache_Entry sfx_cache[SFX_CACHE_SIZE];
+int             sfx_cache_count = 0;
+int             sfx_evict_next = 0;        // where the eviction scan resumes
+
+// Work shared with the generator threads
+struct Sfx_Job {
+    const Sfx_Params* params;
+    Uint8*            samples;
+    Uint32            length;
+};
+
+Sfx_Job*     sfx_jobs = NULL;
+int          sfx_job_count = 0;
+SDL_atomic_t sfx_next_job;
+
+// Mixer format (from Mix_QuerySpec)
+int     sfx_frequency = 0;
+Uint16  sfx_format = 0;
+int     sfx_channels = 0;
+
+Uint32 hash_sfx_params(const Sfx_Params* p);
+bool   sfx_params_equal(const Sfx_Params* a, const Sfx_Params* b);
+Sfx_Cache_Entry* find_cached_sfx(const Sfx_Params* p, Uint32 hash);
+Sfx_Cache_Entry* insert_cached_sfx(const Sfx_Params* p, Uint32 hash,
+        Uint8* samples, Uint32 length);
+bool   sfx_in_use(const Sfx_Cache_Entry* e);
+void   remove_cached_sfx(int i);
+bool   evict_cached_sfx(void);
+bool   render_sfx(const Sfx_Params* p, Uint8** samples, Uint32* length);
+int    sfx_generator_thread(void* data);
+
+Uint32 hash_sfx_params(const Sfx_Params* p) {
+
+    //FNV-1a, one field at a time so struct padding never gets hashed
+    const float fields[10] = {
+        (float)p->waveform, p->base_frequency, p->frequency_slide,
+        p->duty, p->duty_slide, p->attack, p->sustain, p->decay,
+        p->noise, p->volume };
+
+    Uint32 h = 2166136261u;
+    const Uint8* b = (const Uint8*)fields;
+    for(int i = 0; i < (int)sizeof(fields); i++) {
+        h ^= b[i];
+        h *= 16777619u;
+    }
+
+    return h;
+}
+
+bool sfx_params_equal(const Sfx_Params* a, const Sfx_Params* b) {
+
+    return a->waveform == b->waveform &&
+        a->base_frequency == b->base_frequency &&
+        a->frequency_slide == b->frequency_slide &&
+        a->duty == b->duty &&
+        a->duty_slide == b->duty_slide &&
+        a->attack == b->attack &&
+        a->sustain == b->sustain &&
+        a->decay == b->decay &&
+        a->noise == b->noise &&
+        a->volume == b->volume;
+}
+
+Sfx_Cache_Entry* find_cached_sfx(const Sfx_Params* p, Uint32 hash) {
+
+    int i = hash & (SFX_CACHE_SIZE - 1);
+
+    while(sfx_cache[i].used) {
+        if(sfx_cache[i].hash == hash && sfx_params_equal(&sfx_cache[i].params, p))
+            return &sfx_cache[i];
+        i = (i + 1) & (SFX_CACHE_SIZE - 1);
+    }
+
+    return NULL;
+}
+
+bool sfx_in_use(const Sfx_Cache_Entry* e) {
+
+    //A slot's chunk points straight at the cached samples
+    for(int i = 0; i < NUM_SOUND_EFFECTS; i++) {
+        if(sound_effect_list[i] != NULL && sound_effect_list[i]->abuf == e->samples)
+            return true;
+    }
+    return false;
+}
+
+void remove_cached_sfx(int i) {
+
+    free(sfx_cache[i].samples);
+    sfx_cache[i].used = false;
+    sfx_cache_count--;
+
+    //Shift later entries of the probe run back so lookups still find them
+    int hole = i;
+    int j = (i + 1) & (SFX_CACHE_SIZE - 1);
+    while(sfx_cache[j].used) {
+        int home = sfx_cache[j].hash & (SFX_CACHE_SIZE - 1);
+        if(((j - home) & (SFX_CACHE_SIZE - 1)) >= ((j - hole) & (SFX_CACHE_SIZE - 1))) {
+            sfx_cache[hole] = sfx_cache[j];
+            sfx_cache[j].used = false;
+            hole = j;
+        }
+        j = (j + 1) & (SFX_CACHE_SIZE - 1);
+    }
+}
+
+bool evict_cached_sfx(void) {
+
+    //Round robin, so the oldest unused effects tend to go first
+    for(int n = 0; n < SFX_CACHE_SIZE; n++) {
+        int i = (sfx_evict_next + n) & (SFX_CACHE_SIZE - 1);
+        if(sfx_cache[i].used && sfx_in_use(&sfx_cache[i]) == false) {
+            remove_cached_sfx(i);
+            sfx_evict_next = (i + 1) & (SFX_CACHE_SIZE - 1);
+            return true;
+        }
+    }
+    return false;
+}
+
+Sfx_Cache_Entry* insert_cached_sfx(const Sfx_Params* p, Uint32 hash,
+        Uint8* samples, Uint32 length) {
+
+    //Keep the table at most 3/4 full so probing stays short. Every slot
+    //using a different effect is still under that, so eviction finds one;
+    //past it the table only fills further if it somehow can't.
+    if(sfx_cache_count >= (SFX_CACHE_SIZE * 3) / 4 && evict_cached_sfx() == false) {
+        LOG_WARN(LOG_AUDIO, " SFX: cache full (%d effects), none unused", sfx_cache_count);
+        if(sfx_cache_count == SFX_CACHE_SIZE - 1) {
+            free(samples);
+            return NULL;
+        }
+    }
+
+    int i = hash & (SFX_CACHE_SIZE - 1);
+    while(sfx_cache[i].used)
+        i = (i + 1) & (SFX_CACHE_SIZE - 1);
+
+    sfx_cache[i].used = true;
+    sfx_cache[i].hash = hash;
+    sfx_cache[i].params = *p;
+    sfx_cache[i].samples = samples;
+    sfx_cache[i].length = length;
+    sfx_cache_count++;
+
+    return &sfx_cache[i];
+}
+
+bool render_sfx(const Sfx_Params* p, Uint8** samples, Uint32* length) {
+
+    //Renders 16-bit mono at the mixer frequency, then lets SDL convert to
+    //the mixer's format and channel count. Only touches its own memory, so
+    //it is safe to run on several threads at once.
+
+    float seconds = p->attack + p->sustain + p->decay;
+    if(seconds <= 0.0f)
+        seconds = 0.01f;
+    if(seconds > SFX_MAX_SECONDS)
+        seconds = SFX_MAX_SECONDS;
+
+    int num_samples = (int)(seconds * sfx_frequency);
+
+    SDL_AudioCVT cvt;
+    if(SDL_BuildAudioCVT(&cvt, AUDIO_S16SYS, 1, sfx_frequency,
+                sfx_format, (Uint8)sfx_channels, sfx_frequency) < 0) {
+        return false;
+    }
+    cvt.len = num_samples * 2;
+    cvt.buf = (Uint8*)malloc(cvt.len * cvt.len_mult);
+    if(cvt.buf == NULL)
+        return false;
+
+    Sint16* out = (Sint16*)cvt.buf;
+    float   dt = 1.0f / sfx_frequency;
+    float   frequency = p->base_frequency;
+    float   duty = p->duty;
+    float   phase = 0.0f;
+    float   noise_value = 0.0f;
+    Uint32  random_state = hash_sfx_params(p) | 1;  // same params, same noise
+
+    int attack_end = (int)(p->attack * sfx_frequency);
+    int sustain_end = attack_end + (int)(p->sustain * sfx_frequency);
+
+    for(int i = 0; i < num_samples; i++) {
+
+        //Envelope: linear attack, flat sustain, linear decay
+        float envelope = 1.0f;
+        if(i < attack_end)
+            envelope = (float)i / attack_end;
+        else if(i >= sustain_end)
+            envelope = 1.0f - (float)(i - sustain_end) /
+                (num_samples - sustain_end);
+
+        //Noise changes value once per period, like sfxr
+        phase += frequency * dt;
+        if(phase >= 1.0f) {
+            phase -= (int)phase;
+            random_state = random_state * 1103515245u + 12345u;
+            noise_value = ((random_state >> 16) & 0x7FFF) / 16383.5f - 1.0f;
+        }
+
+        float tone;
+        switch(p->waveform) {
+            case SYNTH_SQUARE:
+                tone = (phase < duty) ? 1.0f : -1.0f;
+                break;
+            case SYNTH_TRIANGLE:
+                tone = (phase < 0.5f) ? (phase * 4.0f - 1.0f) :
+                    (3.0f - phase * 4.0f);
+                break;
+            case SYNTH_SAWTOOTH:
+                tone = phase * 2.0f - 1.0f;
+                break;
+            default:
+                tone = noise_value;
+                break;
+        }
+
+        float value = (tone * (1.0f - p->noise) + noise_value * p->noise) *
+            envelope * p->volume;
+        if(value > 1.0f)
+            value = 1.0f;
+        if(value < -1.0f)
+            value = -1.0f;
+        out[i] = (Sint16)(value * 32000.0f);
+
+        //Slides
+        frequency += p->frequency_slide * dt;
+        if(frequency < 20.0f)
+            frequency = 20.0f;
+        duty += p->duty_slide * dt;
+        if(duty < 0.05f)
+            duty = 0.05f;
+        if(duty > 0.95f)
+            duty = 0.95f;
+    }
+
+    SDL_ConvertAudio(&cvt);
+
+    *samples = cvt.buf;
+    *length = cvt.len_cvt;
+
+    return true;
+}
+
+int sfx_generator_thread(void* data) {
+
+    //Grab the next unclaimed job until there are none left
+    int job;
+    while((job = SDL_AtomicAdd(&sfx_next_job, 1)) < sfx_job_count) {
+        if(render_sfx(sfx_jobs[job].params, &sfx_jobs[job].samples,
+                    &sfx_jobs[job].length) == false) {
+            sfx_jobs[job].samples = NULL;
+        }
+    }
+
+    return 0;
+}
+
+bool query_sfx_format(void) {
+
+    if(Mix_QuerySpec(&sfx_frequency, &sfx_format, &sfx_channels) == 0) {
+        LOG_ERROR(LOG_AUDIO, " SFX: mixer not open (%s)", Mix_GetError());
+        return false;
+    }
+
+    return true;
+}
+
+void generate_sound_effects(const Sfx_Params* list, int count) {
+
+    //Renders every effect in the list that isn't cached yet, one worker
+    //thread per CPU core, then adds the results to the cache.
+
+    if(query_sfx_format() == false)
+        return;
+
+    Uint32 start_time = SDL_GetTicks();
+
+    sfx_jobs = (Sfx_Job*)malloc(count * sizeof(Sfx_Job));
+    sfx_job_count = 0;
+    for(int i = 0; i < count; i++) {
+        if(find_cached_sfx(&list[i], hash_sfx_params(&list[i])) == NULL) {
+            sfx_jobs[sfx_job_count].params = &list[i];
+            sfx_jobs[sfx_job_count].samples = NULL;
+            sfx_job_count++;
+        }
+    }
+    SDL_AtomicSet(&sfx_next_job, 0);
+
+    const int MAX_SFX_THREADS = 16;
+    SDL_Thread* threads[MAX_SFX_THREADS];
+    int num_threads = SDL_GetCPUCount();
+    if(num_threads > MAX_SFX_THREADS)
+        num_threads = MAX_SFX_THREADS;
+    if(num_threads > sfx_job_count)
+        num_threads = sfx_job_count;
+
+    for(int i = 0; i < num_threads; i++) {
+        threads[i] = SDL_CreateThread(sfx_generator_thread, "sfx_generator",
+                NULL);
+    }
+
+    //The main thread works too (and does everything if threads failed)
+    sfx_generator_thread(NULL);
+
+    for(int i = 0; i < num_threads; i++) {
+        SDL_WaitThread(threads[i], NULL);
+    }
+
+    //Same params can appear twice in one list; keep the first
+    for(int i = 0; i < sfx_job_count; i++) {
+        const Sfx_Params* p = sfx_jobs[i].params;
+        Uint32 hash = hash_sfx_params(p);
+        if(sfx_jobs[i].samples == NULL) {
+            continue;
+        } else if(find_cached_sfx(p, hash) != NULL) {
+            free(sfx_jobs[i].samples);
+        } else {
+            insert_cached_sfx(p, hash, sfx_jobs[i].samples,
+                    sfx_jobs[i].length);
+        }
+    }
+
+    LOG_INFO(LOG_AUDIO, " SFX: generated %d sound effects in %d ms (%d threads)",
+            sfx_job_count, SDL_GetTicks() - start_time, num_threads + 1);
+
+    free(sfx_jobs);
+    sfx_jobs = NULL;
+    sfx_job_count = 0;
+}
+
+void load_sound_effect_params(const Sfx_Params* p, int i) {
+
+    //Same slot rules as load_wav_sound_file(). Calling this again with
+    //tweaked params replaces the effect at runtime.
+
+    if(i < 0 || i >= NUM_SOUND_EFFECTS)
+        return;
+
+    if(query_sfx_format() == false)
+        return;
+
+    Uint32 hash = hash_sfx_params(p);
+    Sfx_Cache_Entry* e = find_cached_sfx(p, hash);
+
+    if(e == NULL) {
+        Uint8* samples;
+        Uint32 length;
+        if(render_sfx(p, &samples, &length) == false) {
+            LOG_ERROR(LOG_AUDIO, " SFX: unable to render effect %d (SDL Error: %s)",
+                    i, SDL_GetError());
+            return;
+        }
+        e = insert_cached_sfx(p, hash, samples, length);
+        if(e == NULL)
+            return;
+    }
+
+    if(sound_effect_list[i] != NULL) {
+        Mix_FreeChunk(sound_effect_list[i]);
+    }
+    sound_effect_list[i] = Mix_QuickLoad_RAW(e->samples, e->length);
+}
+
+void free_sound_effect_cache(void) {
+
+    //Only call once nothing is playing from the cache (shutdown_engine)
+    for(int i = 0; i < SFX_CACHE_SIZE; i++) {
+        if(sfx_cache[i].used) {
+            free(sfx_cache[i].samples);
+            sfx_cache[i].used = false;
+        }
+    }
+    sfx_cache_count = 0;
+}
@@ -0,0 +1,549 @@
+//345678901234567890123456789012345678901234567890123456789012345678901234567890
+//       1         2         3         4         5         6         7         8
+// Filename: ../engine_juliet_synth.cpp
+// Last Modified: Tue Oct 20, 2026  09:20AM
+//
+// Synth voices and tracker music player.
+//
+// This is the engine's own sound chip: NUM_SYNTH_VOICES oscillators (square
+// with variable duty, triangle, sawtooth, noise), each with a simple ADSR
+// envelope, rendered directly into the audio device opened by
+// initialize_audio(). Nothing here goes through SDL_mixer.
+//
+// On top of the voices sits a tracker player, in the style of the old
+// Amiga/C64 trackers. A song is:
+//
+//     instruments   waveform, duty, volume and ADSR envelope
+//     patterns      rows x NUM_SYNTH_VOICES cells (note, instrument,
+//                   effect, effect parameter), 4 bytes per cell
+//     order list    which pattern plays next, with a restart position
+//
+// A full song is a few KB. The player runs inside the audio callback: every
+// 'tick' (tick_rate per second, 50 by default) it advances envelopes and
+// effects, and every 'speed' ticks it reads the next row. Between ticks the
+// callback does nothing but run the oscillators, so a block costs a few
+// microseconds.
+//
+// Effects (Note_Cell.effect):
+//
+//     0x0  arpeggio     param hi/lo nibble = semitones added on ticks 1, 2
+//     0x1  slide up     param = 1/16ths of a semitone per tick
+//     0x2  slide down   param = 1/16ths of a semitone per tick
+//     0xC  volume       param = 0-64
+//     0xF  speed        param = ticks per row
+//
+// Song file layout (.jtrk, little endian, all fields one byte):
+//
+//     'J' 'T' 'R' 'K' version speed tick_rate rows_per_pattern
+//     num_instruments num_patterns order_length restart_position
+//     instruments   (8 bytes each: waveform duty volume attack decay
+//                    sustain release unused)
+//     order list    (order_length bytes)
+//     patterns      (rows_per_pattern * NUM_SYNTH_VOICES * 4 bytes each)
+
+#include "engine_juliet.h"
+
+extern SDL_AudioDeviceID audio_device_id;
+extern Audio_Callback_Timing synth_callback_timing;
+
+// Voices (owned by the audio callback once the device is running)
+struct Synth_Voice {
+    Uint32  phase;            // oscillator position, wraps at 2^32
+    Uint32  phase_step;       // added every sample
+    Uint32  noise;            // 15-bit LFSR for the noise waveform
+    Uint8   waveform;
+    Uint8   duty;             // square wave high time, 0-255
+    Uint8   volume;           // 0-64
+    int     pitch;            // in 1/16 semitones, note * 16
+    int     envelope;         // 0-255
+    int     envelope_stage;   // ATTACK, DECAY, SUSTAIN, RELEASE, OFF
+    const Instrument* instrument;
+};
+
+const int ENV_ATTACK  = 0;
+const int ENV_DECAY   = 1;
+const int ENV_SUSTAIN = 2;
+const int ENV_RELEASE = 3;
+const int ENV_OFF     = 4;
+
+Synth_Voice synth_voice[NUM_SYNTH_VOICES];
+int         synth_frequency = 44100;
+bool        synth_voices_ready = false;   // voices set up by the first open
+
+// Audio clock: seconds of sound handed to the device so far, and the
+// performance counter when the last block was handed over. Kept in
+// seconds so it carries straight on if the device is reopened at a
+// different rate. See audio_clock_ms().
+//
+// The callback publishes the pair under a sequence count (a seqlock) rather
+// than the device lock, so the main thread can read the clock as often as
+// it likes without ever holding up the callback: the count is odd while
+// the pair is being written, and a reader that sees it odd or changed just
+// reads again.
+volatile double synth_clock_seconds = 0.0;
+volatile Uint64 synth_clock_counter = 0;
+SDL_atomic_t    synth_clock_sequence;
+double          audio_clock_last_ms = 0.0;
+
+// phase_step for every pitch the player can produce (97 notes in 1/16
+// semitone steps), calculated once in initialize_synth()
+const int   NUM_PITCHES = (SYNTH_NOTE_MAX + 1) * 16;
+Uint32      pitch_table[NUM_PITCHES];
+
+// Tracker state (audio callback only, except when the device is locked)
+const Song* song = NULL;
+int         song_order_index = 0;
+int         song_row = 0;
+int         song_speed = 6;
+int         song_tick = 0;           // ticks since the current row started
+int         samples_per_tick = 0;
+int         samples_until_tick = 0;
+Note_Cell   song_effect[NUM_SYNTH_VOICES];  // effect running on each voice
+int         song_base_pitch[NUM_SYNTH_VOICES];
+
+void synth_note_on(Synth_Voice* v, const Instrument* ins, int note);
+void synth_note_off(Synth_Voice* v);
+void synth_envelope_tick(Synth_Voice* v);
+void tracker_tick(void);
+void tracker_read_row(void);
+
+void initialize_synth(int frequency) {
+
+    int old_frequency = synth_frequency;
+    synth_frequency = frequency;
+
+    //Note 1 is C-0, note 58 is A-4 (440 Hz)
+    for(int i = 0; i < NUM_PITCHES; i++) {
+        double hz = 440.0 * pow(2.0, ((i / 16.0) - 58.0) / 12.0);
+        pitch_table[i] = (Uint32)(hz * 4294967296.0 / frequency);
+    }
+
+    //Called again whenever the device is reopened (see open_synth_device),
+    //with the callback stopped. Held notes and envelopes carry on: only
+    //what depends on the rate is worked out again.
+    samples_per_tick = frequency / ((song != NULL) ? song->tick_rate : 50);
+    if(synth_voices_ready) {
+        for(int i = 0; i < NUM_SYNTH_VOICES; i++)
+            synth_voice[i].phase_step = pitch_table[synth_voice[i].pitch];
+        samples_until_tick = (int)((Sint64)samples_until_tick * frequency /
+                old_frequency);
+        return;
+    }
+
+    for(int i = 0; i < NUM_SYNTH_VOICES; i++) {
+        SDL_memset(&synth_voice[i], 0, sizeof(Synth_Voice));
+        synth_voice[i].envelope_stage = ENV_OFF;
+        synth_voice[i].noise = 0x4000;
+    }
+    samples_until_tick = samples_per_tick;
+    synth_voices_ready = true;
+}
+
+void SDLCALL synth_audio_callback(void* userdata, Uint8* stream, int len) {
+
+    //Renders 8-bit unsigned mono (the format initialize_audio() asks for).
+    //The block is split at tick boundaries so the tracker stays sample
+    //accurate no matter what buffer size the device was opened with.
+    TRACE_THREAD("audio (synth)");
+    TRACE_ZONE("synth_audio_callback");
+
+    Uint64 callback_start = SDL_GetPerformanceCounter();
+
+    int i = 0;
+    while(i < len) {
+
+        if(song != NULL && samples_until_tick == 0) {
+            tracker_tick();
+            samples_until_tick = samples_per_tick;
+        }
+
+        int run = len - i;
+        if(song != NULL && run > samples_until_tick)
+            run = samples_until_tick;
+
+        for(int s = i; s < i + run; s++) {
+
+            int mix = 0;
+
+            for(int n = 0; n < NUM_SYNTH_VOICES; n++) {
+
+                Synth_Voice* v = &synth_voice[n];
+                if(v->envelope_stage == ENV_OFF)
+                    continue;
+
+                int amp = (v->volume * v->envelope) >> 8;  // 0-64
+                int top = v->phase >> 24;                  // 0-255
+                int out;
+
+                switch(v->waveform) {
+                    case SYNTH_SQUARE:
+                        out = (top < v->duty) ? amp : -amp;
+                        break;
+                    case SYNTH_TRIANGLE:
+                        out = (top < 128) ? (top * 2 - 128) : (383 - top * 2);
+                        out = (out * amp) >> 7;
+                        break;
+                    case SYNTH_SAWTOOTH:
+                        out = ((top - 128) * amp) >> 7;
+                        break;
+                    default: // SYNTH_NOISE, new LFSR bit every wrap
+                        if(v->phase + v->phase_step < v->phase) {
+                            Uint32 bit = (v->noise ^ (v->noise >> 1)) & 1;
+                            v->noise = (v->noise >> 1) | (bit << 14);
+                        }
+                        out = (v->noise & 1) ? amp : -amp;
+                        break;
+                }
+
+                v->phase += v->phase_step;
+                mix += out;
+            }
+
+            //4 voices at +/-64 each, halved to fit the 8-bit range
+            mix = (mix / 2) + 128;
+            if(mix < 0)
+                mix = 0;
+            if(mix > 255)
+                mix = 255;
+            stream[s] = (Uint8)mix;
+        }
+
+        i += run;
+        if(song != NULL)
+            samples_until_tick -= run;
+    }
+
+    SDL_AtomicIncRef(&synth_clock_sequence);         // odd: writing
+    synth_clock_seconds += (double)len / synth_frequency;
+    synth_clock_counter = callback_start;
+    SDL_AtomicIncRef(&synth_clock_sequence);         // even: done
+
+    record_audio_callback(&synth_callback_timing, len, synth_frequency,
+            callback_start);
+}
+
+double audio_clock_ms(void) {
+
+    //The device only reports progress once per buffer, which is coarser
+    //than a frame at small FPS values let alone large buffers. Between
+    //callbacks, fill in with the performance counter (never more than a
+    //buffer's worth) and never let the clock run backwards.
+
+    double seconds;
+    Uint64 counter;
+    int sequence;
+    do {
+        sequence = SDL_AtomicGet(&synth_clock_sequence);
+        seconds = synth_clock_seconds;
+        counter = synth_clock_counter;
+    } while((sequence & 1) != 0 ||
+            SDL_AtomicGet(&synth_clock_sequence) != sequence);
+
+    double ms = seconds * 1000.0;
+    if(counter != 0) {
+        double since = (SDL_GetPerformanceCounter() - counter) * 1000.0 /
+            SDL_GetPerformanceFrequency();
+        if(since > audio_latency_ms)
+            since = audio_latency_ms;
+        ms += since;
+    }
+
+    if(ms < audio_clock_last_ms)
+        ms = audio_clock_last_ms;
+    audio_clock_last_ms = ms;
+
+    return ms;
+}
+
+void synth_note_on(Synth_Voice* v, const Instrument* ins, int note) {
+
+    if(note < 1 || note > SYNTH_NOTE_MAX)
+        return;
+
+    v->instrument = ins;
+    v->waveform = ins->waveform;
+    v->duty = ins->duty;
+    v->volume = ins->volume;
+    v->pitch = note * 16;
+    v->phase_step = pitch_table[v->pitch];
+    v->phase = 0;
+    v->envelope = 0;
+    v->envelope_stage = ENV_ATTACK;
+    if(ins->attack == 0) {
+        v->envelope = 255;
+        v->envelope_stage = ENV_DECAY;
+    }
+}
+
+void synth_note_off(Synth_Voice* v) {
+
+    if(v->envelope_stage != ENV_OFF)
+        v->envelope_stage = ENV_RELEASE;
+}
+
+void synth_envelope_tick(Synth_Voice* v) {
+
+    //Linear ADSR, one step per tick. attack/decay/release are in ticks,
+    //sustain is a level 0-255.
+    const Instrument* ins = v->instrument;
+
+    switch(v->envelope_stage) {
+        case ENV_ATTACK:
+            v->envelope += 255 / ins->attack;
+            if(v->envelope >= 255) {
+                v->envelope = 255;
+                v->envelope_stage = ENV_DECAY;
+            }
+            break;
+        case ENV_DECAY:
+            if(ins->decay == 0) {
+                v->envelope = ins->sustain;
+            } else {
+                v->envelope -= (255 - ins->sustain) / ins->decay + 1;
+            }
+            if(v->envelope <= ins->sustain) {
+                v->envelope = ins->sustain;
+                v->envelope_stage = ENV_SUSTAIN;
+            }
+            break;
+        case ENV_RELEASE:
+            if(ins->release == 0) {
+                v->envelope = 0;
+            } else {
+                v->envelope -= 255 / ins->release + 1;
+            }
+            if(v->envelope <= 0) {
+                v->envelope = 0;
+                v->envelope_stage = ENV_OFF;
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+void tracker_tick(void) {
+
+    if(song_tick == 0)
+        tracker_read_row();
+
+    for(int n = 0; n < NUM_SYNTH_VOICES; n++) {
+
+        Synth_Voice* v = &synth_voice[n];
+        Note_Cell*   e = &song_effect[n];
+
+        if(v->envelope_stage == ENV_OFF)
+            continue;
+
+        switch(e->effect) {
+            case 0x0:
+                if(e->param != 0) {
+                    int step = song_tick % 3;
+                    int add = 0;
+                    if(step == 1)
+                        add = (e->param >> 4) * 16;
+                    else if(step == 2)
+                        add = (e->param & 0x0F) * 16;
+                    v->pitch = song_base_pitch[n] + add;
+                }
+                break;
+            case 0x1:
+                if(song_tick != 0)
+                    v->pitch += e->param;
+                break;
+            case 0x2:
+                if(song_tick != 0)
+                    v->pitch -= e->param;
+                break;
+            default:
+                break;
+        }
+
+        if(v->pitch < 16)
+            v->pitch = 16;
+        if(v->pitch >= NUM_PITCHES)
+            v->pitch = NUM_PITCHES - 1;
+        v->phase_step = pitch_table[v->pitch];
+
+        synth_envelope_tick(v);
+    }
+
+    song_tick++;
+    if(song_tick >= song_speed) {
+        song_tick = 0;
+        song_row++;
+        if(song_row >= song->rows_per_pattern) {
+            song_row = 0;
+            song_order_index++;
+            if(song_order_index >= song->order_length)
+                song_order_index = song->restart_position;
+        }
+    }
+}
+
+void tracker_read_row(void) {
+
+    int pattern = song->order[song_order_index];
+    const Note_Cell* row = song->patterns +
+        (pattern * song->rows_per_pattern + song_row) * NUM_SYNTH_VOICES;
+
+    for(int n = 0; n < NUM_SYNTH_VOICES; n++) {
+
+        const Note_Cell* cell = &row[n];
+        Synth_Voice* v = &synth_voice[n];
+
+        if(cell->note == SYNTH_NOTE_OFF) {
+            synth_note_off(v);
+        } else if(cell->note != 0 && cell->instrument < song->num_instruments) {
+            synth_note_on(v, &song->instruments[cell->instrument], cell->note);
+            song_base_pitch[n] = v->pitch;
+        }
+
+        song_effect[n] = *cell;
+
+        if(cell->effect == 0xC) {
+            v->volume = (cell->param > 64) ? 64 : cell->param;
+        } else if(cell->effect == 0xF && cell->param != 0) {
+            song_speed = cell->param;
+        }
+    }
+}
+
+void play_tracker_song(const Song* s) {
+
+    SDL_LockAudioDevice(audio_device_id);
+
+    for(int n = 0; n < NUM_SYNTH_VOICES; n++) {
+        synth_voice[n].envelope_stage = ENV_OFF;
+        SDL_memset(&song_effect[n], 0, sizeof(Note_Cell));
+    }
+
+    song = s;
+    song_order_index = 0;
+    song_row = 0;
+    song_tick = 0;
+    if(s != NULL) {
+        song_speed = s->speed;
+        samples_per_tick = synth_frequency / s->tick_rate;
+        samples_until_tick = 0;
+    }
+
+    SDL_UnlockAudioDevice(audio_device_id);
+}
+
+void stop_tracker_song(void) {
+    play_tracker_song(NULL);
+}
+
+Song* load_tracker_song(const char* filename) {
+
+    //The whole file goes into one allocation: the Song header followed by
+    //the instrument, order and pattern data it points into.
+
+    SDL_RWops* file = SDL_RWFromFile(filename, "rb");
+    if(file == NULL) {
+        LOG_ERROR(LOG_AUDIO, " TRACKER: unable to open %s (SDL Error: %s)",
+                filename, SDL_GetError());
+        return NULL;
+    }
+
+    Sint64 file_size = SDL_RWsize(file);
+    Uint8 header[12];
+
+    if(file_size < 12 || SDL_RWread(file, header, 12, 1) != 1 ||
+            SDL_memcmp(header, "JTRK", 4) != 0 || header[4] != 1) {
+        LOG_ERROR(LOG_AUDIO, " TRACKER: %s is not a version 1 .jtrk song", filename);
+        SDL_RWclose(file);
+        return NULL;
+    }
+
+    int rows = header[7];
+    int num_instruments = header[8];
+    int num_patterns = header[9];
+    int order_length = header[10];
+    int pattern_bytes = num_patterns * rows * NUM_SYNTH_VOICES * 4;
+    int data_bytes = num_instruments * 8 + order_length + pattern_bytes;
+
+    if(file_size != 12 + data_bytes || header[5] == 0 || header[6] == 0 ||
+            rows == 0 || num_patterns == 0 || order_length == 0 ||
+            header[11] >= order_length) {
+        LOG_ERROR(LOG_AUDIO, " TRACKER: %s is damaged (size or header fields)", filename);
+        SDL_RWclose(file);
+        return NULL;
+    }
+
+    Song* s = (Song*)malloc(sizeof(Song) +
+            num_instruments * sizeof(Instrument) +
+            order_length + pattern_bytes);
+    if(s == NULL) {
+        LOG_ERROR(LOG_AUDIO, " TRACKER: out of memory loading %s", filename);
+        SDL_RWclose(file);
+        return NULL;
+    }
+
+    s->instruments = (Instrument*)(s + 1);
+    s->patterns = (Note_Cell*)(s->instruments + num_instruments);
+    s->order = (Uint8*)s->patterns + pattern_bytes;
+    s->speed = header[5];
+    s->tick_rate = header[6];
+    s->rows_per_pattern = rows;
+    s->num_instruments = num_instruments;
+    s->num_patterns = num_patterns;
+    s->order_length = order_length;
+    s->restart_position = header[11];
+
+    //The size was checked, but the file can still come up short (a read
+    //error, or it changed underneath us); the callback must never play
+    //pattern data that wasn't read
+    bool read_ok = true;
+    for(int i = 0; i < num_instruments; i++) {
+        Uint8 raw[8];
+        if(SDL_RWread(file, raw, 8, 1) != 1) {
+            read_ok = false;
+            break;
+        }
+        s->instruments[i].waveform = raw[0];
+        s->instruments[i].duty = raw[1];
+        s->instruments[i].volume = (raw[2] > 64) ? 64 : raw[2];
+        s->instruments[i].attack = raw[3];
+        s->instruments[i].decay = raw[4];
+        s->instruments[i].sustain = raw[5];
+        s->instruments[i].release = raw[6];
+    }
+    if(read_ok)
+        read_ok = SDL_RWread(file, s->order, order_length, 1) == 1;
+    if(read_ok)   // Note_Cell is 4 bytes
+        read_ok = SDL_RWread(file, s->patterns, pattern_bytes, 1) == 1;
+    SDL_RWclose(file);
+
+    if(read_ok == false) {
+        LOG_ERROR(LOG_AUDIO, " TRACKER: unable to read %s (SDL Error: %s)",
+                filename, SDL_GetError());
+        free(s);
+        return NULL;
+    }
+
+    for(int i = 0; i < order_length; i++) {
+        if(s->order[i] >= num_patterns) {
+            LOG_ERROR(LOG_AUDIO, " TRACKER: %s order list points past the last pattern",
+                    filename);
+            free(s);
+            return NULL;
+        }
+    }
+
+    return s;
+}
+
+void free_tracker_song(Song* s) {
+
+    //Make sure the callback isn't still reading it
+    if(s != NULL && s == song)
+        stop_tracker_song();
+
+    free(s);
+}
+
+bool tracker_song_playing(void) {
+    return song != NULL;
+}
@@ -0,0 +1,333 @@
+//345678901234567890123456789012345678901234567890123456789012345678901234567890
+//       1         2         3         4         5         6         7         8
+// Filename: ../engine_juliet_trace.cpp
+// Last Modified: Tue Oct 20, 2026  07:50AM
+//
+// Startup trace and frame trace.
+//
+// initialize_engine() wraps each step (SDL_Init, window creation, audio
+// probing, font decode, ...) in begin_startup_step()/end_startup_step().
+// Some of those steps run on their own threads, so steps can be recorded
+// from any thread; each claims a slot with an atomic counter.
+//
+// After the first frame has been presented, main_game_loop() calls
+// report_startup_trace(), which logs a table of every step (when it
+// started relative to initialize_engine(), how long it took, which thread
+// ran it) followed by the time to first frame. If startup_trace_json is
+// set before initialize_engine(), the same steps are also written as
+// Chrome trace-event JSON, which chrome://tracing or ui.perfetto.dev will
+// draw as a timeline.
+//
+// Frame trace (only built with -DENGINE_TRACE, otherwise the TRACE_ZONE()
+// and TRACE_THREAD() macros are empty and none of this is compiled).
+//
+// TRACE_ZONE("name") times from where it appears to the end of the
+// enclosing block. main_game_loop() marks out each frame and its phases
+// (input, user callbacks, asset uploads, drawing, SDL_RenderPresent,
+// waiting); the audio callbacks and the loader, music, hot reload and log
+// threads have zones of their own, and game code can add more. Each thread
+// writes its zones into its own ring of the last TRACE_EVENTS_PER_THREAD,
+// claimed the first time it records one, so recording is a couple of
+// counter reads and a store with no lock. write_frame_trace() (also run by
+// shutdown_engine() if frame_trace_json is set) writes every ring, plus the
+// startup steps, as one trace-event JSON file on the startup trace's clock.
+//
+// A thread's ring is handed back when it exits (a TLS destructor, as the
+// log buffers do) but stays as it is until a new thread needs one, and new
+// threads get unused rings first. So zones from threads that have finished
+// (the startup threads) are still there to be written out, and it's only
+// once MAX_TRACE_THREADS rings are taken that a new thread (another audio
+// callback after a retune, the next music prefetch thread) starts over in
+// a ring an exited thread gave back. Zone names must be string literals or
+// otherwise outlive the trace.
+
+#include "engine_juliet.h"
+
+struct Startup_Step {
+    const char*  name;
+    SDL_threadID thread;
+    Uint64       start;     // performance counter
+    Uint64       end;       // 0 while running
+};
+
+const int    MAX_STARTUP_STEPS = 64;
+Startup_Step startup_steps[MAX_STARTUP_STEPS];
+SDL_atomic_t num_startup_steps;
+Uint64       startup_origin = 0;
+const char*  startup_trace_json = NULL;  // file to write, NULL = table only
+
+int begin_startup_step(const char* name) {
+
+    if(startup_origin == 0)
+        startup_origin = SDL_GetPerformanceCounter();
+
+    int i = SDL_AtomicAdd(&num_startup_steps, 1);
+    if(i >= MAX_STARTUP_STEPS)
+        return -1;
+
+    startup_steps[i].name = name;
+    startup_steps[i].thread = SDL_ThreadID();
+    startup_steps[i].end = 0;
+    startup_steps[i].start = SDL_GetPerformanceCounter();
+    return i;
+}
+
+void end_startup_step(int step) {
+
+    if(step >= 0 && step < MAX_STARTUP_STEPS)
+        startup_steps[step].end = SDL_GetPerformanceCounter();
+}
+
+int  write_startup_steps(FILE* f, double ticks_per_ms, bool first);
+
+void report_startup_trace(void) {
+
+    int count = SDL_min(SDL_AtomicGet(&num_startup_steps), MAX_STARTUP_STEPS);
+    double ticks_per_ms = SDL_GetPerformanceFrequency() / 1000.0;
+
+    //Threads are shown as 0 (the main thread, which started the trace),
+    //1, 2, ... rather than the OS's ids
+    SDL_threadID threads[MAX_STARTUP_STEPS];
+    int step_thread[MAX_STARTUP_STEPS];
+    int num_threads = 0;
+    for(int i = 0; i < count; i++) {
+        int t = 0;
+        while(t < num_threads && threads[t] != startup_steps[i].thread)
+            t++;
+        if(t == num_threads)
+            threads[num_threads++] = startup_steps[i].thread;
+        step_thread[i] = t;
+    }
+
+    LOG_INFO(LOG_ENGINE, " STARTUP:     start (ms)  duration (ms)  thread  step");
+    Uint64 last_end = startup_origin;
+    for(int i = 0; i < count; i++) {
+        Startup_Step* s = &startup_steps[i];
+        if(s->end == 0)
+            continue;
+        LOG_INFO(LOG_ENGINE, " STARTUP:  %10.2f  %13.2f  %6d  %s",
+                (s->start - startup_origin) / ticks_per_ms,
+                (s->end - s->start) / ticks_per_ms, step_thread[i], s->name);
+        if(s->end > last_end)
+            last_end = s->end;
+    }
+    LOG_INFO(LOG_ENGINE, " STARTUP: time to first frame %.2f ms",
+            (last_end - startup_origin) / ticks_per_ms);
+
+    if(startup_trace_json == NULL)
+        return;
+
+    FILE* f = fopen(startup_trace_json, "w");
+    if(f == NULL) {
+        LOG_ERROR(LOG_ENGINE, " STARTUP: unable to write %s", startup_trace_json);
+        return;
+    }
+
+    fprintf(f, "{\"traceEvents\":[\n");
+    write_startup_steps(f, ticks_per_ms, true);
+    fprintf(f, "\n]}\n");
+    fclose(f);
+
+    LOG_INFO(LOG_ENGINE, " STARTUP: trace written to %s", startup_trace_json);
+}
+
+int write_startup_steps(FILE* f, double ticks_per_ms, bool first) {
+
+    //Complete ("X") events, times in microseconds. Startup steps are
+    //shown on a process of their own, one row per thread that ran them.
+    int count = SDL_min(SDL_AtomicGet(&num_startup_steps), MAX_STARTUP_STEPS);
+    SDL_threadID threads[MAX_STARTUP_STEPS];
+    int num_threads = 0;
+    int written = 0;
+    for(int i = 0; i < count; i++) {
+        Startup_Step* s = &startup_steps[i];
+        if(s->end == 0)
+            continue;
+        int t = 0;
+        while(t < num_threads && threads[t] != s->thread)
+            t++;
+        if(t == num_threads)
+            threads[num_threads++] = s->thread;
+        fprintf(f, "%s{\"name\":\"%s\",\"cat\":\"startup\",\"ph\":\"X\","
+                "\"ts\":%.1f,\"dur\":%.1f,\"pid\":1,\"tid\":%d}",
+                (first && written == 0) ? "" : ",\n", s->name,
+                (s->start - startup_origin) * 1000.0 / ticks_per_ms,
+                (s->end - s->start) * 1000.0 / ticks_per_ms, t);
+        written++;
+    }
+    return written;
+}
+
+// FRAME TRACE ////////////////////////////////////////////////////////////////
+
+const char* frame_trace_json = NULL;  // written by shutdown_engine() if set
+
+#ifdef ENGINE_TRACE
+
+struct Trace_Event {
+    const char* name;
+    Uint64      start;     // performance counter
+    Uint64      end;
+};
+
+const int TRACE_EVENTS_PER_THREAD = 32768;  // power of 2
+const int MAX_TRACE_THREADS = 32;
+
+struct Trace_Buffer {
+    Trace_Event* events;
+    SDL_atomic_t head;     // events recorded, only the owner writes it
+    const char*  name;     // from TRACE_THREAD(), NULL if never named
+    SDL_threadID thread;
+    SDL_atomic_t released; // 1 once its thread has exited
+};
+
+Trace_Buffer trace_buffers[MAX_TRACE_THREADS];
+SDL_atomic_t num_trace_buffers;     // rings handed out so far, at most MAX
+SDL_atomic_t trace_events_dropped;  // threads beyond MAX_TRACE_THREADS
+SDL_TLSID    trace_tls = 0;
+
+void SDLCALL release_trace_buffer(void* data);
+
+Trace_Buffer* get_trace_buffer(void) {
+
+    Trace_Buffer* b = (Trace_Buffer*)SDL_TLSGet(trace_tls);
+    if(b != NULL || trace_tls == 0)
+        return b;
+
+    //A ring nobody has used yet, while there are any
+    int count = SDL_AtomicGet(&num_trace_buffers);
+    while(b == NULL && count < MAX_TRACE_THREADS) {
+        if(SDL_AtomicCAS(&num_trace_buffers, count, count + 1)) {
+            b = &trace_buffers[count];
+            b->events = (Trace_Event*)SDL_calloc(TRACE_EVENTS_PER_THREAD,
+                    sizeof(Trace_Event));
+        }
+        count = SDL_AtomicGet(&num_trace_buffers);
+    }
+
+    //Otherwise one an exited thread gave back, started over
+    for(int i = 0; b == NULL && i < MAX_TRACE_THREADS; i++) {
+        if(SDL_AtomicCAS(&trace_buffers[i].released, 1, 0)) {
+            b = &trace_buffers[i];
+            b->name = NULL;
+            SDL_AtomicSet(&b->head, 0);
+        }
+    }
+
+    if(b == NULL)
+        return NULL;
+
+    b->thread = SDL_ThreadID();
+    SDL_TLSSet(trace_tls, b, release_trace_buffer);
+    return b;
+}
+
+void SDLCALL release_trace_buffer(void* data) {
+
+    //Called by SDL when a thread that recorded zones exits. The zones
+    //stay until another thread is given the ring.
+    Trace_Buffer* b = (Trace_Buffer*)data;
+    SDL_AtomicSet(&b->released, 1);
+}
+
+void start_frame_trace(void) {
+
+    if(trace_tls == 0)
+        trace_tls = SDL_TLSCreate();
+    if(startup_origin == 0)
+        startup_origin = SDL_GetPerformanceCounter();
+}
+
+void record_trace_zone(const char* name, Uint64 start, Uint64 end) {
+
+    Trace_Buffer* b = get_trace_buffer();
+    if(b == NULL || b->events == NULL) {
+        SDL_AtomicIncRef(&trace_events_dropped);
+        return;
+    }
+
+    //Only this thread writes head, so a plain read is fine; the atomic
+    //set publishes the event to write_frame_trace()
+    int head = SDL_AtomicGet(&b->head);
+    Trace_Event* e = &b->events[head & (TRACE_EVENTS_PER_THREAD - 1)];
+    e->name = name;
+    e->start = start;
+    e->end = end;
+    SDL_AtomicSet(&b->head, head + 1);
+}
+
+void name_trace_thread(const char* name) {
+
+    Trace_Buffer* b = get_trace_buffer();
+    if(b != NULL)
+        b->name = name;
+}
+
+void write_frame_trace(const char* filename) {
+
+    FILE* f = fopen(filename, "w");
+    if(f == NULL) {
+        LOG_ERROR(LOG_ENGINE, " TRACE: unable to write %s", filename);
+        return;
+    }
+
+    double ticks_per_ms = SDL_GetPerformanceFrequency() / 1000.0;
+    fprintf(f, "{\"traceEvents\":[\n");
+    fprintf(f, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,"
+            "\"args\":{\"name\":\"startup\"}},\n");
+    fprintf(f, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":2,"
+            "\"args\":{\"name\":\"frames\"}}");
+    write_startup_steps(f, ticks_per_ms, false);
+
+    int count = SDL_min(SDL_AtomicGet(&num_trace_buffers), MAX_TRACE_THREADS);
+    int total = 0;
+    for(int t = 0; t < count; t++) {
+
+        Trace_Buffer* b = &trace_buffers[t];
+        if(b->events == NULL)
+            continue;
+
+        if(b->name != NULL) {
+            fprintf(f, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":2,"
+                    "\"tid\":%d,\"args\":{\"name\":\"%s\"}}", t, b->name);
+        }
+
+        //The thread may still be recording. Once its ring has wrapped,
+        //leave a margin at the old end in case it's being overwritten.
+        int head = SDL_AtomicGet(&b->head);
+        int first = 0;
+        if(head > TRACE_EVENTS_PER_THREAD)
+            first = head - TRACE_EVENTS_PER_THREAD + 64;
+
+        for(int i = first; i < head; i++) {
+            Trace_Event* e = &b->events[i & (TRACE_EVENTS_PER_THREAD - 1)];
+            fprintf(f, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"ts\":%.1f,"
+                    "\"dur\":%.1f,\"pid\":2,\"tid\":%d}", e->name,
+                    ((Sint64)(e->start - startup_origin)) * 1000.0 / ticks_per_ms,
+                    (e->end - e->start) * 1000.0 / ticks_per_ms, t);
+        }
+        total += head - first;
+    }
+
+    fprintf(f, "\n]}\n");
+    fclose(f);
+
+    LOG_INFO(LOG_ENGINE, " TRACE: %d zones from %d threads written to %s",
+            total, count, filename);
+    if(SDL_AtomicGet(&trace_events_dropped) > 0) {
+        LOG_WARN(LOG_ENGINE, " TRACE: %d zones dropped (more than %d threads at once)",
+                SDL_AtomicGet(&trace_events_dropped), MAX_TRACE_THREADS);
+    }
+}
+
+#else
+
+void start_frame_trace(void) {
+}
+
+void write_frame_trace(const char* filename) {
+    LOG_WARN(LOG_ENGINE, " TRACE: built without ENGINE_TRACE, %s not written",
+            filename);
+}
+
+#endif
@@ -0,0 +1,200 @@
+//345678901234567890123456789012345678901234567890123456789012345678901234567890
+//       1         2         3         4         5         6         7         8
+// Filename: ../tools/asset_packer.cpp
+// Last Modified: Mon Oct 19, 2026  05:45PM
+//
+// Offline asset packer for engine juliet (see engine_juliet_pack.cpp).
+//
+// Usage (from the directory the game runs in, so names match the paths
+// the game loads with):
+//
+//     asset_packer assets.jpak ../graphics/c64_font.bmp ../sound/blip.wav
+//
+// Images (anything SDL_image reads) are converted to
+// ASSET_PACK_PIXEL_FORMAT and every (10,10,10) pixel becomes fully
+// transparent, which is what create_optimized_texture() does with its
+// color key. .wav files are converted to the mixer's format. The game then
+// does no decoding or conversion at all for anything in the pack.
+//
+// The pack is written in the machine's byte order (the engine only runs
+// on little-endian x86), so it's built on the same kind of machine that
+// runs the game.
+
+#include "../engine_juliet.h"
+
+struct Packed_Asset {
+    Asset_Pack_Entry entry;
+    Uint8*           data;
+};
+
+const int MAX_PACKED_ASSETS = 1024;
+Packed_Asset assets[MAX_PACKED_ASSETS];
+int          num_assets = 0;
+
+bool pack_image(const char* filename, Packed_Asset* a);
+bool pack_sound(const char* filename, Packed_Asset* a);
+int  compare_assets(const void* x, const void* y);
+
+int main(int argc, char* argv[]) {
+
+    if(argc < 3) {
+        printf("usage: asset_packer <pack file> <asset> [asset ...]\n");
+        return 1;
+    }
+
+    for(int i = 2; i < argc; i++) {
+
+        const char* name = argv[i];
+        if(SDL_strlen(name) >= (size_t)ASSET_NAME_LENGTH) {
+            printf(" %s: name longer than %d characters\n", name,
+                    ASSET_NAME_LENGTH - 1);
+            return 1;
+        }
+        if(num_assets == MAX_PACKED_ASSETS) {
+            printf(" too many assets (limit %d)\n", MAX_PACKED_ASSETS);
+            return 1;
+        }
+
+        Packed_Asset* a = &assets[num_assets];
+        SDL_memset(a, 0, sizeof(Packed_Asset));
+        SDL_strlcpy(a->entry.name, name, ASSET_NAME_LENGTH);
+
+        size_t len = SDL_strlen(name);
+        bool is_wav = (len > 4) && SDL_strcasecmp(name + len - 4, ".wav") == 0;
+        bool ok = is_wav ? pack_sound(name, a) : pack_image(name, a);
+        if(ok == false)
+            return 1;
+
+        num_assets++;
+    }
+
+    //Sorted so the engine can binary search the directory
+    qsort(assets, num_assets, sizeof(Packed_Asset), compare_assets);
+
+    Asset_Pack_Header header;
+    SDL_memset(&header, 0, sizeof(header));
+    SDL_memcpy(header.id, "JPAK", 4);
+    header.version = ASSET_PACK_VERSION;
+    header.num_entries = num_assets;
+    header.pixel_format = ASSET_PACK_PIXEL_FORMAT;
+    header.sound_frequency = ASSET_PACK_FREQUENCY;
+    header.sound_format = ASSET_PACK_AUDIO_FORMAT;
+    header.sound_channels = ASSET_PACK_CHANNELS;
+
+    //Lay out the data after the directory, each block aligned
+    Uint32 offset = sizeof(header) + num_assets * sizeof(Asset_Pack_Entry);
+    for(int i = 0; i < num_assets; i++) {
+        offset = (offset + ASSET_PACK_ALIGNMENT - 1) & ~(ASSET_PACK_ALIGNMENT - 1);
+        assets[i].entry.offset = offset;
+        offset += assets[i].entry.size;
+    }
+
+    FILE* f = fopen(argv[1], "wb");
+    if(f == NULL) {
+        printf(" unable to create %s\n", argv[1]);
+        return 1;
+    }
+
+    fwrite(&header, sizeof(header), 1, f);
+    for(int i = 0; i < num_assets; i++)
+        fwrite(&assets[i].entry, sizeof(Asset_Pack_Entry), 1, f);
+
+    static const Uint8 zeros[ASSET_PACK_ALIGNMENT] = { 0 };
+    for(int i = 0; i < num_assets; i++) {
+        long pad = (long)assets[i].entry.offset - ftell(f);
+        fwrite(zeros, 1, pad, f);
+        fwrite(assets[i].data, 1, assets[i].entry.size, f);
+        SDL_free(assets[i].data);
+    }
+
+    bool ok = (ferror(f) == 0);
+    fclose(f);
+
+    printf(" %s: %d assets, %u bytes%s\n", argv[1], num_assets, offset,
+            ok ? "" : " (WRITE FAILED)");
+    return ok ? 0 : 1;
+}
+
+bool pack_image(const char* filename, Packed_Asset* a) {
+
+    SDL_Surface* loaded = IMG_Load(filename);
+    if(loaded == NULL) {
+        printf(" %s: %s\n", filename, IMG_GetError());
+        return false;
+    }
+
+    SDL_Surface* s = SDL_ConvertSurfaceFormat(loaded, ASSET_PACK_PIXEL_FORMAT, 0);
+    SDL_FreeSurface(loaded);
+    if(s == NULL) {
+        printf(" %s: %s\n", filename, SDL_GetError());
+        return false;
+    }
+
+    //Resolve the engine's color key now, so the game doesn't have to
+    Uint32 key = SDL_MapRGBA(s->format, 10, 10, 10, 0xFF);
+    SDL_LockSurface(s);
+    for(int y = 0; y < s->h; y++) {
+        Uint32* row = (Uint32*)((Uint8*)s->pixels + y * s->pitch);
+        for(int x = 0; x < s->w; x++) {
+            if(row[x] == key)
+                row[x] = 0; // transparent black
+        }
+    }
+
+    a->entry.type = ASSET_IMAGE;
+    a->entry.width = s->w;
+    a->entry.height = s->h;
+    a->entry.pitch = s->w * 4;
+    a->entry.size = a->entry.pitch * s->h;
+    a->data = (Uint8*)SDL_malloc(a->entry.size);
+    for(int y = 0; y < s->h; y++) {
+        SDL_memcpy(a->data + y * a->entry.pitch,
+                (Uint8*)s->pixels + y * s->pitch, a->entry.pitch);
+    }
+
+    SDL_UnlockSurface(s);
+    SDL_FreeSurface(s);
+
+    printf(" %s: %d x %d image\n", filename, a->entry.width, a->entry.height);
+    return true;
+}
+
+bool pack_sound(const char* filename, Packed_Asset* a) {
+
+    SDL_AudioSpec spec;
+    Uint8* samples = NULL;
+    Uint32 length = 0;
+    if(SDL_LoadWAV(filename, &spec, &samples, &length) == NULL) {
+        printf(" %s: %s\n", filename, SDL_GetError());
+        return false;
+    }
+
+    SDL_AudioCVT cvt;
+    if(SDL_BuildAudioCVT(&cvt, spec.format, spec.channels, spec.freq,
+            ASSET_PACK_AUDIO_FORMAT, ASSET_PACK_CHANNELS,
+            ASSET_PACK_FREQUENCY) < 0) {
+        printf(" %s: %s\n", filename, SDL_GetError());
+        SDL_FreeWAV(samples);
+        return false;
+    }
+
+    cvt.len = length;
+    cvt.buf = (Uint8*)SDL_malloc(length * cvt.len_mult);
+    SDL_memcpy(cvt.buf, samples, length);
+    SDL_FreeWAV(samples);
+    if(cvt.needed)
+        SDL_ConvertAudio(&cvt);
+
+    a->entry.type = ASSET_SOUND;
+    a->entry.size = cvt.len_cvt;
+    a->data = cvt.buf;
+
+    printf(" %s: %.2f s sound\n", filename, (double)cvt.len_cvt /
+            (ASSET_PACK_FREQUENCY * ASSET_PACK_CHANNELS * 2));
+    return true;
+}
+
+int compare_assets(const void* x, const void* y) {
+    return SDL_strcmp(((const Packed_Asset*)x)->entry.name,
+            ((const Packed_Asset*)y)->entry.name);
+}